@@ -0,0 +1,198 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "BakedParticleEmitter2D.h"
+#include "BakeWidget.h"
+#include "FloatEditor.h"
+#include "IntEditor.h"
+#include "ParticleEditor.h"
+#include <QCheckBox>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QSlider>
+#include <QTimer>
+#include <QVBoxLayout>
+
+namespace Urho3D
+{
+
+BakeWidget::BakeWidget(Context* context) :
+    QWidget(),
+    ParticleEffectEditor(context)
+{
+    QVBoxLayout* vBoxLayout = new QVBoxLayout();
+    setLayout(vBoxLayout);
+
+    durationEditor_ = new FloatEditor(tr("Duration"));
+    vBoxLayout->addLayout(durationEditor_);
+    durationEditor_->setRange(0.1f, 60.0f);
+    durationEditor_->setValue(2.0f);
+
+    frameRateEditor_ = new IntEditor(tr("Frame Rate"));
+    vBoxLayout->addLayout(frameRateEditor_);
+    frameRateEditor_->setRange(1, 120);
+    frameRateEditor_->setValue(30);
+
+    QHBoxLayout* hBoxLayout = new QHBoxLayout();
+    vBoxLayout->addLayout(hBoxLayout);
+
+    QPushButton* bakePushButton = new QPushButton(tr("Bake ..."));
+    hBoxLayout->addWidget(bakePushButton);
+    connect(bakePushButton, SIGNAL(clicked(bool)), this, SLOT(HandleBakePushButtonClicked()));
+
+    QPushButton* openPushButton = new QPushButton(tr("Open ..."));
+    hBoxLayout->addWidget(openPushButton);
+    connect(openPushButton, SIGNAL(clicked(bool)), this, SLOT(HandleOpenPushButtonClicked()));
+
+    previewCheckBox_ = new QCheckBox(tr("Show Bake"));
+    hBoxLayout->addWidget(previewCheckBox_);
+    connect(previewCheckBox_, SIGNAL(toggled(bool)), this, SLOT(HandlePreviewCheckBoxToggled(bool)));
+
+    hBoxLayout = new QHBoxLayout();
+    vBoxLayout->addLayout(hBoxLayout);
+
+    playPushButton_ = new QPushButton(tr("Pause"));
+    hBoxLayout->addWidget(playPushButton_);
+    connect(playPushButton_, SIGNAL(clicked(bool)), this, SLOT(HandlePlayPushButtonClicked()));
+
+    timeSlider_ = new QSlider(Qt::Horizontal);
+    hBoxLayout->addWidget(timeSlider_, 1);
+    connect(timeSlider_, SIGNAL(valueChanged(int)), this, SLOT(HandleTimeSliderValueChanged(int)));
+
+    timeLabel_ = new QLabel();
+    timeLabel_->setMinimumWidth(48);
+    hBoxLayout->addWidget(timeLabel_);
+
+    statusLabel_ = new QLabel();
+    vBoxLayout->addWidget(statusLabel_);
+    vBoxLayout->addStretch(1);
+
+    // The slider follows playback, so it is polled more often than the statistics of other docks
+    QTimer* timer = new QTimer(this);
+    connect(timer, SIGNAL(timeout()), this, SLOT(HandleRefreshTimeout()));
+    timer->start(50);
+}
+
+BakeWidget::~BakeWidget()
+{
+}
+
+void BakeWidget::HandleBakePushButtonClicked()
+{
+    QString fileName = QFileDialog::getSaveFileName(0, tr("Bake particle"), "./Data/Urho2D/", "*.pbake");
+    if (fileName.isEmpty())
+        return;
+
+    ParticleEditor::Get()->Bake(fileName.toLatin1().data(), durationEditor_->value(), (float)frameRateEditor_->value());
+    UpdateWidget();
+}
+
+void BakeWidget::HandleOpenPushButtonClicked()
+{
+    QString fileName = QFileDialog::getOpenFileName(0, tr("Open baked particle"), "./Data/Urho2D/", "*.pbake");
+    if (fileName.isEmpty())
+        return;
+
+    ParticleEditor::Get()->OpenBake(fileName.toLatin1().data());
+    UpdateWidget();
+}
+
+void BakeWidget::HandlePreviewCheckBoxToggled(bool checked)
+{
+    if (updatingWidget_)
+        return;
+
+    ParticleEditor::Get()->SetBakePreview(checked);
+}
+
+void BakeWidget::HandlePlayPushButtonClicked()
+{
+    BakedParticleEmitter2D* bakedEmitter = ParticleEditor::Get()->GetBakedEmitter();
+    if (!bakedEmitter)
+        return;
+
+    // Playing from the end of a bake that does not loop starts it over
+    bool playing = !bakedEmitter->IsPlaying();
+    ParticleBake2D* bake = bakedEmitter->GetBake();
+    if (playing && bake && !bake->IsLooping() && bakedEmitter->GetTime() >= bake->GetDuration())
+        bakedEmitter->SetTime(0.0f);
+    bakedEmitter->SetPlaying(playing);
+
+    ParticleEditor::Get()->RequestFrame();
+    HandleRefreshTimeout();
+}
+
+void BakeWidget::HandleTimeSliderValueChanged(int value)
+{
+    if (updatingWidget_)
+        return;
+
+    // Scrubbing holds playback where the slider is
+    BakedParticleEmitter2D* bakedEmitter = ParticleEditor::Get()->GetBakedEmitter();
+    if (!bakedEmitter)
+        return;
+
+    bakedEmitter->SetPlaying(false);
+    bakedEmitter->SetTime(value * 0.001f);
+    ParticleEditor::Get()->RequestFrame();
+    HandleRefreshTimeout();
+}
+
+void BakeWidget::HandleRefreshTimeout()
+{
+    if (!isVisible())
+        return;
+
+    BakedParticleEmitter2D* bakedEmitter = ParticleEditor::Get()->GetBakedEmitter();
+    ParticleBake2D* bake = bakedEmitter ? bakedEmitter->GetBake() : 0;
+    playPushButton_->setEnabled(bake != 0);
+    timeSlider_->setEnabled(bake != 0);
+    if (!bake)
+    {
+        timeLabel_->clear();
+        statusLabel_->setText(tr("Not baked"));
+        return;
+    }
+
+    // Following playback must not count as scrubbing
+    timeSlider_->blockSignals(true);
+    timeSlider_->setRange(0, (int)(bake->GetDuration() * 1000.0f));
+    timeSlider_->setValue((int)(bakedEmitter->GetTime() * 1000.0f));
+    timeSlider_->blockSignals(false);
+
+    playPushButton_->setText(bakedEmitter->IsPlaying() ? tr("Pause") : tr("Play"));
+    timeLabel_->setText(tr("%1 s").arg(bakedEmitter->GetTime(), 0, 'f', 2));
+    statusLabel_->setText(tr("%1 frames at %2 fps, %3 KB, %4 particles").arg(bake->GetNumFrames()).arg(bake->GetFrameRate())
+        .arg(bake->GetDataSize() / 1024).arg(bakedEmitter->GetNumParticles()));
+}
+
+void BakeWidget::HandleUpdateWidget()
+{
+    previewCheckBox_->setChecked(ParticleEditor::Get()->IsBakePreview());
+    previewCheckBox_->setEnabled(ParticleEditor::Get()->GetBakedEmitter() != 0);
+
+    HandleRefreshTimeout();
+}
+
+}
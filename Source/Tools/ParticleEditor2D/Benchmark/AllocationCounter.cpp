@@ -0,0 +1,137 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifdef _MSC_VER
+#include <windows.h>
+#endif
+
+#if __cplusplus >= 201103L
+#define ALLOCATION_THROW
+#define ALLOCATION_NOTHROW noexcept
+#else
+#define ALLOCATION_THROW throw(std::bad_alloc)
+#define ALLOCATION_NOTHROW throw()
+#endif
+
+namespace Urho3D
+{
+
+/// Number of allocations since program start.
+static volatile long long numAllocations = 0;
+/// Number of bytes allocated since program start.
+static volatile long long numBytes = 0;
+
+/// Add to a counter atomically and return the new value.
+static unsigned long long AddCount(volatile long long& counter, long long value)
+{
+#ifdef _MSC_VER
+    return (unsigned long long)(InterlockedExchangeAdd64(&counter, value) + value);
+#else
+    return (unsigned long long)__sync_add_and_fetch(&counter, value);
+#endif
+}
+
+AllocationCounts GetAllocationCounts()
+{
+    AllocationCounts counts;
+    counts.allocations_ = AddCount(numAllocations, 0);
+    counts.bytes_ = AddCount(numBytes, 0);
+    return counts;
+}
+
+/// Count an allocation and allocate. Return null if out of memory.
+static void* CountedAllocate(size_t size)
+{
+    AddCount(numAllocations, 1);
+    AddCount(numBytes, (long long)size);
+
+    return malloc(size ? size : 1);
+}
+
+/// Count an allocation and allocate. Throw std::bad_alloc if out of memory.
+static void* CountedAllocateOrThrow(size_t size)
+{
+    void* ptr = CountedAllocate(size);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+}
+
+void* operator new(size_t size) ALLOCATION_THROW
+{
+    return Urho3D::CountedAllocateOrThrow(size);
+}
+
+void* operator new[](size_t size) ALLOCATION_THROW
+{
+    return Urho3D::CountedAllocateOrThrow(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) ALLOCATION_NOTHROW
+{
+    return Urho3D::CountedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) ALLOCATION_NOTHROW
+{
+    return Urho3D::CountedAllocate(size);
+}
+
+void operator delete(void* ptr) ALLOCATION_NOTHROW
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr) ALLOCATION_NOTHROW
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) ALLOCATION_NOTHROW
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) ALLOCATION_NOTHROW
+{
+    free(ptr);
+}
+
+// C++14 compilers call the sized forms when the size is known, which would otherwise bypass the free() above
+#if defined(__cpp_sized_deallocation) || (defined(_MSC_VER) && _MSC_VER >= 1900)
+void operator delete(void* ptr, size_t) ALLOCATION_NOTHROW
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) ALLOCATION_NOTHROW
+{
+    free(ptr);
+}
+#endif
@@ -0,0 +1,50 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Context.h"
+#include "ParticleBenchmark2D.h"
+#include "ProcessUtils.h"
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+using namespace Urho3D;
+
+#ifdef WIN32
+int wmain(int argc, wchar_t** argv)
+#else
+int main(int argc, char** argv)
+#endif
+{
+    Vector<String> arguments;
+
+#ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+#else
+    arguments = ParseArguments(argc, argv);
+#endif
+
+    SharedPtr<Context> context(new Context());
+    SharedPtr<ParticleBenchmark2D> benchmark(new ParticleBenchmark2D(context));
+    return benchmark->Run(arguments);
+}
@@ -0,0 +1,412 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "AllocationCounter.h"
+#include "Context.h"
+#include "File.h"
+#include "Node.h"
+#include "ParticleBenchmark2D.h"
+#include "ParticleEffect2D.h"
+#include "ParticleEffectBinary2D.h"
+#include "ParticleSimulator2D.h"
+#include "ParticleUpdater2D.h"
+#include "ProcessUtils.h"
+#include "Scene.h"
+#include "SimulatedParticleEmitter2D.h"
+#include "SimulationHost.h"
+#include "Sprite2D.h"
+#include "Texture2D.h"
+#include "Timer.h"
+
+namespace Urho3D
+{
+
+/// Emitter type names in EmitterType2D order.
+static const char* emitterTypeNames[] = { "gravity", "radial" };
+/// Kernel level names in ParticleKernelLevel2D order.
+static const char* kernelLevelNames[] = { "scalar", "sse2", "avx2" };
+
+/// Return string as a JSON string literal.
+static String ToJSONString(const String& value)
+{
+    String result = "\"";
+    for (unsigned i = 0; i < value.Length(); ++i)
+    {
+        if (value[i] == '"' || value[i] == '\\')
+            result += '\\';
+        result += value[i];
+    }
+    result += '"';
+    return result;
+}
+
+/// Return number as JSON.
+static String ToJSONNumber(double value)
+{
+    return ToString("%.6g", value);
+}
+
+ParticleBenchmark2D::ParticleBenchmark2D(Context* context) :
+    Object(context),
+    kernelLevel_(MAX_PARTICLE_KERNEL_LEVELS),
+    randomSeed_(1),
+    timeStep_(1.0f / 60.0f),
+    numSteps_(120),
+    verify_(false)
+{
+    effectNames_.Push("Urho2D/fire.pex");
+    effectNames_.Push("Urho2D/sun.pex");
+    effectNames_.Push("Urho2D/greenspiral.pex");
+
+    particleCounts_.Push(1000);
+    particleCounts_.Push(10000);
+    particleCounts_.Push(100000);
+    particleCounts_.Push(1000000);
+}
+
+ParticleBenchmark2D::~ParticleBenchmark2D()
+{
+}
+
+int ParticleBenchmark2D::Run(const Vector<String>& arguments)
+{
+    if (!ParseArguments(arguments))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    // Worker threads stay on, so -verify steps the chunk work items the editor does. The allocation counts include them
+    host_ = new SimulationHost(context_);
+    if (!host_->Initialize("ParticleBenchmark2D.log", true))
+    {
+        PrintLine("Could not initialize the headless engine", true);
+        return 1;
+    }
+    ParticleUpdater2D::RegisterObject(context_);
+    SimulatedParticleEmitter2D::RegisterObject(context_);
+
+    results_.Clear();
+    unsigned numAllocatingWorkloads = 0;
+    for (unsigned i = 0; i < effectNames_.Size(); ++i)
+    {
+        for (unsigned j = 0; j < 2; ++j)
+        {
+            for (unsigned k = 0; k < particleCounts_.Size(); ++k)
+            {
+                BenchmarkWorkload2D workload;
+                workload.effectName_ = effectNames_[i];
+                workload.emitterType_ = (int)j;
+                workload.maxParticles_ = particleCounts_[k];
+
+                BenchmarkResult2D result;
+                if (!RunWorkload(workload, result))
+                {
+                    PrintLine("Could not load " + workload.effectName_, true);
+                    return 1;
+                }
+
+                // Progress goes to standard error so the report can be piped
+                PrintLine(workload.effectName_ + " " + emitterTypeNames[j] + " " + String(workload.maxParticles_) + ": " +
+                    ToString("%.3f ns/particle/step, %.2f allocations/step", result.nsPerParticleStep_, result.allocationsPerStep_), true);
+                results_.Push(result);
+
+                if (verify_)
+                {
+                    unsigned long long allocations = 0;
+                    if (!VerifyWorkload(workload, allocations))
+                    {
+                        PrintLine("Could not load " + workload.effectName_, true);
+                        return 1;
+                    }
+
+                    PrintLine(workload.effectName_ + " " + emitterTypeNames[j] + " " + String(workload.maxParticles_) + ": " +
+                        String((unsigned)allocations) + " emitter allocations after warm-up" + (allocations ? ", FAILED" : ""), true);
+                    if (allocations)
+                        ++numAllocatingWorkloads;
+                }
+            }
+        }
+    }
+
+    String report = GetReport();
+    if (outputFileName_.Empty())
+        PrintLine(report);
+    else
+    {
+        File file(context_);
+        if (!file.Open(outputFileName_, FILE_WRITE) || file.Write(report.CString(), report.Length()) != report.Length())
+        {
+            PrintLine("Could not write " + outputFileName_, true);
+            return 1;
+        }
+    }
+
+    if (numAllocatingWorkloads)
+    {
+        PrintLine(String(numAllocatingWorkloads) + " workloads allocated after warm-up", true);
+        return 1;
+    }
+
+    return 0;
+}
+
+bool ParticleBenchmark2D::RunWorkload(const BenchmarkWorkload2D& workload, BenchmarkResult2D& result)
+{
+    ParticleEffect2D* effect = host_->LoadEffect(workload.effectName_);
+    if (!effect)
+        return false;
+
+    // The effect is a shared resource, restore it afterwards so workloads do not affect each other
+    ParticleEffectParameters2D originalParameters;
+    GetParticleEffectParameters(effect, originalParameters);
+    effect->SetEmitterType((EmitterType2D)workload.emitterType_);
+    effect->SetMaxParticles((int)workload.maxParticles_);
+    effect->SetDuration(-1.0f);
+
+    SharedPtr<ParticleSimulator2D> simulator(new ParticleSimulator2D(context_));
+    simulator->SetRandomSeed(randomSeed_);
+    if (kernelLevel_ != MAX_PARTICLE_KERNEL_LEVELS)
+        simulator->SetKernelLevel(kernelLevel_);
+    simulator->SetEffect(effect);
+
+    // Run until the particle count has settled, then measure
+    float warmUpTime = effect->GetParticleLifeSpan() + Abs(effect->GetParticleLifespanVariance()) + 0.5f;
+    simulator->Simulate(warmUpTime, timeStep_);
+
+    PerfCounters counters;
+    double particleSteps = 0.0;
+    AllocationCounts startCounts = GetAllocationCounts();
+    HiresTimer timer;
+    counters.Start();
+
+    for (unsigned i = 0; i < numSteps_; ++i)
+    {
+        simulator->Update(timeStep_);
+        particleSteps += simulator->GetNumParticles();
+    }
+
+    counters.Stop();
+    long long elapsed = timer.GetUSec(false);
+    AllocationCounts endCounts = GetAllocationCounts();
+
+    SetParticleEffectParameters(effect, originalParameters);
+
+    particleSteps = Max(particleSteps, 1.0);
+    result.workload_ = workload;
+    result.averageParticles_ = particleSteps / numSteps_;
+    result.msPerStep_ = elapsed / 1000.0 / numSteps_;
+    result.nsPerParticleStep_ = elapsed * 1000.0 / particleSteps;
+    result.allocationsPerStep_ = (double)(endCounts.allocations_ - startCounts.allocations_) / numSteps_;
+    result.bytesPerStep_ = (double)(endCounts.bytes_ - startCounts.bytes_) / numSteps_;
+    for (unsigned i = 0; i < MAX_PERF_COUNTERS; ++i)
+    {
+        result.hasCounter_[i] = counters.IsAvailable((PerfCounterType)i);
+        result.countersPerParticleStep_[i] = counters.GetValue((PerfCounterType)i) / particleSteps;
+    }
+
+    return true;
+}
+
+bool ParticleBenchmark2D::VerifyWorkload(const BenchmarkWorkload2D& workload, unsigned long long& allocations)
+{
+    ParticleEffect2D* effect = host_->LoadEffect(workload.effectName_);
+    if (!effect)
+        return false;
+
+    ParticleEffectParameters2D originalParameters;
+    GetParticleEffectParameters(effect, originalParameters);
+    effect->SetEmitterType((EmitterType2D)workload.emitterType_);
+    effect->SetMaxParticles((int)workload.maxParticles_);
+    effect->SetDuration(-1.0f);
+
+    // Frames of one and a half fixed steps alternate between one and two steps and draw interpolated positions, as in the
+    // editor
+    SharedPtr<Scene> scene(new Scene(context_));
+    ParticleUpdater2D* updater = scene->CreateComponent<ParticleUpdater2D>();
+    updater->SetFixedTimeStep(timeStep_);
+    float frameTime = timeStep_ * 1.5f;
+
+    Node* node = scene->CreateChild("ParticleEmitter2D");
+    SimulatedParticleEmitter2D* emitter = node->CreateComponent<SimulatedParticleEmitter2D>();
+    emitter->GetSimulator()->SetRandomSeed(randomSeed_);
+    if (kernelLevel_ != MAX_PARTICLE_KERNEL_LEVELS)
+        emitter->GetSimulator()->SetKernelLevel(kernelLevel_);
+    emitter->SetEffect(effect);
+
+    // Headless textures have no size and would leave the vertices out, so the emitter gets a stand-in sprite. Its texture
+    // coordinates mean nothing, only the vertex writes count
+    SharedPtr<Sprite2D> sprite(new Sprite2D(context_));
+    sprite->SetTexture(new Texture2D(context_));
+    sprite->SetRectangle(IntRect(0, 0, 1, 1));
+    emitter->SetSprite(sprite);
+
+    // Warming up covers the longest life twice, so the particle count has peaked
+    float warmUpTime = (effect->GetParticleLifeSpan() + Abs(effect->GetParticleLifespanVariance())) * 2.0f + 0.5f;
+    for (float time = 0.0f; time < warmUpTime; time += frameTime)
+        updater->Advance(frameTime);
+
+    // Max particles is lowered and raised again on the way, as the editor does while its value is dragged
+    AllocationCounts startCounts = GetAllocationCounts();
+    for (unsigned i = 0; i < numSteps_; ++i)
+    {
+        if (i == numSteps_ / 3)
+            emitter->SetMaxParticles(Max(workload.maxParticles_ / 2, 1U));
+        else if (i == numSteps_ * 2 / 3)
+            emitter->SetMaxParticles(workload.maxParticles_);
+        updater->Advance(frameTime);
+    }
+    AllocationCounts endCounts = GetAllocationCounts();
+
+    SetParticleEffectParameters(effect, originalParameters);
+
+    allocations = endCounts.allocations_ - startCounts.allocations_;
+    return true;
+}
+
+String ParticleBenchmark2D::GetReport() const
+{
+    const ParticleKernels2D& kernels = kernelLevel_ != MAX_PARTICLE_KERNEL_LEVELS ? GetParticleKernels(kernelLevel_) :
+        SelectParticleKernels();
+
+    String report = "{\n";
+    report += "    \"platform\": " + ToJSONString(GetPlatform()) + ",\n";
+    report += "    \"logicalCPUs\": " + String(GetNumLogicalCPUs()) + ",\n";
+    report += "    \"kernels\": " + ToJSONString(kernels.name_) + ",\n";
+    report += "    \"randomSeed\": " + String(randomSeed_) + ",\n";
+    report += "    \"timeStep\": " + ToJSONNumber(timeStep_) + ",\n";
+    report += "    \"steps\": " + String(numSteps_) + ",\n";
+    report += "    \"results\": [";
+
+    for (unsigned i = 0; i < results_.Size(); ++i)
+    {
+        const BenchmarkResult2D& result = results_[i];
+        report += i ? ",\n        {\n" : "\n        {\n";
+        report += "            \"effect\": " + ToJSONString(result.workload_.effectName_) + ",\n";
+        report += "            \"emitterType\": " + ToJSONString(emitterTypeNames[result.workload_.emitterType_]) + ",\n";
+        report += "            \"maxParticles\": " + String(result.workload_.maxParticles_) + ",\n";
+        report += "            \"averageParticles\": " + ToJSONNumber(result.averageParticles_) + ",\n";
+        report += "            \"msPerStep\": " + ToJSONNumber(result.msPerStep_) + ",\n";
+        report += "            \"nsPerParticleStep\": " + ToJSONNumber(result.nsPerParticleStep_) + ",\n";
+        report += "            \"allocationsPerStep\": " + ToJSONNumber(result.allocationsPerStep_) + ",\n";
+        report += "            \"bytesPerStep\": " + ToJSONNumber(result.bytesPerStep_) + ",\n";
+        report += "            \"countersPerParticleStep\": {";
+        for (unsigned j = 0; j < MAX_PERF_COUNTERS; ++j)
+        {
+            report += j ? ", " : " ";
+            report += ToJSONString(PerfCounters::GetName((PerfCounterType)j)) + ": ";
+            report += result.hasCounter_[j] ? ToJSONNumber(result.countersPerParticleStep_[j]) : String("null");
+        }
+        report += " }\n        }";
+    }
+
+    report += "\n    ]\n}";
+    return report;
+}
+
+void ParticleBenchmark2D::PrintUsage()
+{
+    PrintLine("Usage: ParticleBenchmark2D [options]\n"
+        "\n"
+        "Step each effect as gravity and radial emitter at each particle count with a fixed seed and time step, and report\n"
+        "ns/particle/step, heap allocations per step and, where perf events are available, hardware counters as JSON.\n"
+        "\n"
+        "Options:\n"
+        "-effects <a,b>  Effect resource names, default Urho2D/fire.pex,Urho2D/sun.pex,Urho2D/greenspiral.pex\n"
+        "-counts <a,b>   Particle counts, default 1000,10000,100000,1000000\n"
+        "-steps <n>      Measured steps per workload, default 120\n"
+        "-kernel <name>  Kernels to use, scalar, sse2 or avx2, default the best validated ones\n"
+        "-seed <n>       Random seed, default 1\n"
+        "-verify         Also step each workload through a scene emitter, lowering and raising max particles on the way,\n"
+        "                and exit with an error if any step allocates once the emitter has warmed up\n"
+        "-output <file>  Write the report to file instead of standard output");
+}
+
+bool ParticleBenchmark2D::ParseArguments(const Vector<String>& arguments)
+{
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        String argument = arguments[i].ToLower();
+        bool hasValue = i + 1 < arguments.Size();
+
+        if (argument == "-effects" && hasValue)
+        {
+            effectNames_ = arguments[++i].Split(',');
+            if (effectNames_.Empty())
+                return false;
+        }
+        else if (argument == "-counts" && hasValue)
+        {
+            Vector<String> counts = arguments[++i].Split(',');
+            particleCounts_.Clear();
+            for (unsigned j = 0; j < counts.Size(); ++j)
+            {
+                unsigned count = ToUInt(counts[j]);
+                if (!count)
+                    return false;
+                particleCounts_.Push(count);
+            }
+            if (particleCounts_.Empty())
+                return false;
+        }
+        else if (argument == "-steps" && hasValue)
+        {
+            numSteps_ = ToUInt(arguments[++i]);
+            if (!numSteps_)
+                return false;
+        }
+        else if (argument == "-kernel" && hasValue)
+        {
+            String name = arguments[++i].ToLower();
+            kernelLevel_ = MAX_PARTICLE_KERNEL_LEVELS;
+            for (unsigned j = 0; j < MAX_PARTICLE_KERNEL_LEVELS; ++j)
+            {
+                if (name == kernelLevelNames[j])
+                    kernelLevel_ = (ParticleKernelLevel2D)j;
+            }
+            if (kernelLevel_ == MAX_PARTICLE_KERNEL_LEVELS)
+                return false;
+            if (kernelLevel_ > GetSupportedParticleKernelLevel())
+            {
+                PrintLine(String("Kernels ") + kernelLevelNames[kernelLevel_] + " are not supported on this CPU", true);
+                return false;
+            }
+        }
+        else if (argument == "-verify")
+            verify_ = true;
+        else if (argument == "-seed" && hasValue)
+            randomSeed_ = ToUInt(arguments[++i]);
+        else if (argument == "-output" && hasValue)
+            outputFileName_ = arguments[++i];
+        else if (argument == "-help")
+            return false;
+        else
+        {
+            PrintLine("Unknown argument " + arguments[i], true);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}
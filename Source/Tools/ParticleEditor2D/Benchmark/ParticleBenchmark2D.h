@@ -0,0 +1,117 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Object.h"
+#include "ParticleKernels2D.h"
+#include "PerfCounters.h"
+
+namespace Urho3D
+{
+
+class SimulationHost;
+
+/// Benchmark workload: one effect stepped at one emitter type and particle count.
+struct BenchmarkWorkload2D
+{
+    /// Effect resource name.
+    String effectName_;
+    /// Emitter type.
+    int emitterType_;
+    /// Max particles.
+    unsigned maxParticles_;
+};
+
+/// Measured cost of a workload.
+struct BenchmarkResult2D
+{
+    /// Workload.
+    BenchmarkWorkload2D workload_;
+    /// Average live particles per measured step.
+    double averageParticles_;
+    /// Milliseconds per step.
+    double msPerStep_;
+    /// Nanoseconds per live particle per step.
+    double nsPerParticleStep_;
+    /// Heap allocations per step.
+    double allocationsPerStep_;
+    /// Heap bytes allocated per step.
+    double bytesPerStep_;
+    /// Availability of each hardware counter.
+    bool hasCounter_[MAX_PERF_COUNTERS];
+    /// Hardware counter values per live particle per step.
+    double countersPerParticleStep_[MAX_PERF_COUNTERS];
+};
+
+/// Particle simulation benchmark. Sweeps effects, emitter types and particle counts with a fixed seed and time step, so runs
+/// on the same machine and build are comparable, and reports the results as JSON.
+class ParticleBenchmark2D : public Object
+{
+    OBJECT(ParticleBenchmark2D)
+
+public:
+    /// Construct.
+    ParticleBenchmark2D(Context* context);
+    /// Destruct.
+    virtual ~ParticleBenchmark2D();
+
+    /// Parse arguments, run all workloads and write the report. Return process exit code.
+    int Run(const Vector<String>& arguments);
+    /// Run one workload. Return true if successful.
+    bool RunWorkload(const BenchmarkWorkload2D& workload, BenchmarkResult2D& result);
+    /// Step one workload through a scene emitter as the editor does, after warming up, and count the heap allocations of the
+    /// steps. Return true if successful.
+    bool VerifyWorkload(const BenchmarkWorkload2D& workload, unsigned long long& allocations);
+    /// Return results as JSON.
+    String GetReport() const;
+
+    /// Print command line usage.
+    static void PrintUsage();
+
+private:
+    /// Parse command line arguments. Return true if successful.
+    bool ParseArguments(const Vector<String>& arguments);
+
+    /// Headless engine.
+    SharedPtr<SimulationHost> host_;
+    /// Effect resource names.
+    Vector<String> effectNames_;
+    /// Particle counts.
+    PODVector<unsigned> particleCounts_;
+    /// Kernel level, MAX_PARTICLE_KERNEL_LEVELS to use the selected kernels.
+    ParticleKernelLevel2D kernelLevel_;
+    /// Random seed.
+    unsigned randomSeed_;
+    /// Fixed time step.
+    float timeStep_;
+    /// Measured steps per workload.
+    unsigned numSteps_;
+    /// Whether to verify that warmed up emitters do not allocate.
+    bool verify_;
+    /// Report file name, empty to print to standard output.
+    String outputFileName_;
+    /// Results.
+    Vector<BenchmarkResult2D> results_;
+};
+
+}
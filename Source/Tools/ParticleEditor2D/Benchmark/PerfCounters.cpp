@@ -0,0 +1,140 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "PerfCounters.h"
+
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Urho3D
+{
+
+static const char* perfCounterNames[] =
+{
+    "cycles",
+    "instructions",
+    "cacheReferences",
+    "cacheMisses",
+    "l1dReadMisses"
+};
+
+#ifdef __linux__
+/// Perf event type and config of each counter.
+static const unsigned perfEventTypes[] =
+{
+    PERF_TYPE_HARDWARE,
+    PERF_TYPE_HARDWARE,
+    PERF_TYPE_HARDWARE,
+    PERF_TYPE_HARDWARE,
+    PERF_TYPE_HW_CACHE
+};
+
+static const unsigned long long perfEventConfigs[] =
+{
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_REFERENCES,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+};
+
+/// Open a user space counter of the calling thread in disabled state. Return file descriptor or -1.
+static int OpenPerfEvent(unsigned type, unsigned long long config)
+{
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof attr);
+    attr.type = type;
+    attr.size = sizeof attr;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+PerfCounters::PerfCounters()
+{
+    for (unsigned i = 0; i < MAX_PERF_COUNTERS; ++i)
+    {
+#ifdef __linux__
+        fds_[i] = OpenPerfEvent(perfEventTypes[i], perfEventConfigs[i]);
+#else
+        fds_[i] = -1;
+#endif
+        values_[i] = 0;
+    }
+}
+
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+    for (unsigned i = 0; i < MAX_PERF_COUNTERS; ++i)
+    {
+        if (fds_[i] >= 0)
+            close(fds_[i]);
+    }
+#endif
+}
+
+void PerfCounters::Start()
+{
+#ifdef __linux__
+    for (unsigned i = 0; i < MAX_PERF_COUNTERS; ++i)
+    {
+        if (fds_[i] < 0)
+            continue;
+
+        ioctl(fds_[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(fds_[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+void PerfCounters::Stop()
+{
+#ifdef __linux__
+    for (unsigned i = 0; i < MAX_PERF_COUNTERS; ++i)
+    {
+        if (fds_[i] < 0)
+            continue;
+
+        ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fds_[i], &values_[i], sizeof values_[i]) != sizeof values_[i])
+            values_[i] = 0;
+    }
+#endif
+}
+
+const char* PerfCounters::GetName(PerfCounterType type)
+{
+    return perfCounterNames[type];
+}
+
+}
@@ -0,0 +1,74 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+namespace Urho3D
+{
+
+/// Hardware performance counter.
+enum PerfCounterType
+{
+    PCT_CYCLES = 0,
+    PCT_INSTRUCTIONS,
+    PCT_CACHEREFERENCES,
+    PCT_CACHEMISSES,
+    PCT_L1DREADMISSES,
+    MAX_PERF_COUNTERS
+};
+
+/// Hardware performance counters of the calling thread, read through perf events on Linux. Counters the kernel or the
+/// machine does not provide stay unavailable, and on other platforms none are.
+class PerfCounters
+{
+public:
+    /// Construct and open the counters.
+    PerfCounters();
+    /// Destruct and close the counters.
+    ~PerfCounters();
+
+    /// Reset and start counting.
+    void Start();
+    /// Stop counting and read the values.
+    void Stop();
+
+    /// Return whether a counter is available.
+    bool IsAvailable(PerfCounterType type) const { return fds_[type] >= 0; }
+    /// Return counted value since the last start.
+    unsigned long long GetValue(PerfCounterType type) const { return values_[type]; }
+
+    /// Return counter name.
+    static const char* GetName(PerfCounterType type);
+
+private:
+    /// Prevent copy construction.
+    PerfCounters(const PerfCounters& rhs);
+    /// Prevent assignment.
+    PerfCounters& operator = (const PerfCounters& rhs);
+
+    /// Counter file descriptors, negative if unavailable.
+    int fds_[MAX_PERF_COUNTERS];
+    /// Counted values.
+    unsigned long long values_[MAX_PERF_COUNTERS];
+};
+
+}
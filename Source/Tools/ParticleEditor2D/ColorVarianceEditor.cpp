@@ -22,6 +22,7 @@
 
 #include "FloatEditor.h"
 #include "ColorVarianceEditor.h"
+#include "ParticleEffectRanges2D.h"
 #include <QComboBox>
 #include <QGroupBox>
 
@@ -133,7 +134,9 @@ void ColorVarianceEditor::colorModeComboBoxIndexChanged(int index)
 FloatEditor* ColorVarianceEditor::CreateFloatEditor(const QString& text)
 {
     FloatEditor* editor = new FloatEditor(text, false);
-    editor->setRange(0.0f, 1.0f);
+    // Start and finish colors share one range
+    const ParticleEffectRange2D& range = GetParticleEffectRange(PEA_STARTCOLOR);
+    editor->setRange(range.min_, range.max_);
     connect(editor, SIGNAL(valueChanged(float)), this, SLOT(editorValueChanged()));
     return editor;
 }
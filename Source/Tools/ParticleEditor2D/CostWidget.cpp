@@ -0,0 +1,154 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "CostWidget.h"
+#include "ParticleEffect2D.h"
+#include "ParticleSimulator2D.h"
+#include "SimulatedParticleEmitter2D.h"
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+namespace Urho3D
+{
+
+/// Estimate table rows.
+enum CostRow
+{
+    CR_LIVEPARTICLES = 0,
+    CR_SPAWNRATE,
+    CR_PARTICLEAREA,
+    CR_FRAGMENTS,
+    CR_SCREENS,
+    CR_BLENDCOST,
+    CR_GPUMS,
+    CR_CPUMS,
+    MAX_COST_ROWS
+};
+
+CostWidget::CostWidget(Context* context) :
+    QWidget(),
+    ParticleEffectEditor(context)
+{
+    QVBoxLayout* vBoxLayout = new QVBoxLayout();
+    setLayout(vBoxLayout);
+
+    tableWidget_ = new QTableWidget(MAX_COST_ROWS, 1);
+    vBoxLayout->addWidget(tableWidget_, 1);
+
+    QStringList rowLabels;
+    rowLabels << tr("Live Particles") << tr("Spawn Rate (1/s)") << tr("Particle Area (px)") << tr("Fragments / Frame") <<
+        tr("Overdraw (screens)") << tr("Blend Cost") << tr("GPU Fill (ms)") << tr("Simulation (ms)");
+    tableWidget_->setVerticalHeaderLabels(rowLabels);
+    tableWidget_->setHorizontalHeaderLabels(QStringList() << tr("Estimate"));
+    tableWidget_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    tableWidget_->setSelectionMode(QAbstractItemView::NoSelection);
+    tableWidget_->horizontalHeader()->setResizeMode(QHeaderView::Stretch);
+
+    for (int row = 0; row < MAX_COST_ROWS; ++row)
+    {
+        QTableWidgetItem* item = new QTableWidgetItem();
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        tableWidget_->setItem(row, 0, item);
+    }
+
+    warningsLabel_ = new QLabel();
+    vBoxLayout->addWidget(warningsLabel_);
+    warningsLabel_->setWordWrap(true);
+
+    QHBoxLayout* hBoxLayout = new QHBoxLayout();
+    vBoxLayout->addLayout(hBoxLayout);
+
+    modelLabel_ = new QLabel();
+    hBoxLayout->addWidget(modelLabel_, 1);
+    modelLabel_->setWordWrap(true);
+
+    calibratePushButton_ = new QPushButton(tr("Calibrate"));
+    hBoxLayout->addWidget(calibratePushButton_);
+    connect(calibratePushButton_, SIGNAL(clicked(bool)), this, SLOT(HandleCalibratePushButtonClicked()));
+
+    // Estimates are closed form and cheap, so polling picks up attribute edits without hooking every editor
+    QTimer* timer = new QTimer(this);
+    connect(timer, SIGNAL(timeout()), this, SLOT(HandleRefreshTimeout()));
+    timer->start(250);
+}
+
+CostWidget::~CostWidget()
+{
+}
+
+void CostWidget::HandleCalibratePushButtonClicked()
+{
+    CalibrateParticleCostModel(context_, model_);
+    HandleRefreshTimeout();
+}
+
+void CostWidget::HandleRefreshTimeout()
+{
+    ParticleEffect2D* effect = GetEffect();
+    if (!effect || !isVisible())
+        return;
+
+    // The simulation rates are measured the first time the panel is shown
+    if (!model_.calibrated_)
+        CalibrateParticleCostModel(context_, model_);
+
+    ParticleCostEstimate2D estimate;
+    EstimateParticleEffectCost(effect, model_, estimate);
+
+    // Live particles also show the emitter's count, which the estimate should approach once the effect has warmed up
+    QString liveParticles = QString::number(estimate.liveParticles_, 'f', 0);
+    SimulatedParticleEmitter2D* emitter = GetEmitter();
+    if (emitter)
+        liveParticles = tr("%1 (now %2)").arg(liveParticles).arg(emitter->GetSimulator()->GetNumParticles());
+
+    tableWidget_->item(CR_LIVEPARTICLES, 0)->setText(liveParticles);
+    tableWidget_->item(CR_SPAWNRATE, 0)->setText(QString::number(estimate.spawnRate_, 'f', 1));
+    tableWidget_->item(CR_PARTICLEAREA, 0)->setText(QString::number(estimate.particleArea_, 'f', 0));
+    tableWidget_->item(CR_FRAGMENTS, 0)->setText(QString::number(estimate.fragments_, 'f', 0));
+    tableWidget_->item(CR_SCREENS, 0)->setText(QString::number(estimate.screens_, 'f', 2));
+    tableWidget_->item(CR_BLENDCOST, 0)->setText(QString::number(estimate.blendCost_, 'f', 1));
+    tableWidget_->item(CR_GPUMS, 0)->setText(QString::number(estimate.gpuMs_, 'f', 3));
+    tableWidget_->item(CR_CPUMS, 0)->setText(QString::number(estimate.cpuMs_, 'f', 3));
+
+    QStringList warnings;
+    for (unsigned i = 0; i < estimate.warnings_.Size(); ++i)
+        warnings << estimate.warnings_[i].CString();
+    warningsLabel_->setText(warnings.isEmpty() ? tr("Within budget") : tr("Over budget: %1").arg(warnings.join(", ")));
+    warningsLabel_->setStyleSheet(warnings.isEmpty() ? "" : "color: #e0a040");
+
+    modelLabel_->setText(tr("%1 %2 ns per gravity and radial particle step, %3 Mpixels/s fill, %4 pixel screen")
+        .arg(model_.calibrated_ ? tr("Measured") : tr("Assumed"))
+        .arg(model_.nsPerParticleStep_[0], 0, 'f', 1).arg(model_.nsPerParticleStep_[1], 0, 'f', 1)
+        .arg(model_.fragmentsPerMs_ * 0.001f, 0, 'f', 0).arg(model_.screenPixels_, 0, 'f', 0));
+}
+
+void CostWidget::HandleUpdateWidget()
+{
+    HandleRefreshTimeout();
+}
+
+}
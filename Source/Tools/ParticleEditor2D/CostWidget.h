@@ -0,0 +1,70 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "ParticleCostAnalyzer2D.h"
+#include "ParticleEffectEditor.h"
+#include <QWidget>
+
+class QLabel;
+class QPushButton;
+class QTableWidget;
+
+namespace Urho3D
+{
+
+/// Static cost estimate of the selected layer's effect, refreshed as its attributes change.
+class CostWidget : public QWidget, public ParticleEffectEditor
+{
+    Q_OBJECT
+    OBJECT(CostWidget)
+
+public:
+    /// Construct.
+    CostWidget(Context* context);
+    /// Destruct.
+    virtual ~CostWidget();
+
+private slots:
+    /// Handle calibrate button.
+    void HandleCalibratePushButtonClicked();
+    /// Handle refresh timer.
+    void HandleRefreshTimeout();
+
+private:
+    /// Handle update widget.
+    virtual void HandleUpdateWidget();
+
+    /// Estimate table.
+    QTableWidget* tableWidget_;
+    /// Budget warnings label.
+    QLabel* warningsLabel_;
+    /// Cost model label.
+    QLabel* modelLabel_;
+    /// Calibrate button.
+    QPushButton* calibratePushButton_;
+    /// Cost model.
+    ParticleCostModel2D model_;
+};
+
+}
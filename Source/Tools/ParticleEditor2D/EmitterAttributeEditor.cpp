@@ -21,13 +21,15 @@
 //
 
 #include "Context.h"
-#include "CoreEvents.h"
 #include "EmitterAttributeEditor.h"
 #include "FloatEditor.h"
 #include "IntEditor.h"
+#include "ParticleEditor.h"
 #include "ParticleEffect2D.h"
-#include "ParticleEmitter2D.h"
-#include "ResourceCache.h"
+#include "ParticleEffectChanges2D.h"
+#include "ParticleEffectRanges2D.h"
+#include "ParticleEffectSettings2D.h"
+#include "SimulatedParticleEmitter2D.h"
 #include "Texture2D.h"
 #include "ValueVarianceEditor.h"
 #include "Vector2Editor.h"
@@ -40,12 +42,17 @@
 
 namespace Urho3D
 {
+
+/// Longest prewarm time the editor offers in seconds.
+static const float MAX_PREWARM_TIME = 60.0f;
+
 EmitterAttributeEditor::EmitterAttributeEditor(Context* context) :
-    ParticleEffectEditor(context),
-    maxParticlesChanged_(false)
+    ParticleEffectEditor(context)
 {
     CreateMaxParticlesEditor();
     CreateDurationEditor();
+    CreateRandomSeedEditor();
+    CreatePrewarmEditor();
     
     vBoxLayout_->addSpacing(8);
 
@@ -58,14 +65,12 @@ EmitterAttributeEditor::EmitterAttributeEditor(Context* context) :
 
     vBoxLayout_->addSpacing(8);
 
-    angleEditor_ = CreateValueVarianceEditor(tr("Angle"), 0.0f, 360.0f);
+    angleEditor_ = CreateValueVarianceEditor(tr("Angle"), PEA_ANGLE);
 
     CreateGravityTypeEditor();
     CreateRadialTypeEditor();
 
     vBoxLayout_->addStretch(1);
-
-    SubscribeToEvent(E_POSTUPDATE, HANDLER(EmitterAttributeEditor, HandlePostUpdate));
 }
 
 EmitterAttributeEditor::~EmitterAttributeEditor()
@@ -77,7 +82,7 @@ void EmitterAttributeEditor::HandleMaxParticlesEditorValueChanged(int value)
     if (updatingWidget_)
         return;
 
-    maxParticlesChanged_ = true;
+    GetChanges().SetValue(PEA_MAXPARTICLES, value);
 }
 
 void EmitterAttributeEditor::HandleDurationEditorValueChanged(float value)
@@ -85,7 +90,33 @@ void EmitterAttributeEditor::HandleDurationEditorValueChanged(float value)
     if (updatingWidget_)
         return;
 
-    GetEffect()->SetDuration(value);
+    GetChanges().SetValue(PEA_DURATION, value);
+}
+
+void EmitterAttributeEditor::HandleRandomSeedEditorEditingFinished()
+{
+    if (updatingWidget_)
+        return;
+
+    // Seeds use all 32 bits, so text that does not parse as an unsigned int puts the current seed back
+    bool ok = false;
+    unsigned seed = randomSeedEditor_->text().toUInt(&ok);
+    if (!ok)
+    {
+        randomSeedEditor_->setText(QString::number(GetSettings().GetRandomSeed()));
+        return;
+    }
+
+    if (seed != GetSettings().GetRandomSeed())
+        GetChanges().SetRandomSeed(seed);
+}
+
+void EmitterAttributeEditor::HandlePrewarmEditorValueChanged(float value)
+{
+    if (updatingWidget_)
+        return;
+
+    GetChanges().SetPrewarmTime(value);
 }
 
 void EmitterAttributeEditor::HandleTexturePushButtonClicked()
@@ -100,15 +131,8 @@ void EmitterAttributeEditor::HandleTexturePushButtonClicked()
 
     fileName = fileName.right(fileName.length() - dataPath.length());
 
-    ResourceCache* cache = GetSubsystem<ResourceCache>();
-    Sprite2D* sprite = cache->GetResource<Sprite2D>(fileName.toLatin1().data());
-    if (!sprite)
-        return;
-
-    textureEditor_->setText(fileName);
-
-    GetEffect()->SetSprite(sprite);
-    GetEmitter()->SetSprite(sprite);
+    // The texture field updates when the sprite arrives
+    ParticleEditor::Get()->LoadSprite(fileName.toLatin1().data());
 }
 
 void EmitterAttributeEditor::HandleBlendModeEditorChanged(int index)
@@ -116,8 +140,7 @@ void EmitterAttributeEditor::HandleBlendModeEditorChanged(int index)
     if (updatingWidget_)
         return;
 
-    GetEffect()->SetBlendMode((BlendMode)index);
-    GetEmitter()->SetBlendMode((BlendMode)index);
+    GetChanges().SetBlendMode((BlendMode)index);
 }
 
 void EmitterAttributeEditor::HandleEmitterTypeEditorChanged(int index)
@@ -129,7 +152,7 @@ void EmitterAttributeEditor::HandleEmitterTypeEditorChanged(int index)
     if (updatingWidget_)
         return;
 
-    GetEffect()->SetEmitterType(emitterType);
+    GetChanges().SetEmitterType(emitterType);
 }
 
 void EmitterAttributeEditor::HandleSourcePositionVarianceEditorValueChanged(const Vector2& value)
@@ -137,7 +160,7 @@ void EmitterAttributeEditor::HandleSourcePositionVarianceEditorValueChanged(cons
     if (updatingWidget_)
         return;
 
-    GetEffect()->SetSourcePositionVariance(value);
+    GetChanges().SetValue(PEA_SOURCEPOSITIONVARIANCE, value);
 }
 
 void EmitterAttributeEditor::HandleGravityEditorValueChanged(const Vector2& value)
@@ -145,7 +168,7 @@ void EmitterAttributeEditor::HandleGravityEditorValueChanged(const Vector2& valu
     if (updatingWidget_)
         return;
 
-    GetEffect()->SetGravity(value);
+    GetChanges().SetValue(PEA_GRAVITY, value);
 }
 
 void EmitterAttributeEditor::HandleValueVarianceEditorValueChanged(float average, float variance)
@@ -153,46 +176,7 @@ void EmitterAttributeEditor::HandleValueVarianceEditorValueChanged(float average
     if (updatingWidget_)
         return;
 
-    QObject* s = sender();
-    ParticleEffect2D* effect = GetEffect();
-
-    if (s == speedEditor_)
-    {
-        effect->SetSpeed(speedEditor_->value());
-        effect->SetSpeedVariance(speedEditor_->variance());
-    }
-    else if (s == angleEditor_)
-    {
-        effect->SetAngle(angleEditor_->value());
-        effect->SetAngleVariance(angleEditor_->variance());
-    }
-    else if (s == radialAccelerationEditor_)
-    {
-        effect->SetRadialAcceleration(radialAccelerationEditor_->value());
-        effect->SetRadialAccelVariance(radialAccelerationEditor_->variance());
-
-    }
-    else if (s == tangentialAccelerationEditor_)
-    {
-        effect->SetTangentialAcceleration(tangentialAccelerationEditor_->value());
-        effect->SetTangentialAccelVariance(tangentialAccelerationEditor_->variance());
-    }
-    else if (s == maxRadiusEditor_)
-    {
-        effect->SetMaxRadius(maxRadiusEditor_->value());
-        effect->SetMaxRadiusVariance(maxRadiusEditor_->variance());
-
-    }
-    else if (s == minRadiusEditor_)
-    {
-        effect->SetMinRadius(minRadiusEditor_->value());
-        effect->SetMinRadiusVariance(minRadiusEditor_->variance());
-    }
-    else if (s == rotatePerSecondEditor_)
-    {
-        effect->SetRotatePerSecond(rotatePerSecondEditor_->value());
-        effect->SetRotatePerSecondVariance(rotatePerSecondEditor_->variance());
-    }
+    QueueValueVarianceChange(sender(), average, variance);
 }
 
 void EmitterAttributeEditor::HandleUpdateWidget()
@@ -201,6 +185,8 @@ void EmitterAttributeEditor::HandleUpdateWidget()
 
     maxParticlesEditor_->setValue(effect_->GetMaxParticles());
     durationEditor_->setValue(effect_->GetDuration());
+    randomSeedEditor_->setText(QString::number(GetSettings().GetRandomSeed()));
+    prewarmEditor_->setValue(GetSettings().GetPrewarmTime());
 
     Sprite2D* sprite = effect_->GetSprite();
     textureEditor_->setText(sprite ? sprite->GetName().CString() : "");
@@ -210,16 +196,9 @@ void EmitterAttributeEditor::HandleUpdateWidget()
     emitterTypeEditor_->setCurrentIndex((int)effect_->GetEmitterType());
 
     sourcePositionVarianceEditor_->setValue(effect_->GetSourcePositionVariance());
-    speedEditor_->setValue(effect_->GetSpeed(), effect_->GetSpeedVariance());
-    angleEditor_->setValue(effect_->GetAngle(), effect_->GetAngleVariance());
     gravityEditor_->setValue(effect_->GetGravity());
 
-    radialAccelerationEditor_->setValue(effect_->GetRadialAcceleration(), effect_->GetRadialAccelVariance());
-    tangentialAccelerationEditor_->setValue(effect_->GetTangentialAcceleration(), effect_->GetTangentialAccelVariance());
-
-    maxRadiusEditor_->setValue(effect_->GetMaxRadius(), effect_->GetMaxRadiusVariance());
-    minRadiusEditor_->setValue(effect_->GetMinRadius(), effect_->GetMinRadiusVariance());
-    rotatePerSecondEditor_->setValue(effect_->GetRotatePerSecond(), effect_->GetRotatePerSecondVariance());
+    UpdateValueVarianceEditors();
 }
 
 void EmitterAttributeEditor::CreateMaxParticlesEditor()
@@ -227,7 +206,8 @@ void EmitterAttributeEditor::CreateMaxParticlesEditor()
     maxParticlesEditor_ = new IntEditor(tr("MaxParticles"));
     vBoxLayout_->addLayout(maxParticlesEditor_);
     
-    maxParticlesEditor_->setRange(1, 2048);    
+    const ParticleEffectRange2D& range = GetParticleEffectRange(PEA_MAXPARTICLES);
+    maxParticlesEditor_->setRange((int)range.min_, (int)range.max_);
     connect(maxParticlesEditor_, SIGNAL(valueChanged(int)), this, SLOT(HandleMaxParticlesEditorValueChanged(int)));
 }
 
@@ -236,10 +216,31 @@ void EmitterAttributeEditor::CreateDurationEditor()
     durationEditor_ = new FloatEditor(tr("Duration"));
     vBoxLayout_->addLayout(durationEditor_);
     
-    durationEditor_->setRange(-1.0f, 100.0f);    
+    const ParticleEffectRange2D& range = GetParticleEffectRange(PEA_DURATION);
+    durationEditor_->setRange(range.min_, range.max_);
     connect(durationEditor_, SIGNAL(valueChanged(float)), this, SLOT(HandleDurationEditorValueChanged(float)));
 }
 
+void EmitterAttributeEditor::CreateRandomSeedEditor()
+{
+    QHBoxLayout* hBoxLayout = AddHBoxLayout();
+    hBoxLayout->addWidget(new QLabel(tr("RandomSeed")));
+
+    randomSeedEditor_ = new QLineEdit();
+    hBoxLayout->addWidget(randomSeedEditor_, 1);
+
+    connect(randomSeedEditor_, SIGNAL(editingFinished()), this, SLOT(HandleRandomSeedEditorEditingFinished()));
+}
+
+void EmitterAttributeEditor::CreatePrewarmEditor()
+{
+    prewarmEditor_ = new FloatEditor(tr("Prewarm"));
+    vBoxLayout_->addLayout(prewarmEditor_);
+
+    prewarmEditor_->setRange(0.0f, MAX_PREWARM_TIME);
+    connect(prewarmEditor_, SIGNAL(valueChanged(float)), this, SLOT(HandlePrewarmEditorValueChanged(float)));
+}
+
 void EmitterAttributeEditor::CreateTextureEditor()
 {
     QHBoxLayout* hBoxLayout = AddHBoxLayout();
@@ -303,28 +304,29 @@ void EmitterAttributeEditor::CreateGravityTypeEditor()
     sourcePositionVarianceEditor_ = new Vector2Editor(tr("SourcePositionVariance"));
     vBoxLayout_->addWidget(sourcePositionVarianceEditor_);
     
-    sourcePositionVarianceEditor_->setRange(Vector2::ZERO, Vector2::ONE * 1000.0f);    
+    const ParticleEffectRange2D& sourcePositionVarianceRange = GetParticleEffectRange(PEA_SOURCEPOSITIONVARIANCE);
+    sourcePositionVarianceEditor_->setRange(Vector2::ONE * sourcePositionVarianceRange.min_, Vector2::ONE * sourcePositionVarianceRange.max_);
     connect(sourcePositionVarianceEditor_, SIGNAL(valueChanged(const Vector2&)), this, SLOT(HandleSourcePositionVarianceEditorValueChanged(const Vector2&)));
 
-    speedEditor_ = CreateValueVarianceEditor(tr("Speed"), 0.0f, 2000.0f);
+    speedEditor_ = CreateValueVarianceEditor(tr("Speed"), PEA_SPEED);
 
     gravityEditor_ = new Vector2Editor(tr("Gravity"));
     vBoxLayout_->addWidget(gravityEditor_);
 
-    gravityEditor_->setRange(Vector2::ONE * -3000.0f, Vector2::ONE * 3000.0f);
+    const ParticleEffectRange2D& gravityRange = GetParticleEffectRange(PEA_GRAVITY);
+    gravityEditor_->setRange(Vector2::ONE * gravityRange.min_, Vector2::ONE * gravityRange.max_);
     connect(gravityEditor_, SIGNAL(valueChanged(const Vector2&)), this, SLOT(HandleGravityEditorValueChanged(const Vector2&)));
 
-    radialAccelerationEditor_ = CreateValueVarianceEditor(tr("Radial Acceleration"), -10000.0f, 10000.0f);
-    tangentialAccelerationEditor_ = CreateValueVarianceEditor(tr("Tangential AccelVariance"), -50000.0f, 50000.0f);
+    radialAccelerationEditor_ = CreateValueVarianceEditor(tr("Radial Acceleration"), PEA_RADIALACCELERATION);
+    tangentialAccelerationEditor_ = CreateValueVarianceEditor(tr("Tangential AccelVariance"), PEA_TANGENTIALACCELERATION);
 }
 
 void EmitterAttributeEditor::CreateRadialTypeEditor()
 {
-    maxRadiusEditor_ = CreateValueVarianceEditor(tr("MaxRadius"), 0.0f, 1000.0f);
-    minRadiusEditor_ = CreateValueVarianceEditor(tr("MinRadius"), 0.0f, 1000.0f);
+    maxRadiusEditor_ = CreateValueVarianceEditor(tr("MaxRadius"), PEA_MAXRADIUS);
+    minRadiusEditor_ = CreateValueVarianceEditor(tr("MinRadius"), PEA_MINRADIUS);
 
-    const float s = 2.0f;
-    rotatePerSecondEditor_ = CreateValueVarianceEditor(tr("RotatePerSecond"), -360.0f * s, 360.0f * s);
+    rotatePerSecondEditor_ = CreateValueVarianceEditor(tr("RotatePerSecond"), PEA_ROTATEPERSECOND);
 }
 
 void EmitterAttributeEditor::ShowGravityTypeEditor(bool visible)
@@ -344,26 +346,15 @@ void EmitterAttributeEditor::ShowRadialTypeEditor(bool visible)
     rotatePerSecondEditor_->setVisible(visible);
 }
 
-ValueVarianceEditor* EmitterAttributeEditor::CreateValueVarianceEditor(const QString& name, float min, float max)
+ValueVarianceEditor* EmitterAttributeEditor::CreateValueVarianceEditor(const QString& name, ParticleEffectAttribute2D attribute)
 {
     ValueVarianceEditor* editor = new ValueVarianceEditor(name);
     vBoxLayout_->addWidget(editor);
     
-    editor->setRange(min, max);    
+    AddValueVarianceEditor(editor, attribute);
     connect(editor, SIGNAL(valueChanged(float, float)), this, SLOT(HandleValueVarianceEditorValueChanged(float, float)));
 
     return editor;
 }
 
-void EmitterAttributeEditor::HandlePostUpdate(StringHash eventType, VariantMap& eventData)
-{
-    if (!maxParticlesChanged_)
-        return;
-
-    maxParticlesChanged_ = false;
-
-    GetEffect()->SetMaxParticles(maxParticlesEditor_->value());
-    GetEmitter()->SetMaxParticles(maxParticlesEditor_->value());
-}
-
 }
\ No newline at end of file
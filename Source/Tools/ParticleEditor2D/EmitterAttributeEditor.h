@@ -23,6 +23,7 @@
 #pragma once
 
 #include "ParticleEffectEditor.h"
+#include "ParticleEffectRanges2D.h"
 #include "ScrollAreaWidget.h"
 
 class QComboBox;
@@ -48,6 +49,8 @@ public:
 private slots:
     void HandleMaxParticlesEditorValueChanged(int value);
     void HandleDurationEditorValueChanged(float value);    
+    void HandleRandomSeedEditorEditingFinished();
+    void HandlePrewarmEditorValueChanged(float value);
     void HandleTexturePushButtonClicked();
     void HandleBlendModeEditorChanged(int index);
     
@@ -62,6 +65,8 @@ private:
 
     void CreateMaxParticlesEditor();
     void CreateDurationEditor();
+    void CreateRandomSeedEditor();
+    void CreatePrewarmEditor();
     void CreateTextureEditor();
     void CreateBlendModeEditor();
 
@@ -70,16 +75,16 @@ private:
     void CreateRadialTypeEditor();
     void ShowRadialTypeEditor(bool visible);
     void ShowGravityTypeEditor(bool visible);
-    ValueVarianceEditor* CreateValueVarianceEditor(const QString& name, float min, float max);
-
-    void HandlePostUpdate(StringHash eventType, VariantMap& eventData);
+    ValueVarianceEditor* CreateValueVarianceEditor(const QString& name, ParticleEffectAttribute2D attribute);
 
     /// Max particle editor.
     IntEditor* maxParticlesEditor_;
-    /// Is max particles changed.
-    bool maxParticlesChanged_;
     /// Duration editor.
     FloatEditor* durationEditor_;
+    /// Random seed editor.
+    QLineEdit* randomSeedEditor_;
+    /// Prewarm editor.
+    FloatEditor* prewarmEditor_;
     /// Texture editor.
     QLineEdit* textureEditor_;
     /// Blend mode editor.
@@ -0,0 +1,160 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#include "FloatEditor.h"
+#include "LayerWidget.h"
+#include "ParticleEditor.h"
+#include "Vector2Editor.h"
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QListWidget>
+#include <QPushButton>
+#include <QTimer>
+#include <QVBoxLayout>
+
+namespace Urho3D
+{
+
+LayerWidget::LayerWidget(Context* context) :
+    QWidget(),
+    ParticleEffectEditor(context)
+{
+    QVBoxLayout* vBoxLayout = new QVBoxLayout();
+    setLayout(vBoxLayout);
+
+    layerListWidget_ = new QListWidget();
+    vBoxLayout->addWidget(layerListWidget_, 1);
+    connect(layerListWidget_, SIGNAL(currentRowChanged(int)), this, SLOT(HandleLayerListWidgetCurrentRowChanged(int)));
+
+    QHBoxLayout* hBoxLayout = new QHBoxLayout();
+    vBoxLayout->addLayout(hBoxLayout);
+
+    QPushButton* addPushButton = new QPushButton(tr("Add ..."));
+    hBoxLayout->addWidget(addPushButton);
+    connect(addPushButton, SIGNAL(clicked(bool)), this, SLOT(HandleAddPushButtonClicked()));
+
+    removePushButton_ = new QPushButton(tr("Remove"));
+    hBoxLayout->addWidget(removePushButton_);
+    connect(removePushButton_, SIGNAL(clicked(bool)), this, SLOT(HandleRemovePushButtonClicked()));
+
+    QPushButton* restartPushButton = new QPushButton(tr("Restart"));
+    hBoxLayout->addWidget(restartPushButton);
+    connect(restartPushButton, SIGNAL(clicked(bool)), this, SLOT(HandleRestartPushButtonClicked()));
+
+    offsetEditor_ = new Vector2Editor(tr("Offset"));
+    vBoxLayout->addWidget(offsetEditor_);
+    offsetEditor_->setRange(Vector2(-1024.0f, -1024.0f), Vector2(1024.0f, 1024.0f));
+    connect(offsetEditor_, SIGNAL(valueChanged(const Vector2&)), this, SLOT(HandleOffsetEditorValueChanged(const Vector2&)));
+
+    delayEditor_ = new FloatEditor(tr("Delay"));
+    vBoxLayout->addLayout(delayEditor_);
+    delayEditor_->setRange(0.0f, 10.0f);
+    connect(delayEditor_, SIGNAL(valueChanged(float)), this, SLOT(HandleDelayEditorValueChanged(float)));
+
+    drawCallsLabel_ = new QLabel();
+    vBoxLayout->addWidget(drawCallsLabel_);
+
+    // Draw calls follow live particles, textures and blend modes, so they are polled like the profiler
+    QTimer* timer = new QTimer(this);
+    connect(timer, SIGNAL(timeout()), this, SLOT(HandleRefreshTimeout()));
+    timer->start(500);
+}
+
+LayerWidget::~LayerWidget()
+{
+}
+
+void LayerWidget::HandleLayerListWidgetCurrentRowChanged(int row)
+{
+    if (updatingWidget_ || row < 0)
+        return;
+
+    ParticleEditor::Get()->SelectLayer((unsigned)row);
+}
+
+void LayerWidget::HandleOffsetEditorValueChanged(const Vector2& value)
+{
+    if (updatingWidget_)
+        return;
+
+    ParticleEditor* editor = ParticleEditor::Get();
+    editor->SetLayerOffset(editor->GetSelectedLayer(), value);
+}
+
+void LayerWidget::HandleDelayEditorValueChanged(float value)
+{
+    if (updatingWidget_)
+        return;
+
+    ParticleEditor* editor = ParticleEditor::Get();
+    editor->SetLayerDelay(editor->GetSelectedLayer(), value);
+}
+
+void LayerWidget::HandleAddPushButtonClicked()
+{
+    QString fileName = QFileDialog::getOpenFileName(0, tr("Add layer"), "./Data/Urho2D/", "*.pex *.pexb");
+    if (fileName.isEmpty())
+        return;
+
+    // The list updates when the effect arrives
+    ParticleEditor::Get()->AddLayer(fileName.toLatin1().data());
+}
+
+void LayerWidget::HandleRemovePushButtonClicked()
+{
+    ParticleEditor* editor = ParticleEditor::Get();
+    editor->RemoveLayer(editor->GetSelectedLayer());
+}
+
+void LayerWidget::HandleRestartPushButtonClicked()
+{
+    ParticleEditor::Get()->Restart();
+}
+
+void LayerWidget::HandleRefreshTimeout()
+{
+    if (!isVisible())
+        return;
+
+    ParticleEditor* editor = ParticleEditor::Get();
+    drawCallsLabel_->setText(tr("%1 layers in %2 draw calls").arg(editor->GetNumLayers()).arg(editor->GetNumDrawCalls()));
+}
+
+void LayerWidget::HandleUpdateWidget()
+{
+    ParticleEditor* editor = ParticleEditor::Get();
+    unsigned numLayers = editor->GetNumLayers();
+
+    layerListWidget_->clear();
+    for (unsigned i = 0; i < numLayers; ++i)
+        layerListWidget_->addItem(editor->GetLayer(i).layer_.effectName_.CString());
+    layerListWidget_->setCurrentRow((int)editor->GetSelectedLayer());
+
+    const ParticleCompositeLayer2D& layer = editor->GetLayer(editor->GetSelectedLayer()).layer_;
+    offsetEditor_->setValue(layer.offset_);
+    delayEditor_->setValue(layer.delay_);
+    removePushButton_->setEnabled(numLayers > 1);
+
+    HandleRefreshTimeout();
+}
+
+}
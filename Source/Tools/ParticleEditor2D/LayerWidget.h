@@ -0,0 +1,81 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#pragma once
+
+#include "ParticleEffectEditor.h"
+#include <QWidget>
+
+class QLabel;
+class QListWidget;
+class QPushButton;
+
+namespace Urho3D
+{
+
+class FloatEditor;
+class Vector2Editor;
+
+/// Layer list of the open effect, with offset and start delay of the selected layer and the draw calls they take.
+class LayerWidget : public QWidget, public ParticleEffectEditor
+{
+    Q_OBJECT
+    OBJECT(LayerWidget)
+
+public:
+    /// Construct.
+    LayerWidget(Context* context);
+    /// Destruct.
+    virtual ~LayerWidget();
+
+private slots:
+    /// Handle layer selection.
+    void HandleLayerListWidgetCurrentRowChanged(int row);
+    /// Handle offset editor.
+    void HandleOffsetEditorValueChanged(const Vector2& value);
+    /// Handle delay editor.
+    void HandleDelayEditorValueChanged(float value);
+    /// Handle add button.
+    void HandleAddPushButtonClicked();
+    /// Handle remove button.
+    void HandleRemovePushButtonClicked();
+    /// Handle restart button.
+    void HandleRestartPushButtonClicked();
+    /// Handle refresh timer.
+    void HandleRefreshTimeout();
+
+private:
+    /// Handle update widget.
+    virtual void HandleUpdateWidget();
+
+    /// Layer list.
+    QListWidget* layerListWidget_;
+    /// Offset editor.
+    Vector2Editor* offsetEditor_;
+    /// Start delay editor.
+    FloatEditor* delayEditor_;
+    /// Remove button.
+    QPushButton* removePushButton_;
+    /// Draw call count label.
+    QLabel* drawCallsLabel_;
+};
+
+}
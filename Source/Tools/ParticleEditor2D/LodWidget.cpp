@@ -0,0 +1,256 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#include "IntEditor.h"
+#include "LodWidget.h"
+#include "ParticleEditor.h"
+#include "ParticleEffectSettings2D.h"
+#include "ParticleUpdater2D.h"
+#include "SimulatedParticleEmitter2D.h"
+#include <QComboBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+namespace Urho3D
+{
+
+/// Level table columns.
+enum LodColumn
+{
+    LC_THRESHOLD = 0,
+    LC_PARTICLES,
+    LC_SPAWNRATE,
+    LC_SIMPLIFIED,
+    MAX_LOD_COLUMNS
+};
+
+LodWidget::LodWidget(Context* context) :
+    QWidget(),
+    ParticleEffectEditor(context)
+{
+    QVBoxLayout* vBoxLayout = new QVBoxLayout();
+    setLayout(vBoxLayout);
+
+    QHBoxLayout* hBoxLayout = new QHBoxLayout();
+    vBoxLayout->addLayout(hBoxLayout);
+
+    hBoxLayout->addWidget(new QLabel(tr("Metric")));
+    metricComboBox_ = new QComboBox();
+    hBoxLayout->addWidget(metricComboBox_, 1);
+    metricComboBox_->addItem(tr("Distance (pixels)"));
+    metricComboBox_->addItem(tr("Screen size (view heights)"));
+    connect(metricComboBox_, SIGNAL(currentIndexChanged(int)), this, SLOT(HandleMetricComboBoxChanged(int)));
+
+    levelTableWidget_ = new QTableWidget(0, MAX_LOD_COLUMNS);
+    vBoxLayout->addWidget(levelTableWidget_, 1);
+
+    QStringList labels;
+    labels << tr("Threshold") << tr("Particles") << tr("Spawn Rate") << tr("Simplified");
+    levelTableWidget_->setHorizontalHeaderLabels(labels);
+    levelTableWidget_->setSelectionBehavior(QAbstractItemView::SelectRows);
+    levelTableWidget_->setSelectionMode(QAbstractItemView::SingleSelection);
+    levelTableWidget_->horizontalHeader()->setResizeMode(QHeaderView::Stretch);
+    connect(levelTableWidget_, SIGNAL(itemChanged(QTableWidgetItem*)), this, SLOT(HandleLevelTableWidgetItemChanged(QTableWidgetItem*)));
+
+    hBoxLayout = new QHBoxLayout();
+    vBoxLayout->addLayout(hBoxLayout);
+
+    QPushButton* addPushButton = new QPushButton(tr("Add Level"));
+    hBoxLayout->addWidget(addPushButton);
+    connect(addPushButton, SIGNAL(clicked(bool)), this, SLOT(HandleAddPushButtonClicked()));
+
+    QPushButton* removePushButton = new QPushButton(tr("Remove Level"));
+    hBoxLayout->addWidget(removePushButton);
+    connect(removePushButton, SIGNAL(clicked(bool)), this, SLOT(HandleRemovePushButtonClicked()));
+
+    // The budget belongs to the preview, not to the effect, so it is not saved
+    budgetEditor_ = new IntEditor(tr("Budget"));
+    vBoxLayout->addLayout(budgetEditor_);
+    budgetEditor_->setRange(0, 100000);
+    connect(budgetEditor_, SIGNAL(valueChanged(int)), this, SLOT(HandleBudgetEditorValueChanged(int)));
+
+    statusLabel_ = new QLabel();
+    vBoxLayout->addWidget(statusLabel_);
+
+    QTimer* timer = new QTimer(this);
+    connect(timer, SIGNAL(timeout()), this, SLOT(HandleRefreshTimeout()));
+    timer->start(500);
+}
+
+LodWidget::~LodWidget()
+{
+}
+
+void LodWidget::HandleMetricComboBoxChanged(int index)
+{
+    if (updatingWidget_)
+        return;
+
+    // Thresholds of one metric mean nothing in the other, so they are kept for the user to adjust
+    ParticleEffectLod2D lod = GetSettings().GetLod();
+    lod.SetMetric((ParticleLodMetric2D)index);
+    GetSettings().SetLod(lod);
+    if (GetEmitter())
+        GetEmitter()->SetLod(lod);
+
+    UpdateWidget();
+}
+
+void LodWidget::HandleLevelTableWidgetItemChanged(QTableWidgetItem* item)
+{
+    if (updatingWidget_)
+        return;
+
+    ApplyLevels();
+}
+
+void LodWidget::HandleAddPushButtonClicked()
+{
+    // Each added level halves the detail of the last one
+    ParticleEffectLod2D lod = GetSettings().GetLod();
+    PODVector<ParticleLodLevel2D> levels = lod.GetLevels();
+    if (levels.Size() >= MAX_PARTICLE_LOD_LEVELS)
+        return;
+
+    ParticleLodLevel2D level;
+    if (levels.Empty())
+        level.threshold_ = lod.GetMetric() == PLM_DISTANCE ? 500.0f : 0.25f;
+    else
+    {
+        const ParticleLodLevel2D& last = levels.Back();
+        level.threshold_ = lod.GetMetric() == PLM_DISTANCE ? last.threshold_ * 2.0f : last.threshold_ * 0.5f;
+        level.particleScale_ = last.particleScale_;
+        level.spawnScale_ = last.spawnScale_;
+        level.simplified_ = last.simplified_;
+    }
+    level.particleScale_ *= 0.5f;
+    level.spawnScale_ *= 0.5f;
+    levels.Push(level);
+
+    lod.SetLevels(levels);
+    GetSettings().SetLod(lod);
+    if (GetEmitter())
+        GetEmitter()->SetLod(lod);
+
+    UpdateWidget();
+}
+
+void LodWidget::HandleRemovePushButtonClicked()
+{
+    int row = levelTableWidget_->currentRow();
+    if (row < 0)
+        row = levelTableWidget_->rowCount() - 1;
+    if (row < 0)
+        return;
+
+    ApplyLevels(row);
+    UpdateWidget();
+}
+
+void LodWidget::HandleBudgetEditorValueChanged(int value)
+{
+    if (updatingWidget_)
+        return;
+
+    ParticleUpdater2D* updater = ParticleEditor::Get()->GetUpdater();
+    if (updater)
+        updater->SetParticleBudget((unsigned)value);
+}
+
+void LodWidget::HandleRefreshTimeout()
+{
+    ParticleUpdater2D* updater = ParticleEditor::Get()->GetUpdater();
+    SimulatedParticleEmitter2D* emitter = GetEmitter();
+    if (!updater || !emitter || !isVisible())
+        return;
+
+    QString status = tr("Level %1 of %2").arg(emitter->GetLodLevel()).arg(emitter->GetLod().GetNumLevels());
+    if (updater->GetParticleBudget())
+    {
+        status += tr(", budget scale %1 (%2 particles wanted)").arg(updater->GetBudgetScale(), 0, 'f', 2)
+            .arg(updater->GetParticleDemand());
+    }
+    statusLabel_->setText(status);
+}
+
+void LodWidget::HandleUpdateWidget()
+{
+    const ParticleEffectLod2D& lod = GetSettings().GetLod();
+    metricComboBox_->setCurrentIndex((int)lod.GetMetric());
+
+    const PODVector<ParticleLodLevel2D>& levels = lod.GetLevels();
+    levelTableWidget_->setRowCount((int)levels.Size());
+    for (unsigned i = 0; i < levels.Size(); ++i)
+    {
+        levelTableWidget_->setItem(i, LC_THRESHOLD, new QTableWidgetItem(QString::number(levels[i].threshold_)));
+        levelTableWidget_->setItem(i, LC_PARTICLES, new QTableWidgetItem(QString::number(levels[i].particleScale_)));
+        levelTableWidget_->setItem(i, LC_SPAWNRATE, new QTableWidgetItem(QString::number(levels[i].spawnScale_)));
+
+        QTableWidgetItem* simplifiedItem = new QTableWidgetItem();
+        simplifiedItem->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsUserCheckable);
+        simplifiedItem->setCheckState(levels[i].simplified_ ? Qt::Checked : Qt::Unchecked);
+        levelTableWidget_->setItem(i, LC_SIMPLIFIED, simplifiedItem);
+    }
+
+    ParticleUpdater2D* updater = ParticleEditor::Get()->GetUpdater();
+    if (updater)
+        budgetEditor_->setValue((int)updater->GetParticleBudget());
+
+    HandleRefreshTimeout();
+}
+
+void LodWidget::ApplyLevels(int skipRow)
+{
+    PODVector<ParticleLodLevel2D> levels;
+    for (int row = 0; row < levelTableWidget_->rowCount(); ++row)
+    {
+        if (row == skipRow)
+            continue;
+
+        QTableWidgetItem* thresholdItem = levelTableWidget_->item(row, LC_THRESHOLD);
+        QTableWidgetItem* particlesItem = levelTableWidget_->item(row, LC_PARTICLES);
+        QTableWidgetItem* spawnRateItem = levelTableWidget_->item(row, LC_SPAWNRATE);
+        QTableWidgetItem* simplifiedItem = levelTableWidget_->item(row, LC_SIMPLIFIED);
+        if (!thresholdItem || !particlesItem || !spawnRateItem || !simplifiedItem)
+            continue;
+
+        // Levels are clamped and sorted by the settings. The table shows the result on the next update
+        ParticleLodLevel2D level;
+        level.threshold_ = thresholdItem->text().toFloat();
+        level.particleScale_ = particlesItem->text().toFloat();
+        level.spawnScale_ = spawnRateItem->text().toFloat();
+        level.simplified_ = simplifiedItem->checkState() == Qt::Checked;
+        levels.Push(level);
+    }
+
+    ParticleEffectLod2D lod = GetSettings().GetLod();
+    lod.SetLevels(levels);
+    GetSettings().SetLod(lod);
+    if (GetEmitter())
+        GetEmitter()->SetLod(lod);
+}
+
+}
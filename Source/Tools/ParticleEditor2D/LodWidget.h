@@ -0,0 +1,79 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#pragma once
+
+#include "ParticleEffectEditor.h"
+#include <QWidget>
+
+class QComboBox;
+class QLabel;
+class QTableWidget;
+class QTableWidgetItem;
+
+namespace Urho3D
+{
+
+class IntEditor;
+
+/// LOD levels of the selected layer's effect and the particle budget of the preview.
+class LodWidget : public QWidget, public ParticleEffectEditor
+{
+    Q_OBJECT
+    OBJECT(LodWidget)
+
+public:
+    /// Construct.
+    LodWidget(Context* context);
+    /// Destruct.
+    virtual ~LodWidget();
+
+private slots:
+    /// Handle metric combo box.
+    void HandleMetricComboBoxChanged(int index);
+    /// Handle level table edits.
+    void HandleLevelTableWidgetItemChanged(QTableWidgetItem* item);
+    /// Handle add level button.
+    void HandleAddPushButtonClicked();
+    /// Handle remove level button.
+    void HandleRemovePushButtonClicked();
+    /// Handle budget editor.
+    void HandleBudgetEditorValueChanged(int value);
+    /// Handle refresh timer.
+    void HandleRefreshTimeout();
+
+private:
+    /// Handle update widget.
+    virtual void HandleUpdateWidget();
+    /// Set the levels in the table, except one row, on the effect settings and the emitter.
+    void ApplyLevels(int skipRow = -1);
+
+    /// Metric combo box.
+    QComboBox* metricComboBox_;
+    /// Level table.
+    QTableWidget* levelTableWidget_;
+    /// Particle budget editor.
+    IntEditor* budgetEditor_;
+    /// Current level and budget label.
+    QLabel* statusLabel_;
+};
+
+}
@@ -22,13 +22,25 @@
 
 #include "Application.h"
 #include "ParticleEditor.h"
+#include "ParticleEffectBatch2D.h"
+#include "ProcessUtils.h"
 #include <QFile>
 
 int Main()
 {
+    Urho3D::SharedPtr<Urho3D::Context> context(new Urho3D::Context());
+
+    // Batch mode runs headless and never creates the Qt application, so it works without a display
+    const Urho3D::Vector<Urho3D::String>& arguments = Urho3D::GetArguments();
+    if (!arguments.Empty() && arguments[0].ToLower() == "-batch")
+    {
+        Urho3D::OpenConsoleWindow();
+        Urho3D::SharedPtr<Urho3D::ParticleEffectBatch2D> batch(new Urho3D::ParticleEffectBatch2D(context));
+        return batch->Run(arguments);
+    }
+
     int argc = 0;
     char** argv = 0;
-    Urho3D::SharedPtr<Urho3D::Context> context(new Urho3D::Context());
     Urho3D::ParticleEditor editor(argc, argv, context);
 
     QFile file(":/qdarkstyle/style.qss");
@@ -20,13 +20,24 @@
 // THE SOFTWARE.
 //
 
+#include "BakeWidget.h"
 #include "Camera.h"
 #include "Context.h"
+#include "CostWidget.h"
 #include "EmitterAttributeEditor.h"
+#include "FileSystem.h"
+#include "LayerWidget.h"
+#include "LodWidget.h"
 #include "MainWindow.h"
+#include "OverdrawWidget.h"
+#include "PackDialog.h"
 #include "ParticleAttributeEditor.h"
 #include "ParticleEditor.h"
+#include "ParticleEffectLoader2D.h"
+#include "ParticleEffectPack2D.h"
+#include "ProfilerWidget.h"
 #include "Renderer.h"
+#include "TimelineWidget.h"
 #include "Zone.h"
 #include <QAction>
 #include <QColorDialog>
@@ -34,6 +45,8 @@
 #include <QFileDialog>
 #include <QMenu>
 #include <QMenuBar>
+#include <QProgressBar>
+#include <QStatusBar>
 #include <QToolBar>
 
 namespace Urho3D
@@ -43,7 +56,15 @@ MainWindow::MainWindow(Context* context) :
     QMainWindow(0, 0),
     ParticleEffectEditor(context),
     emitterAttributeEditor_(0),
-    particleAttributeEditor_(0)
+    particleAttributeEditor_(0),
+    layerWidget_(0),
+    lodWidget_(0),
+    costWidget_(0),
+    bakeWidget_(0),
+    timelineWidget_(0),
+    profilerWidget_(0),
+    overdrawWidget_(0),
+    loadProgressBar_(0)
 {
     setWindowIcon(QIcon(":/Images/Icon.png"));
     showMaximized();
@@ -62,6 +83,29 @@ void MainWindow::CreateWidgets()
     CreateMenuBar();
     CreateToolBar();
     CreateDockWidgets();
+    CreateStatusBar();
+}
+
+void MainWindow::UpdateLoadProgress()
+{
+    if (!loadProgressBar_)
+        return;
+
+    ParticleEffectLoader2D* loader = ParticleEditor::Get()->GetLoader();
+    if (!loader->IsLoading())
+    {
+        if (loadProgressBar_->isVisible())
+        {
+            loadProgressBar_->hide();
+            statusBar()->clearMessage();
+        }
+        return;
+    }
+
+    String fileName = GetFileNameAndExtension(loader->GetLoadingName());
+    statusBar()->showMessage(tr("Loading %1").arg(fileName.CString()));
+    loadProgressBar_->setValue((int)(loader->GetProgress() * 100.0f));
+    loadProgressBar_->show();
 }
 
 void MainWindow::HandleUpdateWidget()
@@ -70,6 +114,18 @@ void MainWindow::HandleUpdateWidget()
         emitterAttributeEditor_->UpdateWidget();
     if (particleAttributeEditor_)
         particleAttributeEditor_->UpdateWidget();
+    if (layerWidget_)
+        layerWidget_->UpdateWidget();
+    if (lodWidget_)
+        lodWidget_->UpdateWidget();
+    if (costWidget_)
+        costWidget_->UpdateWidget();
+    if (bakeWidget_)
+        bakeWidget_->UpdateWidget();
+    if (timelineWidget_)
+        timelineWidget_->UpdateWidget();
+    if (overdrawWidget_)
+        overdrawWidget_->UpdateWidget();
 }
 
 void MainWindow::CreateActions()
@@ -90,10 +146,31 @@ void MainWindow::CreateActions()
     saveAsAction_->setShortcut(QKeySequence::fromString("Ctrl+Shift+S"));
     connect(saveAsAction_, SIGNAL(triggered(bool)), this, SLOT(HandleSaveAsAction()));
 
+    exportAction_ = new QAction(tr("Export Binary ..."), this);
+    exportAction_->setShortcut(QKeySequence::fromString("Ctrl+Shift+E"));
+    connect(exportAction_, SIGNAL(triggered(bool)), this, SLOT(HandleExportAction()));
+
+    buildAtlasAction_ = new QAction(tr("Build Atlas ..."), this);
+    connect(buildAtlasAction_, SIGNAL(triggered(bool)), this, SLOT(HandleBuildAtlasAction()));
+
+    buildPackAction_ = new QAction(tr("Build Pack ..."), this);
+    connect(buildPackAction_, SIGNAL(triggered(bool)), this, SLOT(HandleBuildPackAction()));
+
+    openPackAction_ = new QAction(tr("Open Pack ..."), this);
+    connect(openPackAction_, SIGNAL(triggered(bool)), this, SLOT(HandleOpenPackAction()));
+
     exitAction_ = new QAction(tr("Exit"), this);
     exitAction_->setShortcut(QKeySequence::fromString("Alt+F4"));
     connect(exitAction_, SIGNAL(triggered(bool)), this, SLOT(close()));
 
+    undoAction_ = new QAction(tr("Undo"), this);
+    undoAction_->setShortcut(QKeySequence::fromString("Ctrl+Z"));
+    connect(undoAction_, SIGNAL(triggered(bool)), this, SLOT(HandleUndoAction()));
+
+    redoAction_ = new QAction(tr("Redo"), this);
+    redoAction_->setShortcut(QKeySequence::fromString("Ctrl+Y"));
+    connect(redoAction_, SIGNAL(triggered(bool)), this, SLOT(HandleRedoAction()));
+
     zoomInAction_ = new QAction(QIcon(":/Images/ZoomIn.png"), tr("Zoom In"), this);
     zoomInAction_->setShortcut(QKeySequence::fromString("Ctrl++"));
     connect(zoomInAction_, SIGNAL(triggered(bool)), this, SLOT(HandleZoomAction()));
@@ -129,11 +206,20 @@ void MainWindow::CreateMenuBar()
     fileMenu_->addAction(openAction_);
     fileMenu_->addAction(saveAction_);
     fileMenu_->addAction(saveAsAction_);
+    fileMenu_->addAction(exportAction_);
+    fileMenu_->addAction(buildAtlasAction_);
+    fileMenu_->addAction(buildPackAction_);
+    fileMenu_->addAction(openPackAction_);
 
     fileMenu_->addSeparator();
     
     fileMenu_->addAction(exitAction_);
 
+    editMenu_ = menuBar()->addMenu(tr("&Edit"));
+
+    editMenu_->addAction(undoAction_);
+    editMenu_->addAction(redoAction_);
+
     viewMenu_ = menuBar()->addMenu(tr("&View"));
 
     viewMenu_->addAction(zoomInAction_);
@@ -184,6 +270,89 @@ void MainWindow::CreateDockWidgets()
     QAction* paToggleViewAction = paDockWidget->toggleViewAction();
     viewMenu_->addAction(paToggleViewAction);
     paToggleViewAction->setShortcut(QKeySequence::fromString("Ctrl+P"));
+
+    layerWidget_ = new LayerWidget(context_);
+
+    QDockWidget* lyDockWidget = new QDockWidget(tr("Layers"));
+    addDockWidget(Qt::LeftDockWidgetArea, lyDockWidget);
+    lyDockWidget->setWidget(layerWidget_);
+
+    QAction* lyToggleViewAction = lyDockWidget->toggleViewAction();
+    viewMenu_->addAction(lyToggleViewAction);
+    lyToggleViewAction->setShortcut(QKeySequence::fromString("Ctrl+L"));
+
+    lodWidget_ = new LodWidget(context_);
+
+    QDockWidget* ldDockWidget = new QDockWidget(tr("LOD"));
+    addDockWidget(Qt::RightDockWidgetArea, ldDockWidget);
+    ldDockWidget->setWidget(lodWidget_);
+    ldDockWidget->hide();
+
+    QAction* ldToggleViewAction = ldDockWidget->toggleViewAction();
+    viewMenu_->addAction(ldToggleViewAction);
+    ldToggleViewAction->setShortcut(QKeySequence::fromString("Ctrl+Shift+L"));
+
+    costWidget_ = new CostWidget(context_);
+
+    QDockWidget* csDockWidget = new QDockWidget(tr("Cost"));
+    addDockWidget(Qt::RightDockWidgetArea, csDockWidget);
+    csDockWidget->setWidget(costWidget_);
+
+    QAction* csToggleViewAction = csDockWidget->toggleViewAction();
+    viewMenu_->addAction(csToggleViewAction);
+    csToggleViewAction->setShortcut(QKeySequence::fromString("Ctrl+Shift+C"));
+
+    timelineWidget_ = new TimelineWidget(context_);
+
+    QDockWidget* tlDockWidget = new QDockWidget(tr("Timeline"));
+    addDockWidget(Qt::BottomDockWidgetArea, tlDockWidget);
+    tlDockWidget->setWidget(timelineWidget_);
+
+    QAction* tlToggleViewAction = tlDockWidget->toggleViewAction();
+    viewMenu_->addAction(tlToggleViewAction);
+    tlToggleViewAction->setShortcut(QKeySequence::fromString("Ctrl+T"));
+
+    bakeWidget_ = new BakeWidget(context_);
+
+    QDockWidget* bkDockWidget = new QDockWidget(tr("Bake"));
+    addDockWidget(Qt::BottomDockWidgetArea, bkDockWidget);
+    bkDockWidget->setWidget(bakeWidget_);
+    bkDockWidget->hide();
+
+    QAction* bkToggleViewAction = bkDockWidget->toggleViewAction();
+    viewMenu_->addAction(bkToggleViewAction);
+    bkToggleViewAction->setShortcut(QKeySequence::fromString("Ctrl+Shift+B"));
+
+    profilerWidget_ = new ProfilerWidget(context_);
+
+    QDockWidget* pfDockWidget = new QDockWidget(tr("Profiler"));
+    addDockWidget(Qt::BottomDockWidgetArea, pfDockWidget);
+    pfDockWidget->setWidget(profilerWidget_);
+    pfDockWidget->hide();
+
+    QAction* pfToggleViewAction = pfDockWidget->toggleViewAction();
+    viewMenu_->addAction(pfToggleViewAction);
+    pfToggleViewAction->setShortcut(QKeySequence::fromString("Ctrl+Shift+P"));
+
+    overdrawWidget_ = new OverdrawWidget(context_);
+
+    QDockWidget* odDockWidget = new QDockWidget(tr("Overdraw"));
+    addDockWidget(Qt::BottomDockWidgetArea, odDockWidget);
+    odDockWidget->setWidget(overdrawWidget_);
+    odDockWidget->hide();
+
+    QAction* odToggleViewAction = odDockWidget->toggleViewAction();
+    viewMenu_->addAction(odToggleViewAction);
+    odToggleViewAction->setShortcut(QKeySequence::fromString("Ctrl+Shift+O"));
+}
+
+void MainWindow::CreateStatusBar()
+{
+    loadProgressBar_ = new QProgressBar();
+    loadProgressBar_->setRange(0, 100);
+    loadProgressBar_->setMaximumWidth(160);
+    loadProgressBar_->hide();
+    statusBar()->addPermanentWidget(loadProgressBar_);
 }
 
 void MainWindow::HandleNewAction()
@@ -193,7 +362,7 @@ void MainWindow::HandleNewAction()
 
 void MainWindow::HandleOpenAction()
 {
-    QString fileName = QFileDialog::getOpenFileName(0, tr("Open particle"), "./Data/Urho2D/", "*.pex");
+    QString fileName = QFileDialog::getOpenFileName(0, tr("Open particle"), "./Data/Urho2D/", "*.pex *.pexb *.pexc");
     if (fileName.isEmpty())
         return;
 
@@ -202,22 +371,106 @@ void MainWindow::HandleOpenAction()
 
 void MainWindow::HandleSaveAction()
 {
-    const String& fileName = ParticleEditor::Get()->GetFileName();
-    if (fileName.Empty())
+    // Layers added to a plain effect only fit in a composite
+    ParticleEditor* editor = ParticleEditor::Get();
+    const String& fileName = editor->GetFileName();
+    if (fileName.Empty() || (editor->GetNumLayers() > 1 && !IsParticleComposite(fileName)))
         HandleSaveAsAction();
     else
-        ParticleEditor::Get()->Save(fileName);
+        editor->Save(fileName);
 }
 
 void MainWindow::HandleSaveAsAction()
 {
-    QString fileName = QFileDialog::getSaveFileName(0, tr("Open particle"), "./Data/Urho2D/", "*.pex");
+    QString fileName = QFileDialog::getSaveFileName(0, tr("Open particle"), "./Data/Urho2D/", "*.pex;;*.pexb;;*.pexc");
     if (fileName.isEmpty())
         return;
 
     ParticleEditor::Get()->Save(fileName.toLatin1().data());
 }
 
+void MainWindow::HandleExportAction()
+{
+    QString fileName = QFileDialog::getSaveFileName(0, tr("Export binary particle"), "./Data/Urho2D/", "*.pexb");
+    if (fileName.isEmpty())
+        return;
+
+    ParticleEditor::Get()->Export(fileName.toLatin1().data());
+}
+
+void MainWindow::HandleBuildAtlasAction()
+{
+    QStringList fileNames = QFileDialog::getOpenFileNames(0, tr("Particles to pack"), "./Data/Urho2D/", "*.pex *.pexb");
+    if (fileNames.isEmpty())
+        return;
+
+    QString pathName = QFileDialog::getExistingDirectory(0, tr("Atlas output directory"), "./Data/Urho2D/");
+    if (pathName.isEmpty())
+        return;
+
+    Vector<String> effectFileNames;
+    for (int i = 0; i < fileNames.size(); ++i)
+        effectFileNames.Push(fileNames[i].toLatin1().data());
+
+    unsigned numAtlases = ParticleEditor::Get()->BuildAtlas(effectFileNames, pathName.toLatin1().data());
+    if (numAtlases)
+        statusBar()->showMessage(tr("Packed %1 particles into %2 atlases").arg(fileNames.size()).arg(numAtlases), 5000);
+    else
+        statusBar()->showMessage(tr("Build atlas failed, see the log for details"), 5000);
+}
+
+void MainWindow::HandleBuildPackAction()
+{
+    QStringList fileNames = QFileDialog::getOpenFileNames(0, tr("Particles to pack"), "./Data/Urho2D/", "*.pex *.pexb");
+    if (fileNames.isEmpty())
+        return;
+
+    QString packFileName = QFileDialog::getSaveFileName(0, tr("Pack file"), "./Data/Urho2D/", "*.pexpack");
+    if (packFileName.isEmpty())
+        return;
+
+    Vector<String> effectFileNames;
+    for (int i = 0; i < fileNames.size(); ++i)
+        effectFileNames.Push(fileNames[i].toLatin1().data());
+
+    // The built pack is loaded, so its entries can be browsed right away
+    unsigned numEntries = ParticleEditor::Get()->BuildPack(effectFileNames, packFileName.toLatin1().data());
+    if (numEntries)
+        statusBar()->showMessage(tr("Packed %1 of %2 particles").arg(numEntries).arg(fileNames.size()), 5000);
+    else
+        statusBar()->showMessage(tr("Build pack failed, see the log for details"), 5000);
+}
+
+void MainWindow::HandleOpenPackAction()
+{
+    QString fileName = QFileDialog::getOpenFileName(0, tr("Open pack"), "./Data/Urho2D/", "*.pexpack");
+    if (fileName.isEmpty())
+        return;
+
+    ParticleEditor* editor = ParticleEditor::Get();
+    if (!editor->OpenPack(fileName.toLatin1().data()))
+    {
+        statusBar()->showMessage(tr("Open pack failed, see the log for details"), 5000);
+        return;
+    }
+
+    PackDialog dialog(editor->GetPack(), this);
+    if (dialog.exec() != QDialog::Accepted || dialog.GetSelectedEntry() < 0)
+        return;
+
+    editor->OpenPackEntry(dialog.GetSelectedEntry());
+}
+
+void MainWindow::HandleUndoAction()
+{
+    ParticleEditor::Get()->Undo();
+}
+
+void MainWindow::HandleRedoAction()
+{
+    ParticleEditor::Get()->Redo();
+}
+
 void MainWindow::HandleZoomAction()
 {
     Camera* camera = ParticleEditor::Get()->GetCamera();
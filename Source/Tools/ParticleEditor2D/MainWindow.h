@@ -31,13 +31,21 @@
 class QAction;
 class QActionGroup;
 class QMenu;
+class QProgressBar;
 
 namespace Urho3D
 {
 
+class BakeWidget;
+class CostWidget;
 class EmitterAttributeEditor;
+class LayerWidget;
+class LodWidget;
+class OverdrawWidget;
 class ParticleAttributeEditor;
+class ProfilerWidget;
 class ScrollAreaWidget;
+class TimelineWidget;
 
 /// Editor main window class.
 class MainWindow : public QMainWindow, public ParticleEffectEditor
@@ -51,6 +59,8 @@ public:
     
     /// Create widgets.
     void CreateWidgets();
+    /// Show progress of background loading in the status bar.
+    void UpdateLoadProgress();
 
 private:
     /// Handle update widget.
@@ -64,6 +74,8 @@ private:
     void CreateToolBar();
     /// Create dock widgets.
     void CreateDockWidgets();
+    /// Create status bar.
+    void CreateStatusBar();
 
 private slots:
     /// Handle new action.
@@ -74,6 +86,18 @@ private slots:
     void HandleSaveAction();
     /// Handle save as action.
     void HandleSaveAsAction();
+    /// Handle export action.
+    void HandleExportAction();
+    /// Handle build atlas action.
+    void HandleBuildAtlasAction();
+    /// Handle build pack action.
+    void HandleBuildPackAction();
+    /// Handle open pack action.
+    void HandleOpenPackAction();
+    /// Handle undo action.
+    void HandleUndoAction();
+    /// Handle redo action.
+    void HandleRedoAction();
     /// Handle zoom action.
     void HandleZoomAction();
     /// Handle background action.
@@ -88,8 +112,20 @@ private:
     QAction* saveAction_;
     /// Save action.
     QAction* saveAsAction_;
+    /// Export action.
+    QAction* exportAction_;
+    /// Build atlas action.
+    QAction* buildAtlasAction_;
+    /// Build pack action.
+    QAction* buildPackAction_;
+    /// Open pack action.
+    QAction* openPackAction_;
     /// Exit action.
     QAction* exitAction_;
+    /// Undo action.
+    QAction* undoAction_;
+    /// Redo action.
+    QAction* redoAction_;
     /// Zoom in action.
     QAction* zoomInAction_;
     /// Zoom out action.
@@ -100,6 +136,8 @@ private:
     QAction* backgroundAction_;
     /// File menu.
     QMenu* fileMenu_;
+    /// Edit menu.
+    QMenu* editMenu_;
     /// View menu.
     QMenu* viewMenu_;
     /// Tool bar.
@@ -108,6 +146,22 @@ private:
     EmitterAttributeEditor* emitterAttributeEditor_;
     /// Inspector window.
     ParticleAttributeEditor* particleAttributeEditor_;
+    /// Layer window.
+    LayerWidget* layerWidget_;
+    /// LOD window.
+    LodWidget* lodWidget_;
+    /// Cost window.
+    CostWidget* costWidget_;
+    /// Bake window.
+    BakeWidget* bakeWidget_;
+    /// Timeline window.
+    TimelineWidget* timelineWidget_;
+    /// Profiler window.
+    ProfilerWidget* profilerWidget_;
+    /// Overdraw window.
+    OverdrawWidget* overdrawWidget_;
+    /// Load progress bar.
+    QProgressBar* loadProgressBar_;
 };
 
 }
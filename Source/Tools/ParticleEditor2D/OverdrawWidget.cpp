@@ -0,0 +1,138 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Graphics.h"
+#include "OverdrawWidget.h"
+#include "ParticleEditor.h"
+#include "ParticleOverdraw2D.h"
+#include <QCheckBox>
+#include <QLabel>
+#include <QPainter>
+#include <QPixmap>
+#include <QTimer>
+#include <QVBoxLayout>
+
+namespace Urho3D
+{
+
+/// Histogram width in pixels.
+static const int HISTOGRAM_WIDTH = 256;
+/// Histogram height in pixels, including the bin labels.
+static const int HISTOGRAM_HEIGHT = 112;
+/// Height of the bin labels in pixels.
+static const int HISTOGRAM_LABEL_HEIGHT = 16;
+
+OverdrawWidget::OverdrawWidget(Context* context) :
+    QWidget(),
+    ParticleEffectEditor(context)
+{
+    QVBoxLayout* vBoxLayout = new QVBoxLayout();
+    setLayout(vBoxLayout);
+
+    heatmapCheckBox_ = new QCheckBox(tr("Show heatmap"));
+    vBoxLayout->addWidget(heatmapCheckBox_);
+    connect(heatmapCheckBox_, SIGNAL(toggled(bool)), this, SLOT(HandleHeatmapCheckBoxToggled(bool)));
+
+    histogramLabel_ = new QLabel();
+    vBoxLayout->addWidget(histogramLabel_);
+    histogramLabel_->setFixedSize(HISTOGRAM_WIDTH, HISTOGRAM_HEIGHT);
+
+    statusLabel_ = new QLabel();
+    vBoxLayout->addWidget(statusLabel_);
+    statusLabel_->setWordWrap(true);
+
+    vBoxLayout->addStretch(1);
+
+    QTimer* timer = new QTimer(this);
+    connect(timer, SIGNAL(timeout()), this, SLOT(HandleRefreshTimeout()));
+    timer->start(250);
+}
+
+OverdrawWidget::~OverdrawWidget()
+{
+}
+
+void OverdrawWidget::HandleHeatmapCheckBoxToggled(bool checked)
+{
+    if (updatingWidget_)
+        return;
+
+    ParticleEditor::Get()->SetOverdrawView(checked);
+}
+
+void OverdrawWidget::HandleRefreshTimeout()
+{
+    if (!isVisible())
+        return;
+
+    ParticleEditor* editor = ParticleEditor::Get();
+    ParticleOverdraw2D* overdraw = editor->GetOverdraw();
+    if (!editor->IsOverdrawView() || !overdraw)
+    {
+        histogramLabel_->clear();
+        statusLabel_->setText(tr("Show the heatmap to measure overdraw"));
+        return;
+    }
+
+    const PODVector<unsigned>& histogram = overdraw->GetHistogram();
+    unsigned maxPixels = 1;
+    for (unsigned i = 0; i < histogram.Size(); ++i)
+        maxPixels = Max(maxPixels, histogram[i]);
+
+    QPixmap pixmap(HISTOGRAM_WIDTH, HISTOGRAM_HEIGHT);
+    pixmap.fill(palette().color(QPalette::Base));
+
+    // One bar per bin, scaled to the fullest one. The last bin holds everything filled that often or more
+    QPainter painter(&pixmap);
+    int barWidth = HISTOGRAM_WIDTH / MAX_OVERDRAW_BINS;
+    int barHeight = HISTOGRAM_HEIGHT - HISTOGRAM_LABEL_HEIGHT;
+    for (unsigned i = 0; i < histogram.Size(); ++i)
+    {
+        int height = (int)((float)histogram[i] / maxPixels * barHeight + 0.5f);
+        painter.fillRect(i * barWidth + 1, barHeight - height, barWidth - 2, height, palette().color(QPalette::Highlight));
+
+        if (i % 3 == 0 || i + 1 == histogram.Size())
+        {
+            QString label = i + 1 == histogram.Size() ? QString("%1+").arg(i + 1) : QString::number(i + 1);
+            painter.drawText(i * barWidth - barWidth, barHeight, barWidth * 3, HISTOGRAM_LABEL_HEIGHT, Qt::AlignCenter, label);
+        }
+    }
+    painter.end();
+    histogramLabel_->setPixmap(pixmap);
+
+    Graphics* graphics = GetSubsystem<Graphics>();
+    float screenPixels = (float)Max(graphics->GetWidth() * graphics->GetHeight(), 1);
+    statusLabel_->setText(tr("%1 fragments (%2 screens), %3 pixels covered, %4x mean and %5x peak overdraw")
+        .arg(overdraw->GetNumFragments())
+        .arg(overdraw->GetNumFragments() / screenPixels, 0, 'f', 2)
+        .arg(overdraw->GetNumCoveredPixels())
+        .arg(overdraw->GetMeanOverdraw(), 0, 'f', 1)
+        .arg(overdraw->GetMaxOverdraw()));
+}
+
+void OverdrawWidget::HandleUpdateWidget()
+{
+    heatmapCheckBox_->setChecked(ParticleEditor::Get()->IsOverdrawView());
+    HandleRefreshTimeout();
+}
+
+}
@@ -0,0 +1,64 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "ParticleEffectEditor.h"
+#include <QWidget>
+
+class QCheckBox;
+class QLabel;
+
+namespace Urho3D
+{
+
+/// Overdraw heatmap switch, histogram of how many times pixels are filled and fragment counters of the selected layer.
+class OverdrawWidget : public QWidget, public ParticleEffectEditor
+{
+    Q_OBJECT
+    OBJECT(OverdrawWidget)
+
+public:
+    /// Construct.
+    OverdrawWidget(Context* context);
+    /// Destruct.
+    virtual ~OverdrawWidget();
+
+private slots:
+    /// Handle heatmap check box.
+    void HandleHeatmapCheckBoxToggled(bool checked);
+    /// Handle refresh timer.
+    void HandleRefreshTimeout();
+
+private:
+    /// Handle update widget.
+    virtual void HandleUpdateWidget();
+
+    /// Heatmap check box.
+    QCheckBox* heatmapCheckBox_;
+    /// Histogram label.
+    QLabel* histogramLabel_;
+    /// Fragment counters label.
+    QLabel* statusLabel_;
+};
+
+}
@@ -0,0 +1,115 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "MathDefs.h"
+#include "PackDialog.h"
+#include "ParticleEffectPack2D.h"
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+namespace Urho3D
+{
+
+PackDialog::PackDialog(ParticleEffectPack2D* pack, QWidget* parent) :
+    QDialog(parent),
+    pack_(pack)
+{
+    setWindowTitle(tr("Open Pack Entry"));
+    resize(480, 400);
+
+    QVBoxLayout* vBoxLayout = new QVBoxLayout();
+    setLayout(vBoxLayout);
+
+    filterLineEdit_ = new QLineEdit();
+    filterLineEdit_->setPlaceholderText(tr("Filter"));
+    vBoxLayout->addWidget(filterLineEdit_);
+    connect(filterLineEdit_, SIGNAL(textChanged(const QString&)), this, SLOT(HandleFilterLineEditTextChanged(const QString&)));
+
+    unsigned numEntries = pack_->GetNumEntries();
+    entryTableWidget_ = new QTableWidget(numEntries, 2);
+    vBoxLayout->addWidget(entryTableWidget_, 1);
+
+    QStringList labels;
+    labels << tr("Effect") << tr("Texture");
+    entryTableWidget_->setHorizontalHeaderLabels(labels);
+    entryTableWidget_->setSelectionBehavior(QAbstractItemView::SelectRows);
+    entryTableWidget_->setSelectionMode(QAbstractItemView::SingleSelection);
+    entryTableWidget_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    entryTableWidget_->horizontalHeader()->setResizeMode(QHeaderView::Stretch);
+    connect(entryTableWidget_, SIGNAL(cellDoubleClicked(int, int)), this, SLOT(accept()));
+
+    // Rows are in pack order, so a row is an entry index
+    for (unsigned i = 0; i < numEntries; ++i)
+    {
+        entryTableWidget_->setItem(i, 0, new QTableWidgetItem(pack_->GetEntryName(i).CString()));
+        entryTableWidget_->setItem(i, 1, new QTableWidgetItem(pack_->GetEntryTextureName(i).CString()));
+    }
+    if (numEntries)
+        entryTableWidget_->selectRow(0);
+
+    statusLabel_ = new QLabel(tr("%1 entries, %2 KB").arg(numEntries).arg((pack_->GetDataSize() + 1023) / 1024));
+    vBoxLayout->addWidget(statusLabel_);
+
+    QDialogButtonBox* buttonBox = new QDialogButtonBox(QDialogButtonBox::Open | QDialogButtonBox::Cancel);
+    vBoxLayout->addWidget(buttonBox);
+    connect(buttonBox, SIGNAL(accepted()), this, SLOT(accept()));
+    connect(buttonBox, SIGNAL(rejected()), this, SLOT(reject()));
+}
+
+PackDialog::~PackDialog()
+{
+}
+
+int PackDialog::GetSelectedEntry() const
+{
+    QList<QTableWidgetItem*> items = entryTableWidget_->selectedItems();
+    if (items.isEmpty() || entryTableWidget_->isRowHidden(items[0]->row()))
+        return -1;
+
+    return items[0]->row();
+}
+
+void PackDialog::HandleFilterLineEditTextChanged(const QString& text)
+{
+    // A full name goes through the pack index, anything else filters the rows by substring
+    unsigned index = pack_->Find(text.toLatin1().data());
+    for (int i = 0; i < entryTableWidget_->rowCount(); ++i)
+    {
+        bool visible = index != M_MAX_UNSIGNED ? i == (int)index :
+            entryTableWidget_->item(i, 0)->text().contains(text, Qt::CaseInsensitive);
+        entryTableWidget_->setRowHidden(i, !visible);
+    }
+
+    if (index != M_MAX_UNSIGNED)
+    {
+        entryTableWidget_->selectRow(index);
+        statusLabel_->setText(tr("Found entry %1").arg(index));
+    }
+    else
+        statusLabel_->setText(tr("%1 entries, %2 KB").arg(pack_->GetNumEntries()).arg((pack_->GetDataSize() + 1023) / 1024));
+}
+
+}
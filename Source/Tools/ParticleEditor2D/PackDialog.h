@@ -0,0 +1,65 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <QDialog>
+
+class QLabel;
+class QLineEdit;
+class QTableWidget;
+
+namespace Urho3D
+{
+
+class ParticleEffectPack2D;
+
+/// Entries of a particle effect pack to pick one to open.
+class PackDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    /// Construct.
+    PackDialog(ParticleEffectPack2D* pack, QWidget* parent = 0);
+    /// Destruct.
+    virtual ~PackDialog();
+
+    /// Return index of the selected entry, or -1 if none.
+    int GetSelectedEntry() const;
+
+private slots:
+    /// Handle filter edits.
+    void HandleFilterLineEditTextChanged(const QString& text);
+
+private:
+    /// Pack.
+    ParticleEffectPack2D* pack_;
+    /// Name filter.
+    QLineEdit* filterLineEdit_;
+    /// Entry table.
+    QTableWidget* entryTableWidget_;
+    /// Entry count and lookup result label.
+    QLabel* statusLabel_;
+};
+
+}
@@ -23,6 +23,7 @@
 #include "ColorVarianceEditor.h"
 #include "ParticleAttributeEditor.h"
 #include "ParticleEffect2D.h"
+#include "ParticleEffectChanges2D.h"
 #include "ValueVarianceEditor.h"
 #include <QVBoxLayout>
 
@@ -31,13 +32,13 @@ namespace Urho3D
 ParticleAttributeEditor::ParticleAttributeEditor(Context* context) :
     ParticleEffectEditor(context)
 {
-    particleLifeSpanEditor_ = CreateValueVarianceEditor(tr("Life Span"), 0.01f, 10.0f);
+    particleLifeSpanEditor_ = CreateValueVarianceEditor(tr("Life Span"), PEA_PARTICLELIFESPAN);
     
-    startSizeEditor_ = CreateValueVarianceEditor(tr("Start Size"), 0.0f, 100.0f);
-    finishSizeEditor_ = CreateValueVarianceEditor(tr("Finish Size"), 0.0f, 100.0f);
+    startSizeEditor_ = CreateValueVarianceEditor(tr("Start Size"), PEA_STARTPARTICLESIZE);
+    finishSizeEditor_ = CreateValueVarianceEditor(tr("Finish Size"), PEA_FINISHPARTICLESIZE);
     
-    startRotationEditor_ = CreateValueVarianceEditor(tr("Start Rotation"), 0.0f, 360.0f);
-    finishRotationEditor_ = CreateValueVarianceEditor(tr("Finish Rotation"), 0.0f, 360.0f);
+    startRotationEditor_ = CreateValueVarianceEditor(tr("Start Rotation"), PEA_ROTATIONSTART);
+    finishRotationEditor_ = CreateValueVarianceEditor(tr("Finish Rotation"), PEA_ROTATIONEND);
 
     startColorEditor_ = new ColorVarianceEditor(tr("Start Color"));
     vBoxLayout_->addWidget(startColorEditor_);
@@ -59,33 +60,7 @@ void ParticleAttributeEditor::HanldeValueVarianceEditorValueChanged(float averag
     if (updatingWidget_)
         return;
 
-    ParticleEffect2D* effect = GetEffect();
-    QObject* s = sender();
-    if (s == particleLifeSpanEditor_)
-    {
-        effect->SetParticleLifeSpan(average);
-        effect->SetParticleLifespanVariance(variance);
-    }
-    else if (s == startSizeEditor_)
-    {
-        effect->SetStartParticleSize(average);
-        effect->SetStartParticleSizeVariance(variance);
-    }
-    else if (s == finishSizeEditor_)
-    {
-        effect->SetFinishParticleSize(average);
-        effect->SetFinishParticleSizeVariance(variance);
-    }
-    else if (s == startRotationEditor_)
-    {
-        effect->SetRotationStart(average);
-        effect->SetRotationStartVariance(variance);
-    }
-    else if (s == finishRotationEditor_)
-    {
-        effect->SetRotationEnd(average);
-        effect->SetRotationEndVariance(variance);
-    }
+    QueueValueVarianceChange(sender(), average, variance);
 }
 
 
@@ -93,13 +68,7 @@ void ParticleAttributeEditor::HandleUpdateWidget()
 {
     ParticleEffect2D* effect = GetEffect();
 
-    particleLifeSpanEditor_->setValue(effect->GetParticleLifeSpan(), effect->GetParticleLifespanVariance());
-
-    startSizeEditor_->setValue(effect->GetStartParticleSize(), effect->GetStartParticleSizeVariance());
-    finishSizeEditor_->setValue(effect->GetFinishParticleSize(), effect->GetFinishParticleSizeVariance());
-    
-    startRotationEditor_->setValue(effect->GetRotationStart(), effect->GetRotationStartVariance());
-    finishRotationEditor_->setValue(effect->GetRotationEnd(), effect->GetRotationEndVariance());
+    UpdateValueVarianceEditors();
 
     const Color& startColor = effect->GetStartColor();
     const Color& startColorVariance = effect->GetStartColorVariance();
@@ -110,10 +79,10 @@ void ParticleAttributeEditor::HandleUpdateWidget()
     finishColorEditor_->setValue(finishColor, finishColorVariance);
 }
 
-ValueVarianceEditor* ParticleAttributeEditor::CreateValueVarianceEditor(const QString& name, float min, float max)
+ValueVarianceEditor* ParticleAttributeEditor::CreateValueVarianceEditor(const QString& name, ParticleEffectAttribute2D attribute)
 {
     ValueVarianceEditor* editor = new ValueVarianceEditor(name);
-    editor->setRange(min, max);
+    AddValueVarianceEditor(editor, attribute);
     vBoxLayout_->addWidget(editor);
     connect(editor, SIGNAL(valueChanged(float, float)), this, SLOT(HanldeValueVarianceEditorValueChanged(float, float)));
     return editor;
@@ -124,9 +93,8 @@ void ParticleAttributeEditor::HandleStartColorEditorValueChanged(const Color& av
 {
     if (updatingWidget_)
         return;
-    ParticleEffect2D* effect = GetEffect();
-    effect->SetStartColor(average);
-    effect->SetStartColorVariance(variance);
+
+    GetChanges().SetValue(PEA_STARTCOLOR, average, variance);
 }
 
 void ParticleAttributeEditor::HandleFinishColorEditorValueChanged(const Color& average, const Color& variance)
@@ -134,8 +102,6 @@ void ParticleAttributeEditor::HandleFinishColorEditorValueChanged(const Color& a
     if (updatingWidget_)
         return;
 
-    ParticleEffect2D* effect_ = GetEffect();
-    effect_->SetFinishColor(average);
-    effect_->SetFinishColorVariance(variance);
+    GetChanges().SetValue(PEA_FINISHCOLOR, average, variance);
 }
 }
\ No newline at end of file
@@ -23,6 +23,7 @@
 #pragma once
 
 #include "ParticleEffectEditor.h"
+#include "ParticleEffectRanges2D.h"
 #include "ScrollAreaWidget.h"
 
 namespace Urho3D
@@ -48,7 +49,7 @@ private:
     /// Handle update widget.
     virtual void HandleUpdateWidget();
     /// Create value variance editor.
-    ValueVarianceEditor* CreateValueVarianceEditor(const QString& name, float min, float max);
+    ValueVarianceEditor* CreateValueVarianceEditor(const QString& name, ParticleEffectAttribute2D attribute);
 
     /// Particle life span editor.
     ValueVarianceEditor* particleLifeSpanEditor_;
@@ -20,6 +20,7 @@
 // THE SOFTWARE.
 //
 
+#include "BakedParticleEmitter2D.h"
 #include "Camera.h"
 #include "Console.h"
 #include "Context.h"
@@ -27,35 +28,82 @@
 #include "DebugHud.h"
 #include "DebugRenderer.h"
 #include "Engine.h"
+#include "File.h"
+#include "FileSystem.h"
 #include "Graphics.h"
 #include "Input.h"
 #include "InputEvents.h"
 #include "Log.h"
 #include "MainWindow.h"
 #include "Octree.h"
+#include "ParticleAtlasBuilder2D.h"
+#include "ParticleBake2D.h"
+#include "ParticleComposite2D.h"
 #include "ParticleEditor.h"
 #include "ParticleEffect2D.h"
-#include "ParticleEmitter2D.h"
+#include "ParticleEffectBinary2D.h"
+#include "ParticleEffectLoader2D.h"
+#include "ParticleEffectPack2D.h"
+#include "ParticleEffectWatcher2D.h"
+#include "ParticleOverdraw2D.h"
+#include "ParticleSimulator2D.h"
+#include "ParticleUpdater2D.h"
+#include "PhaseProfiler2D.h"
 #include "ProcessUtils.h"
 #include "Renderer.h"
 #include "ResourceCache.h"
 #include "Scene.h"
+#include "SimulatedParticleEmitter2D.h"
+#include "Sprite2D.h"
+#include "StaticSprite2D.h"
+#include "Texture2D.h"
+#include "Timer.h"
+#include "VectorBuffer.h"
 #include "Viewport.h"
 #include "XMLFile.h"
+#include <QEvent>
 #include <QFile>
 #include <QTimer>
 
 namespace Urho3D
 {
 
+/// Simulation time step.
+static const float SIMULATION_TIME_STEP = 1.0f / 60.0f;
+/// Interval between drawn frames in nanoseconds.
+static const long long FRAME_INTERVAL = 16666667;
+/// Number of frames drawn after an event.
+static const unsigned WAKE_FRAMES = 30;
+/// Interval between file watch checks in milliseconds.
+static const int WATCH_INTERVAL = 100;
+/// Shortest timeline in seconds.
+static const float MIN_TIMELINE_LENGTH = 1.0f;
+/// Drawable layer of the overdraw heatmap. Effect layers are ordered within layer 0.
+static const int OVERDRAW_LAYER = 1;
+
 ParticleEditor::ParticleEditor(int argc, char** argv, Context* context) :
     QApplication(argc, argv),
     Object(context),
     engine_(new Engine(context_)),
     scene_(new Scene(context_)),
-    mainWindow_(new MainWindow(context_))
+    mainWindow_(new MainWindow(context_)),
+    selectedLayer_(0),
+    bakePreview_(false),
+    overdrawView_(false),
+    loader_(new ParticleEffectLoader2D(context_)),
+    addLoadId_(0),
+    watcher_(new ParticleEffectWatcher2D(context_)),
+    timer_(0),
+    watchTimer_(0),
+    wakeFrames_(0),
+    scheduledTime_(0)
 {
+    // Edits and settings always have a layer to go to, even before the first effect is loaded
+    layers_.Resize(1);
+
+    SubscribeToEvent(E_BEGINFRAME, HANDLER(ParticleEditor, HandleBeginFrame));
     SubscribeToEvent(E_UPDATE, HANDLER(ParticleEditor, HandleUpdate));
+    SubscribeToEvent(E_POSTUPDATE, HANDLER(ParticleEditor, HandlePostUpdate));
     SubscribeToEvent(E_KEYDOWN, HANDLER(ParticleEditor, HandleKeyDown));
     SubscribeToEvent(E_MOUSEWHEEL, HANDLER(ParticleEditor, HandleMouseWheel));
     SubscribeToEvent(E_RENDERUPDATE, HANDLER(ParticleEditor, HandleRenderUpdate));
@@ -75,6 +123,11 @@ int ParticleEditor::Run()
     if (!engine_->Initialize(engineParameters))
         return -1;
 
+    ParticleUpdater2D::RegisterObject(context_);
+    SimulatedParticleEmitter2D::RegisterObject(context_);
+    BakedParticleEmitter2D::RegisterObject(context_);
+    context_->RegisterSubsystem(new PhaseProfiler2D(context_));
+
     CreateScene();
     CreateConsole();
     CreateDebugHud();
@@ -83,61 +136,159 @@ int ParticleEditor::Run()
     
     New();
 
-    QTimer timer;
-    connect(&timer, SIGNAL(timeout()), this, SLOT(OnTimeout()));
-    timer.start(16);
+    // Frames are scheduled one at a time, and only while something is moving or the user is interacting
+    timer_ = new QTimer(this);
+    timer_->setSingleShot(true);
+    connect(timer_, SIGNAL(timeout()), this, SLOT(OnTimeout()));
+    installEventFilter(this);
+    RequestFrame();
+
+    // File changes are polled on their own timer, so they are noticed while no frames are drawn
+    watchTimer_ = new QTimer(this);
+    connect(watchTimer_, SIGNAL(timeout()), this, SLOT(OnWatchTimeout()));
+    watchTimer_->start(WATCH_INTERVAL);
 
     return QApplication::exec();
 }
 
 void ParticleEditor::New()
 {
-    Open("Urho2D/fire.pex");
-
-    fileName_.Clear();
+    BeginOpen("Urho2D/fire.pex", String::EMPTY);
 }
 
 void ParticleEditor::Open(const String& fileName)
 {
-    if (particleNode_)
-    {
-        particleNode_->Remove();
-        particleNode_ = 0;
-    }
+    BeginOpen(fileName, fileName);
+}
 
-    ResourceCache* cache = GetSubsystem<ResourceCache>();
-    ParticleEffect2D* particleEffect = cache->GetResource<ParticleEffect2D>(fileName);
+void ParticleEditor::Save(const String& fileName)
+{
+    ParticleEffect2D* particleEffect = GetEffect();
     if (!particleEffect)
+        return;
+
+    ApplyChanges();
+
+    if (IsParticleComposite(fileName))
     {
-        LOGERROR("Open particle effect failed " + fileName);
+        if (SaveComposite(fileName))
+        {
+            fileName_ = fileName;
+            WatchFiles();
+        }
         return;
     }
 
-    fileName_ = fileName;
-
-    particleNode_ = scene_->CreateChild("ParticleEmitter2D");
-    ParticleEmitter2D* particleEmitter = particleNode_->CreateComponent<ParticleEmitter2D>();
-    particleEmitter->SetEffect(particleEffect);
+    ParticleEditorLayer& layer = layers_[selectedLayer_];
+    if (!SaveEffect(particleEffect, layer.settings_, fileName, IsParticleEffectBinary(fileName)))
+        return;
 
-    mainWindow_->UpdateWidget();
+    // A layer saved on its own keeps its place in the composite
+    layer.fileName_ = fileName;
+    if (layers_.Size() == 1)
+        fileName_ = fileName;
+    WatchFiles();
 }
 
-void ParticleEditor::Save(const String& fileName)
+bool ParticleEditor::Export(const String& fileName)
 {
     ParticleEffect2D* particleEffect = GetEffect();
     if (!particleEffect)
-        return;
+        return false;
+
+    ApplyChanges();
 
+    return SaveEffect(particleEffect, layers_[selectedLayer_].settings_, fileName, true);
+}
+
+unsigned ParticleEditor::BuildAtlas(const Vector<String>& fileNames, const String& pathName)
+{
+    String atlasPath = AddTrailingSlash(GetInternalPath(pathName));
+
+    // Effects without a texture are left out
+    SharedPtr<ParticleAtlasBuilder2D> builder(new ParticleAtlasBuilder2D(context_));
+    Vector<String> packedNames;
+    for (unsigned i = 0; i < fileNames.Size(); ++i)
+    {
+        if (builder->AddEffect(GetInternalPath(fileNames[i])))
+            packedNames.Push(GetFileNameAndExtension(fileNames[i]));
+    }
+
+    if (packedNames.Empty() || !builder->Build(atlasPath, "ParticleAtlas") || !builder->WriteEffects(atlasPath))
+        return 0;
+
+    // Preview the packed copy of the open effect, or of the first one
+    String previewName = packedNames[0];
+    if (packedNames.Contains(GetFileNameAndExtension(fileName_)))
+        previewName = GetFileNameAndExtension(fileName_);
+    Open(atlasPath + previewName);
+
+    return builder->GetNumAtlases();
+}
+
+unsigned ParticleEditor::BuildPack(const Vector<String>& fileNames, const String& packFileName)
+{
+    String packName = GetInternalPath(packFileName);
+    Vector<String> effectNames;
+    for (unsigned i = 0; i < fileNames.Size(); ++i)
+        effectNames.Push(GetInternalPath(fileNames[i]));
+
+    // Files that fail are logged and left out of the pack
+    Vector<String> errors;
     File file(context_);
-    if (!file.Open(fileName, FILE_WRITE))
+    if (!file.Open(packName, FILE_WRITE) || !BuildParticleEffectPack(context_, effectNames, GetPath(packName), file, &errors))
     {
-        LOGERROR("Open file failed " + fileName);
-        return;
+        LOGERROR("Build particle effect pack failed " + packName);
+        return 0;
+    }
+    file.Close();
+
+    for (unsigned i = 0; i < errors.Size(); ++i)
+        LOGERROR(errors[i]);
+
+    if (!OpenPack(packName))
+        return 0;
+
+    return pack_->GetNumEntries();
+}
+
+bool ParticleEditor::OpenPack(const String& fileName)
+{
+    SharedPtr<ParticleEffectPack2D> pack(new ParticleEffectPack2D());
+    if (!pack->Load(context_, fileName))
+    {
+        LOGERROR("Open particle effect pack failed " + fileName);
+        return false;
     }
 
-    particleEffect->Save(file);
+    pack_ = pack;
+    return true;
+}
+
+bool ParticleEditor::OpenPackEntry(unsigned index)
+{
+    if (!pack_ || index >= pack_->GetNumEntries())
+        return false;
+
+    // The entry is read straight from the mapped pack, so it loads in place together with its sprite
+    ParticleEditorLayer layer;
+    SharedPtr<ParticleEffect2D> effect = pack_->LoadEffect(context_, index, &layer.settings_);
+    if (!effect)
+        return false;
+
+    CancelOpen();
+    loader_->Cancel(addLoadId_);
+    addLoadId_ = 0;
 
-    fileName_ = fileName;
+    layer.layer_.effectName_ = GetFileNameAndExtension(effect->GetName());
+
+    loadLayers_.Push(layer);
+    loadEffects_.Push(effect);
+    loadIds_.Push(0);
+    loadFileName_.Clear();
+    SetLoadedLayers();
+
+    return true;
 }
 
 Camera* ParticleEditor::GetCamera() const
@@ -145,19 +296,87 @@ Camera* ParticleEditor::GetCamera() const
     return cameraNode_->GetComponent<Camera>();
 }
 
+ParticleUpdater2D* ParticleEditor::GetUpdater() const
+{
+    return scene_->GetComponent<ParticleUpdater2D>();
+}
+
+BakedParticleEmitter2D* ParticleEditor::GetBakedEmitter() const
+{
+    return bakeNode_ ? bakeNode_->GetComponent<BakedParticleEmitter2D>() : 0;
+}
+
+void ParticleEditor::Undo()
+{
+    if (!GetEmitter())
+        return;
+
+    // Pending edits become the entry to undo
+    ApplyChanges();
+    if (layers_[selectedLayer_].history_.Undo(GetEmitter(), layers_[selectedLayer_].settings_))
+    {
+        mainWindow_->UpdateWidget();
+        RequestFrame();
+    }
+}
+
+void ParticleEditor::Redo()
+{
+    if (!GetEmitter())
+        return;
+
+    ApplyChanges();
+    if (layers_[selectedLayer_].history_.Redo(GetEmitter(), layers_[selectedLayer_].settings_))
+    {
+        mainWindow_->UpdateWidget();
+        RequestFrame();
+    }
+}
+
 ParticleEffect2D* ParticleEditor::GetEffect() const
 {
-    ParticleEmitter2D* emitter = GetEmitter();
+    SimulatedParticleEmitter2D* emitter = GetEmitter();
     if (!emitter)
         return 0;
 
     return emitter->GetEffect();
 }
 
+SimulatedParticleEmitter2D* ParticleEditor::GetEmitter() const
+{
+    return GetEmitter(selectedLayer_);
+}
 
-ParticleEmitter2D* ParticleEditor::GetEmitter() const
+SimulatedParticleEmitter2D* ParticleEditor::GetEmitter(unsigned index) const
 {
-    return particleNode_->GetComponent<ParticleEmitter2D>();
+    if (index >= layers_.Size() || !layers_[index].node_)
+        return 0;
+
+    return layers_[index].node_->GetComponent<SimulatedParticleEmitter2D>();
+}
+
+unsigned ParticleEditor::GetNumDrawCalls() const
+{
+    // Layers without particles write no vertices, so they do not split the batch
+    unsigned numDrawCalls = 0;
+    Texture2D* lastTexture = 0;
+    BlendMode lastBlendMode = MAX_BLENDMODES;
+    for (unsigned i = 0; i < layers_.Size(); ++i)
+    {
+        SimulatedParticleEmitter2D* emitter = GetEmitter(i);
+        if (!emitter || !emitter->GetSprite() || !emitter->GetSimulator()->GetNumParticles())
+            continue;
+
+        Texture2D* texture = emitter->GetSprite()->GetTexture();
+        BlendMode blendMode = emitter->GetBlendMode();
+        if (!numDrawCalls || texture != lastTexture || blendMode != lastBlendMode)
+            ++numDrawCalls;
+
+        lastTexture = texture;
+        lastBlendMode = blendMode;
+    }
+
+    return numDrawCalls;
 }
 
 
@@ -166,10 +385,374 @@ ParticleEditor* ParticleEditor::Get()
     return qobject_cast<ParticleEditor*>(qApp);
 }
 
+void ParticleEditor::RequestFrame()
+{
+    wakeFrames_ = WAKE_FRAMES;
+    if (timer_ && !timer_->isActive())
+    {
+        scheduledTime_ = PhaseProfiler2D::GetTime();
+        timer_->start(0);
+    }
+}
+
+void ParticleEditor::LoadSprite(const String& name)
+{
+    ParticleEditorLayer& layer = layers_[selectedLayer_];
+    loader_->Cancel(layer.spriteLoadId_);
+    layer.spriteLoadId_ = loader_->LoadSprite(name);
+    if (!layer.spriteLoadId_)
+        LOGERROR("Load sprite failed " + name);
+
+    RequestFrame();
+}
+
+void ParticleEditor::AddLayer(const String& fileName)
+{
+    loader_->Cancel(addLoadId_);
+    addLoadId_ = loader_->LoadEffect(fileName);
+    if (!addLoadId_)
+    {
+        LOGERROR("Add layer failed " + fileName);
+        return;
+    }
+
+    mainWindow_->UpdateLoadProgress();
+    RequestFrame();
+}
+
+void ParticleEditor::RemoveLayer(unsigned index)
+{
+    if (index >= layers_.Size() || layers_.Size() == 1)
+        return;
+
+    // Pending edits belong to the selected layer, which may be the one removed
+    ApplyChanges();
+    changes_.Clear();
+
+    ParticleEditorLayer& layer = layers_[index];
+    loader_->Cancel(layer.spriteLoadId_);
+    if (layer.node_)
+        layer.node_->Remove();
+    layers_.Erase(index);
+
+    if (selectedLayer_ >= index && selectedLayer_ > 0)
+        --selectedLayer_;
+
+    UpdateDrawOrder();
+    WatchFiles();
+    mainWindow_->UpdateWidget();
+    RequestFrame();
+}
+
+void ParticleEditor::SelectLayer(unsigned index)
+{
+    if (index >= layers_.Size() || index == selectedLayer_)
+        return;
+
+    // Edits made so far reach the layer they were made on
+    ApplyChanges();
+    changes_.Clear();
+    layers_[selectedLayer_].history_.EndMerge();
+
+    selectedLayer_ = index;
+    WatchFiles();
+    mainWindow_->UpdateWidget();
+    RequestFrame();
+}
+
+void ParticleEditor::SetLayerOffset(unsigned index, const Vector2& offset)
+{
+    if (index >= layers_.Size())
+        return;
+
+    ParticleEditorLayer& layer = layers_[index];
+    layer.layer_.offset_ = offset;
+    if (layer.node_)
+        layer.node_->SetPosition(Vector3(offset.x_ * PIXEL_SIZE, offset.y_ * PIXEL_SIZE, 0.0f));
+
+    RequestFrame();
+}
+
+void ParticleEditor::SetLayerDelay(unsigned index, float delay)
+{
+    if (index >= layers_.Size())
+        return;
+
+    ParticleEditorLayer& layer = layers_[index];
+    layer.layer_.delay_ = Max(delay, 0.0f);
+    SimulatedParticleEmitter2D* emitter = GetEmitter(index);
+    if (emitter)
+        emitter->GetSimulator()->SetStartDelay(layer.layer_.delay_);
+
+    // Delays are relative to the other layers, which only shows when they start together
+    Restart();
+}
+
+void ParticleEditor::Restart()
+{
+    for (unsigned i = 0; i < layers_.Size(); ++i)
+    {
+        SimulatedParticleEmitter2D* emitter = GetEmitter(i);
+        if (emitter)
+            emitter->GetSimulator()->Reset();
+    }
+
+    RequestFrame();
+}
+
+long long ParticleEditor::Seek(float time)
+{
+    ParticleUpdater2D* updater = GetUpdater();
+    if (!updater)
+        return 0;
+
+    // Pending edits would otherwise land on the first step after the jump
+    ApplyChanges();
+
+    HiresTimer seekTimer;
+    updater->Seek(time);
+    long long elapsed = seekTimer.GetUSec(false);
+
+    RequestFrame();
+    return elapsed;
+}
+
+float ParticleEditor::GetTimelineLength() const
+{
+    float length = MIN_TIMELINE_LENGTH;
+    for (unsigned i = 0; i < layers_.Size(); ++i)
+    {
+        SimulatedParticleEmitter2D* emitter = GetEmitter(i);
+        ParticleEffect2D* effect = emitter ? emitter->GetEffect() : 0;
+        if (!effect)
+            continue;
+
+        float lifespan = effect->GetParticleLifeSpan() + Abs(effect->GetParticleLifespanVariance());
+        float emission = effect->GetDuration() < 0.0f ? lifespan : Max(effect->GetDuration(), 0.0f);
+        float prewarm = emitter->GetSimulator()->GetPrewarmTime();
+        length = Max(length, Max(layers_[i].layer_.delay_, prewarm) + emission + lifespan);
+    }
+
+    return length;
+}
+
+bool ParticleEditor::Bake(const String& fileName, float duration, float frameRate)
+{
+    ParticleEffect2D* particleEffect = GetEffect();
+    if (!particleEffect)
+        return false;
+
+    ApplyChanges();
+
+    // The previous bake may be mapped from the same file, so it is let go before the file is rewritten
+    if (GetBakedEmitter())
+        GetBakedEmitter()->SetBake(0);
+
+    {
+        File file(context_);
+        if (!file.Open(fileName, FILE_WRITE))
+        {
+            LOGERROR("Open file failed " + fileName);
+            return false;
+        }
+
+        if (!BakeParticleEffect(context_, particleEffect, layers_[selectedLayer_].settings_.GetRandomSeed(), duration, frameRate,
+            file))
+        {
+            LOGERROR("Bake particle effect failed " + fileName);
+            return false;
+        }
+    }
+
+    return OpenBake(fileName);
+}
+
+bool ParticleEditor::OpenBake(const String& fileName)
+{
+    if (!particleNode_)
+        return false;
+
+    SharedPtr<ParticleBake2D> bake(new ParticleBake2D());
+    if (!bake->Load(context_, fileName))
+        return false;
+
+    if (!bakeNode_)
+    {
+        bakeNode_ = particleNode_->CreateChild("Bake");
+        bakeNode_->CreateComponent<BakedParticleEmitter2D>();
+    }
+
+    BakedParticleEmitter2D* bakedEmitter = GetBakedEmitter();
+    bakedEmitter->SetSprite(bake->GetTextureName().Empty() ? 0 :
+        GetParticleEffectSprite(GetSubsystem<ResourceCache>(), GetPath(fileName) + bake->GetTextureName()));
+    bakedEmitter->SetBake(bake);
+    bakedEmitter->SetPlaying(true);
+
+    LOGINFO("Baked particles " + fileName + ", " + String(bake->GetNumFrames()) + " frames, " + String(bake->GetDataSize()) +
+        " bytes");
+
+    SetBakePreview(true);
+    return true;
+}
+
+void ParticleEditor::SetBakePreview(bool enable)
+{
+    if (!bakeNode_)
+        enable = false;
+
+    // Hidden layers are not stepped by the updater, so the preview costs the bake playback only
+    bakePreview_ = enable;
+    if (bakeNode_)
+        bakeNode_->SetEnabled(enable);
+    for (unsigned i = 0; i < layers_.Size(); ++i)
+    {
+        if (layers_[i].node_)
+            layers_[i].node_->SetEnabled(!enable);
+    }
+
+    mainWindow_->UpdateWidget();
+    RequestFrame();
+}
+
+void ParticleEditor::SetOverdrawView(bool enable)
+{
+    if (enable && !overdrawNode_)
+    {
+        overdraw_ = new ParticleOverdraw2D(context_);
+
+        // One texel per screen pixel, uploaded every drawn frame
+        overdrawTexture_ = new Texture2D(context_);
+        overdrawTexture_->SetNumLevels(1);
+        overdrawTexture_->SetFilterMode(FILTER_NEAREST);
+
+        SharedPtr<Sprite2D> sprite(new Sprite2D(context_));
+        sprite->SetTexture(overdrawTexture_);
+
+        overdrawNode_ = scene_->CreateChild("Overdraw");
+        StaticSprite2D* staticSprite = overdrawNode_->CreateComponent<StaticSprite2D>();
+        staticSprite->SetSprite(sprite);
+        staticSprite->SetBlendMode(BLEND_ALPHA);
+        staticSprite->SetLayer(OVERDRAW_LAYER);
+    }
+
+    overdrawView_ = enable;
+    if (overdrawNode_)
+        overdrawNode_->SetEnabled(enable);
+
+    mainWindow_->UpdateWidget();
+    RequestFrame();
+}
+
+void ParticleEditor::WatchFiles()
+{
+    const String& fileName = layers_[selectedLayer_].fileName_;
+    if (fileName.Empty() || !GetEmitter())
+        watcher_->StopWatching();
+    else if (!watcher_->Watch(fileName, GetEmitter()))
+        LOGWARNING("Watch particle effect failed " + fileName);
+}
+
+bool ParticleEditor::eventFilter(QObject* watched, QEvent* event)
+{
+    // Any user input or window change may alter what the preview shows
+    switch (event->type())
+    {
+    case QEvent::MouseButtonRelease:
+        // Releasing a slider or spin box button ends the edit, so the next one gets its own undo entry
+        ApplyChanges();
+        layers_[selectedLayer_].history_.EndMerge();
+        RequestFrame();
+        break;
+
+    case QEvent::KeyPress:
+    case QEvent::KeyRelease:
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseMove:
+    case QEvent::Wheel:
+    case QEvent::Resize:
+    case QEvent::Show:
+    case QEvent::WindowStateChange:
+    case QEvent::WindowActivate:
+        RequestFrame();
+        break;
+
+    default:
+        break;
+    }
+
+    return QApplication::eventFilter(watched, event);
+}
+
 void ParticleEditor::OnTimeout()
 {
-    if (engine_ && !engine_->IsExiting())
-        engine_->RunFrame();
+    if (!engine_ || engine_->IsExiting())
+        return;
+
+    // Nothing is drawn while minimized. Restoring the window wakes the scheduler through the event filter
+    if (mainWindow_->isMinimized())
+        return;
+
+    // Time past the scheduled start was spent by Qt processing other events
+    PhaseProfiler2D* profiler = GetSubsystem<PhaseProfiler2D>();
+    long long frameStart = PhaseProfiler2D::GetTime();
+    if (profiler && frameStart > scheduledTime_)
+        profiler->AddEvent(PP_EVENTPUMP, scheduledTime_, frameStart);
+
+    engine_->RunFrame();
+
+    long long frameEnd = PhaseProfiler2D::GetTime();
+    if (profiler)
+    {
+        profiler->AddEvent(PP_FRAME, frameStart, frameEnd);
+        profiler->EndFrame();
+    }
+
+    if (wakeFrames_)
+        --wakeFrames_;
+
+    // Sleep until an event requests a frame
+    if (!IsActive())
+        return;
+
+    scheduledTime_ = Max(frameStart + FRAME_INTERVAL, frameEnd);
+    timer_->start((int)((scheduledTime_ - frameEnd) / 1000000));
+}
+
+void ParticleEditor::OnWatchTimeout()
+{
+    if (!engine_ || engine_->IsExiting())
+        return;
+
+    mainWindow_->UpdateLoadProgress();
+
+    unsigned flags = watcher_->Update();
+    if (flags & WATCH_EFFECT_CHANGED)
+        ReloadEffect();
+    if (flags)
+        RequestFrame();
+}
+
+bool ParticleEditor::IsActive() const
+{
+    if (wakeFrames_)
+        return true;
+
+    // Loaded resources are swapped in at the start of a frame
+    if (loader_->IsLoading())
+        return true;
+
+    ParticleUpdater2D* updater = scene_->GetComponent<ParticleUpdater2D>();
+    if (updater && updater->IsActive())
+        return true;
+
+    BakedParticleEmitter2D* bakedEmitter = GetBakedEmitter();
+    if (bakePreview_ && bakedEmitter && bakedEmitter->IsActive())
+        return true;
+
+    // Keep drawing while the console or the frame statistics are on screen
+    Console* console = GetSubsystem<Console>();
+    DebugHud* debugHud = GetSubsystem<DebugHud>();
+    return (console && console->IsVisible()) || (debugHud && debugHud->GetMode());
 }
 
 void ParticleEditor::CreateScene()
@@ -178,6 +761,10 @@ void ParticleEditor::CreateScene()
     scene_->CreateComponent<Octree>();
     scene_->CreateComponent<DebugRenderer>();
 
+    // The simulation steps at a fixed rate, independent of when frames are drawn
+    ParticleUpdater2D* updater = scene_->CreateComponent<ParticleUpdater2D>();
+    updater->SetFixedTimeStep(SIMULATION_TIME_STEP);
+
     // Create camera.
     cameraNode_ = scene_->CreateChild("Camera");
     Camera* camera = cameraNode_->CreateComponent<Camera>();
@@ -186,6 +773,9 @@ void ParticleEditor::CreateScene()
     Graphics* graphic = GetSubsystem<Graphics>();
     camera->SetOrthoSize(graphic->GetHeight() * PIXEL_SIZE);
 
+    // LOD levels follow the preview camera, so zooming out shows the reduced levels
+    updater->SetLodCamera(camera);
+
     SharedPtr<Viewport> viewport(new Viewport(context_, scene_, camera));
 
     Renderer* renderer = GetSubsystem<Renderer>();
@@ -216,6 +806,448 @@ void ParticleEditor::CreateDebugHud()
     debugHud->SetDefaultStyle(xmlFile);
 }
 
+void ParticleEditor::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
+{
+    // Widgets may fire many times between frames. Only their last values reach the effect, once, before the step
+    ApplyChanges();
+
+    HandleLoadResults();
+}
+
+void ParticleEditor::BeginOpen(const String& name, const String& fileName)
+{
+    // A newer open replaces any pending one
+    CancelOpen();
+    loader_->Cancel(addLoadId_);
+    addLoadId_ = 0;
+
+    Vector<ParticleCompositeLayer2D> layers;
+    if (IsParticleComposite(name))
+    {
+        // The composite is a short list of file names, read here. Its effects load in the background
+        ResourceCache* cache = GetSubsystem<ResourceCache>();
+        SharedPtr<File> file = cache->GetFile(name);
+        XMLFile xmlFile(context_);
+        if (!file || !xmlFile.Load(*file) || !ReadParticleComposite(xmlFile.GetRoot(), layers) || layers.Empty())
+        {
+            LOGERROR("Open particle composite failed " + name);
+            return;
+        }
+    }
+    else
+    {
+        ParticleCompositeLayer2D layer;
+        layer.effectName_ = GetFileNameAndExtension(name);
+        layers.Push(layer);
+    }
+
+    String pathName = GetPath(name);
+    for (unsigned i = 0; i < layers.Size(); ++i)
+    {
+        String effectName = pathName + layers[i].effectName_;
+        unsigned loadId = loader_->LoadEffect(effectName);
+        if (!loadId)
+        {
+            LOGERROR("Open particle effect failed " + effectName);
+            CancelOpen();
+            return;
+        }
+
+        ParticleEditorLayer layer;
+        layer.layer_ = layers[i];
+        if (!fileName.Empty())
+            layer.fileName_ = effectName;
+
+        loadLayers_.Push(layer);
+        loadEffects_.Push(SharedPtr<ParticleEffect2D>());
+        loadIds_.Push(loadId);
+    }
+
+    loadFileName_ = fileName;
+    mainWindow_->UpdateLoadProgress();
+    RequestFrame();
+}
+
+void ParticleEditor::CancelOpen()
+{
+    for (unsigned i = 0; i < loadIds_.Size(); ++i)
+    {
+        loader_->Cancel(loadIds_[i]);
+        loader_->Cancel(loadLayers_[i].spriteLoadId_);
+    }
+
+    loadLayers_.Clear();
+    loadEffects_.Clear();
+    loadIds_.Clear();
+}
+
+void ParticleEditor::HandleLoadResults()
+{
+    ParticleLoadResult2D result;
+    while (loader_->GetNextResult(result))
+    {
+        // Results of cancelled or replaced requests are dropped
+        if (result.texture_)
+            SetLoadedSprite(result);
+        else if (result.id_ == addLoadId_)
+            AddLoadedLayer(result);
+        else
+            SetLoadedEffect(result);
+    }
+
+    mainWindow_->UpdateLoadProgress();
+}
+
+void ParticleEditor::SetLoadedEffect(const ParticleLoadResult2D& result)
+{
+    unsigned index = 0;
+    while (index < loadIds_.Size() && loadIds_[index] != result.id_)
+        ++index;
+    if (index == loadIds_.Size() || !result.id_)
+        return;
+
+    if (!result.success_)
+    {
+        LOGERROR("Open particle effect failed " + result.name_);
+        CancelOpen();
+        return;
+    }
+
+    // Effects with a sprite get it again in the texture result
+    ParticleEditorLayer& layer = loadLayers_[index];
+    layer.settings_ = result.settings_;
+    layer.spriteLoadId_ = result.effect_->GetSprite() ? result.id_ : 0;
+    loadEffects_[index] = result.effect_;
+    loadIds_[index] = 0;
+
+    // Layers are swapped in together, so they start on the same frame
+    for (unsigned i = 0; i < loadIds_.Size(); ++i)
+    {
+        if (loadIds_[i])
+            return;
+    }
+
+    SetLoadedLayers();
+}
+
+void ParticleEditor::SetLoadedLayers()
+{
+    changes_.Clear();
+
+    if (particleNode_)
+    {
+        particleNode_->Remove();
+        particleNode_ = 0;
+    }
+    bakeNode_ = 0;
+    bakePreview_ = false;
+
+    particleNode_ = scene_->CreateChild("ParticleEmitter2D");
+
+    // The effects keep the placeholder sprite until their textures arrive
+    layers_ = loadLayers_;
+    selectedLayer_ = 0;
+    for (unsigned i = 0; i < layers_.Size(); ++i)
+        CreateLayerNode(i, loadEffects_[i]);
+    UpdateDrawOrder();
+
+    fileName_ = loadFileName_;
+    loadLayers_.Clear();
+    loadEffects_.Clear();
+    loadIds_.Clear();
+
+    WatchFiles();
+    mainWindow_->UpdateWidget();
+    RequestFrame();
+}
+
+void ParticleEditor::AddLoadedLayer(const ParticleLoadResult2D& result)
+{
+    addLoadId_ = 0;
+    if (!result.success_ || !particleNode_)
+    {
+        LOGERROR("Add layer failed " + result.name_);
+        return;
+    }
+
+    ParticleEditorLayer layer;
+    layer.layer_.effectName_ = GetFileNameAndExtension(result.name_);
+    layer.fileName_ = result.name_;
+    layer.settings_ = result.settings_;
+    layer.spriteLoadId_ = result.effect_->GetSprite() ? result.id_ : 0;
+    layers_.Push(layer);
+
+    CreateLayerNode(layers_.Size() - 1, result.effect_);
+    UpdateDrawOrder();
+    SelectLayer(layers_.Size() - 1);
+    Restart();
+}
+
+void ParticleEditor::SetLoadedSprite(const ParticleLoadResult2D& result)
+{
+    if (!result.id_)
+        return;
+
+    // Sprites of layers still being opened go to their effect, which hands them to the emitter when the layers swap in
+    for (unsigned i = 0; i < loadLayers_.Size(); ++i)
+    {
+        if (loadLayers_[i].spriteLoadId_ != result.id_)
+            continue;
+
+        loadLayers_[i].spriteLoadId_ = 0;
+        if (result.success_ && loadEffects_[i])
+            loadEffects_[i]->SetSprite(result.sprite_);
+        return;
+    }
+
+    for (unsigned i = 0; i < layers_.Size(); ++i)
+    {
+        if (layers_[i].spriteLoadId_ != result.id_)
+            continue;
+
+        layers_[i].spriteLoadId_ = 0;
+        SimulatedParticleEmitter2D* emitter = GetEmitter(i);
+        if (!result.success_ || !emitter || !emitter->GetEffect())
+            return;
+
+        emitter->GetEffect()->SetSprite(result.sprite_);
+        emitter->SetSprite(result.sprite_);
+        if (i == selectedLayer_)
+        {
+            WatchFiles();
+            mainWindow_->UpdateWidget();
+        }
+        return;
+    }
+}
+
+void ParticleEditor::CreateLayerNode(unsigned index, ParticleEffect2D* effect)
+{
+    ParticleEditorLayer& layer = layers_[index];
+    GetSubsystem<ResourceCache>()->AddManualResource(effect);
+
+    const Vector2& offset = layer.layer_.offset_;
+    layer.node_ = particleNode_->CreateChild("Layer");
+    layer.node_->SetPosition(Vector3(offset.x_ * PIXEL_SIZE, offset.y_ * PIXEL_SIZE, 0.0f));
+    layer.node_->SetEnabled(!bakePreview_);
+
+    SimulatedParticleEmitter2D* particleEmitter = layer.node_->CreateComponent<SimulatedParticleEmitter2D>();
+    particleEmitter->GetSimulator()->SetRandomSeed(layer.settings_.GetRandomSeed());
+    particleEmitter->GetSimulator()->SetStartDelay(layer.layer_.delay_);
+    particleEmitter->GetSimulator()->SetPrewarmTime(layer.settings_.GetPrewarmTime());
+    particleEmitter->SetEffect(effect);
+    particleEmitter->SetLod(layer.settings_.GetLod());
+}
+
+void ParticleEditor::UpdateDrawOrder()
+{
+    // The 2D renderer merges consecutive drawables with the same material into one vertex buffer and draw call. Ordering
+    // by list position keeps the authored blending order, and layers sharing an atlas and blend mode still merge
+    for (unsigned i = 0; i < layers_.Size(); ++i)
+    {
+        SimulatedParticleEmitter2D* emitter = GetEmitter(i);
+        if (emitter)
+            emitter->SetOrderInLayer((int)i);
+    }
+}
+
+bool ParticleEditor::SaveEffect(ParticleEffect2D* effect, const ParticleEffectSettings2D& settings, const String& fileName,
+    bool binary)
+{
+    File file(context_);
+    if (!file.Open(fileName, FILE_WRITE))
+    {
+        LOGERROR("Open file failed " + fileName);
+        return false;
+    }
+
+    if (binary)
+    {
+        if (!SaveParticleEffectBinary(effect, settings, file))
+        {
+            LOGERROR("Export particle effect failed " + fileName);
+            return false;
+        }
+        return true;
+    }
+
+    // Let the engine write its attributes, then add the settings it does not know about
+    VectorBuffer buffer;
+    effect->Save(buffer);
+    buffer.Seek(0);
+
+    XMLFile xmlFile(context_);
+    if (!xmlFile.Load(buffer))
+    {
+        LOGERROR("Save particle effect failed " + fileName);
+        return false;
+    }
+
+    // The engine writes the sprite name only, which misses the sheet of atlas sprites
+    XMLElement rootElem = xmlFile.GetRoot();
+    if (effect->GetSprite())
+        rootElem.GetChild("texture").SetAttribute("name", GetParticleEffectTextureName(effect->GetSprite()));
+    settings.Save(rootElem);
+    return xmlFile.Save(file);
+}
+
+bool ParticleEditor::SaveComposite(const String& fileName)
+{
+    // Each layer's effect is written next to the composite. Layers whose effects share a file name are numbered
+    String pathName = GetPath(fileName);
+    Vector<ParticleCompositeLayer2D> compositeLayers;
+    Vector<String> effectNames;
+    for (unsigned i = 0; i < layers_.Size(); ++i)
+    {
+        ParticleEffect2D* effect = GetEmitter(i) ? GetEmitter(i)->GetEffect() : 0;
+        if (!effect)
+            continue;
+
+        ParticleEditorLayer& layer = layers_[i];
+        String effectName = GetFileNameAndExtension(layer.layer_.effectName_);
+        if (effectNames.Contains(effectName))
+            effectName = GetFileName(effectName) + "_" + String(i) + GetExtension(effectName);
+        effectNames.Push(effectName);
+
+        String effectFileName = pathName + effectName;
+        if (!SaveEffect(effect, layer.settings_, effectFileName, IsParticleEffectBinary(effectFileName)))
+            return false;
+
+        layer.layer_.effectName_ = effectName;
+        layer.fileName_ = effectFileName;
+        compositeLayers.Push(layer.layer_);
+    }
+
+    XMLFile xmlFile(context_);
+    XMLElement rootElem = xmlFile.CreateRoot("particleComposite");
+    WriteParticleComposite(rootElem, compositeLayers);
+
+    File file(context_);
+    if (!file.Open(fileName, FILE_WRITE) || !xmlFile.Save(file))
+    {
+        LOGERROR("Save particle composite failed " + fileName);
+        return false;
+    }
+
+    return true;
+}
+
+void ParticleEditor::ApplyChanges()
+{
+    ParticleEffect2D* effect = GetEffect();
+    if (!effect || !changes_.HasChanges())
+        return;
+
+    ParticleEditorLayer& layer = layers_[selectedLayer_];
+    ParticleEffectParameters2D before;
+    GetParticleEffectParameters(effect, before);
+    ParticleEffectSettings2D settingsBefore = layer.settings_;
+    if (!changes_.Apply(GetEmitter(), layer.settings_))
+        return;
+
+    ParticleEffectParameters2D after;
+    GetParticleEffectParameters(effect, after);
+    layer.history_.Record(before, settingsBefore, after, layer.settings_);
+}
+
+void ParticleEditor::ReloadEffect()
+{
+    ParticleEffect2D* effect = GetEffect();
+    if (!effect)
+        return;
+
+    // Elements removed from the file keep their current values
+    ParticleEffectParameters2D parameters;
+    GetParticleEffectParameters(effect, parameters);
+    ParticleEffectSettings2D settings;
+    String textureName;
+    ParticleEditorLayer& layer = layers_[selectedLayer_];
+    if (!watcher_->ReadEffect(parameters, settings, textureName))
+    {
+        // Editors often write in several steps. The final write triggers another reload
+        LOGWARNING("Reload particle effect failed " + layer.fileName_);
+        return;
+    }
+
+    // Edits made in the editor reach the effect first, so the reload becomes its own undo entry
+    ApplyChanges();
+    layer.history_.EndMerge();
+
+    ParticleEffectParameters2D before;
+    GetParticleEffectParameters(effect, before);
+    ParticleEffectSettings2D settingsBefore = layer.settings_;
+
+    // Live particles keep their state. Only spawning and integration pick up the new parameters
+    SimulatedParticleEmitter2D* emitter = GetEmitter();
+    emitter->SetEffectParameters(parameters);
+
+    if (settings.GetRandomSeed() != layer.settings_.GetRandomSeed())
+    {
+        layer.settings_.SetRandomSeed(settings.GetRandomSeed());
+        emitter->GetSimulator()->SetRandomSeed(layer.settings_.GetRandomSeed());
+    }
+
+    if (settings.GetPrewarmTime() != layer.settings_.GetPrewarmTime())
+    {
+        layer.settings_.SetPrewarmTime(settings.GetPrewarmTime());
+        emitter->GetSimulator()->SetPrewarmTime(layer.settings_.GetPrewarmTime());
+    }
+
+    layer.settings_.SetLod(settings.GetLod());
+    emitter->SetLod(layer.settings_.GetLod());
+
+    ParticleEffectParameters2D after;
+    GetParticleEffectParameters(effect, after);
+    layer.history_.Record(before, settingsBefore, after, layer.settings_);
+    layer.history_.EndMerge();
+
+    Sprite2D* sprite = effect->GetSprite();
+    String spriteName = GetParticleEffectTextureName(sprite);
+    if (!textureName.Empty() && textureName != spriteName)
+        LoadSprite(GetPath(effect->GetName()) + textureName);
+
+    mainWindow_->UpdateWidget();
+    LOGINFO("Reloaded particle effect " + layer.fileName_);
+}
+
+void ParticleEditor::UpdateOverdrawView()
+{
+    Graphics* graphics = GetSubsystem<Graphics>();
+    int width = Max(graphics->GetWidth(), 1);
+    int height = Max(graphics->GetHeight(), 1);
+
+    StaticSprite2D* staticSprite = overdrawNode_->GetComponent<StaticSprite2D>();
+    if (overdraw_->GetWidth() != width || overdraw_->GetHeight() != height)
+    {
+        overdraw_->SetSize(width, height);
+        overdrawTexture_->SetSize(width, height, Graphics::GetRGBAFormat(), TEXTURE_DYNAMIC);
+
+        // Set again so that the sprite's vertices pick up the new rectangle
+        Sprite2D* sprite = staticSprite->GetSprite();
+        sprite->SetRectangle(IntRect(0, 0, width, height));
+        staticSprite->SetSprite(sprite);
+    }
+
+    // The map covers exactly what the camera sees
+    Camera* camera = cameraNode_->GetComponent<Camera>();
+    Vector3 center = cameraNode_->GetWorldPosition();
+    float halfHeight = camera->GetOrthoSize() * 0.5f / camera->GetZoom();
+    float halfWidth = halfHeight * camera->GetAspectRatio();
+    overdraw_->SetView(Rect(center.x_ - halfWidth, center.y_ - halfHeight, center.x_ + halfWidth, center.y_ + halfHeight));
+
+    overdraw_->Clear();
+    SimulatedParticleEmitter2D* emitter = GetEmitter();
+    if (emitter && !bakePreview_)
+        overdraw_->Accumulate(emitter->GetSimulator()->GetParticles());
+    overdraw_->Resolve();
+
+    overdrawTexture_->SetData(0, 0, 0, width, height, &overdraw_->GetHeatmap()[0]);
+
+    // A map pixel spans 1 / pixels per unit in the world, a sprite texel PIXEL_SIZE times the node scale
+    overdrawNode_->SetPosition(Vector3(center.x_, center.y_, 0.0f));
+    overdrawNode_->SetScale(1.0f / (overdraw_->GetPixelsPerUnit() * PIXEL_SIZE));
+}
+
 void ParticleEditor::HandleUpdate(StringHash eventType, VariantMap& eventData)
 {
     using namespace Update;
@@ -238,6 +1270,12 @@ void ParticleEditor::HandleUpdate(StringHash eventType, VariantMap& eventData)
     }
 }
 
+void ParticleEditor::HandlePostUpdate(StringHash eventType, VariantMap& eventData)
+{
+    if (overdrawView_)
+        UpdateOverdrawView();
+}
+
 void ParticleEditor::HandleKeyDown(StringHash eventType, VariantMap& eventData)
 {
     using namespace KeyDown;
@@ -21,20 +21,57 @@
 //
 
 #include "Object.h"
+#include "ParticleComposite2D.h"
+#include "ParticleEffectChanges2D.h"
+#include "ParticleEffectHistory2D.h"
+#include "ParticleEffectSettings2D.h"
 #include "Ptr.h"
 #include <QApplication>
 
+class QTimer;
+
 namespace Urho3D
 {
 
+class BakedParticleEmitter2D;
 class Camera;
 class Context;
 class Engine;
 class MainWindow;
 class Node;
 class ParticleEffect2D;
-class ParticleEmitter2D;
+class ParticleEffectLoader2D;
+class ParticleEffectPack2D;
+class ParticleEffectWatcher2D;
+struct ParticleLoadResult2D;
+class ParticleOverdraw2D;
+class ParticleUpdater2D;
 class Scene;
+class SimulatedParticleEmitter2D;
+class Texture2D;
+
+/// Emitter layer of the open effect. A plain effect has one layer, a composite effect (.pexc) has one per emitter.
+struct ParticleEditorLayer
+{
+    /// Construct.
+    ParticleEditorLayer() :
+        spriteLoadId_(0)
+    {
+    }
+
+    /// Effect name, offset and delay as stored in the composite.
+    ParticleCompositeLayer2D layer_;
+    /// File the effect was loaded from or saved to, empty for new effects.
+    String fileName_;
+    /// Emitter node, child of the particle node.
+    SharedPtr<Node> node_;
+    /// Settings stored alongside the effect.
+    ParticleEffectSettings2D settings_;
+    /// Undo history.
+    ParticleEffectHistory2D history_;
+    /// Id of the sprite being loaded.
+    unsigned spriteLoadId_;
+};
 
 /// Particle editor class.
 class ParticleEditor : public QApplication, public Object
@@ -52,33 +89,152 @@ public:
     int Run();
 
     void New();
+    /// Open an effect or a composite. It is loaded in the background and replaces the current effect at the start of a later frame.
     void Open(const String& fileName);
+    /// Save a composite with the effects of all layers next to it, or the selected layer as a plain effect.
     void Save(const String& fileName);
+    /// Export the selected layer in binary format without changing the current file name. Return true if successful.
+    bool Export(const String& fileName);
+    /// Pack the textures of effects into atlases, write the effects pointing at them to pathName and open one for preview.
+    /// Return number of atlases, or 0 on failure.
+    unsigned BuildAtlas(const Vector<String>& fileNames, const String& pathName);
+    /// Compile effects into a pack, naming them by their path relative to the pack. Return number of entries, or 0 on failure.
+    unsigned BuildPack(const Vector<String>& fileNames, const String& packFileName);
+    /// Load a pack to open its entries from. Return true if successful.
+    bool OpenPack(const String& fileName);
+    /// Open an entry of the loaded pack. It has no file name, so saving asks for one.
+    bool OpenPackEntry(unsigned index);
+    /// Undo the last edit.
+    void Undo();
+    /// Redo the last undone edit.
+    void Redo();
+    /// Draw frames for a short while. Called for changes that do not come from user input.
+    void RequestFrame();
+    /// Watch the effect file and its texture for changes made by other programs.
+    void WatchFiles();
+    /// Load a sprite in the background and set it on the selected layer's effect when it arrives.
+    void LoadSprite(const String& name);
+    /// Add an effect as the top layer. It is loaded in the background and selected when it arrives.
+    void AddLayer(const String& fileName);
+    /// Remove a layer. The last one is kept.
+    void RemoveLayer(unsigned index);
+    /// Select the layer that edits, undo and file watching apply to.
+    void SelectLayer(unsigned index);
+    /// Set layer offset in pixels.
+    void SetLayerOffset(unsigned index, const Vector2& offset);
+    /// Set layer start delay in seconds and restart all layers.
+    void SetLayerDelay(unsigned index, float delay);
+    /// Restart all layers together.
+    void Restart();
+    /// Jump all layers to a time in seconds without stepping through it. Return the time taken in microseconds.
+    long long Seek(float time);
+    /// Bake the selected layer to a file and preview the bake. Return true if successful.
+    bool Bake(const String& fileName, float duration, float frameRate);
+    /// Load a bake and preview it. Return true if successful.
+    bool OpenBake(const String& fileName);
+    /// Show the bake in place of the layers, or the layers again.
+    void SetBakePreview(bool enable);
+    /// Show how many times the selected layer's particles fill each pixel as a heatmap over the preview, or hide it.
+    void SetOverdrawView(bool enable);
 
     const String& GetFileName() const { return fileName_; }
     /// Return camera.
     Camera* GetCamera() const;
-    /// Return effect.
+    /// Return effect of the selected layer.
     ParticleEffect2D* GetEffect() const;
-    /// Return emitter.
-    ParticleEmitter2D* GetEmitter() const;
+    /// Return emitter of the selected layer.
+    SimulatedParticleEmitter2D* GetEmitter() const;
+    /// Return emitter of a layer.
+    SimulatedParticleEmitter2D* GetEmitter(unsigned index) const;
+    /// Return settings stored alongside the selected layer's effect.
+    ParticleEffectSettings2D& GetSettings() { return layers_[selectedLayer_].settings_; }
+    /// Return pending effect edits.
+    ParticleEffectChanges2D& GetChanges() { return changes_; }
+    /// Return undo history of the selected layer.
+    const ParticleEffectHistory2D& GetHistory() const { return layers_[selectedLayer_].history_; }
+    /// Return number of layers.
+    unsigned GetNumLayers() const { return layers_.Size(); }
+    /// Return layer.
+    const ParticleEditorLayer& GetLayer(unsigned index) const { return layers_[index]; }
+    /// Return index of the selected layer.
+    unsigned GetSelectedLayer() const { return selectedLayer_; }
+    /// Return seconds the timeline spans: until the last particle of one-shot layers dies, and two life spans past the start
+    /// of layers that emit forever.
+    float GetTimelineLength() const;
+    /// Return number of draw calls of the layers with live particles. Adjacent layers with the same texture and blend mode
+    /// share a material, and the 2D renderer merges them into one.
+    unsigned GetNumDrawCalls() const;
+    /// Return background loader.
+    ParticleEffectLoader2D* GetLoader() const { return loader_; }
+    /// Return particle updater of the scene.
+    ParticleUpdater2D* GetUpdater() const;
+    /// Return bake playback emitter, null before the first bake.
+    BakedParticleEmitter2D* GetBakedEmitter() const;
+    /// Return whether the bake is shown in place of the layers.
+    bool IsBakePreview() const { return bakePreview_; }
+    /// Return whether the overdraw heatmap is shown.
+    bool IsOverdrawView() const { return overdrawView_; }
+    /// Return loaded pack, null before one is opened.
+    ParticleEffectPack2D* GetPack() const { return pack_; }
+    /// Return overdraw of the last drawn frame, null before the heatmap is first shown.
+    ParticleOverdraw2D* GetOverdraw() const { return overdraw_; }
 
     /// Return editor pointer.
     static ParticleEditor* Get();
 
+protected:
+    /// Request frames on user input and window changes.
+    virtual bool eventFilter(QObject* watched, QEvent* event);
+
 private slots:
     // Timeout handler.
     void OnTimeout();
+    // Watch timeout handler.
+    void OnWatchTimeout();
 
 private:
+    /// Return whether frames need to be drawn.
+    bool IsActive() const;
+    /// Apply pending effect edits and record them in the undo history.
+    void ApplyChanges();
+    /// Queue loading an effect or the effects of a composite, stored under a file name that is empty for new effects.
+    void BeginOpen(const String& name, const String& fileName);
+    /// Cancel loading the effects of a pending open.
+    void CancelOpen();
+    /// Swap in loaded effects and sprites.
+    void HandleLoadResults();
+    /// Store a loaded effect of the pending open, and replace the current layers once all have arrived.
+    void SetLoadedEffect(const ParticleLoadResult2D& result);
+    /// Replace the current layers with the loaded ones.
+    void SetLoadedLayers();
+    /// Add a loaded effect as the top layer.
+    void AddLoadedLayer(const ParticleLoadResult2D& result);
+    /// Set a loaded sprite on the layer waiting for it.
+    void SetLoadedSprite(const ParticleLoadResult2D& result);
+    /// Create the emitter node of a layer.
+    void CreateLayerNode(unsigned index, ParticleEffect2D* effect);
+    /// Draw layers in list order.
+    void UpdateDrawOrder();
+    /// Save an effect with its settings, in binary or XML format. Return true if successful.
+    bool SaveEffect(ParticleEffect2D* effect, const ParticleEffectSettings2D& settings, const String& fileName, bool binary);
+    /// Save all layers and the composite referencing them. Return true if successful.
+    bool SaveComposite(const String& fileName);
+    /// Patch the live effect with the parameters of the changed effect file and record them in the undo history.
+    void ReloadEffect();
     /// Create scene.
     void CreateScene();
     /// Create console.
     void CreateConsole();
     /// Create debug HUD.
     void CreateDebugHud();
+    /// Measure the overdraw of the selected layer over the visible area and upload its heatmap.
+    void UpdateOverdrawView();
+    /// Handle begin frame event (apply pending effect edits).
+    void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
     /// Handle update event.
     void HandleUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle post update event (update overdraw heatmap after the particles have been stepped).
+    void HandlePostUpdate(StringHash eventType, VariantMap& eventData);
     /// Handle key down (toggle debug HUD).
     void HandleKeyDown(StringHash eventType, VariantMap& eventData);
     /// Handle mouse wheel.
@@ -96,8 +252,50 @@ private:
     String fileName_;
     /// Camera node.
     SharedPtr<Node> cameraNode_;
-    /// Particle node.
+    /// Particle node, parent of the layer nodes. Dragging it moves all layers.
     SharedPtr<Node> particleNode_;
+    /// Layers in draw order. There is always at least one.
+    Vector<ParticleEditorLayer> layers_;
+    /// Index of the selected layer.
+    unsigned selectedLayer_;
+    /// Bake playback node, child of the particle node.
+    SharedPtr<Node> bakeNode_;
+    /// Whether the bake is shown in place of the layers.
+    bool bakePreview_;
+    /// Overdraw map of the visible area.
+    SharedPtr<ParticleOverdraw2D> overdraw_;
+    /// Overdraw heatmap texture.
+    SharedPtr<Texture2D> overdrawTexture_;
+    /// Overdraw heatmap node, drawn above the layers.
+    SharedPtr<Node> overdrawNode_;
+    /// Whether the overdraw heatmap is shown.
+    bool overdrawView_;
+    /// Pending effect edits of the selected layer.
+    ParticleEffectChanges2D changes_;
+    /// Background effect and texture loader.
+    SharedPtr<ParticleEffectLoader2D> loader_;
+    /// Layers of the effect being opened.
+    Vector<ParticleEditorLayer> loadLayers_;
+    /// Loaded effects of the layers being opened.
+    Vector<SharedPtr<ParticleEffect2D> > loadEffects_;
+    /// Ids of the effects being opened, 0 once loaded.
+    PODVector<unsigned> loadIds_;
+    /// File name of the effect being opened.
+    String loadFileName_;
+    /// Id of the effect being added as a layer.
+    unsigned addLoadId_;
+    /// Pack the entries are opened from.
+    SharedPtr<ParticleEffectPack2D> pack_;
+    /// Effect and texture file watcher.
+    SharedPtr<ParticleEffectWatcher2D> watcher_;
+    /// Frame timer.
+    QTimer* timer_;
+    /// File watch and load progress timer.
+    QTimer* watchTimer_;
+    /// Frames left to draw after the last event.
+    unsigned wakeFrames_;
+    /// Time the next frame is scheduled to start.
+    long long scheduledTime_;
 };
 
 }
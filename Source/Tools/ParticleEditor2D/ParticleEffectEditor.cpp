@@ -22,7 +22,10 @@
 //
 
 #include "ParticleEditor.h"
+#include "ParticleEffectBinary2D.h"
+#include "ParticleEffectChanges2D.h"
 #include "ParticleEffectEditor.h"
+#include "ValueVarianceEditor.h"
 
 
 namespace Urho3D
@@ -53,9 +56,49 @@ ParticleEffect2D* ParticleEffectEditor::GetEffect() const
     return ParticleEditor::Get()->GetEffect();
 }
 
-ParticleEmitter2D* ParticleEffectEditor::GetEmitter() const
+SimulatedParticleEmitter2D* ParticleEffectEditor::GetEmitter() const
 {
     return ParticleEditor::Get()->GetEmitter();
 }
 
+ParticleEffectSettings2D& ParticleEffectEditor::GetSettings() const
+{
+    return ParticleEditor::Get()->GetSettings();
+}
+
+ParticleEffectChanges2D& ParticleEffectEditor::GetChanges() const
+{
+    return ParticleEditor::Get()->GetChanges();
+}
+
+void ParticleEffectEditor::AddValueVarianceEditor(ValueVarianceEditor* editor, ParticleEffectAttribute2D attribute)
+{
+    const ParticleEffectRange2D& range = GetParticleEffectRange(attribute);
+    editor->setRange(range.min_, range.max_);
+
+    valueVarianceAttributes_[editor] = attribute;
+}
+
+void ParticleEffectEditor::QueueValueVarianceChange(QObject* editor, float value, float variance)
+{
+    QMap<ValueVarianceEditor*, ParticleEffectAttribute2D>::const_iterator i = valueVarianceAttributes_.find(qobject_cast<ValueVarianceEditor*>(editor));
+    if (i != valueVarianceAttributes_.end())
+        GetChanges().SetValue(i.value(), value, variance);
+}
+
+void ParticleEffectEditor::UpdateValueVarianceEditors()
+{
+    ParticleEffectParameters2D parameters;
+    GetParticleEffectParameters(GetEffect(), parameters);
+
+    const unsigned char* source = reinterpret_cast<const unsigned char*>(&parameters);
+    for (QMap<ValueVarianceEditor*, ParticleEffectAttribute2D>::const_iterator i = valueVarianceAttributes_.begin(); i != valueVarianceAttributes_.end(); ++i)
+    {
+        const ParticleEffectRange2D& range = GetParticleEffectRange(i.value());
+        float value = *reinterpret_cast<const float*>(source + range.valueOffset_);
+        float variance = *reinterpret_cast<const float*>(source + range.varianceOffset_);
+        i.key()->setValue(value, variance);
+    }
+}
+
 }
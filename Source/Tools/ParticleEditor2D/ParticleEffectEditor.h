@@ -23,11 +23,18 @@
 #pragma once
 
 #include "Object.h"
+#include "ParticleEffectRanges2D.h"
+#include <QMap>
+
+class QObject;
 
 namespace Urho3D
 {
 class ParticleEffect2D;
-class ParticleEmitter2D;
+class ParticleEffectChanges2D;
+class ParticleEffectSettings2D;
+class SimulatedParticleEmitter2D;
+class ValueVarianceEditor;
 
 /// Particle effect editor interface.
 class ParticleEffectEditor : public Object
@@ -48,10 +55,23 @@ protected:
     /// Return particle effect.
     ParticleEffect2D* GetEffect() const;
     /// Return particle emitter.
-    ParticleEmitter2D* GetEmitter() const;
+    SimulatedParticleEmitter2D* GetEmitter() const;
+    /// Return settings stored alongside the effect.
+    ParticleEffectSettings2D& GetSettings() const;
+    /// Return pending effect edits, applied before the next simulation step.
+    ParticleEffectChanges2D& GetChanges() const;
+
+    /// Add value variance editor of an attribute.
+    void AddValueVarianceEditor(ValueVarianceEditor* editor, ParticleEffectAttribute2D attribute);
+    /// Queue value and variance from a value variance editor added with AddValueVarianceEditor().
+    void QueueValueVarianceChange(QObject* editor, float value, float variance);
+    /// Update value variance editors from the effect.
+    void UpdateValueVarianceEditors();
 
     /// Is updating widget.
     bool updatingWidget_;
+    /// Attributes of value variance editors.
+    QMap<ValueVarianceEditor*, ParticleEffectAttribute2D> valueVarianceAttributes_;
 };
 
 }
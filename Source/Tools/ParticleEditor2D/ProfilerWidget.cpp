@@ -0,0 +1,142 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Context.h"
+#include "File.h"
+#include "Log.h"
+#include "PhaseProfiler2D.h"
+#include "ProfilerWidget.h"
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+namespace Urho3D
+{
+
+static const int numStatsColumns = 5;
+
+ProfilerWidget::ProfilerWidget(Context* context) :
+    QWidget(),
+    Object(context)
+{
+    QVBoxLayout* vBoxLayout = new QVBoxLayout();
+    setLayout(vBoxLayout);
+
+    tableWidget_ = new QTableWidget(MAX_PROFILE_PHASES, numStatsColumns);
+    vBoxLayout->addWidget(tableWidget_);
+
+    QStringList labels;
+    labels << tr("Last") << tr("p50") << tr("p95") << tr("p99") << tr("Max");
+    tableWidget_->setHorizontalHeaderLabels(labels);
+    tableWidget_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    tableWidget_->setSelectionMode(QAbstractItemView::NoSelection);
+    tableWidget_->horizontalHeader()->setResizeMode(QHeaderView::Stretch);
+
+    for (int row = 0; row < MAX_PROFILE_PHASES; ++row)
+    {
+        tableWidget_->setVerticalHeaderItem(row, new QTableWidgetItem(PhaseProfiler2D::GetPhaseName((ProfilePhase2D)row)));
+        for (int column = 0; column < numStatsColumns; ++column)
+        {
+            QTableWidgetItem* item = new QTableWidgetItem();
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            tableWidget_->setItem(row, column, item);
+        }
+    }
+
+    statusLabel_ = new QLabel();
+    vBoxLayout->addWidget(statusLabel_);
+
+    QHBoxLayout* hBoxLayout = new QHBoxLayout();
+    vBoxLayout->addLayout(hBoxLayout);
+
+    capturePushButton_ = new QPushButton(tr("Capture"));
+    hBoxLayout->addWidget(capturePushButton_);
+    capturePushButton_->setCheckable(true);
+    connect(capturePushButton_, SIGNAL(toggled(bool)), this, SLOT(HandleCapturePushButtonToggled(bool)));
+
+    exportPushButton_ = new QPushButton(tr("Export Chrome Trace..."));
+    hBoxLayout->addWidget(exportPushButton_);
+    exportPushButton_->setEnabled(false);
+    connect(exportPushButton_, SIGNAL(clicked(bool)), this, SLOT(HandleExportPushButtonClicked()));
+
+    QTimer* timer = new QTimer(this);
+    connect(timer, SIGNAL(timeout()), this, SLOT(HandleRefreshTimeout()));
+    timer->start(500);
+}
+
+ProfilerWidget::~ProfilerWidget()
+{
+}
+
+void ProfilerWidget::HandleRefreshTimeout()
+{
+    PhaseProfiler2D* profiler = GetSubsystem<PhaseProfiler2D>();
+    if (!profiler || !isVisible())
+        return;
+
+    for (int row = 0; row < MAX_PROFILE_PHASES; ++row)
+    {
+        ProfileStats2D stats = profiler->GetStats((ProfilePhase2D)row);
+        tableWidget_->item(row, 0)->setText(QString::number(stats.last_, 'f', 3));
+        tableWidget_->item(row, 1)->setText(QString::number(stats.p50_, 'f', 3));
+        tableWidget_->item(row, 2)->setText(QString::number(stats.p95_, 'f', 3));
+        tableWidget_->item(row, 3)->setText(QString::number(stats.p99_, 'f', 3));
+        tableWidget_->item(row, 4)->setText(QString::number(stats.max_, 'f', 3));
+    }
+
+    QString status = tr("Milliseconds per frame over the last %1 frames").arg(profiler->GetNumFrames());
+    if (profiler->IsCapturing())
+        status += tr(", %1 intervals captured").arg(profiler->GetNumTraceEvents());
+    statusLabel_->setText(status);
+}
+
+void ProfilerWidget::HandleCapturePushButtonToggled(bool checked)
+{
+    PhaseProfiler2D* profiler = GetSubsystem<PhaseProfiler2D>();
+    if (!profiler)
+        return;
+
+    profiler->SetCapture(checked);
+    exportPushButton_->setEnabled(true);
+}
+
+void ProfilerWidget::HandleExportPushButtonClicked()
+{
+    PhaseProfiler2D* profiler = GetSubsystem<PhaseProfiler2D>();
+    if (!profiler)
+        return;
+
+    QString fileName = QFileDialog::getSaveFileName(0, tr("Export Chrome trace"), "./", "*.json");
+    if (fileName.isEmpty())
+        return;
+
+    File file(context_);
+    if (!file.Open(fileName.toLatin1().data(), FILE_WRITE) || !profiler->SaveChromeTrace(file))
+        LOGERROR("Could not write trace " + String(fileName.toLatin1().data()));
+}
+
+}
@@ -0,0 +1,185 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "BakedParticleEmitter2D.h"
+#include "Context.h"
+#include "MathDefs.h"
+#include "ParticleQuad2D.h"
+#include "Scene.h"
+#include "SceneEvents.h"
+#include "Sprite2D.h"
+#include "Texture2D.h"
+
+namespace Urho3D
+{
+
+BakedParticleEmitter2D::BakedParticleEmitter2D(Context* context) :
+    Drawable2D(context),
+    sampleBounds_(Rect::ZERO),
+    time_(0.0f),
+    playing_(true)
+{
+}
+
+BakedParticleEmitter2D::~BakedParticleEmitter2D()
+{
+}
+
+void BakedParticleEmitter2D::RegisterObject(Context* context)
+{
+    context->RegisterFactory<BakedParticleEmitter2D>();
+}
+
+void BakedParticleEmitter2D::SetBake(ParticleBake2D* bake)
+{
+    bake_ = bake;
+    if (bake_)
+        SetBlendMode(bake_->GetBlendMode());
+
+    time_ = 0.0f;
+    UpdateSamples();
+}
+
+void BakedParticleEmitter2D::SetTime(float time)
+{
+    time_ = Max(time, 0.0f);
+    UpdateSamples();
+}
+
+void BakedParticleEmitter2D::SetPlaying(bool enable)
+{
+    playing_ = enable;
+}
+
+bool BakedParticleEmitter2D::IsActive() const
+{
+    return playing_ && bake_ && (bake_->IsLooping() || time_ < bake_->GetDuration());
+}
+
+void BakedParticleEmitter2D::OnNodeSet(Node* node)
+{
+    Drawable2D::OnNodeSet(node);
+
+    if (node)
+    {
+        Scene* scene = GetScene();
+        if (scene)
+            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(BakedParticleEmitter2D, HandleScenePostUpdate));
+    }
+}
+
+void BakedParticleEmitter2D::OnWorldBoundingBoxUpdate()
+{
+    Vector3 worldPosition = node_->GetWorldPosition();
+    if (samples_.Empty())
+    {
+        worldBoundingBox_.Define(worldPosition, worldPosition);
+        return;
+    }
+
+    // Rotation keeps the bounds within the radius of their farthest corner
+    float scale = node_->GetWorldScale().x_;
+    float radius = Max(Max(Abs(sampleBounds_.min_.x_), Abs(sampleBounds_.max_.x_)),
+        Max(Abs(sampleBounds_.min_.y_), Abs(sampleBounds_.max_.y_))) * 1.4142136f * Abs(scale);
+    worldBoundingBox_.Define(worldPosition - Vector3(radius, radius, 0.0f), worldPosition + Vector3(radius, radius, 0.0f));
+}
+
+void BakedParticleEmitter2D::UpdateVertices()
+{
+    if (!verticesDirty_)
+        return;
+
+    vertices_.Clear();
+    verticesDirty_ = false;
+
+    Texture2D* texture = sprite_ ? sprite_->GetTexture() : 0;
+    if (!texture || samples_.Empty())
+        return;
+
+    const IntRect& rectangle = sprite_->GetRectangle();
+    if (rectangle.Width() == 0 || rectangle.Height() == 0)
+        return;
+
+    float invTexW = 1.0f / (float)texture->GetWidth();
+    float invTexH = 1.0f / (float)texture->GetHeight();
+    Rect textureRect(rectangle.left_ * invTexW, rectangle.top_ * invTexH, rectangle.right_ * invTexW, rectangle.bottom_ * invTexH);
+
+    // Samples are relative to an unscaled emitter at the origin, so the node transform is applied here
+    Vector3 worldPosition = node_->GetWorldPosition();
+    float angle = node_->GetWorldRotation().RollAngle();
+    float scale = node_->GetWorldScale().x_;
+    float nodeCos = Cos(angle) * scale;
+    float nodeSin = Sin(angle) * scale;
+
+    vertices_.Resize(samples_.Size() * 4);
+    Vertex2D* vertex = &vertices_[0];
+    for (unsigned i = 0; i < samples_.Size(); ++i)
+    {
+        const ParticleBakeSample2D& sample = samples_[i];
+        float x = worldPosition.x_ + sample.position_.x_ * nodeCos - sample.position_.y_ * nodeSin;
+        float y = worldPosition.y_ + sample.position_.x_ * nodeSin + sample.position_.y_ * nodeCos;
+        float add;
+        float sub;
+        GetParticleQuadOffsets(sample.size_ * scale, sample.rotation_ + angle, add, sub);
+
+        WriteParticleQuad(vertex, x, y, add, sub, sample.color_, textureRect);
+        vertex += 4;
+    }
+}
+
+void BakedParticleEmitter2D::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ScenePostUpdate;
+
+    if (!IsEnabledEffective() || !IsActive())
+        return;
+
+    // Bakes that do not loop stop on their last frame
+    time_ += eventData[P_TIMESTEP].GetFloat();
+    if (!bake_->IsLooping())
+        time_ = Min(time_, bake_->GetDuration());
+    else if (time_ >= bake_->GetDuration())
+        time_ = fmodf(time_, bake_->GetDuration());
+
+    UpdateSamples();
+}
+
+void BakedParticleEmitter2D::UpdateSamples()
+{
+    if (bake_)
+        bake_->Sample(time_, samples_);
+    else
+        samples_.Clear();
+
+    sampleBounds_ = Rect::ZERO;
+    for (unsigned i = 0; i < samples_.Size(); ++i)
+    {
+        const ParticleBakeSample2D& sample = samples_[i];
+        MergeParticleQuadBounds(sampleBounds_.min_, sampleBounds_.max_, sample.position_.x_, sample.position_.y_, sample.size_);
+    }
+
+    verticesDirty_ = true;
+    if (node_)
+        OnMarkedDirty(node_);
+}
+
+}
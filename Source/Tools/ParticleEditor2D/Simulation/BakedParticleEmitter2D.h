@@ -0,0 +1,86 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Drawable2D.h"
+#include "ParticleBake2D.h"
+
+namespace Urho3D
+{
+
+/// 2D particle emitter component playing back a bake instead of simulating. Follows the node position, rotation and scale.
+class BakedParticleEmitter2D : public Drawable2D
+{
+    OBJECT(BakedParticleEmitter2D)
+
+public:
+    /// Construct.
+    BakedParticleEmitter2D(Context* context);
+    /// Destruct.
+    virtual ~BakedParticleEmitter2D();
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+
+    /// Set bake and return to its start. Takes the blend mode of the bake; the sprite is left to the caller.
+    void SetBake(ParticleBake2D* bake);
+    /// Set playback time in seconds.
+    void SetTime(float time);
+    /// Set whether playback advances with the scene.
+    void SetPlaying(bool enable);
+
+    /// Return bake.
+    ParticleBake2D* GetBake() const { return bake_; }
+    /// Return playback time.
+    float GetTime() const { return time_; }
+    /// Return whether playback advances with the scene.
+    bool IsPlaying() const { return playing_; }
+    /// Return whether playback is playing and has not reached the end of a bake that does not loop.
+    bool IsActive() const;
+    /// Return number of particles drawn.
+    unsigned GetNumParticles() const { return samples_.Size(); }
+
+private:
+    /// Handle node being assigned.
+    virtual void OnNodeSet(Node* node);
+    /// Recalculate the world-space bounding box.
+    virtual void OnWorldBoundingBoxUpdate();
+    /// Update vertices.
+    virtual void UpdateVertices();
+    /// Handle scene post-update event.
+    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    /// Sample the bake at the playback time and mark the drawable dirty.
+    void UpdateSamples();
+
+    /// Bake.
+    SharedPtr<ParticleBake2D> bake_;
+    /// Particles sampled at the playback time, relative to the node.
+    PODVector<ParticleBakeSample2D> samples_;
+    /// Bounds of the sampled particles relative to the node.
+    Rect sampleBounds_;
+    /// Playback time.
+    float time_;
+    /// Whether playback advances with the scene.
+    bool playing_;
+};
+
+}
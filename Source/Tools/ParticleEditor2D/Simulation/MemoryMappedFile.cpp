@@ -0,0 +1,170 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Context.h"
+#include "File.h"
+#include "FileSystem.h"
+#include "MathDefs.h"
+#include "MemoryMappedFile.h"
+#include "ResourceCache.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Urho3D
+{
+
+MemoryMappedFile::MemoryMappedFile() :
+    data_(0),
+    size_(0)
+#ifdef WIN32
+    ,
+    fileHandle_(0),
+    mappingHandle_(0)
+#endif
+{
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+    Close();
+}
+
+bool MemoryMappedFile::Open(const String& fileName)
+{
+    Close();
+
+#ifdef WIN32
+    HANDLE fileHandle = CreateFileW(WString(GetNativePath(fileName)).CString(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, 0);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0 || fileSize.HighPart != 0)
+    {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    HANDLE mappingHandle = CreateFileMappingW(fileHandle, 0, PAGE_READONLY, 0, 0, 0);
+    void* data = mappingHandle ? MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0) : 0;
+    if (!data)
+    {
+        if (mappingHandle)
+            CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    fileHandle_ = fileHandle;
+    mappingHandle_ = mappingHandle;
+    data_ = (const unsigned char*)data;
+    size_ = fileSize.LowPart;
+#else
+    int fd = open(GetNativePath(fileName).CString(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0 || (unsigned long long)fileStat.st_size > M_MAX_UNSIGNED)
+    {
+        close(fd);
+        return false;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    void* data = mmap(0, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    data_ = (const unsigned char*)data;
+    size_ = (unsigned)fileStat.st_size;
+#endif
+
+    return true;
+}
+
+bool MemoryMappedFile::Open(Context* context, const String& resourceName)
+{
+    Close();
+
+    ResourceCache* cache = context->GetSubsystem<ResourceCache>();
+    if (!cache)
+        return false;
+
+    String nativeFileName = cache->GetResourceFileName(resourceName);
+    if (nativeFileName.Empty() && context->GetSubsystem<FileSystem>()->FileExists(resourceName))
+        nativeFileName = resourceName;
+    if (!nativeFileName.Empty() && Open(nativeFileName))
+        return true;
+
+    SharedPtr<File> file = cache->GetFile(resourceName);
+    if (!file || !file->GetSize())
+        return false;
+
+    unsigned size = file->GetSize();
+    SharedArrayPtr<unsigned char> buffer(new unsigned char[size]);
+    if (file->Read(buffer.Get(), size) != size)
+        return false;
+
+    buffer_ = buffer;
+    data_ = buffer_.Get();
+    size_ = size;
+    return true;
+}
+
+void MemoryMappedFile::Close()
+{
+    if (!data_)
+        return;
+
+    if (buffer_)
+    {
+        buffer_.Reset();
+        data_ = 0;
+        size_ = 0;
+        return;
+    }
+
+#ifdef WIN32
+    UnmapViewOfFile(data_);
+    CloseHandle((HANDLE)mappingHandle_);
+    CloseHandle((HANDLE)fileHandle_);
+    fileHandle_ = 0;
+    mappingHandle_ = 0;
+#else
+    munmap((void*)data_, size_);
+#endif
+
+    data_ = 0;
+    size_ = 0;
+}
+
+}
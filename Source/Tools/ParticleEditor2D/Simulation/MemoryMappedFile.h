@@ -0,0 +1,85 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "ArrayPtr.h"
+#include "Str.h"
+
+namespace Urho3D
+{
+
+class Context;
+
+/// Read-only memory mapped file. Resources inside package files can not be mapped and are read into memory instead.
+class MemoryMappedFile
+{
+public:
+    /// Construct.
+    MemoryMappedFile();
+    /// Destruct. Unmap the file.
+    ~MemoryMappedFile();
+
+    /// Map a file by native file system path. Return true if successful.
+    bool Open(const String& fileName);
+    /// Open a resource by name, or by file system path if not found as a resource. Plain files are mapped, packaged ones read
+    /// into memory. Return true if successful.
+    bool Open(Context* context, const String& resourceName);
+    /// Unmap the file or free the data read into memory.
+    void Close();
+
+    /// Return mapped data.
+    const unsigned char* GetData() const { return data_; }
+    /// Return size in bytes.
+    unsigned GetSize() const { return size_; }
+    /// Return whether a file is mapped or read into memory.
+    bool IsOpen() const { return data_ != 0; }
+    /// Return whether the data is mapped rather than read into memory.
+    bool IsMapped() const { return data_ != 0 && !buffer_; }
+
+private:
+    /// Prevent copy construction.
+    MemoryMappedFile(const MemoryMappedFile& rhs);
+    /// Prevent assignment.
+    MemoryMappedFile& operator = (const MemoryMappedFile& rhs);
+
+    /// Mapped data, or the buffer.
+    const unsigned char* data_;
+    /// Size in bytes.
+    unsigned size_;
+    /// Data read into memory when the file could not be mapped.
+    SharedArrayPtr<unsigned char> buffer_;
+#ifdef WIN32
+    /// File handle.
+    void* fileHandle_;
+    /// Mapping handle.
+    void* mappingHandle_;
+#endif
+};
+
+/// Return whether a block of a file lies within its size. Checked without overflow for offsets and sizes read from the file.
+inline bool IsBlockValid(unsigned offset, unsigned blockSize, unsigned size)
+{
+    return offset <= size && blockSize <= size - offset;
+}
+
+}
@@ -0,0 +1,350 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "AreaAllocator.h"
+#include "Context.h"
+#include "File.h"
+#include "FileSystem.h"
+#include "Image.h"
+#include "Log.h"
+#include "MemoryMappedFile.h"
+#include "ParticleAtlasBuilder2D.h"
+#include "ParticleEffect2D.h"
+#include "ParticleEffectSettings2D.h"
+#include "Sort.h"
+#include "VectorBuffer.h"
+#include "WorkQueue.h"
+#include "XMLFile.h"
+#include <cstring>
+
+namespace Urho3D
+{
+
+/// Default maximum atlas size.
+static const int DEFAULT_ATLAS_SIZE = 2048;
+/// Default padding around sprites.
+static const int DEFAULT_ATLAS_PADDING = 2;
+/// Initial atlas size. Atlases grow up to the maximum size as sprites are added.
+static const int INITIAL_ATLAS_SIZE = 256;
+
+static void DecodeTextureWork(const WorkItem* item, unsigned threadIndex)
+{
+    ParticleAtlasTexture2D* texture = reinterpret_cast<ParticleAtlasTexture2D*>(item->start_);
+    Context* context = reinterpret_cast<Context*>(item->aux_);
+
+    SharedPtr<Image> image(new Image(context));
+    File file(context);
+    if (file.Open(texture->fileName_) && image->Load(file))
+        texture->image_ = image;
+}
+
+static bool CompareTextureSize(const ParticleAtlasTexture2D* lhs, const ParticleAtlasTexture2D* rhs)
+{
+    if (lhs->image_->GetHeight() != rhs->image_->GetHeight())
+        return lhs->image_->GetHeight() > rhs->image_->GetHeight();
+    return lhs->image_->GetWidth() > rhs->image_->GetWidth();
+}
+
+ParticleAtlasBuilder2D::ParticleAtlasBuilder2D(Context* context) :
+    Object(context),
+    maxSize_(DEFAULT_ATLAS_SIZE),
+    padding_(DEFAULT_ATLAS_PADDING)
+{
+    SharedPtr<ParticleEffect2D> defaultEffect(new ParticleEffect2D(context_));
+    GetParticleEffectParameters(defaultEffect, defaults_);
+}
+
+ParticleAtlasBuilder2D::~ParticleAtlasBuilder2D()
+{
+}
+
+void ParticleAtlasBuilder2D::SetMaxSize(int size)
+{
+    maxSize_ = Max(size, 1);
+}
+
+void ParticleAtlasBuilder2D::SetPadding(int padding)
+{
+    padding_ = Max(padding, 0);
+}
+
+bool ParticleAtlasBuilder2D::AddEffect(const String& fileName)
+{
+    ParticleEffectParameters2D parameters = defaults_;
+    ParticleEffectSettings2D settings;
+    String textureName;
+
+    MemoryMappedFile file;
+    if (!file.Open(fileName) || !ReadParticleEffectData(context_, IsParticleEffectBinary(fileName), file.GetData(), file.GetSize(),
+        parameters, settings, textureName))
+    {
+        LOGERROR("Read particle effect failed " + fileName);
+        return false;
+    }
+
+    if (textureName.Empty())
+        return false;
+
+    if (textureName.Find('@') != String::NPOS)
+    {
+        LOGWARNING("Texture of " + fileName + " is already in a sprite sheet");
+        return false;
+    }
+
+    String textureFileName = GetPath(fileName) + textureName;
+    unsigned index;
+    HashMap<String, unsigned>::ConstIterator i = textureIndices_.Find(textureFileName);
+    if (i != textureIndices_.End())
+        index = i->second_;
+    else
+    {
+        ParticleAtlasTexture2D texture;
+        texture.fileName_ = textureFileName;
+
+        // Sprites are named after their texture file, numbered when textures of different directories share a name
+        texture.spriteName_ = GetFileNameAndExtension(textureFileName);
+        for (unsigned n = 1; spriteNames_.Contains(texture.spriteName_); ++n)
+            texture.spriteName_ = GetFileName(textureFileName) + "_" + String(n) + GetExtension(textureFileName);
+        spriteNames_.Insert(texture.spriteName_);
+
+        index = textures_.Size();
+        textures_.Push(texture);
+        textureIndices_[textureFileName] = index;
+    }
+
+    if (!effectTextures_.Contains(fileName))
+        effects_.Push(fileName);
+    effectTextures_[fileName] = index;
+    return true;
+}
+
+bool ParticleAtlasBuilder2D::Build(const String& pathName, const String& baseName)
+{
+    atlasNames_.Clear();
+    if (textures_.Empty())
+    {
+        LOGERROR("No textures to pack");
+        return false;
+    }
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    bool threaded = queue && queue->GetNumThreads() && textures_.Size() > 1;
+
+    WorkItem item;
+    item.workFunction_ = DecodeTextureWork;
+    item.aux_ = context_;
+    item.priority_ = M_MAX_UNSIGNED;
+
+    for (unsigned i = 0; i < textures_.Size(); ++i)
+    {
+        item.start_ = &textures_[i];
+        if (threaded)
+            queue->AddWorkItem(item);
+        else
+            DecodeTextureWork(&item, 0);
+    }
+
+    if (threaded)
+        queue->Complete(M_MAX_UNSIGNED);
+
+    PODVector<ParticleAtlasTexture2D*> order;
+    for (unsigned i = 0; i < textures_.Size(); ++i)
+    {
+        ParticleAtlasTexture2D& texture = textures_[i];
+        if (!texture.image_)
+        {
+            LOGERROR("Load texture failed " + texture.fileName_);
+            return false;
+        }
+
+        if (texture.image_->IsCompressed())
+        {
+            LOGERROR("Compressed texture can not be packed " + texture.fileName_);
+            return false;
+        }
+
+        if (texture.image_->GetWidth() + 2 * padding_ > maxSize_ || texture.image_->GetHeight() + 2 * padding_ > maxSize_)
+        {
+            LOGERROR("Texture is larger than the atlas " + texture.fileName_);
+            return false;
+        }
+
+        order.Push(&texture);
+    }
+
+    // Tallest first, each into the first atlas with room
+    Sort(order.Begin(), order.End(), CompareTextureSize);
+
+    Vector<AreaAllocator> allocators;
+    int initialSize = Min(INITIAL_ATLAS_SIZE, maxSize_);
+    for (unsigned i = 0; i < order.Size(); ++i)
+    {
+        ParticleAtlasTexture2D& texture = *order[i];
+        int width = texture.image_->GetWidth();
+        int height = texture.image_->GetHeight();
+
+        int x = 0;
+        int y = 0;
+        unsigned atlas = 0;
+        while (atlas < allocators.Size() && !allocators[atlas].Allocate(width + 2 * padding_, height + 2 * padding_, x, y))
+            ++atlas;
+
+        if (atlas == allocators.Size())
+        {
+            allocators.Push(AreaAllocator(initialSize, initialSize, maxSize_, maxSize_));
+            if (!allocators.Back().Allocate(width + 2 * padding_, height + 2 * padding_, x, y))
+            {
+                LOGERROR("Pack texture failed " + texture.fileName_);
+                return false;
+            }
+        }
+
+        texture.atlas_ = atlas;
+        texture.rectangle_ = IntRect(x + padding_, y + padding_, x + padding_ + width, y + padding_ + height);
+    }
+
+    for (unsigned i = 0; i < allocators.Size(); ++i)
+    {
+        String atlasName = baseName + String(i);
+        int width = allocators[i].GetWidth();
+        int height = allocators[i].GetHeight();
+
+        SharedPtr<Image> atlasImage(new Image(context_));
+        atlasImage->SetSize(width, height, 4);
+        memset(atlasImage->GetData(), 0, width * height * 4);
+
+        SharedPtr<XMLFile> xmlFile(new XMLFile(context_));
+        XMLElement rootElem = xmlFile->CreateRoot("TextureAtlas");
+        rootElem.SetAttribute("imagePath", atlasName + ".png");
+
+        for (unsigned j = 0; j < textures_.Size(); ++j)
+        {
+            const ParticleAtlasTexture2D& texture = textures_[j];
+            if (texture.atlas_ != i)
+                continue;
+
+            CopyTexture(texture, atlasImage);
+
+            XMLElement subTextureElem = rootElem.CreateChild("SubTexture");
+            subTextureElem.SetAttribute("name", texture.spriteName_);
+            subTextureElem.SetInt("x", texture.rectangle_.left_);
+            subTextureElem.SetInt("y", texture.rectangle_.top_);
+            subTextureElem.SetInt("width", texture.rectangle_.Width());
+            subTextureElem.SetInt("height", texture.rectangle_.Height());
+        }
+
+        if (!atlasImage->SavePNG(pathName + atlasName + ".png"))
+        {
+            LOGERROR("Save atlas image failed " + pathName + atlasName + ".png");
+            return false;
+        }
+
+        File file(context_);
+        if (!file.Open(pathName + atlasName + ".xml", FILE_WRITE) || !xmlFile->Save(file))
+        {
+            LOGERROR("Save sprite sheet failed " + pathName + atlasName + ".xml");
+            return false;
+        }
+
+        atlasNames_.Push(atlasName + ".xml");
+    }
+
+    for (unsigned i = 0; i < textures_.Size(); ++i)
+        textures_[i].image_.Reset();
+
+    LOGINFO("Packed " + String(textures_.Size()) + " textures into " + String(atlasNames_.Size()) + " atlases");
+    return true;
+}
+
+bool ParticleAtlasBuilder2D::WriteEffects(const String& pathName)
+{
+    bool success = true;
+    for (unsigned i = 0; i < effects_.Size(); ++i)
+    {
+        const String& fileName = effects_[i];
+        bool binary = IsParticleEffectBinary(fileName);
+
+        ParticleEffectParameters2D parameters = defaults_;
+        ParticleEffectSettings2D settings;
+        String textureName;
+        VectorBuffer buffer;
+
+        // Unmap the source before writing, the output may replace it
+        {
+            MemoryMappedFile source;
+            if (!source.Open(fileName) || !ReadParticleEffectData(context_, binary, source.GetData(), source.GetSize(), parameters,
+                settings, textureName))
+            {
+                LOGERROR("Read particle effect failed " + fileName);
+                success = false;
+                continue;
+            }
+        }
+
+        String atlasTextureName = GetTextureName(fileName);
+        if (!atlasTextureName.Empty())
+            textureName = atlasTextureName;
+
+        String outputName = pathName + GetFileNameAndExtension(fileName);
+        File file(context_);
+        if (!WriteParticleEffectData(context_, binary, parameters, settings, textureName, buffer) ||
+            !file.Open(outputName, FILE_WRITE) || file.Write(buffer.GetData(), buffer.GetSize()) != buffer.GetSize())
+        {
+            LOGERROR("Write particle effect failed " + outputName);
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+String ParticleAtlasBuilder2D::GetTextureName(const String& fileName) const
+{
+    HashMap<String, unsigned>::ConstIterator i = effectTextures_.Find(fileName);
+    if (i == effectTextures_.End())
+        return String::EMPTY;
+
+    const ParticleAtlasTexture2D& texture = textures_[i->second_];
+    if (texture.atlas_ >= atlasNames_.Size())
+        return String::EMPTY;
+
+    return atlasNames_[texture.atlas_] + "@" + texture.spriteName_;
+}
+
+void ParticleAtlasBuilder2D::CopyTexture(const ParticleAtlasTexture2D& texture, Image* atlas) const
+{
+    const IntRect& rectangle = texture.rectangle_;
+    int width = rectangle.Width();
+    int height = rectangle.Height();
+
+    // Extruded edges keep filtering at the sprite border from sampling its neighbours
+    for (int y = -padding_; y < height + padding_; ++y)
+    {
+        for (int x = -padding_; x < width + padding_; ++x)
+        {
+            Color color = texture.image_->GetPixel(Clamp(x, 0, width - 1), Clamp(y, 0, height - 1));
+            atlas->SetPixel(rectangle.left_ + x, rectangle.top_ + y, color);
+        }
+    }
+}
+
+}
@@ -0,0 +1,118 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "HashMap.h"
+#include "HashSet.h"
+#include "Object.h"
+#include "ParticleEffectBinary2D.h"
+#include "Rect.h"
+
+namespace Urho3D
+{
+
+class Image;
+
+/// Texture packed by the atlas builder.
+struct ParticleAtlasTexture2D
+{
+    /// Construct.
+    ParticleAtlasTexture2D() :
+        atlas_(0)
+    {
+    }
+
+    /// Texture file name.
+    String fileName_;
+    /// Sprite name in the sprite sheet.
+    String spriteName_;
+    /// Decoded image, released after packing.
+    SharedPtr<Image> image_;
+    /// Atlas index.
+    unsigned atlas_;
+    /// Rectangle in the atlas, excluding padding.
+    IntRect rectangle_;
+};
+
+/// Packs the textures used by a set of particle effects into shared atlases, so that emitters of different effects batch
+/// into one draw call. Each atlas is written as a PNG image and a sprite sheet, and effects refer to their sprite as
+/// sheet.xml@sprite.
+class ParticleAtlasBuilder2D : public Object
+{
+    OBJECT(ParticleAtlasBuilder2D)
+
+public:
+    /// Construct.
+    ParticleAtlasBuilder2D(Context* context);
+    /// Destruct.
+    virtual ~ParticleAtlasBuilder2D();
+
+    /// Set maximum atlas width and height.
+    void SetMaxSize(int size);
+    /// Set padding around each sprite, filled with its edge pixels.
+    void SetPadding(int padding);
+    /// Add an effect file by file system path. Return true if it has a texture to pack.
+    bool AddEffect(const String& fileName);
+    /// Decode and pack the textures, then write the atlases as baseName0.png and baseName0.xml and so on to pathName. Return
+    /// true if successful.
+    bool Build(const String& pathName, const String& baseName);
+    /// Write the added effects to pathName in their own format, with texture names pointing into the atlases. Return true if
+    /// successful.
+    bool WriteEffects(const String& pathName);
+
+    /// Return maximum atlas size.
+    int GetMaxSize() const { return maxSize_; }
+    /// Return padding.
+    int GetPadding() const { return padding_; }
+    /// Return texture name of an added effect after building, or empty if its texture was not packed.
+    String GetTextureName(const String& fileName) const;
+    /// Return number of atlases after building.
+    unsigned GetNumAtlases() const { return atlasNames_.Size(); }
+    /// Return packed textures.
+    const Vector<ParticleAtlasTexture2D>& GetTextures() const { return textures_; }
+
+private:
+    /// Copy a texture into its atlas, extruding its edges into the padding.
+    void CopyTexture(const ParticleAtlasTexture2D& texture, Image* atlas) const;
+
+    /// Maximum atlas size.
+    int maxSize_;
+    /// Padding around sprites.
+    int padding_;
+    /// Textures.
+    Vector<ParticleAtlasTexture2D> textures_;
+    /// Texture index by file name.
+    HashMap<String, unsigned> textureIndices_;
+    /// Sprite names in use.
+    HashSet<String> spriteNames_;
+    /// Texture index by effect file name.
+    HashMap<String, unsigned> effectTextures_;
+    /// Effect file names in the order added.
+    Vector<String> effects_;
+    /// Sprite sheet file names of the atlases.
+    Vector<String> atlasNames_;
+    /// Parameters of a default constructed effect, used for missing elements.
+    ParticleEffectParameters2D defaults_;
+};
+
+}
@@ -0,0 +1,448 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Color.h"
+#include "Context.h"
+#include "FileSystem.h"
+#include "Log.h"
+#include "MathDefs.h"
+#include "ParticleBake2D.h"
+#include "ParticleEffect2D.h"
+#include "ParticleEffectBinary2D.h"
+#include "ParticleSimulator2D.h"
+#include "Serializer.h"
+#include "Sort.h"
+
+#include <cstring>
+
+namespace Urho3D
+{
+
+/// Baked particle file extension.
+static const char* PARTICLE_BAKE_EXTENSION = ".pbake";
+/// Simulation steps per second while baking. Frames are recorded every few steps.
+static const float BAKE_STEP_RATE = 60.0f;
+/// Largest quantized value.
+static const float QUANTIZE_MAX = 65535.0f;
+
+/// Compare records by id.
+static bool CompareRecords(const ParticleBakeRecord2D& lhs, const ParticleBakeRecord2D& rhs)
+{
+    return lhs.id_ < rhs.id_;
+}
+
+/// Quantize a value in range to 16 bits.
+static unsigned short Quantize(float value, float min, float max)
+{
+    float range = max - min;
+    if (range <= 0.0f)
+        return 0;
+
+    return (unsigned short)Clamp((value - min) / range * QUANTIZE_MAX + 0.5f, 0.0f, QUANTIZE_MAX);
+}
+
+/// Record the live particles of a simulator as a frame.
+static void RecordFrame(const ParticleSimulator2D* simulator, PODVector<ParticleBakeFrame2D>& frames,
+    PODVector<ParticleBakeRecord2D>& records)
+{
+    const ParticlePool2D& particles = simulator->GetParticles();
+    const PODVector<unsigned>& ids = simulator->GetParticleIds();
+
+    ParticleBakeFrame2D frame;
+    frame.firstRecord_ = records.Size();
+    frame.min_[0] = frame.min_[1] = M_INFINITY;
+    frame.max_[0] = frame.max_[1] = -M_INFINITY;
+    frame.maxSize_ = 0.0f;
+
+    // Particles that died in the last step are removed only by the next one, so they are left out here
+    for (unsigned i = 0; i < particles.GetSize(); ++i)
+    {
+        if (particles.Get(PS_TIME_TO_LIVE, i) <= 0.0f)
+            continue;
+
+        float x = particles.Get(PS_POSITION_X, i);
+        float y = particles.Get(PS_POSITION_Y, i);
+        frame.min_[0] = Min(frame.min_[0], x);
+        frame.min_[1] = Min(frame.min_[1], y);
+        frame.max_[0] = Max(frame.max_[0], x);
+        frame.max_[1] = Max(frame.max_[1], y);
+        frame.maxSize_ = Max(frame.maxSize_, particles.Get(PS_SIZE, i));
+    }
+
+    for (unsigned i = 0; i < particles.GetSize(); ++i)
+    {
+        if (particles.Get(PS_TIME_TO_LIVE, i) <= 0.0f)
+            continue;
+
+        float rotation = fmodf(particles.Get(PS_ROTATION, i), 360.0f);
+        if (rotation < 0.0f)
+            rotation += 360.0f;
+
+        ParticleBakeRecord2D record;
+        record.id_ = ids[i];
+        record.position_[0] = Quantize(particles.Get(PS_POSITION_X, i), frame.min_[0], frame.max_[0]);
+        record.position_[1] = Quantize(particles.Get(PS_POSITION_Y, i), frame.min_[1], frame.max_[1]);
+        record.size_ = Quantize(particles.Get(PS_SIZE, i), 0.0f, frame.maxSize_);
+        record.rotation_ = (unsigned short)((unsigned)(rotation * (65536.0f / 360.0f) + 0.5f) & 0xffff);
+        record.color_ = Color(particles.Get(PS_COLOR_R, i), particles.Get(PS_COLOR_G, i), particles.Get(PS_COLOR_B, i),
+            particles.Get(PS_COLOR_A, i)).ToUInt();
+        records.Push(record);
+    }
+
+    // Sorted ids let playback pair up the particles of two frames in one pass
+    frame.numRecords_ = records.Size() - frame.firstRecord_;
+    if (frame.numRecords_)
+        Sort(records.Begin() + frame.firstRecord_, records.End(), CompareRecords);
+    else
+        frame.min_[0] = frame.min_[1] = frame.max_[0] = frame.max_[1] = 0.0f;
+
+    frames.Push(frame);
+}
+
+/// Decodes the records of one frame.
+struct ParticleBakeDecoder2D
+{
+    /// Construct from a frame.
+    ParticleBakeDecoder2D(const ParticleBakeFrame2D& frame) :
+        min_(frame.min_[0], frame.min_[1]),
+        positionScale_((frame.max_[0] - frame.min_[0]) / QUANTIZE_MAX, (frame.max_[1] - frame.min_[1]) / QUANTIZE_MAX),
+        sizeScale_(frame.maxSize_ / QUANTIZE_MAX)
+    {
+    }
+
+    /// Decode a record.
+    void Decode(const ParticleBakeRecord2D& record, ParticleBakeSample2D& dest) const
+    {
+        dest.position_.x_ = min_.x_ + record.position_[0] * positionScale_.x_;
+        dest.position_.y_ = min_.y_ + record.position_[1] * positionScale_.y_;
+        dest.size_ = record.size_ * sizeScale_;
+        dest.rotation_ = record.rotation_ * (360.0f / 65536.0f);
+        dest.color_ = record.color_;
+    }
+
+    /// Lower bounds of the positions.
+    Vector2 min_;
+    /// Position units per quantization step.
+    Vector2 positionScale_;
+    /// Size units per quantization step.
+    float sizeScale_;
+};
+
+/// Blend two packed colors one channel at a time.
+static unsigned LerpColor(unsigned from, unsigned to, float t)
+{
+    unsigned weight = (unsigned)(t * 256.0f);
+    unsigned result = 0;
+    for (unsigned shift = 0; shift < 32; shift += 8)
+    {
+        unsigned a = (from >> shift) & 0xff;
+        unsigned b = (to >> shift) & 0xff;
+        result |= ((a * (256 - weight) + b * weight) >> 8) << shift;
+    }
+    return result;
+}
+
+/// Scale the alpha of a packed color.
+static unsigned FadeColor(unsigned color, float t)
+{
+    unsigned alpha = (unsigned)((color >> 24) * t);
+    return (color & 0x00ffffff) | (alpha << 24);
+}
+
+bool IsParticleBake(const String& fileName)
+{
+    return GetExtension(fileName) == PARTICLE_BAKE_EXTENSION;
+}
+
+bool BakeParticleEffect(Context* context, ParticleEffect2D* effect, unsigned randomSeed, float duration, float frameRate,
+    Serializer& dest)
+{
+    if (!effect || duration <= 0.0f || frameRate <= 0.0f)
+        return false;
+
+    SharedPtr<ParticleSimulator2D> simulator(new ParticleSimulator2D(context));
+    simulator->SetRandomSeed(randomSeed);
+    simulator->SetTrackIds(true);
+    simulator->SetEffect(effect);
+
+    // Effects that emit forever are baked in their steady state and wrap around, one-shot effects are baked from the start
+    // with a frame at each end
+    bool looping = effect->GetDuration() < 0.0f;
+    unsigned numFrames = Max((unsigned)(duration * frameRate + 0.5f), 1U);
+    if (!looping)
+        ++numFrames;
+
+    unsigned stepsPerFrame = Max((unsigned)(BAKE_STEP_RATE / frameRate + 0.5f), 1U);
+    float timeStep = 1.0f / (frameRate * stepsPerFrame);
+    if (looping)
+        simulator->Seek(effect->GetParticleLifeSpan() + Max(effect->GetParticleLifespanVariance(), 0.0f), timeStep);
+
+    PODVector<ParticleBakeFrame2D> frames;
+    PODVector<ParticleBakeRecord2D> records;
+    frames.Reserve(numFrames);
+    for (unsigned i = 0; i < numFrames; ++i)
+    {
+        if (i)
+        {
+            for (unsigned j = 0; j < stepsPerFrame; ++j)
+                simulator->Update(timeStep);
+        }
+        RecordFrame(simulator, frames, records);
+    }
+
+    String textureName = GetParticleEffectTextureName(effect->GetSprite());
+
+    ParticleBakeHeader2D header;
+    header.id_ = PARTICLE_BAKE_ID;
+    header.version_ = PARTICLE_BAKE_VERSION;
+    header.frameRate_ = frameRate;
+    header.numFrames_ = numFrames;
+    header.looping_ = looping ? 1 : 0;
+    header.blendMode_ = (unsigned)effect->GetBlendMode();
+    header.framesOffset_ = sizeof header;
+    header.recordsOffset_ = header.framesOffset_ + numFrames * sizeof(ParticleBakeFrame2D);
+    header.numRecords_ = records.Size();
+    header.stringsOffset_ = header.recordsOffset_ + records.Size() * sizeof(ParticleBakeRecord2D);
+    header.stringsSize_ = textureName.Empty() ? 0 : textureName.Length() + 1;
+    header.textureName_ = textureName.Empty() ? M_MAX_UNSIGNED : 0;
+
+    unsigned framesSize = numFrames * sizeof(ParticleBakeFrame2D);
+    unsigned recordsSize = records.Size() * sizeof(ParticleBakeRecord2D);
+
+    bool success = true;
+    success &= dest.Write(&header, sizeof header) == sizeof header;
+    success &= dest.Write(&frames[0], framesSize) == framesSize;
+    if (recordsSize)
+        success &= dest.Write(&records[0], recordsSize) == recordsSize;
+    if (header.stringsSize_)
+        success &= dest.Write(textureName.CString(), header.stringsSize_) == header.stringsSize_;
+
+    return success;
+}
+
+ParticleBake2D::ParticleBake2D() :
+    frames_(0),
+    records_(0),
+    size_(0)
+{
+    memset(&header_, 0, sizeof header_);
+}
+
+ParticleBake2D::~ParticleBake2D()
+{
+}
+
+bool ParticleBake2D::Load(Context* context, const String& fileName)
+{
+    Clear();
+
+    if (!mappedFile_.Open(context, fileName))
+    {
+        LOGERROR("Open baked particles failed " + fileName);
+        return false;
+    }
+
+    if (!SetData(mappedFile_.GetData(), mappedFile_.GetSize()))
+    {
+        LOGERROR("Load baked particles failed " + fileName);
+        Clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool ParticleBake2D::Load(const unsigned char* data, unsigned size)
+{
+    Clear();
+
+    buffer_ = new unsigned char[size];
+    memcpy(buffer_.Get(), data, size);
+    if (!SetData(buffer_.Get(), size))
+    {
+        Clear();
+        return false;
+    }
+
+    return true;
+}
+
+void ParticleBake2D::Sample(float time, PODVector<ParticleBakeSample2D>& dest) const
+{
+    dest.Clear();
+    if (!header_.numFrames_)
+        return;
+
+    // Pick the two frames around the time and how far between them it is
+    unsigned numFrames = header_.numFrames_;
+    float position = time * header_.frameRate_;
+    if (header_.looping_)
+    {
+        position = fmodf(position, (float)numFrames);
+        if (position < 0.0f)
+            position += (float)numFrames;
+    }
+    else
+        position = Clamp(position, 0.0f, (float)(numFrames - 1));
+
+    unsigned first = Min((unsigned)position, numFrames - 1);
+    unsigned second = header_.looping_ ? (first + 1) % numFrames : Min(first + 1, numFrames - 1);
+    float t = Clamp(position - (float)first, 0.0f, 1.0f);
+
+    const ParticleBakeFrame2D& firstFrame = frames_[first];
+    const ParticleBakeFrame2D& secondFrame = frames_[second];
+    ParticleBakeDecoder2D firstDecoder(firstFrame);
+    ParticleBakeDecoder2D secondDecoder(secondFrame);
+    const ParticleBakeRecord2D* a = records_ + firstFrame.firstRecord_;
+    const ParticleBakeRecord2D* aEnd = a + firstFrame.numRecords_;
+    const ParticleBakeRecord2D* b = records_ + secondFrame.firstRecord_;
+    const ParticleBakeRecord2D* bEnd = b + secondFrame.numRecords_;
+
+    dest.Resize(firstFrame.numRecords_ + secondFrame.numRecords_);
+    if (dest.Empty())
+        return;
+    ParticleBakeSample2D* sample = &dest[0];
+
+    // Both runs are sorted by id, so particles alive in both frames meet in one pass
+    while (a < aEnd || b < bEnd)
+    {
+        if (b == bEnd || (a < aEnd && a->id_ < b->id_))
+        {
+            firstDecoder.Decode(*a++, *sample);
+            sample->color_ = FadeColor(sample->color_, 1.0f - t);
+        }
+        else if (a == aEnd || b->id_ < a->id_)
+        {
+            secondDecoder.Decode(*b++, *sample);
+            sample->color_ = FadeColor(sample->color_, t);
+        }
+        else
+        {
+            ParticleBakeSample2D next;
+            firstDecoder.Decode(*a++, *sample);
+            secondDecoder.Decode(*b++, next);
+
+            // Rotation turns the short way across the wrap at 360 degrees
+            float rotationDelta = next.rotation_ - sample->rotation_;
+            if (rotationDelta > 180.0f)
+                rotationDelta -= 360.0f;
+            else if (rotationDelta < -180.0f)
+                rotationDelta += 360.0f;
+
+            sample->position_ += (next.position_ - sample->position_) * t;
+            sample->size_ += (next.size_ - sample->size_) * t;
+            sample->rotation_ += rotationDelta * t;
+            sample->color_ = LerpColor(sample->color_, next.color_, t);
+        }
+        ++sample;
+    }
+
+    dest.Resize((unsigned)(sample - &dest[0]));
+}
+
+float ParticleBake2D::GetDuration() const
+{
+    if (!header_.numFrames_ || header_.frameRate_ <= 0.0f)
+        return 0.0f;
+
+    return (header_.looping_ ? header_.numFrames_ : header_.numFrames_ - 1) / header_.frameRate_;
+}
+
+unsigned ParticleBake2D::GetNumParticles(unsigned frame) const
+{
+    return frame < header_.numFrames_ ? frames_[frame].numRecords_ : 0;
+}
+
+bool ParticleBake2D::SetData(const unsigned char* data, unsigned size)
+{
+    if (!data || size < sizeof(ParticleBakeHeader2D))
+    {
+        LOGERROR("Baked particle data is too small");
+        return false;
+    }
+
+    memcpy(&header_, data, sizeof header_);
+    if (header_.id_ != PARTICLE_BAKE_ID)
+    {
+        LOGERROR("Not baked particle data");
+        return false;
+    }
+    if (header_.version_ != PARTICLE_BAKE_VERSION)
+    {
+        LOGERROR("Unsupported baked particle version " + String(header_.version_));
+        return false;
+    }
+
+    // Counts are checked against the size before they are multiplied, so a damaged header cannot overflow the checks
+    if (header_.numFrames_ > size / sizeof(ParticleBakeFrame2D) || header_.numRecords_ > size / sizeof(ParticleBakeRecord2D) ||
+        !IsBlockValid(header_.framesOffset_, header_.numFrames_ * sizeof(ParticleBakeFrame2D), size) ||
+        !IsBlockValid(header_.recordsOffset_, header_.numRecords_ * sizeof(ParticleBakeRecord2D), size) ||
+        !IsBlockValid(header_.stringsOffset_, header_.stringsSize_, size) ||
+        header_.framesOffset_ % 4 || header_.recordsOffset_ % 4)
+    {
+        LOGERROR("Baked particle data is truncated");
+        return false;
+    }
+
+    frames_ = (const ParticleBakeFrame2D*)(data + header_.framesOffset_);
+    records_ = (const ParticleBakeRecord2D*)(data + header_.recordsOffset_);
+    for (unsigned i = 0; i < header_.numFrames_; ++i)
+    {
+        const ParticleBakeFrame2D& frame = frames_[i];
+        if (frame.firstRecord_ > header_.numRecords_ || frame.numRecords_ > header_.numRecords_ - frame.firstRecord_)
+        {
+            LOGERROR("Baked particle frame " + String(i) + " is out of range");
+            return false;
+        }
+    }
+
+    textureName_.Clear();
+    if (header_.textureName_ != M_MAX_UNSIGNED)
+    {
+        const char* strings = (const char*)data + header_.stringsOffset_;
+        unsigned length = header_.textureName_;
+        while (length < header_.stringsSize_ && strings[length])
+            ++length;
+        if (length >= header_.stringsSize_)
+        {
+            LOGERROR("Baked particle texture name is not terminated");
+            return false;
+        }
+        textureName_ = String(strings + header_.textureName_, length - header_.textureName_);
+    }
+
+    size_ = size;
+    return true;
+}
+
+void ParticleBake2D::Clear()
+{
+    mappedFile_.Close();
+    buffer_.Reset();
+    memset(&header_, 0, sizeof header_);
+    frames_ = 0;
+    records_ = 0;
+    size_ = 0;
+    textureName_.Clear();
+}
+
+}
@@ -0,0 +1,180 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "ArrayPtr.h"
+#include "GraphicsDefs.h"
+#include "MemoryMappedFile.h"
+#include "RefCounted.h"
+#include "Vector2.h"
+
+namespace Urho3D
+{
+
+class Context;
+class ParticleEffect2D;
+class Serializer;
+
+/// Baked particle file identifier, "PBAK" in file order.
+static const unsigned PARTICLE_BAKE_ID = 0x4B414250;
+/// Baked particle format version.
+static const unsigned PARTICLE_BAKE_VERSION = 1;
+
+/// Baked particle file header. All fields are 32-bit little endian so the file can be used straight from a memory map.
+struct ParticleBakeHeader2D
+{
+    /// File identifier.
+    unsigned id_;
+    /// Format version.
+    unsigned version_;
+    /// Frames per second.
+    float frameRate_;
+    /// Number of frames.
+    unsigned numFrames_;
+    /// Nonzero if playback wraps from the last frame to the first.
+    unsigned looping_;
+    /// Blend mode of the effect.
+    unsigned blendMode_;
+    /// Frame table offset.
+    unsigned framesOffset_;
+    /// Particle records offset.
+    unsigned recordsOffset_;
+    /// Number of particle records of all frames.
+    unsigned numRecords_;
+    /// String table offset. Strings are zero terminated and stored once.
+    unsigned stringsOffset_;
+    /// String table size.
+    unsigned stringsSize_;
+    /// Texture file name as an offset into the string table, relative to the baked file. M_MAX_UNSIGNED if none.
+    unsigned textureName_;
+};
+
+/// Baked frame, the particles alive at one instant as a run of records sorted by id.
+struct ParticleBakeFrame2D
+{
+    /// Index of the first record.
+    unsigned firstRecord_;
+    /// Number of records.
+    unsigned numRecords_;
+    /// Lower bounds of the positions relative to the emitter, which positions are quantized to.
+    float min_[2];
+    /// Upper bounds of the positions relative to the emitter.
+    float max_[2];
+    /// Largest size, which sizes are quantized to.
+    float maxSize_;
+};
+
+/// Quantized particle state, 16 bytes against 36 for the id and floats it is recorded from.
+struct ParticleBakeRecord2D
+{
+    /// Spawn slot, the same in every frame the particle is alive.
+    unsigned id_;
+    /// Position within the frame bounds, 0 to 65535.
+    unsigned short position_[2];
+    /// Size relative to the largest size of the frame, 0 to 65535.
+    unsigned short size_;
+    /// Rotation, 65536 steps per turn.
+    unsigned short rotation_;
+    /// Color as packed by Color::ToUInt().
+    unsigned color_;
+};
+
+/// Particle state sampled from a bake.
+struct ParticleBakeSample2D
+{
+    /// Position relative to the emitter.
+    Vector2 position_;
+    /// Size.
+    float size_;
+    /// Rotation in degrees.
+    float rotation_;
+    /// Color as packed by Color::ToUInt().
+    unsigned color_;
+};
+
+/// Return whether file name has the baked particle extension.
+bool IsParticleBake(const String& fileName);
+/// Simulate an effect from its start in world units of an unscaled emitter at the origin and record the particles frameRate
+/// times a second for duration seconds. Effects that emit forever are warmed up for one life span first and baked to loop.
+/// Return true if successful.
+bool BakeParticleEffect(Context* context, ParticleEffect2D* effect, unsigned randomSeed, float duration, float frameRate,
+    Serializer& dest);
+
+/// Baked particle playback, read straight from the file data. Sampling interpolates between the two nearest frames, so its
+/// cost is one pass over their records and does not depend on the effect.
+class ParticleBake2D : public RefCounted
+{
+public:
+    /// Construct.
+    ParticleBake2D();
+    /// Destruct.
+    virtual ~ParticleBake2D();
+
+    /// Load from a file through the resource cache. Plain files are memory mapped, packaged ones read into memory. Return true
+    /// if successful.
+    bool Load(Context* context, const String& fileName);
+    /// Load from a copy of data. Return true if successful.
+    bool Load(const unsigned char* data, unsigned size);
+    /// Sample the particles at a time in seconds. Particles alive in only one of the two frames fade in or out between them.
+    void Sample(float time, PODVector<ParticleBakeSample2D>& dest) const;
+
+    /// Return frames per second.
+    float GetFrameRate() const { return header_.frameRate_; }
+    /// Return number of frames.
+    unsigned GetNumFrames() const { return header_.numFrames_; }
+    /// Return length of playback in seconds. Looping bakes include the step from the last frame back to the first.
+    float GetDuration() const;
+    /// Return whether playback loops.
+    bool IsLooping() const { return header_.looping_ != 0; }
+    /// Return blend mode of the baked effect.
+    BlendMode GetBlendMode() const { return (BlendMode)header_.blendMode_; }
+    /// Return texture file name relative to the baked file.
+    const String& GetTextureName() const { return textureName_; }
+    /// Return number of particles of a frame.
+    unsigned GetNumParticles(unsigned frame) const;
+    /// Return size of the data in bytes.
+    unsigned GetDataSize() const { return size_; }
+
+private:
+    /// Validate data and point the frame table and records into it. Return true if successful.
+    bool SetData(const unsigned char* data, unsigned size);
+    /// Clear data.
+    void Clear();
+
+    /// Memory mapped file.
+    MemoryMappedFile mappedFile_;
+    /// Data read into memory when the file could not be mapped.
+    SharedArrayPtr<unsigned char> buffer_;
+    /// Header.
+    ParticleBakeHeader2D header_;
+    /// Frame table.
+    const ParticleBakeFrame2D* frames_;
+    /// Particle records.
+    const ParticleBakeRecord2D* records_;
+    /// Size of the data in bytes.
+    unsigned size_;
+    /// Texture file name.
+    String textureName_;
+};
+
+}
@@ -0,0 +1,70 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "FileSystem.h"
+#include "ParticleComposite2D.h"
+#include "XMLElement.h"
+
+namespace Urho3D
+{
+
+/// Composite effect file extension.
+static const char* PARTICLE_COMPOSITE_EXTENSION = ".pexc";
+
+bool IsParticleComposite(const String& fileName)
+{
+    return GetExtension(fileName) == PARTICLE_COMPOSITE_EXTENSION;
+}
+
+bool ReadParticleComposite(const XMLElement& source, Vector<ParticleCompositeLayer2D>& layers)
+{
+    layers.Clear();
+    if (!source || source.GetName() != "particleComposite")
+        return false;
+
+    for (XMLElement layerElem = source.GetChild("layer"); layerElem; layerElem = layerElem.GetNext("layer"))
+    {
+        ParticleCompositeLayer2D layer;
+        layer.effectName_ = layerElem.GetAttribute("effect");
+        if (layerElem.HasAttribute("offset"))
+            layer.offset_ = layerElem.GetVector2("offset");
+        if (layerElem.HasAttribute("delay"))
+            layer.delay_ = Max(layerElem.GetFloat("delay"), 0.0f);
+        layers.Push(layer);
+    }
+
+    return true;
+}
+
+void WriteParticleComposite(XMLElement& dest, const Vector<ParticleCompositeLayer2D>& layers)
+{
+    dest.RemoveChildren("layer");
+    for (unsigned i = 0; i < layers.Size(); ++i)
+    {
+        XMLElement layerElem = dest.CreateChild("layer");
+        layerElem.SetAttribute("effect", layers[i].effectName_);
+        layerElem.SetVector2("offset", layers[i].offset_);
+        layerElem.SetFloat("delay", layers[i].delay_);
+    }
+}
+
+}
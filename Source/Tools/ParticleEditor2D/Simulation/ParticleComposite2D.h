@@ -0,0 +1,59 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Str.h"
+#include "Vector.h"
+#include "Vector2.h"
+
+namespace Urho3D
+{
+
+class XMLElement;
+
+/// Emitter layer of a composite effect.
+struct ParticleCompositeLayer2D
+{
+    /// Construct.
+    ParticleCompositeLayer2D() :
+        offset_(Vector2::ZERO),
+        delay_(0.0f)
+    {
+    }
+
+    /// Effect file name, relative to the composite file.
+    String effectName_;
+    /// Offset from the composite origin in pixels.
+    Vector2 offset_;
+    /// Time after the composite starts before the layer emits, in seconds.
+    float delay_;
+};
+
+/// Return whether a file name is a composite effect (.pexc).
+bool IsParticleComposite(const String& fileName);
+/// Read layers from the root element of a .pexc file, in draw order. Return true if the root element is a particle composite.
+bool ReadParticleComposite(const XMLElement& source, Vector<ParticleCompositeLayer2D>& layers);
+/// Write layers to the root element of a .pexc file.
+void WriteParticleComposite(XMLElement& dest, const Vector<ParticleCompositeLayer2D>& layers);
+
+}
@@ -0,0 +1,168 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Context.h"
+#include "ParticleCostAnalyzer2D.h"
+#include "ParticleEffect2D.h"
+#include "ParticleSimulator2D.h"
+#include "Timer.h"
+
+namespace Urho3D
+{
+
+/// Default nanoseconds per live particle per step of each emitter type.
+static const float DEFAULT_NS_PER_PARTICLE_STEP[2] = { 4.0f, 6.0f };
+/// Default GPU fill rate in fragments per millisecond, one gigapixel per second.
+static const float DEFAULT_FRAGMENTS_PER_MS = 1000000.0f;
+/// Default screen size in pixels, 1920 x 1080.
+static const float DEFAULT_SCREEN_PIXELS = 1920.0f * 1080.0f;
+/// Overdraw in screens above which an effect is reported.
+static const float OVERDRAW_WARNING_SCREENS = 1.0f;
+/// GPU fill time in milliseconds above which an effect is reported.
+static const float GPU_WARNING_MS = 1.0f;
+/// Simulation time in milliseconds above which an effect is reported.
+static const float CPU_WARNING_MS = 0.5f;
+/// Average particle width in pixels above which an effect is reported.
+static const float LARGE_PARTICLE_PIXELS = 256.0f;
+/// Max particles of the calibration effect.
+static const int CALIBRATION_PARTICLES = 4096;
+/// Measured steps per emitter type when calibrating.
+static const unsigned CALIBRATION_STEPS = 30;
+/// Time step when calibrating.
+static const float CALIBRATION_TIME_STEP = 1.0f / 60.0f;
+
+/// Relative fill cost of a fragment for each blend mode.
+static const float blendModeFillCosts[MAX_BLENDMODES] =
+{
+    1.0f, // Replace
+    2.0f, // Add
+    2.0f, // Multiply
+    2.0f, // Alpha
+    2.0f, // Add alpha
+    2.0f, // Premultiplied alpha
+    2.0f, // Inverse destination alpha
+    2.0f, // Subtract
+    2.0f  // Subtract alpha
+};
+
+/// Return mean of the square of a value drawn uniformly from average +- variance.
+static float MeanSquare(float average, float variance)
+{
+    return average * average + variance * variance / 3.0f;
+}
+
+ParticleCostModel2D::ParticleCostModel2D() :
+    stepsPerFrame_(1.0f),
+    fragmentsPerMs_(DEFAULT_FRAGMENTS_PER_MS),
+    screenPixels_(DEFAULT_SCREEN_PIXELS),
+    calibrated_(false)
+{
+    nsPerParticleStep_[0] = DEFAULT_NS_PER_PARTICLE_STEP[0];
+    nsPerParticleStep_[1] = DEFAULT_NS_PER_PARTICLE_STEP[1];
+}
+
+void EstimateParticleEffectCost(const ParticleEffect2D* effect, const ParticleCostModel2D& model, ParticleCostEstimate2D& dest)
+{
+    dest = ParticleCostEstimate2D();
+    if (!effect)
+        return;
+
+    float maxParticles = (float)Max(effect->GetMaxParticles(), 0);
+    float lifespan = effect->GetParticleLifeSpan();
+    float lifespanVariance = Abs(effect->GetParticleLifespanVariance());
+    float duration = effect->GetDuration();
+    dest.looping_ = duration < 0.0f;
+
+    // Particles drawn with a negative life span never spawn, so only the positive part of the spread counts
+    float meanLifespan = Max(lifespan, 0.0f);
+    if (lifespanVariance > 0.0f && lifespanVariance > Abs(lifespan))
+        meanLifespan = (lifespan + lifespanVariance) * (lifespan + lifespanVariance) / (4.0f * lifespanVariance);
+
+    if (lifespan > 0.0f && duration != 0.0f)
+    {
+        dest.spawnRate_ = maxParticles / lifespan;
+        float aliveTime = dest.looping_ ? meanLifespan : Min(meanLifespan, duration);
+        dest.liveParticles_ = Min(dest.spawnRate_ * aliveTime, maxParticles);
+    }
+
+    // Size runs linearly from start to finish, so its mean square over a life is (a^2 + ab + b^2) / 3 of the two ends
+    float startSize = effect->GetStartParticleSize();
+    float finishSize = effect->GetFinishParticleSize();
+    float startSquare = MeanSquare(startSize, effect->GetStartParticleSizeVariance());
+    float finishSquare = MeanSquare(finishSize, effect->GetFinishParticleSizeVariance());
+    dest.particleArea_ = (startSquare + startSize * finishSize + finishSquare) / 3.0f;
+
+    dest.fragments_ = dest.liveParticles_ * dest.particleArea_;
+    dest.screens_ = dest.fragments_ / model.screenPixels_;
+    dest.blendCost_ = GetBlendModeFillCost(effect->GetBlendMode());
+    dest.gpuMs_ = dest.fragments_ * dest.blendCost_ / model.fragmentsPerMs_;
+
+    int emitterType = effect->GetEmitterType() == EMITTER_TYPE_RADIAL ? 1 : 0;
+    dest.cpuMs_ = dest.liveParticles_ * model.stepsPerFrame_ * model.nsPerParticleStep_[emitterType] * 0.000001f;
+
+    if (dest.screens_ > OVERDRAW_WARNING_SCREENS)
+        dest.warnings_.Push(ToString("overdraw of %.1f screens", dest.screens_));
+    if (dest.gpuMs_ > GPU_WARNING_MS)
+        dest.warnings_.Push(ToString("fill takes %.2f ms", dest.gpuMs_));
+    if (dest.cpuMs_ > CPU_WARNING_MS)
+        dest.warnings_.Push(ToString("simulation takes %.2f ms", dest.cpuMs_));
+    if (dest.particleArea_ > LARGE_PARTICLE_PIXELS * LARGE_PARTICLE_PIXELS)
+        dest.warnings_.Push("particles average " + String((int)sqrtf(dest.particleArea_)) + " pixels across");
+}
+
+void CalibrateParticleCostModel(Context* context, ParticleCostModel2D& model)
+{
+    for (int type = 0; type < 2; ++type)
+    {
+        SharedPtr<ParticleEffect2D> effect(new ParticleEffect2D(context));
+        effect->SetEmitterType((EmitterType2D)type);
+        effect->SetMaxParticles(CALIBRATION_PARTICLES);
+        effect->SetParticleLifeSpan(1.0f);
+        effect->SetParticleLifespanVariance(0.0f);
+        effect->SetDuration(-1.0f);
+
+        SharedPtr<ParticleSimulator2D> simulator(new ParticleSimulator2D(context));
+        simulator->SetEffect(effect);
+        simulator->Seek(effect->GetParticleLifeSpan(), CALIBRATION_TIME_STEP);
+
+        HiresTimer timer;
+        unsigned particleSteps = 0;
+        for (unsigned i = 0; i < CALIBRATION_STEPS; ++i)
+        {
+            particleSteps += simulator->GetNumParticles();
+            simulator->Update(CALIBRATION_TIME_STEP);
+        }
+        long long elapsed = timer.GetUSec(false);
+
+        if (particleSteps)
+            model.nsPerParticleStep_[type] = elapsed * 1000.0f / particleSteps;
+    }
+
+    model.calibrated_ = true;
+}
+
+float GetBlendModeFillCost(BlendMode blendMode)
+{
+    return blendMode < MAX_BLENDMODES ? blendModeFillCosts[blendMode] : 1.0f;
+}
+
+}
@@ -0,0 +1,102 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "GraphicsDefs.h"
+#include "Str.h"
+#include "Vector.h"
+
+namespace Urho3D
+{
+
+class Context;
+class ParticleEffect2D;
+
+/// Machine rates that effect costs are estimated with.
+struct ParticleCostModel2D
+{
+    /// Construct with typical rates of the SIMD kernels on a desktop CPU and a mobile class GPU.
+    ParticleCostModel2D();
+
+    /// Nanoseconds per live particle per simulation step, indexed by emitter type.
+    float nsPerParticleStep_[2];
+    /// Simulation steps per frame.
+    float stepsPerFrame_;
+    /// Fragments the GPU fills per millisecond.
+    float fragmentsPerMs_;
+    /// Screen size in pixels that overdraw is expressed in.
+    float screenPixels_;
+    /// Whether the simulation rates were measured on this machine.
+    bool calibrated_;
+};
+
+/// Static cost estimate of a particle effect. Areas are in effect pixels, which are screen pixels at 1:1 zoom.
+struct ParticleCostEstimate2D
+{
+    /// Construct with zero cost.
+    ParticleCostEstimate2D() :
+        looping_(false),
+        spawnRate_(0.0f),
+        liveParticles_(0.0f),
+        particleArea_(0.0f),
+        fragments_(0.0f),
+        screens_(0.0f),
+        blendCost_(0.0f),
+        gpuMs_(0.0f),
+        cpuMs_(0.0f)
+    {
+    }
+
+    /// Whether the effect emits forever.
+    bool looping_;
+    /// Particles spawned per second.
+    float spawnRate_;
+    /// Live particles in steady state, or at the peak of a one-shot effect.
+    float liveParticles_;
+    /// Area of a particle averaged over its life.
+    float particleArea_;
+    /// Pixels drawn per frame.
+    float fragments_;
+    /// Pixels drawn per frame in screens of the cost model.
+    float screens_;
+    /// Relative cost of a fragment with the effect's blend mode.
+    float blendCost_;
+    /// Estimated GPU fill time per frame in milliseconds.
+    float gpuMs_;
+    /// Estimated simulation time per frame in milliseconds.
+    float cpuMs_;
+    /// Budgets the effect is over.
+    Vector<String> warnings_;
+};
+
+/// Estimate the cost of an effect from its parameters alone. Particles spawn at maxParticles per life span, so the live count is
+/// that rate times the mean life span, limited by max particles and by the duration of one-shot effects. Sizes change linearly
+/// over a life, which with uniform variance gives the mean area in closed form.
+void EstimateParticleEffectCost(const ParticleEffect2D* effect, const ParticleCostModel2D& model, ParticleCostEstimate2D& dest);
+/// Measure the simulation rates of a cost model on this machine by stepping a steady state effect of each emitter type, like the
+/// benchmark does. Takes a few milliseconds.
+void CalibrateParticleCostModel(Context* context, ParticleCostModel2D& model);
+/// Return relative fill cost of a fragment with blend mode. Every mode but replace reads the destination back.
+float GetBlendModeFillCost(BlendMode blendMode);
+
+}
@@ -0,0 +1,625 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Context.h"
+#include "File.h"
+#include "FileSystem.h"
+#include "HashSet.h"
+#include "Image.h"
+#include "MemoryBuffer.h"
+#include "MemoryMappedFile.h"
+#include "ParticleAtlasBuilder2D.h"
+#include "ParticleCostAnalyzer2D.h"
+#include "ParticleEffect2D.h"
+#include "ParticleEffectBatch2D.h"
+#include "ParticleEffectPack2D.h"
+#include "ParticleEffectRanges2D.h"
+#include "ParticleEffectSettings2D.h"
+#include "ParticleEffectXML2D.h"
+#include "ParticleRasterizer2D.h"
+#include "ProcessUtils.h"
+#include "SimulationHost.h"
+#include "Sort.h"
+#include "Timer.h"
+#include "VectorBuffer.h"
+#include "WorkQueue.h"
+#include "XMLFile.h"
+
+namespace Urho3D
+{
+
+/// Root element name of a .pex file.
+static const char* PARTICLE_EFFECT_XML_ROOT = "particleEmitterConfig";
+/// Default thumbnail width and height in pixels.
+static const int DEFAULT_THUMBNAIL_SIZE = 128;
+/// Default largest channel difference from a golden image that still counts as a match.
+static const int DEFAULT_GOLDEN_TOLERANCE = 2;
+
+static void ProcessFileWork(const WorkItem* item, unsigned threadIndex)
+{
+    const ParticleEffectBatch2D* batch = reinterpret_cast<const ParticleEffectBatch2D*>(item->aux_);
+    batch->ProcessFile(*reinterpret_cast<ParticleBatchFile2D*>(item->start_));
+}
+
+/// Create a directory and its missing parents. Return true if successful.
+static bool CreateDirs(FileSystem* fileSystem, const String& pathName)
+{
+    String path = RemoveTrailingSlash(pathName);
+    if (path.Empty() || fileSystem->DirExists(path))
+        return true;
+
+    return CreateDirs(fileSystem, GetParentPath(path)) && fileSystem->CreateDir(path);
+}
+
+ParticleEffectBatch2D::ParticleEffectBatch2D(Context* context) :
+    Object(context),
+    format_(PBF_SOURCE),
+    writeOutput_(false),
+    recursive_(false),
+    clamp_(false),
+    reportCost_(false),
+    thumbnailSize_(DEFAULT_THUMBNAIL_SIZE),
+    goldenTolerance_(DEFAULT_GOLDEN_TOLERANCE)
+{
+}
+
+ParticleEffectBatch2D::~ParticleEffectBatch2D()
+{
+}
+
+int ParticleEffectBatch2D::Run(const Vector<String>& arguments)
+{
+    if (!ParseArguments(arguments))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    host_ = new SimulationHost(context_);
+    if (!host_->Initialize("ParticleEditor2DBatch.log", true))
+    {
+        PrintLine("Could not initialize the headless engine", true);
+        return 1;
+    }
+
+    if (!CollectFiles())
+    {
+        PrintLine("No particle effect files found in " + inputPath_, true);
+        return 2;
+    }
+
+    if (!CreateOutputDirs())
+        return 1;
+
+    if (!atlasName_.Empty() && !BuildAtlas())
+        return 1;
+
+    SharedPtr<ParticleEffect2D> defaultEffect(new ParticleEffect2D(context_));
+    GetParticleEffectParameters(defaultEffect, defaults_);
+
+    // Kernels are chosen on first use, which must not race between worker threads
+    SelectParticleKernels();
+
+    HiresTimer timer;
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    if (queue && queue->GetNumThreads() && files_.Size() > 1)
+    {
+        WorkItem item;
+        item.workFunction_ = ProcessFileWork;
+        item.aux_ = this;
+        item.priority_ = M_MAX_UNSIGNED;
+
+        for (unsigned i = 0; i < files_.Size(); ++i)
+        {
+            item.start_ = &files_[i];
+            queue->AddWorkItem(item);
+        }
+
+        queue->Complete(M_MAX_UNSIGNED);
+    }
+    else
+    {
+        for (unsigned i = 0; i < files_.Size(); ++i)
+            ProcessFile(files_[i]);
+    }
+
+    bool packWritten = packName_.Empty() || WritePack();
+
+    PrintReport((unsigned)(timer.GetUSec(false) / 1000));
+    if (!packWritten)
+        return 1;
+
+    for (unsigned i = 0; i < files_.Size(); ++i)
+    {
+        if (files_[i].numErrors_ || files_[i].numIssues_)
+            return 1;
+    }
+
+    return 0;
+}
+
+void ParticleEffectBatch2D::ProcessFile(ParticleBatchFile2D& file) const
+{
+    bool sourceBinary = IsParticleEffectBinary(file.sourceName_);
+    ParticleEffectParameters2D parameters = defaults_;
+    ParticleEffectSettings2D settings;
+    String textureName;
+
+    // Unmap the source before writing, the output may replace it
+    {
+        MemoryMappedFile source;
+        if (!source.Open(file.sourceName_))
+        {
+            file.messages_.Push("error: could not open file");
+            ++file.numErrors_;
+            return;
+        }
+
+        if (!ReadEffect(sourceBinary, source.GetData(), source.GetSize(), parameters, settings, textureName, &file))
+        {
+            file.messages_.Push(sourceBinary ? "error: not a valid binary particle effect" : "error: not a valid particle effect");
+            ++file.numErrors_;
+            return;
+        }
+    }
+
+    // Thumbnails are drawn with the source texture, atlases are only written to the output
+    String sourceTextureName = textureName;
+    if (!file.textureName_.Empty())
+        textureName = file.textureName_;
+
+    Vector<String> issues;
+    ValidateParticleEffectParameters(parameters, &issues);
+    for (unsigned i = 0; i < issues.Size(); ++i)
+        file.messages_.Push((clamp_ ? "clamped: " : "range: ") + issues[i]);
+    if (clamp_)
+        ClampParticleEffectParameters(parameters);
+    else
+        file.numIssues_ += issues.Size();
+
+    // Round trip through the output format, or through a canonical .pex when only validating
+    bool outputBinary = format_ == PBF_BINARY || (format_ == PBF_SOURCE && sourceBinary && !file.outputName_.Empty());
+    VectorBuffer buffer;
+    if (!WriteEffect(outputBinary, parameters, settings, textureName, buffer))
+    {
+        file.messages_.Push("error: could not convert");
+        ++file.numErrors_;
+        return;
+    }
+
+    ParticleEffectParameters2D roundTripParameters = defaults_;
+    ParticleEffectSettings2D roundTripSettings;
+    String roundTripTextureName;
+    if (!ReadEffect(outputBinary, buffer.GetData(), buffer.GetSize(), roundTripParameters, roundTripSettings, roundTripTextureName, 0))
+    {
+        file.messages_.Push("error: converted effect could not be read back");
+        ++file.numErrors_;
+        return;
+    }
+
+    Vector<String> differences;
+    CompareParticleEffectParameters(parameters, roundTripParameters, &differences);
+    if (roundTripTextureName != textureName)
+        differences.Push("texture " + textureName + " became " + roundTripTextureName);
+    if (roundTripSettings.GetRandomSeed() != settings.GetRandomSeed())
+        differences.Push("randomSeed " + String(settings.GetRandomSeed()) + " became " + String(roundTripSettings.GetRandomSeed()));
+    if (roundTripSettings.GetPrewarmTime() != settings.GetPrewarmTime())
+        differences.Push("prewarm " + String(settings.GetPrewarmTime()) + " became " + String(roundTripSettings.GetPrewarmTime()));
+    if (roundTripSettings.GetLod().GetNumLevels() != settings.GetLod().GetNumLevels())
+        differences.Push("lod " + String(settings.GetLod().GetNumLevels()) + " levels became " +
+            String(roundTripSettings.GetLod().GetNumLevels()));
+    for (unsigned i = 0; i < differences.Size(); ++i)
+        file.messages_.Push("lossy: " + differences[i]);
+    file.numIssues_ += differences.Size();
+
+    if (reportCost_)
+        ReportCost(file, parameters);
+
+    if (!file.thumbnailName_.Empty() || !file.goldenName_.Empty())
+        RenderThumbnail(file, parameters, settings, sourceTextureName);
+
+    if (file.outputName_.Empty())
+        return;
+
+    File output(context_);
+    if (!output.Open(file.outputName_, FILE_WRITE) || output.Write(buffer.GetData(), buffer.GetSize()) != buffer.GetSize())
+    {
+        file.messages_.Push("error: could not write " + file.outputName_);
+        ++file.numErrors_;
+    }
+}
+
+bool ParticleEffectBatch2D::BuildAtlas()
+{
+    SharedPtr<ParticleAtlasBuilder2D> builder(new ParticleAtlasBuilder2D(context_));
+    for (unsigned i = 0; i < files_.Size(); ++i)
+        builder->AddEffect(files_[i].sourceName_);
+
+    if (!builder->Build(outputPath_, atlasName_))
+    {
+        PrintLine("Could not build atlas " + outputPath_ + atlasName_, true);
+        return false;
+    }
+
+    for (unsigned i = 0; i < files_.Size(); ++i)
+        files_[i].textureName_ = builder->GetTextureName(files_[i].sourceName_);
+
+    PrintLine("Packed " + String(builder->GetTextures().Size()) + " textures into " + String(builder->GetNumAtlases()) +
+        " atlases");
+    return true;
+}
+
+bool ParticleEffectBatch2D::WritePack()
+{
+    // Written files are packed when converting, so that atlas sprites are referenced
+    Vector<String> fileNames;
+    for (unsigned i = 0; i < files_.Size(); ++i)
+    {
+        if (!files_[i].numErrors_)
+            fileNames.Push(files_[i].outputName_.Empty() ? files_[i].sourceName_ : files_[i].outputName_);
+    }
+
+    String basePath = outputPath_;
+    if (!writeOutput_)
+        basePath = GetSubsystem<FileSystem>()->DirExists(inputPath_) ? AddTrailingSlash(inputPath_) : GetPath(inputPath_);
+
+    Vector<String> errors;
+    File file(context_);
+    if (!file.Open(packName_, FILE_WRITE) || !BuildParticleEffectPack(context_, fileNames, basePath, file, &errors))
+    {
+        PrintLine("Could not write pack " + packName_, true);
+        return false;
+    }
+
+    for (unsigned i = 0; i < errors.Size(); ++i)
+        PrintLine(errors[i], true);
+    PrintLine("Packed " + String(fileNames.Size() - errors.Size()) + " effects into " + packName_);
+    return errors.Empty();
+}
+
+void ParticleEffectBatch2D::PrintUsage()
+{
+    PrintLine("Usage: ParticleEditor2D -batch <input> [options]\n"
+        "\n"
+        "Validate .pex and .pexb files against the editor's ranges and check that they survive conversion without loss.\n"
+        "Input is a particle effect file or a directory of them. Exit code is 0 when all files are clean, 1 when any file has\n"
+        "errors or issues and 2 on invalid arguments.\n"
+        "\n"
+        "Options:\n"
+        "-output <dir>   Write converted files to dir, keeping the directory structure of the input\n"
+        "-format <fmt>   Output format, pex or pexb. Without -output files are written next to their sources\n"
+        "-recursive      Scan the input directory recursively\n"
+        "-clamp          Clamp values into the editor's ranges when writing instead of reporting them\n"
+        "-atlas <name>   Pack the textures of all effects into name0.png and name0.xml and so on in the output directory\n"
+        "                and point the written effects at their sprites\n"
+        "-thumbnails <dir> Render each effect on the CPU and write it to dir as a PNG, keeping the directory structure\n"
+        "-golden <dir>   Render each effect and compare it against the PNG of the same name in dir. Mismatches are issues\n"
+        "-size <pixels>  Thumbnail width and height, 128 by default\n"
+        "-tolerance <n>  Largest channel difference from a golden image that still matches, 2 by default\n"
+        "-pack <file>    Compile the effects without errors into one .pexpack file, named by their path below the input\n"
+        "                directory, or below the output directory when writing\n"
+        "-cost           Estimate live particles, overdraw and frame time of each effect. Budgets exceeded are issues");
+}
+
+bool ParticleEffectBatch2D::ParseArguments(const Vector<String>& arguments)
+{
+    // The first argument is -batch itself
+    for (unsigned i = 1; i < arguments.Size(); ++i)
+    {
+        String argument = arguments[i].ToLower();
+        if (argument == "-output" && i + 1 < arguments.Size())
+        {
+            outputPath_ = AddTrailingSlash(GetInternalPath(arguments[++i]));
+            writeOutput_ = true;
+        }
+        else if (argument == "-format" && i + 1 < arguments.Size())
+        {
+            String format = arguments[++i].ToLower();
+            if (format == "pex")
+                format_ = PBF_XML;
+            else if (format == "pexb")
+                format_ = PBF_BINARY;
+            else
+            {
+                PrintLine("Unknown format " + format, true);
+                return false;
+            }
+            writeOutput_ = true;
+        }
+        else if (argument == "-atlas" && i + 1 < arguments.Size())
+        {
+            atlasName_ = arguments[++i];
+            writeOutput_ = true;
+        }
+        else if (argument == "-thumbnails" && i + 1 < arguments.Size())
+            thumbnailPath_ = AddTrailingSlash(GetInternalPath(arguments[++i]));
+        else if (argument == "-golden" && i + 1 < arguments.Size())
+            goldenPath_ = AddTrailingSlash(GetInternalPath(arguments[++i]));
+        else if (argument == "-size" && i + 1 < arguments.Size())
+        {
+            thumbnailSize_ = ToInt(arguments[++i]);
+            if (thumbnailSize_ <= 0)
+            {
+                PrintLine("Invalid thumbnail size " + arguments[i], true);
+                return false;
+            }
+        }
+        else if (argument == "-tolerance" && i + 1 < arguments.Size())
+            goldenTolerance_ = Max(ToInt(arguments[++i]), 0);
+        else if (argument == "-recursive")
+            recursive_ = true;
+        else if (argument == "-clamp")
+            clamp_ = true;
+        else if (argument == "-pack" && i + 1 < arguments.Size())
+            packName_ = GetInternalPath(arguments[++i]);
+        else if (argument == "-cost")
+            reportCost_ = true;
+        else if (argument.StartsWith("-") || !inputPath_.Empty())
+        {
+            PrintLine("Unknown argument " + arguments[i], true);
+            return false;
+        }
+        else
+            inputPath_ = GetInternalPath(arguments[i]);
+    }
+
+    if (inputPath_.Empty())
+    {
+        PrintLine("No input given", true);
+        return false;
+    }
+
+    // Effects refer to their atlas relative to themselves, so they must share its directory
+    if (!atlasName_.Empty() && recursive_)
+    {
+        PrintLine("-atlas can not be combined with -recursive", true);
+        return false;
+    }
+
+    return true;
+}
+
+bool ParticleEffectBatch2D::CollectFiles()
+{
+    FileSystem* fileSystem = GetSubsystem<FileSystem>();
+
+    String sourcePath;
+    Vector<String> names;
+    if (fileSystem->DirExists(inputPath_))
+    {
+        sourcePath = AddTrailingSlash(inputPath_);
+        fileSystem->ScanDir(names, sourcePath, "*.pex", SCAN_FILES, recursive_);
+
+        Vector<String> binaryNames;
+        fileSystem->ScanDir(binaryNames, sourcePath, "*.pexb", SCAN_FILES, recursive_);
+        for (unsigned i = 0; i < binaryNames.Size(); ++i)
+            names.Push(binaryNames[i]);
+
+        Sort(names.Begin(), names.End());
+    }
+    else if (fileSystem->FileExists(inputPath_))
+    {
+        sourcePath = GetPath(inputPath_);
+        names.Push(GetFileNameAndExtension(inputPath_));
+    }
+
+    // Output defaults to the source directory, which normalizes files in place when the format is kept
+    if (writeOutput_ && outputPath_.Empty())
+        outputPath_ = sourcePath;
+
+    files_.Resize(names.Size());
+    for (unsigned i = 0; i < names.Size(); ++i)
+    {
+        ParticleBatchFile2D& file = files_[i];
+        file.sourceName_ = sourcePath + names[i];
+        if (!thumbnailPath_.Empty())
+            file.thumbnailName_ = thumbnailPath_ + names[i] + ".png";
+        if (!goldenPath_.Empty())
+            file.goldenName_ = goldenPath_ + names[i] + ".png";
+        if (!writeOutput_)
+            continue;
+
+        file.outputName_ = outputPath_ + names[i];
+        if (format_ == PBF_XML)
+            file.outputName_ = ReplaceExtension(file.outputName_, ".pex");
+        else if (format_ == PBF_BINARY)
+            file.outputName_ = ReplaceExtension(file.outputName_, ".pexb");
+    }
+
+    return !files_.Empty();
+}
+
+bool ParticleEffectBatch2D::CreateOutputDirs()
+{
+    FileSystem* fileSystem = GetSubsystem<FileSystem>();
+
+    HashSet<String> paths;
+    for (unsigned i = 0; i < files_.Size(); ++i)
+    {
+        if (!files_[i].outputName_.Empty())
+            paths.Insert(GetPath(files_[i].outputName_));
+        if (!files_[i].thumbnailName_.Empty())
+            paths.Insert(GetPath(files_[i].thumbnailName_));
+    }
+    if (!packName_.Empty())
+        paths.Insert(GetPath(packName_));
+
+    for (HashSet<String>::Iterator i = paths.Begin(); i != paths.End(); ++i)
+    {
+        if (!CreateDirs(fileSystem, *i))
+        {
+            PrintLine("Could not create output directory " + *i, true);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ParticleEffectBatch2D::ReadEffect(bool binary, const unsigned char* data, unsigned size, ParticleEffectParameters2D& parameters,
+    ParticleEffectSettings2D& settings, String& textureName, ParticleBatchFile2D* file) const
+{
+    if (binary)
+    {
+        ParticleEffectBinarySettings2D binarySettings;
+        GetParticleEffectBinarySettings(settings, binarySettings);
+        if (!ReadParticleEffectBinary(data, size, parameters, binarySettings, textureName))
+            return false;
+
+        SetParticleEffectBinarySettings(settings, binarySettings);
+        return true;
+    }
+
+    SharedPtr<XMLFile> xmlFile(new XMLFile(context_));
+    MemoryBuffer buffer(data, size);
+    if (!xmlFile->Load(buffer))
+        return false;
+
+    XMLElement root = xmlFile->GetRoot(PARTICLE_EFFECT_XML_ROOT);
+    if (!ReadParticleEffectXML(root, parameters, textureName))
+        return false;
+
+    settings.Load(root);
+
+    if (file)
+    {
+        for (XMLElement child = root.GetChild(); child; child = child.GetNext())
+        {
+            String name = child.GetName();
+            if (!IsParticleEffectXMLElement(name) && !ParticleEffectSettings2D::IsSettingsElement(name))
+            {
+                file->messages_.Push("lossy: element " + name + " is not preserved");
+                ++file->numIssues_;
+            }
+        }
+
+        if (parameters.blendMode_ == MAX_BLENDMODES)
+        {
+            file->messages_.Push("note: blendFuncSource " + String(root.GetChild("blendFuncSource").GetInt("value")) +
+                " and blendFuncDestination " + String(root.GetChild("blendFuncDestination").GetInt("value")) +
+                " match no blend mode");
+        }
+    }
+
+    return true;
+}
+
+bool ParticleEffectBatch2D::WriteEffect(bool binary, const ParticleEffectParameters2D& parameters, const ParticleEffectSettings2D& settings,
+    const String& textureName, VectorBuffer& dest) const
+{
+    return WriteParticleEffectData(context_, binary, parameters, settings, textureName, dest);
+}
+
+void ParticleEffectBatch2D::ReportCost(ParticleBatchFile2D& file, const ParticleEffectParameters2D& parameters) const
+{
+    SharedPtr<ParticleEffect2D> effect(new ParticleEffect2D(context_));
+    SetParticleEffectParameters(effect, parameters);
+
+    // The reference model is not calibrated, so reports do not depend on the machine or its load
+    ParticleCostModel2D model;
+    ParticleCostEstimate2D estimate;
+    EstimateParticleEffectCost(effect, model, estimate);
+
+    file.messages_.Push(ToString("cost: %.0f particles, %.2f screens of overdraw, %.2f ms fill, %.2f ms simulation",
+        estimate.liveParticles_, estimate.screens_, estimate.gpuMs_, estimate.cpuMs_));
+    for (unsigned i = 0; i < estimate.warnings_.Size(); ++i)
+        file.messages_.Push("cost: " + estimate.warnings_[i]);
+    file.numIssues_ += estimate.warnings_.Size();
+}
+
+void ParticleEffectBatch2D::RenderThumbnail(ParticleBatchFile2D& file, const ParticleEffectParameters2D& parameters,
+    const ParticleEffectSettings2D& settings, const String& textureName) const
+{
+    SharedPtr<ParticleEffect2D> effect(new ParticleEffect2D(context_));
+    SetParticleEffectParameters(effect, parameters);
+
+    IntRect rectangle;
+    SharedPtr<Image> texture = LoadParticleTextureImage(context_, file.sourceName_, textureName, rectangle);
+    if (!texture && !textureName.Empty())
+        file.messages_.Push("thumbnail: could not load texture " + textureName + ", drawn untextured");
+
+    // Scalar kernels give the same pixels on every machine, so golden images do not depend on the CPU of the build node
+    ParticleKernelLevel2D level = goldenPath_.Empty() ? SelectParticleKernels().level_ : PKL_SCALAR;
+    SharedPtr<Image> image = RenderParticleThumbnail(context_, effect, settings, texture, rectangle, thumbnailSize_, level);
+    if (!file.thumbnailName_.Empty() && !image->SavePNG(file.thumbnailName_))
+    {
+        file.messages_.Push("error: could not write " + file.thumbnailName_);
+        ++file.numErrors_;
+    }
+
+    if (file.goldenName_.Empty())
+        return;
+
+    File goldenFile(context_);
+    SharedPtr<Image> golden(new Image(context_));
+    if (!goldenFile.Open(file.goldenName_) || !golden->Load(goldenFile))
+    {
+        file.messages_.Push("golden: could not read " + file.goldenName_);
+        ++file.numIssues_;
+        return;
+    }
+
+    int maxDifference;
+    unsigned numDifferent = CompareParticleImages(image, golden, goldenTolerance_, maxDifference);
+    if (numDifferent == M_MAX_UNSIGNED)
+        file.messages_.Push("golden: size differs from " + file.goldenName_);
+    else if (numDifferent)
+    {
+        file.messages_.Push("golden: " + String(numDifferent) + " pixels differ by up to " + String(maxDifference) + " from " +
+            file.goldenName_);
+    }
+    if (numDifferent)
+        ++file.numIssues_;
+}
+
+void ParticleEffectBatch2D::PrintReport(unsigned elapsed) const
+{
+    unsigned numFilesWithErrors = 0;
+    unsigned numFilesWithIssues = 0;
+    unsigned numWritten = 0;
+
+    for (unsigned i = 0; i < files_.Size(); ++i)
+    {
+        const ParticleBatchFile2D& file = files_[i];
+        for (unsigned j = 0; j < file.messages_.Size(); ++j)
+            PrintLine(file.sourceName_ + ": " + file.messages_[j]);
+
+        if (file.numErrors_)
+            ++numFilesWithErrors;
+        else
+        {
+            if (file.numIssues_)
+                ++numFilesWithIssues;
+            if (!file.outputName_.Empty())
+                ++numWritten;
+        }
+    }
+
+    String summary = "Checked " + String(files_.Size()) + " files in " + String(elapsed) + " ms: " + String(numFilesWithErrors) +
+        " with errors, " + String(numFilesWithIssues) + " with issues";
+    if (writeOutput_)
+        summary += ", " + String(numWritten) + " written to " + outputPath_;
+    PrintLine(summary);
+}
+
+}
@@ -0,0 +1,158 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Object.h"
+#include "ParticleEffectBinary2D.h"
+
+namespace Urho3D
+{
+
+class ParticleEffectSettings2D;
+class SimulationHost;
+class VectorBuffer;
+
+/// Output format of the batch converter.
+enum ParticleBatchFormat2D
+{
+    /// Keep the format of each source file.
+    PBF_SOURCE = 0,
+    /// Write .pex files.
+    PBF_XML,
+    /// Write .pexb files.
+    PBF_BINARY
+};
+
+/// Particle effect file processed by the batch converter.
+struct ParticleBatchFile2D
+{
+    /// Construct.
+    ParticleBatchFile2D() :
+        numErrors_(0),
+        numIssues_(0)
+    {
+    }
+
+    /// Source file name.
+    String sourceName_;
+    /// Output file name, empty when only validating.
+    String outputName_;
+    /// Texture name replacing the source one, set when packing an atlas.
+    String textureName_;
+    /// Thumbnail file name, empty unless rendering thumbnails.
+    String thumbnailName_;
+    /// Golden image file name, empty unless comparing against golden images.
+    String goldenName_;
+    /// Report lines.
+    Vector<String> messages_;
+    /// Number of errors. The file could not be read or written.
+    unsigned numErrors_;
+    /// Number of range violations, lossy round trips, golden image mismatches and exceeded cost budgets.
+    unsigned numIssues_;
+};
+
+/// Headless batch converter and validator for particle effect files, run with -batch on the command line. Files are read,
+/// validated against the editor's ranges, round tripped through the output format and optionally written, one work item per
+/// file on the engine's worker threads.
+class ParticleEffectBatch2D : public Object
+{
+    OBJECT(ParticleEffectBatch2D)
+
+public:
+    /// Construct.
+    ParticleEffectBatch2D(Context* context);
+    /// Destruct.
+    virtual ~ParticleEffectBatch2D();
+
+    /// Parse the arguments following -batch, process all files and print the report. Return process exit code: 0 when all files
+    /// are clean, 1 when any file has errors or issues, 2 on invalid arguments.
+    int Run(const Vector<String>& arguments);
+    /// Process one file. Called from worker threads, touches nothing but the file.
+    void ProcessFile(ParticleBatchFile2D& file) const;
+
+    /// Return processed files.
+    const Vector<ParticleBatchFile2D>& GetFiles() const { return files_; }
+
+    /// Print command line usage.
+    static void PrintUsage();
+
+private:
+    /// Parse command line arguments. Return true if successful.
+    bool ParseArguments(const Vector<String>& arguments);
+    /// Collect input files and their output names. Return true if any were found.
+    bool CollectFiles();
+    /// Create output directories on the main thread. Return true if successful.
+    bool CreateOutputDirs();
+    /// Pack the textures of all files into atlases in the output directory. Return true if successful.
+    bool BuildAtlas();
+    /// Compile the files without errors into the pack. Return true if all of them were packed.
+    bool WritePack();
+    /// Read an effect in either format. Report elements that would be dropped to file when given. Return true if successful.
+    bool ReadEffect(bool binary, const unsigned char* data, unsigned size, ParticleEffectParameters2D& parameters,
+        ParticleEffectSettings2D& settings, String& textureName, ParticleBatchFile2D* file) const;
+    /// Write an effect in either format. Return true if successful.
+    bool WriteEffect(bool binary, const ParticleEffectParameters2D& parameters, const ParticleEffectSettings2D& settings,
+        const String& textureName, VectorBuffer& dest) const;
+    /// Estimate the cost of an effect and report the budgets it is over as issues.
+    void ReportCost(ParticleBatchFile2D& file, const ParticleEffectParameters2D& parameters) const;
+    /// Render the thumbnail of an effect, write it and compare it against its golden image as requested.
+    void RenderThumbnail(ParticleBatchFile2D& file, const ParticleEffectParameters2D& parameters,
+        const ParticleEffectSettings2D& settings, const String& textureName) const;
+    /// Print the report.
+    void PrintReport(unsigned elapsed) const;
+
+    /// Headless engine.
+    SharedPtr<SimulationHost> host_;
+    /// Input file or directory.
+    String inputPath_;
+    /// Output directory. Defaults to the input directory.
+    String outputPath_;
+    /// Output format.
+    ParticleBatchFormat2D format_;
+    /// Write converted files. Only validate otherwise.
+    bool writeOutput_;
+    /// Scan input directory recursively.
+    bool recursive_;
+    /// Clamp values into the editing ranges when writing.
+    bool clamp_;
+    /// Report the estimated cost of each effect.
+    bool reportCost_;
+    /// Pack file name. No pack is written when empty.
+    String packName_;
+    /// Atlas base name. No atlas is built when empty.
+    String atlasName_;
+    /// Thumbnail output directory. No thumbnails are written when empty.
+    String thumbnailPath_;
+    /// Golden image directory. No comparison is made when empty.
+    String goldenPath_;
+    /// Thumbnail width and height in pixels.
+    int thumbnailSize_;
+    /// Largest channel difference from a golden image that still counts as a match.
+    int goldenTolerance_;
+    /// Files.
+    Vector<ParticleBatchFile2D> files_;
+    /// Parameters of a default constructed effect, used for missing elements.
+    ParticleEffectParameters2D defaults_;
+};
+
+}
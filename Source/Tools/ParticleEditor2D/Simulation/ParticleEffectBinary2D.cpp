@@ -0,0 +1,429 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Context.h"
+#include "FileSystem.h"
+#include "Log.h"
+#include "MemoryBuffer.h"
+#include "MemoryMappedFile.h"
+#include "ParticleEffect2D.h"
+#include "ParticleEffectBinary2D.h"
+#include "ParticleEffectSettings2D.h"
+#include "ParticleEffectXML2D.h"
+#include "ResourceCache.h"
+#include "Serializer.h"
+#include "Sprite2D.h"
+#include "SpriteSheet2D.h"
+#include "XMLFile.h"
+
+#include <cstring>
+
+namespace Urho3D
+{
+
+/// Binary particle effect file extension.
+static const char* PARTICLE_EFFECT_BINARY_EXTENSION = ".pexb";
+
+/// Copy color to a float array.
+static void CopyColor(const Color& color, float* dest)
+{
+    dest[0] = color.r_;
+    dest[1] = color.g_;
+    dest[2] = color.b_;
+    dest[3] = color.a_;
+}
+
+void GetParticleEffectParameters(const ParticleEffect2D* effect, ParticleEffectParameters2D& dest)
+{
+    dest.maxParticles_ = effect->GetMaxParticles();
+    dest.emitterType_ = (int)effect->GetEmitterType();
+    dest.blendMode_ = (int)effect->GetBlendMode();
+    dest.duration_ = effect->GetDuration();
+    dest.sourcePositionVariance_[0] = effect->GetSourcePositionVariance().x_;
+    dest.sourcePositionVariance_[1] = effect->GetSourcePositionVariance().y_;
+    dest.speed_ = effect->GetSpeed();
+    dest.speedVariance_ = effect->GetSpeedVariance();
+    dest.particleLifeSpan_ = effect->GetParticleLifeSpan();
+    dest.particleLifespanVariance_ = effect->GetParticleLifespanVariance();
+    dest.angle_ = effect->GetAngle();
+    dest.angleVariance_ = effect->GetAngleVariance();
+    dest.gravity_[0] = effect->GetGravity().x_;
+    dest.gravity_[1] = effect->GetGravity().y_;
+    dest.radialAcceleration_ = effect->GetRadialAcceleration();
+    dest.radialAccelVariance_ = effect->GetRadialAccelVariance();
+    dest.tangentialAcceleration_ = effect->GetTangentialAcceleration();
+    dest.tangentialAccelVariance_ = effect->GetTangentialAccelVariance();
+    dest.maxRadius_ = effect->GetMaxRadius();
+    dest.maxRadiusVariance_ = effect->GetMaxRadiusVariance();
+    dest.minRadius_ = effect->GetMinRadius();
+    dest.minRadiusVariance_ = effect->GetMinRadiusVariance();
+    dest.rotatePerSecond_ = effect->GetRotatePerSecond();
+    dest.rotatePerSecondVariance_ = effect->GetRotatePerSecondVariance();
+    dest.startParticleSize_ = effect->GetStartParticleSize();
+    dest.startParticleSizeVariance_ = effect->GetStartParticleSizeVariance();
+    dest.finishParticleSize_ = effect->GetFinishParticleSize();
+    dest.finishParticleSizeVariance_ = effect->GetFinishParticleSizeVariance();
+    CopyColor(effect->GetStartColor(), dest.startColor_);
+    CopyColor(effect->GetStartColorVariance(), dest.startColorVariance_);
+    CopyColor(effect->GetFinishColor(), dest.finishColor_);
+    CopyColor(effect->GetFinishColorVariance(), dest.finishColorVariance_);
+    dest.rotationStart_ = effect->GetRotationStart();
+    dest.rotationStartVariance_ = effect->GetRotationStartVariance();
+    dest.rotationEnd_ = effect->GetRotationEnd();
+    dest.rotationEndVariance_ = effect->GetRotationEndVariance();
+}
+
+void SetParticleEffectParameters(ParticleEffect2D* effect, const ParticleEffectParameters2D& source)
+{
+    effect->SetMaxParticles(source.maxParticles_);
+    effect->SetEmitterType((EmitterType2D)source.emitterType_);
+    effect->SetBlendMode((BlendMode)source.blendMode_);
+    effect->SetDuration(source.duration_);
+    effect->SetSourcePositionVariance(Vector2(source.sourcePositionVariance_[0], source.sourcePositionVariance_[1]));
+    effect->SetSpeed(source.speed_);
+    effect->SetSpeedVariance(source.speedVariance_);
+    effect->SetParticleLifeSpan(source.particleLifeSpan_);
+    effect->SetParticleLifespanVariance(source.particleLifespanVariance_);
+    effect->SetAngle(source.angle_);
+    effect->SetAngleVariance(source.angleVariance_);
+    effect->SetGravity(Vector2(source.gravity_[0], source.gravity_[1]));
+    effect->SetRadialAcceleration(source.radialAcceleration_);
+    effect->SetRadialAccelVariance(source.radialAccelVariance_);
+    effect->SetTangentialAcceleration(source.tangentialAcceleration_);
+    effect->SetTangentialAccelVariance(source.tangentialAccelVariance_);
+    effect->SetMaxRadius(source.maxRadius_);
+    effect->SetMaxRadiusVariance(source.maxRadiusVariance_);
+    effect->SetMinRadius(source.minRadius_);
+    effect->SetMinRadiusVariance(source.minRadiusVariance_);
+    effect->SetRotatePerSecond(source.rotatePerSecond_);
+    effect->SetRotatePerSecondVariance(source.rotatePerSecondVariance_);
+    effect->SetStartParticleSize(source.startParticleSize_);
+    effect->SetStartParticleSizeVariance(source.startParticleSizeVariance_);
+    effect->SetFinishParticleSize(source.finishParticleSize_);
+    effect->SetFinishParticleSizeVariance(source.finishParticleSizeVariance_);
+    effect->SetStartColor(Color(source.startColor_[0], source.startColor_[1], source.startColor_[2], source.startColor_[3]));
+    effect->SetStartColorVariance(Color(source.startColorVariance_[0], source.startColorVariance_[1], source.startColorVariance_[2], source.startColorVariance_[3]));
+    effect->SetFinishColor(Color(source.finishColor_[0], source.finishColor_[1], source.finishColor_[2], source.finishColor_[3]));
+    effect->SetFinishColorVariance(Color(source.finishColorVariance_[0], source.finishColorVariance_[1], source.finishColorVariance_[2], source.finishColorVariance_[3]));
+    effect->SetRotationStart(source.rotationStart_);
+    effect->SetRotationStartVariance(source.rotationStartVariance_);
+    effect->SetRotationEnd(source.rotationEnd_);
+    effect->SetRotationEndVariance(source.rotationEndVariance_);
+}
+
+void GetParticleEffectBinarySettings(const ParticleEffectSettings2D& settings, ParticleEffectBinarySettings2D& dest)
+{
+    memset(&dest, 0, sizeof dest);
+    dest.randomSeed_ = settings.GetRandomSeed();
+    dest.prewarmTime_ = settings.GetPrewarmTime();
+
+    const ParticleEffectLod2D& lod = settings.GetLod();
+    dest.lodMetric_ = (unsigned)lod.GetMetric();
+    dest.numLodLevels_ = lod.GetNumLevels();
+    for (unsigned i = 0; i < lod.GetNumLevels(); ++i)
+    {
+        const ParticleLodLevel2D& level = lod.GetLevels()[i];
+        dest.lodLevels_[i].threshold_ = level.threshold_;
+        dest.lodLevels_[i].particleScale_ = level.particleScale_;
+        dest.lodLevels_[i].spawnScale_ = level.spawnScale_;
+        dest.lodLevels_[i].simplified_ = level.simplified_ ? 1 : 0;
+    }
+}
+
+void SetParticleEffectBinarySettings(ParticleEffectSettings2D& settings, const ParticleEffectBinarySettings2D& source)
+{
+    settings.SetRandomSeed(source.randomSeed_);
+    settings.SetPrewarmTime(source.prewarmTime_);
+
+    ParticleEffectLod2D lod;
+    lod.SetMetric((ParticleLodMetric2D)source.lodMetric_);
+    PODVector<ParticleLodLevel2D> levels;
+    for (unsigned i = 0; i < source.numLodLevels_ && i < MAX_PARTICLE_LOD_LEVELS; ++i)
+    {
+        ParticleLodLevel2D level;
+        level.threshold_ = source.lodLevels_[i].threshold_;
+        level.particleScale_ = source.lodLevels_[i].particleScale_;
+        level.spawnScale_ = source.lodLevels_[i].spawnScale_;
+        level.simplified_ = source.lodLevels_[i].simplified_ != 0;
+        levels.Push(level);
+    }
+    lod.SetLevels(levels);
+    settings.SetLod(lod);
+}
+
+bool IsParticleEffectBinary(const String& fileName)
+{
+    return GetExtension(fileName) == PARTICLE_EFFECT_BINARY_EXTENSION;
+}
+
+bool WriteParticleEffectBinary(const ParticleEffectParameters2D& parameters, const ParticleEffectBinarySettings2D& settings,
+    const String& textureName, Serializer& dest)
+{
+    ParticleEffectBinaryHeader2D header;
+    header.id_ = PARTICLE_EFFECT_BINARY_ID;
+    header.version_ = PARTICLE_EFFECT_BINARY_VERSION;
+    header.parametersOffset_ = sizeof header;
+    header.parametersSize_ = sizeof parameters;
+    header.settingsOffset_ = header.parametersOffset_ + header.parametersSize_;
+    header.settingsSize_ = sizeof settings;
+    header.stringsOffset_ = header.settingsOffset_ + header.settingsSize_;
+    header.stringsSize_ = textureName.Empty() ? 0 : textureName.Length() + 1;
+    header.textureName_ = textureName.Empty() ? M_MAX_UNSIGNED : 0;
+
+    bool success = true;
+    success &= dest.Write(&header, sizeof header) == sizeof header;
+    success &= dest.Write(&parameters, sizeof parameters) == sizeof parameters;
+    success &= dest.Write(&settings, sizeof settings) == sizeof settings;
+    if (header.stringsSize_)
+        success &= dest.Write(textureName.CString(), header.stringsSize_) == header.stringsSize_;
+
+    return success;
+}
+
+bool ReadParticleEffectBinary(const unsigned char* data, unsigned size, ParticleEffectParameters2D& parameters,
+    ParticleEffectBinarySettings2D& settings, String& textureName)
+{
+    if (!data || size < sizeof(ParticleEffectBinaryHeader2D))
+    {
+        LOGERROR("Binary particle effect is too small");
+        return false;
+    }
+
+    ParticleEffectBinaryHeader2D header;
+    memcpy(&header, data, sizeof header);
+    if (header.id_ != PARTICLE_EFFECT_BINARY_ID)
+    {
+        LOGERROR("Not a binary particle effect");
+        return false;
+    }
+    if (header.version_ != PARTICLE_EFFECT_BINARY_VERSION)
+    {
+        LOGERROR("Unsupported binary particle effect version " + String(header.version_));
+        return false;
+    }
+    if (!IsBlockValid(header.parametersOffset_, header.parametersSize_, size) ||
+        !IsBlockValid(header.settingsOffset_, header.settingsSize_, size) ||
+        !IsBlockValid(header.stringsOffset_, header.stringsSize_, size))
+    {
+        LOGERROR("Binary particle effect is truncated");
+        return false;
+    }
+
+    // Blocks written by an older build may be shorter, missing fields keep their current values
+    memcpy(&parameters, data + header.parametersOffset_, Min((unsigned)sizeof parameters, header.parametersSize_));
+    memcpy(&settings, data + header.settingsOffset_, Min((unsigned)sizeof settings, header.settingsSize_));
+
+    textureName.Clear();
+    if (header.textureName_ != M_MAX_UNSIGNED)
+    {
+        const char* strings = (const char*)data + header.stringsOffset_;
+        unsigned length = header.textureName_;
+        while (length < header.stringsSize_ && strings[length])
+            ++length;
+        if (length >= header.stringsSize_)
+        {
+            LOGERROR("Binary particle effect texture name is not terminated");
+            return false;
+        }
+
+        textureName = String(strings + header.textureName_);
+    }
+
+    return true;
+}
+
+bool ReadParticleEffectData(Context* context, bool binary, const unsigned char* data, unsigned size,
+    ParticleEffectParameters2D& parameters, ParticleEffectSettings2D& settings, String& textureName)
+{
+    if (binary)
+    {
+        ParticleEffectBinarySettings2D binarySettings;
+        GetParticleEffectBinarySettings(settings, binarySettings);
+        if (!ReadParticleEffectBinary(data, size, parameters, binarySettings, textureName))
+            return false;
+
+        SetParticleEffectBinarySettings(settings, binarySettings);
+        return true;
+    }
+
+    SharedPtr<XMLFile> xmlFile(new XMLFile(context));
+    MemoryBuffer buffer(data, size);
+    if (!xmlFile->Load(buffer))
+        return false;
+
+    XMLElement rootElem = xmlFile->GetRoot();
+    if (!ReadParticleEffectXML(rootElem, parameters, textureName))
+        return false;
+
+    settings.Load(rootElem);
+    return true;
+}
+
+bool WriteParticleEffectData(Context* context, bool binary, const ParticleEffectParameters2D& parameters,
+    const ParticleEffectSettings2D& settings, const String& textureName, Serializer& dest)
+{
+    if (binary)
+    {
+        ParticleEffectBinarySettings2D binarySettings;
+        GetParticleEffectBinarySettings(settings, binarySettings);
+        return WriteParticleEffectBinary(parameters, binarySettings, textureName, dest);
+    }
+
+    SharedPtr<XMLFile> xmlFile(new XMLFile(context));
+    XMLElement rootElem = xmlFile->CreateRoot("particleEmitterConfig");
+    WriteParticleEffectXML(rootElem, parameters, textureName);
+    settings.Save(rootElem);
+
+    return xmlFile->Save(dest);
+}
+
+Sprite2D* GetParticleEffectSprite(ResourceCache* cache, const String& name)
+{
+    unsigned separator = name.Find('@');
+    if (separator == String::NPOS)
+        return cache->GetResource<Sprite2D>(name);
+
+    SpriteSheet2D* spriteSheet = cache->GetResource<SpriteSheet2D>(name.Substring(0, separator));
+    return spriteSheet ? spriteSheet->GetSprite(name.Substring(separator + 1)) : 0;
+}
+
+String GetParticleEffectTextureName(const Sprite2D* sprite)
+{
+    if (!sprite)
+        return String::EMPTY;
+
+    // Sprites of a sheet are named by the sheet
+    SpriteSheet2D* spriteSheet = sprite->GetSpriteSheet();
+    if (spriteSheet)
+        return GetFileNameAndExtension(spriteSheet->GetName()) + "@" + sprite->GetName();
+
+    return GetFileNameAndExtension(sprite->GetName());
+}
+
+bool SaveParticleEffectBinary(const ParticleEffect2D* effect, const ParticleEffectSettings2D& settings, Serializer& dest)
+{
+    if (!effect)
+        return false;
+
+    ParticleEffectParameters2D parameters;
+    GetParticleEffectParameters(effect, parameters);
+
+    ParticleEffectBinarySettings2D binarySettings;
+    GetParticleEffectBinarySettings(settings, binarySettings);
+
+    String textureName = GetParticleEffectTextureName(effect->GetSprite());
+    return WriteParticleEffectBinary(parameters, binarySettings, textureName, dest);
+}
+
+bool LoadParticleEffectBinary(ParticleEffect2D* effect, ParticleEffectSettings2D& settings, const unsigned char* data, unsigned size)
+{
+    if (!effect)
+        return false;
+
+    ParticleEffectParameters2D parameters;
+    GetParticleEffectParameters(effect, parameters);
+
+    settings = ParticleEffectSettings2D();
+    ParticleEffectBinarySettings2D binarySettings;
+    GetParticleEffectBinarySettings(settings, binarySettings);
+
+    String textureName;
+    if (!ReadParticleEffectBinary(data, size, parameters, binarySettings, textureName))
+        return false;
+
+    SetParticleEffectParameters(effect, parameters);
+    SetParticleEffectBinarySettings(settings, binarySettings);
+
+    if (!textureName.Empty())
+    {
+        ResourceCache* cache = effect->GetSubsystem<ResourceCache>();
+        effect->SetSprite(GetParticleEffectSprite(cache, GetPath(effect->GetName()) + textureName));
+    }
+    else
+        effect->SetSprite(0);
+
+    return true;
+}
+
+ParticleEffect2D* LoadParticleEffect(Context* context, const String& fileName, ParticleEffectSettings2D* settings)
+{
+    ResourceCache* cache = context->GetSubsystem<ResourceCache>();
+    if (!cache)
+        return 0;
+
+    if (!IsParticleEffectBinary(fileName))
+    {
+        ParticleEffect2D* effect = cache->GetResource<ParticleEffect2D>(fileName);
+        if (!effect)
+            return 0;
+
+        XMLFile* xmlFile = cache->GetResource<XMLFile>(fileName);
+        if (settings)
+        {
+            if (xmlFile)
+                settings->Load(xmlFile->GetRoot());
+            else
+                *settings = ParticleEffectSettings2D();
+        }
+
+        // The engine only loads standalone textures. Resolve sprite sheet references here
+        if (!effect->GetSprite() && xmlFile)
+        {
+            String textureName = xmlFile->GetRoot().GetChild("texture").GetAttribute("name");
+            if (textureName.Find('@') != String::NPOS)
+                effect->SetSprite(GetParticleEffectSprite(cache, GetPath(fileName) + textureName));
+        }
+        return effect;
+    }
+
+    if (!settings)
+    {
+        ParticleEffect2D* existing = cache->GetExistingResource<ParticleEffect2D>(fileName);
+        if (existing)
+            return existing;
+    }
+
+    MemoryMappedFile file;
+    if (!file.Open(context, fileName))
+    {
+        LOGERROR("Open binary particle effect failed " + fileName);
+        return 0;
+    }
+
+    SharedPtr<ParticleEffect2D> effect(new ParticleEffect2D(context));
+    effect->SetName(fileName);
+
+    ParticleEffectSettings2D loadedSettings;
+    if (!LoadParticleEffectBinary(effect, loadedSettings, file.GetData(), file.GetSize()))
+    {
+        LOGERROR("Load binary particle effect failed " + fileName);
+        return 0;
+    }
+
+    if (settings)
+        *settings = loadedSettings;
+
+    cache->AddManualResource(effect);
+    return effect;
+}
+
+}
@@ -0,0 +1,204 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "ParticleEffectLod2D.h"
+#include "Str.h"
+
+namespace Urho3D
+{
+
+class Context;
+class ParticleEffect2D;
+class ParticleEffectSettings2D;
+class ResourceCache;
+class Serializer;
+class Sprite2D;
+
+/// Binary particle effect file identifier, "PEXB" in file order.
+static const unsigned PARTICLE_EFFECT_BINARY_ID = 0x42584550;
+/// Binary particle effect format version. Bump when a block changes meaning; appending fields to a block does not need a bump.
+static const unsigned PARTICLE_EFFECT_BINARY_VERSION = 1;
+
+/// Binary particle effect file header. All fields are 32-bit little endian so the file can be used straight from a memory map.
+struct ParticleEffectBinaryHeader2D
+{
+    /// File identifier.
+    unsigned id_;
+    /// Format version.
+    unsigned version_;
+    /// Parameters block offset.
+    unsigned parametersOffset_;
+    /// Parameters block size.
+    unsigned parametersSize_;
+    /// Settings block offset.
+    unsigned settingsOffset_;
+    /// Settings block size.
+    unsigned settingsSize_;
+    /// String table offset. Strings are zero terminated and stored once.
+    unsigned stringsOffset_;
+    /// String table size.
+    unsigned stringsSize_;
+    /// Texture file name as an offset into the string table, relative to the effect file. M_MAX_UNSIGNED if none.
+    unsigned textureName_;
+};
+
+/// Particle effect parameters in fixed layout, matching the attributes of ParticleEffect2D.
+struct ParticleEffectParameters2D
+{
+    /// Max particles.
+    int maxParticles_;
+    /// Emitter type.
+    int emitterType_;
+    /// Blend mode.
+    int blendMode_;
+    /// Duration.
+    float duration_;
+    /// Source position variance.
+    float sourcePositionVariance_[2];
+    /// Speed.
+    float speed_;
+    /// Speed variance.
+    float speedVariance_;
+    /// Particle life span.
+    float particleLifeSpan_;
+    /// Particle life span variance.
+    float particleLifespanVariance_;
+    /// Angle.
+    float angle_;
+    /// Angle variance.
+    float angleVariance_;
+    /// Gravity.
+    float gravity_[2];
+    /// Radial acceleration.
+    float radialAcceleration_;
+    /// Radial acceleration variance.
+    float radialAccelVariance_;
+    /// Tangential acceleration.
+    float tangentialAcceleration_;
+    /// Tangential acceleration variance.
+    float tangentialAccelVariance_;
+    /// Max radius.
+    float maxRadius_;
+    /// Max radius variance.
+    float maxRadiusVariance_;
+    /// Min radius.
+    float minRadius_;
+    /// Min radius variance.
+    float minRadiusVariance_;
+    /// Rotate per second.
+    float rotatePerSecond_;
+    /// Rotate per second variance.
+    float rotatePerSecondVariance_;
+    /// Start particle size.
+    float startParticleSize_;
+    /// Start particle size variance.
+    float startParticleSizeVariance_;
+    /// Finish particle size.
+    float finishParticleSize_;
+    /// Finish particle size variance.
+    float finishParticleSizeVariance_;
+    /// Start color.
+    float startColor_[4];
+    /// Start color variance.
+    float startColorVariance_[4];
+    /// Finish color.
+    float finishColor_[4];
+    /// Finish color variance.
+    float finishColorVariance_[4];
+    /// Rotation start.
+    float rotationStart_;
+    /// Rotation start variance.
+    float rotationStartVariance_;
+    /// Rotation end.
+    float rotationEnd_;
+    /// Rotation end variance.
+    float rotationEndVariance_;
+};
+
+/// Particle effect LOD level in fixed layout.
+struct ParticleEffectBinaryLodLevel2D
+{
+    /// Distance or screen size at which the level starts to apply.
+    float threshold_;
+    /// Max particles multiplier.
+    float particleScale_;
+    /// Spawn rate multiplier.
+    float spawnScale_;
+    /// Nonzero to draw simplified particles.
+    unsigned simplified_;
+};
+
+/// Particle effect settings in fixed layout.
+struct ParticleEffectBinarySettings2D
+{
+    /// Random seed.
+    unsigned randomSeed_;
+    /// LOD metric.
+    unsigned lodMetric_;
+    /// Number of LOD levels used.
+    unsigned numLodLevels_;
+    /// LOD levels.
+    ParticleEffectBinaryLodLevel2D lodLevels_[MAX_PARTICLE_LOD_LEVELS];
+    /// Prewarm time.
+    float prewarmTime_;
+};
+
+/// Copy effect attributes to parameters.
+void GetParticleEffectParameters(const ParticleEffect2D* effect, ParticleEffectParameters2D& dest);
+/// Copy parameters to effect attributes. The sprite is not touched.
+void SetParticleEffectParameters(ParticleEffect2D* effect, const ParticleEffectParameters2D& source);
+/// Copy settings to their fixed layout.
+void GetParticleEffectBinarySettings(const ParticleEffectSettings2D& settings, ParticleEffectBinarySettings2D& dest);
+/// Copy settings from their fixed layout.
+void SetParticleEffectBinarySettings(ParticleEffectSettings2D& settings, const ParticleEffectBinarySettings2D& source);
+
+/// Return whether file name has the binary particle effect extension.
+bool IsParticleEffectBinary(const String& fileName);
+/// Write parameters, settings and texture name in binary format. Return true if successful.
+bool WriteParticleEffectBinary(const ParticleEffectParameters2D& parameters, const ParticleEffectBinarySettings2D& settings,
+    const String& textureName, Serializer& dest);
+/// Read parameters, settings and texture name from binary data without touching the resource cache. Fields missing from blocks
+/// written by an older build keep their values. Return true if successful.
+bool ReadParticleEffectBinary(const unsigned char* data, unsigned size, ParticleEffectParameters2D& parameters,
+    ParticleEffectBinarySettings2D& settings, String& textureName);
+/// Read parameters, settings and texture name from the data of a .pex or .pexb file without touching the resource cache, so it
+/// is safe on worker threads. Parameters missing from the data keep their values. Return true if successful.
+bool ReadParticleEffectData(Context* context, bool binary, const unsigned char* data, unsigned size,
+    ParticleEffectParameters2D& parameters, ParticleEffectSettings2D& settings, String& textureName);
+/// Write parameters, settings and texture name in either format. Return true if successful.
+bool WriteParticleEffectData(Context* context, bool binary, const ParticleEffectParameters2D& parameters,
+    const ParticleEffectSettings2D& settings, const String& textureName, Serializer& dest);
+/// Return a sprite by resource name. Names of the form sheet.xml@sprite pick a sprite of a sprite sheet. Return null if not found.
+Sprite2D* GetParticleEffectSprite(ResourceCache* cache, const String& name);
+/// Return the texture name effect files store for a sprite, relative to the effect.
+String GetParticleEffectTextureName(const Sprite2D* sprite);
+/// Write effect and settings in binary format. Return true if successful.
+bool SaveParticleEffectBinary(const ParticleEffect2D* effect, const ParticleEffectSettings2D& settings, Serializer& dest);
+/// Read effect and settings from binary data, resolving the texture relative to the effect name. Return true if successful.
+bool LoadParticleEffectBinary(ParticleEffect2D* effect, ParticleEffectSettings2D& settings, const unsigned char* data, unsigned size);
+/// Load a particle effect picking the format by extension. Binary files are memory mapped when they are plain files and the
+/// result is added to the resource cache. Settings are filled when given. Return null on failure.
+ParticleEffect2D* LoadParticleEffect(Context* context, const String& fileName, ParticleEffectSettings2D* settings = 0);
+
+}
@@ -0,0 +1,184 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "ParticleEffectChanges2D.h"
+#include "ParticleEffectSettings2D.h"
+#include "ParticleSimulator2D.h"
+#include "Profiler.h"
+#include "SimulatedParticleEmitter2D.h"
+
+#include <cstring>
+
+namespace Urho3D
+{
+
+/// Queued emitter type bit.
+static const unsigned CHANGED_EMITTERTYPE = 1 << MAX_PARTICLE_EFFECT_ATTRIBUTES;
+/// Queued blend mode bit.
+static const unsigned CHANGED_BLENDMODE = 1 << (MAX_PARTICLE_EFFECT_ATTRIBUTES + 1);
+/// Queued random seed bit.
+static const unsigned CHANGED_RANDOMSEED = 1 << (MAX_PARTICLE_EFFECT_ATTRIBUTES + 2);
+/// Queued prewarm time bit.
+static const unsigned CHANGED_PREWARMTIME = 1 << (MAX_PARTICLE_EFFECT_ATTRIBUTES + 3);
+/// Bits of the edits that go to the effect parameters.
+static const unsigned CHANGED_PARAMETERS = CHANGED_RANDOMSEED - 1;
+
+ParticleEffectChanges2D::ParticleEffectChanges2D() :
+    randomSeed_(0),
+    prewarmTime_(0.0f),
+    changed_(0),
+    numQueued_(0)
+{
+    memset(&parameters_, 0, sizeof parameters_);
+}
+
+void ParticleEffectChanges2D::SetValue(ParticleEffectAttribute2D attribute, int value)
+{
+    SetComponents(attribute, &value, 0);
+}
+
+void ParticleEffectChanges2D::SetValue(ParticleEffectAttribute2D attribute, float value, float variance)
+{
+    SetComponents(attribute, &value, &variance);
+}
+
+void ParticleEffectChanges2D::SetValue(ParticleEffectAttribute2D attribute, const Vector2& value)
+{
+    SetComponents(attribute, &value.x_, 0);
+}
+
+void ParticleEffectChanges2D::SetValue(ParticleEffectAttribute2D attribute, const Color& value, const Color& variance)
+{
+    SetComponents(attribute, value.Data(), variance.Data());
+}
+
+void ParticleEffectChanges2D::SetEmitterType(EmitterType2D emitterType)
+{
+    parameters_.emitterType_ = emitterType;
+    changed_ |= CHANGED_EMITTERTYPE;
+    ++numQueued_;
+}
+
+void ParticleEffectChanges2D::SetBlendMode(BlendMode blendMode)
+{
+    parameters_.blendMode_ = blendMode;
+    changed_ |= CHANGED_BLENDMODE;
+    ++numQueued_;
+}
+
+void ParticleEffectChanges2D::SetRandomSeed(unsigned seed)
+{
+    randomSeed_ = seed;
+    changed_ |= CHANGED_RANDOMSEED;
+    ++numQueued_;
+}
+
+void ParticleEffectChanges2D::SetPrewarmTime(float time)
+{
+    prewarmTime_ = time;
+    changed_ |= CHANGED_PREWARMTIME;
+    ++numQueued_;
+}
+
+bool ParticleEffectChanges2D::Apply(SimulatedParticleEmitter2D* emitter, ParticleEffectSettings2D& settings)
+{
+    ParticleEffect2D* effect = emitter ? emitter->GetEffect() : 0;
+    if (!changed_ || !effect)
+        return false;
+
+    PROFILE(ApplyParticleEffectChanges);
+
+    if (changed_ & CHANGED_PARAMETERS)
+        ApplyParameters(emitter);
+
+    if (changed_ & (CHANGED_RANDOMSEED | CHANGED_PREWARMTIME))
+    {
+        ParticleSimulator2D* simulator = emitter->GetSimulator();
+        if (changed_ & CHANGED_RANDOMSEED)
+        {
+            settings.SetRandomSeed(randomSeed_);
+            simulator->SetRandomSeed(randomSeed_);
+        }
+        if (changed_ & CHANGED_PREWARMTIME)
+        {
+            settings.SetPrewarmTime(prewarmTime_);
+            simulator->SetPrewarmTime(prewarmTime_);
+        }
+
+        // Restart so the preview shows the new random stream or prewarm state from the first particle
+        simulator->Reset();
+    }
+
+    Clear();
+    return true;
+}
+
+void ParticleEffectChanges2D::Clear()
+{
+    changed_ = 0;
+    numQueued_ = 0;
+}
+
+void ParticleEffectChanges2D::ApplyParameters(SimulatedParticleEmitter2D* emitter)
+{
+    ParticleEffect2D* effect = emitter->GetEffect();
+    ParticleEffectParameters2D parameters;
+    GetParticleEffectParameters(effect, parameters);
+
+    // Copy each edited attribute by the offsets in the range table
+    unsigned char* dest = reinterpret_cast<unsigned char*>(&parameters);
+    const unsigned char* source = reinterpret_cast<const unsigned char*>(&parameters_);
+    for (unsigned i = 0; i < MAX_PARTICLE_EFFECT_ATTRIBUTES; ++i)
+    {
+        if (!(changed_ & (1 << i)))
+            continue;
+
+        const ParticleEffectRange2D& range = GetParticleEffectRange((ParticleEffectAttribute2D)i);
+        unsigned size = range.integer_ ? sizeof(int) : range.numComponents_ * sizeof(float);
+        memcpy(dest + range.valueOffset_, source + range.valueOffset_, size);
+        if (range.varianceRange_ != PVR_NONE)
+            memcpy(dest + range.varianceOffset_, source + range.varianceOffset_, size);
+    }
+
+    if (changed_ & CHANGED_EMITTERTYPE)
+        parameters.emitterType_ = parameters_.emitterType_;
+    if (changed_ & CHANGED_BLENDMODE)
+        parameters.blendMode_ = parameters_.blendMode_;
+
+    emitter->SetEffectParameters(parameters);
+}
+
+void ParticleEffectChanges2D::SetComponents(ParticleEffectAttribute2D attribute, const void* value, const void* variance)
+{
+    const ParticleEffectRange2D& range = GetParticleEffectRange(attribute);
+    unsigned size = range.integer_ ? sizeof(int) : range.numComponents_ * sizeof(float);
+
+    unsigned char* dest = reinterpret_cast<unsigned char*>(&parameters_);
+    memcpy(dest + range.valueOffset_, value, size);
+    if (range.varianceRange_ != PVR_NONE && variance)
+        memcpy(dest + range.varianceOffset_, variance, size);
+
+    changed_ |= 1 << attribute;
+    ++numQueued_;
+}
+
+}
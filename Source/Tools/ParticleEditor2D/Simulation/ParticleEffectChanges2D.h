@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "ParticleEffect2D.h"
+#include "ParticleEffectBinary2D.h"
+#include "ParticleEffectRanges2D.h"
+
+namespace Urho3D
+{
+
+class ParticleEffectSettings2D;
+class SimulatedParticleEmitter2D;
+
+/// Pending effect attribute edits. Repeated edits of an attribute overwrite each other, and all of them are applied to
+/// the effect in one go before the next simulation step.
+class ParticleEffectChanges2D
+{
+public:
+    /// Construct.
+    ParticleEffectChanges2D();
+
+    /// Queue an integer attribute.
+    void SetValue(ParticleEffectAttribute2D attribute, int value);
+    /// Queue a float attribute and its variance.
+    void SetValue(ParticleEffectAttribute2D attribute, float value, float variance = 0.0f);
+    /// Queue a vector attribute.
+    void SetValue(ParticleEffectAttribute2D attribute, const Vector2& value);
+    /// Queue a color attribute and its variance.
+    void SetValue(ParticleEffectAttribute2D attribute, const Color& value, const Color& variance);
+    /// Queue emitter type.
+    void SetEmitterType(EmitterType2D emitterType);
+    /// Queue blend mode.
+    void SetBlendMode(BlendMode blendMode);
+    /// Queue random seed.
+    void SetRandomSeed(unsigned seed);
+    /// Queue prewarm time.
+    void SetPrewarmTime(float time);
+    /// Apply queued edits to the emitter's effect, and the max particles and blend mode to the emitter itself. A queued
+    /// random seed or prewarm time goes to the settings and the simulator, which then resets once. Return true if
+    /// anything was applied.
+    bool Apply(SimulatedParticleEmitter2D* emitter, ParticleEffectSettings2D& settings);
+    /// Drop queued edits.
+    void Clear();
+
+    /// Return whether edits are queued.
+    bool HasChanges() const { return changed_ != 0; }
+    /// Return whether an attribute has a queued edit.
+    bool HasChange(ParticleEffectAttribute2D attribute) const { return (changed_ & (1 << attribute)) != 0; }
+    /// Return number of edits queued since the last apply, counting overwritten ones.
+    unsigned GetNumQueued() const { return numQueued_; }
+
+private:
+    /// Copy the queued attributes, emitter type and blend mode to the emitter's effect.
+    void ApplyParameters(SimulatedParticleEmitter2D* emitter);
+    /// Queue attribute components.
+    void SetComponents(ParticleEffectAttribute2D attribute, const void* value, const void* variance);
+
+    /// Queued values at their ParticleEffectParameters2D offsets.
+    ParticleEffectParameters2D parameters_;
+    /// Queued random seed.
+    unsigned randomSeed_;
+    /// Queued prewarm time.
+    float prewarmTime_;
+    /// Bit per attribute with a queued edit, followed by the emitter type, blend mode, random seed and prewarm time bits.
+    unsigned changed_;
+    /// Number of edits queued since the last apply.
+    unsigned numQueued_;
+};
+
+}
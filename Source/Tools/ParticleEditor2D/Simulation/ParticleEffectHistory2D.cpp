@@ -0,0 +1,233 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "ParticleEffect2D.h"
+#include "ParticleEffectHistory2D.h"
+#include "ParticleEffectSettings2D.h"
+#include "ParticleSimulator2D.h"
+#include "SimulatedParticleEmitter2D.h"
+
+#include <cstring>
+
+namespace Urho3D
+{
+
+/// Number of 32-bit words in the parameters.
+static const unsigned NUM_PARAMETER_WORDS = sizeof(ParticleEffectParameters2D) / sizeof(unsigned);
+/// Word index of the random seed.
+static const unsigned RANDOMSEED_WORD = NUM_PARAMETER_WORDS;
+/// Word index of the prewarm time.
+static const unsigned PREWARMTIME_WORD = NUM_PARAMETER_WORDS + 1;
+/// Number of words an edit is compared on.
+static const unsigned NUM_WORDS = NUM_PARAMETER_WORDS + 2;
+
+/// Gather the parameters followed by the random seed and prewarm time as words.
+static void GetWords(const ParticleEffectParameters2D& parameters, const ParticleEffectSettings2D& settings, unsigned* words)
+{
+    memcpy(words, &parameters, sizeof parameters);
+    words[RANDOMSEED_WORD] = settings.GetRandomSeed();
+    float prewarmTime = settings.GetPrewarmTime();
+    memcpy(&words[PREWARMTIME_WORD], &prewarmTime, sizeof(unsigned));
+}
+
+ParticleEffectHistory2D::ParticleEffectHistory2D() :
+    position_(0),
+    memoryUse_(0),
+    memoryBudget_(1024 * 1024),
+    mergeTime_(1000),
+    merge_(false)
+{
+}
+
+void ParticleEffectHistory2D::Record(const ParticleEffectParameters2D& before, const ParticleEffectSettings2D& settingsBefore,
+    const ParticleEffectParameters2D& after, const ParticleEffectSettings2D& settingsAfter)
+{
+    unsigned oldWords[NUM_WORDS];
+    unsigned newWords[NUM_WORDS];
+    GetWords(before, settingsBefore, oldWords);
+    GetWords(after, settingsAfter, newWords);
+
+    PODVector<ParticleEffectDelta2D> deltas;
+    for (unsigned i = 0; i < NUM_WORDS; ++i)
+    {
+        if (oldWords[i] == newWords[i])
+            continue;
+
+        ParticleEffectDelta2D delta;
+        delta.word_ = (unsigned short)i;
+        delta.oldValue_ = oldWords[i];
+        delta.newValue_ = newWords[i];
+        deltas.Push(delta);
+    }
+
+    if (deltas.Empty())
+        return;
+
+    // Drop the redo entries
+    while (entries_.Size() > position_)
+    {
+        memoryUse_ -= GetEntrySize(entries_.Back());
+        entries_.Pop();
+    }
+
+    bool merge = merge_ && mergeTimer_.GetMSec(false) <= mergeTime_;
+    merge_ = true;
+    mergeTimer_.Reset();
+    if (merge && Merge(deltas))
+        return;
+
+    entries_.Resize(entries_.Size() + 1);
+    entries_.Back().deltas_ = deltas;
+    memoryUse_ += GetEntrySize(entries_.Back());
+    position_ = entries_.Size();
+
+    // Keep the newest entry even if it alone is over budget
+    while (memoryUse_ > memoryBudget_ && entries_.Size() > 1)
+    {
+        memoryUse_ -= GetEntrySize(entries_.Front());
+        entries_.Erase(0);
+        --position_;
+    }
+}
+
+bool ParticleEffectHistory2D::Undo(SimulatedParticleEmitter2D* emitter, ParticleEffectSettings2D& settings)
+{
+    if (!position_ || !Restore(emitter, settings, entries_[position_ - 1], false))
+        return false;
+
+    --position_;
+    merge_ = false;
+    return true;
+}
+
+bool ParticleEffectHistory2D::Redo(SimulatedParticleEmitter2D* emitter, ParticleEffectSettings2D& settings)
+{
+    if (position_ >= entries_.Size() || !Restore(emitter, settings, entries_[position_], true))
+        return false;
+
+    ++position_;
+    merge_ = false;
+    return true;
+}
+
+void ParticleEffectHistory2D::Clear()
+{
+    entries_.Clear();
+    position_ = 0;
+    memoryUse_ = 0;
+    merge_ = false;
+}
+
+void ParticleEffectHistory2D::SetMemoryBudget(unsigned bytes)
+{
+    memoryBudget_ = bytes;
+    while (memoryUse_ > memoryBudget_ && entries_.Size() > 1)
+    {
+        memoryUse_ -= GetEntrySize(entries_.Front());
+        entries_.Erase(0);
+        if (position_)
+            --position_;
+    }
+}
+
+bool ParticleEffectHistory2D::Restore(SimulatedParticleEmitter2D* emitter, ParticleEffectSettings2D& settings, const Entry& entry,
+    bool redo)
+{
+    ParticleEffect2D* effect = emitter ? emitter->GetEffect() : 0;
+    if (!effect)
+        return false;
+
+    // Patch the current parameters in place, so the effect and its emitter are kept rather than reloaded
+    ParticleEffectParameters2D parameters;
+    GetParticleEffectParameters(effect, parameters);
+
+    unsigned words[NUM_WORDS];
+    GetWords(parameters, settings, words);
+    bool settingsChanged = false;
+    for (unsigned i = 0; i < entry.deltas_.Size(); ++i)
+    {
+        const ParticleEffectDelta2D& delta = entry.deltas_[i];
+        words[delta.word_] = redo ? delta.newValue_ : delta.oldValue_;
+        if (delta.word_ >= NUM_PARAMETER_WORDS)
+            settingsChanged = true;
+    }
+
+    memcpy(&parameters, words, sizeof parameters);
+    emitter->SetEffectParameters(parameters);
+
+    if (settingsChanged)
+    {
+        float prewarmTime;
+        memcpy(&prewarmTime, &words[PREWARMTIME_WORD], sizeof prewarmTime);
+        settings.SetRandomSeed(words[RANDOMSEED_WORD]);
+        settings.SetPrewarmTime(prewarmTime);
+
+        ParticleSimulator2D* simulator = emitter->GetSimulator();
+        simulator->SetRandomSeed(settings.GetRandomSeed());
+        simulator->SetPrewarmTime(settings.GetPrewarmTime());
+        simulator->Reset();
+    }
+
+    return true;
+}
+
+bool ParticleEffectHistory2D::Merge(const PODVector<ParticleEffectDelta2D>& deltas)
+{
+    if (!position_)
+        return false;
+
+    Entry& last = entries_[position_ - 1];
+    if (last.deltas_.Size() != deltas.Size())
+        return false;
+    for (unsigned i = 0; i < deltas.Size(); ++i)
+    {
+        if (last.deltas_[i].word_ != deltas[i].word_)
+            return false;
+    }
+
+    // Keep the values from before the first edit and take the values after this one
+    bool unchanged = true;
+    for (unsigned i = 0; i < deltas.Size(); ++i)
+    {
+        last.deltas_[i].newValue_ = deltas[i].newValue_;
+        if (last.deltas_[i].newValue_ != last.deltas_[i].oldValue_)
+            unchanged = false;
+    }
+
+    // A drag that ends where it started leaves nothing to undo
+    if (unchanged)
+    {
+        memoryUse_ -= GetEntrySize(last);
+        entries_.Pop();
+        --position_;
+        merge_ = false;
+    }
+
+    return true;
+}
+
+unsigned ParticleEffectHistory2D::GetEntrySize(const Entry& entry)
+{
+    return sizeof(Entry) + entry.deltas_.Size() * sizeof(ParticleEffectDelta2D);
+}
+
+}
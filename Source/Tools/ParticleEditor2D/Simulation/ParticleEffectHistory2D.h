@@ -0,0 +1,113 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "ParticleEffectBinary2D.h"
+#include "Timer.h"
+#include "Vector.h"
+
+namespace Urho3D
+{
+
+class ParticleEffectSettings2D;
+class SimulatedParticleEmitter2D;
+
+/// Changed 32-bit word of ParticleEffectParameters2D, or of the random seed and prewarm time that follow it.
+struct ParticleEffectDelta2D
+{
+    /// Word index.
+    unsigned short word_;
+    /// Value before the edit.
+    unsigned oldValue_;
+    /// Value after the edit.
+    unsigned newValue_;
+};
+
+/// Undo history of particle effect parameters and of the random seed and prewarm time settings. Each entry keeps only the words an edit changed. Edits of the same words
+/// in quick succession, such as a slider drag, merge into one entry. The oldest entries are dropped to stay within a
+/// memory budget.
+class ParticleEffectHistory2D
+{
+public:
+    /// Construct.
+    ParticleEffectHistory2D();
+
+    /// Record an edit from the parameters and settings before and after it. Drops the redo entries.
+    void Record(const ParticleEffectParameters2D& before, const ParticleEffectSettings2D& settingsBefore,
+        const ParticleEffectParameters2D& after, const ParticleEffectSettings2D& settingsAfter);
+    /// Make the next edit start a new entry.
+    void EndMerge() { merge_ = false; }
+    /// Revert the emitter's effect and the settings by one entry. Return true if successful.
+    bool Undo(SimulatedParticleEmitter2D* emitter, ParticleEffectSettings2D& settings);
+    /// Reapply one undone entry to the emitter's effect and the settings. Return true if successful.
+    bool Redo(SimulatedParticleEmitter2D* emitter, ParticleEffectSettings2D& settings);
+    /// Remove all entries.
+    void Clear();
+    /// Set memory budget in bytes.
+    void SetMemoryBudget(unsigned bytes);
+    /// Set max time between edits that merge, in milliseconds.
+    void SetMergeTime(unsigned milliseconds) { mergeTime_ = milliseconds; }
+
+    /// Return number of entries that can be undone.
+    unsigned GetNumUndo() const { return position_; }
+    /// Return number of entries that can be redone.
+    unsigned GetNumRedo() const { return entries_.Size() - position_; }
+    /// Return memory use in bytes.
+    unsigned GetMemoryUse() const { return memoryUse_; }
+    /// Return memory budget in bytes.
+    unsigned GetMemoryBudget() const { return memoryBudget_; }
+    /// Return max time between edits that merge, in milliseconds.
+    unsigned GetMergeTime() const { return mergeTime_; }
+
+private:
+    /// History entry.
+    struct Entry
+    {
+        /// Changed words, in word order.
+        PODVector<ParticleEffectDelta2D> deltas_;
+    };
+
+    /// Write either side of an entry's words to the emitter's effect and the settings.
+    bool Restore(SimulatedParticleEmitter2D* emitter, ParticleEffectSettings2D& settings, const Entry& entry, bool redo);
+    /// Merge an edit into the last entry if it changed the same words. Return true if merged.
+    bool Merge(const PODVector<ParticleEffectDelta2D>& deltas);
+    /// Return memory use of an entry.
+    static unsigned GetEntrySize(const Entry& entry);
+
+    /// Entries, oldest first.
+    Vector<Entry> entries_;
+    /// Number of entries before the redo entries.
+    unsigned position_;
+    /// Memory use.
+    unsigned memoryUse_;
+    /// Memory budget.
+    unsigned memoryBudget_;
+    /// Max time between edits that merge.
+    unsigned mergeTime_;
+    /// Whether the next edit may merge into the last entry.
+    bool merge_;
+    /// Time since the last edit.
+    Timer mergeTimer_;
+};
+
+}
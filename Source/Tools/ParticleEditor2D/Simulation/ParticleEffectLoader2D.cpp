@@ -0,0 +1,498 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Context.h"
+#include "File.h"
+#include "FileSystem.h"
+#include "Image.h"
+#include "Log.h"
+#include "MemoryBuffer.h"
+#include "ParticleEffect2D.h"
+#include "ParticleEffectLoader2D.h"
+#include "ResourceCache.h"
+#include "Sprite2D.h"
+#include "Texture2D.h"
+#include "Timer.h"
+#include "XMLFile.h"
+
+namespace Urho3D
+{
+
+/// Bytes read between progress updates.
+static const unsigned LOADER_CHUNK_SIZE = 64 * 1024;
+/// Sleep time of the idle loader thread in milliseconds.
+static const unsigned LOADER_IDLE_SLEEP = 5;
+/// Size of the placeholder texture.
+static const int PLACEHOLDER_SIZE = 32;
+
+ParticleEffectLoader2D::ParticleEffectLoader2D(Context* context) :
+    Object(context),
+    current_(0),
+    nextId_(1),
+    loadedBytes_(0),
+    totalBytes_(0)
+{
+}
+
+ParticleEffectLoader2D::~ParticleEffectLoader2D()
+{
+    Stop();
+
+    for (unsigned i = 0; i < requests_.Size(); ++i)
+        delete requests_[i];
+}
+
+void ParticleEffectLoader2D::ThreadFunction()
+{
+    while (shouldRun_)
+    {
+        ParticleLoadRequest2D* request = 0;
+        bool textureStage = false;
+        {
+            MutexLock lock(mutex_);
+            for (unsigned i = 0; i < requests_.Size(); ++i)
+            {
+                ParticleLoadRequest2D* candidate = requests_[i];
+                if (candidate->cancelled_ || candidate->failed_)
+                    continue;
+
+                // Textures wait until the main thread has checked the resource cache for them
+                if (!candidate->effectLoaded_)
+                    request = candidate;
+                else if (candidate->effectReturned_ && !candidate->textureLoaded_)
+                {
+                    request = candidate;
+                    textureStage = true;
+                }
+
+                if (request)
+                    break;
+            }
+
+            current_ = request;
+        }
+
+        if (!request)
+        {
+            Time::Sleep(LOADER_IDLE_SLEEP);
+            continue;
+        }
+
+        if (textureStage)
+            LoadTextureData(request);
+        else
+            LoadEffectData(request);
+    }
+}
+
+unsigned ParticleEffectLoader2D::LoadEffect(const String& name)
+{
+    String fileName = GetNativeFileName(name);
+    if (fileName.Empty())
+        return 0;
+
+    ParticleLoadRequest2D* request = new ParticleLoadRequest2D();
+    request->effectName_ = name;
+    request->effectFileName_ = fileName;
+
+    // Parameters missing from the file keep the defaults of a new effect
+    request->effect_ = new ParticleEffect2D(context_);
+    request->effect_->SetName(name);
+    GetParticleEffectParameters(request->effect_, request->parameters_);
+
+    return AddRequest(request);
+}
+
+unsigned ParticleEffectLoader2D::LoadSprite(const String& name)
+{
+    ParticleLoadRequest2D* request = new ParticleLoadRequest2D();
+    request->textureName_ = name;
+    request->effectLoaded_ = true;
+    request->effectReturned_ = true;
+
+    request->sprite_ = GetSubsystem<ResourceCache>()->GetExistingResource<Sprite2D>(name);
+    if (request->sprite_)
+        request->textureLoaded_ = true;
+    else
+    {
+        // Sprites of a sheet are found through the sheet file
+        request->textureFileName_ = GetNativeFileName(name.Substring(0, name.Find('@')));
+        if (request->textureFileName_.Empty())
+        {
+            delete request;
+            return 0;
+        }
+    }
+
+    return AddRequest(request);
+}
+
+void ParticleEffectLoader2D::Cancel(unsigned id)
+{
+    MutexLock lock(mutex_);
+    for (unsigned i = 0; i < requests_.Size(); ++i)
+    {
+        if (requests_[i]->id_ == id)
+            requests_[i]->cancelled_ = true;
+    }
+}
+
+bool ParticleEffectLoader2D::GetNextResult(ParticleLoadResult2D& result)
+{
+    ParticleLoadRequest2D* request = 0;
+    bool textureStage = false;
+    {
+        MutexLock lock(mutex_);
+        for (unsigned i = 0; i < requests_.Size(); ++i)
+        {
+            ParticleLoadRequest2D* candidate = requests_[i];
+            if (candidate->cancelled_)
+            {
+                if (candidate != current_)
+                {
+                    delete candidate;
+                    requests_.Erase(i--);
+                }
+                continue;
+            }
+
+            if (candidate->effectLoaded_ && !candidate->effectReturned_)
+                request = candidate;
+            else if (candidate->effectReturned_ && candidate->textureLoaded_)
+            {
+                request = candidate;
+                textureStage = true;
+            }
+
+            if (request)
+                break;
+        }
+    }
+
+    if (!request)
+        return false;
+
+    result.id_ = request->id_;
+    result.texture_ = textureStage;
+    result.effect_.Reset();
+    result.sprite_.Reset();
+    result.settings_ = ParticleEffectSettings2D();
+
+    if (!textureStage)
+    {
+        result.name_ = request->effectName_;
+        result.success_ = !request->failed_;
+        if (result.success_)
+        {
+            SetParticleEffectParameters(request->effect_, request->parameters_);
+            result.effect_ = request->effect_;
+            result.settings_ = request->settings_;
+        }
+
+        bool finished = request->failed_ || request->textureName_.Empty();
+        if (result.success_ && !finished)
+        {
+            ResourceCache* cache = GetSubsystem<ResourceCache>();
+            request->sprite_ = cache->GetExistingResource<Sprite2D>(request->textureName_);
+            request->effect_->SetSprite(request->sprite_ ? request->sprite_.Get() : GetPlaceholderSprite());
+        }
+        else if (result.success_)
+            request->effect_->SetSprite(0);
+
+        MutexLock lock(mutex_);
+        if (finished)
+        {
+            requests_.Remove(request);
+            delete request;
+        }
+        else
+        {
+            request->effectReturned_ = true;
+            if (request->sprite_)
+                request->textureLoaded_ = true;
+        }
+        return true;
+    }
+
+    result.name_ = request->textureName_;
+    result.sprite_ = request->sprite_ ? request->sprite_.Get() : CreateSprite(request);
+    result.success_ = result.sprite_.NotNull();
+
+    MutexLock lock(mutex_);
+    requests_.Remove(request);
+    delete request;
+    return true;
+}
+
+bool ParticleEffectLoader2D::IsLoading() const
+{
+    MutexLock lock(mutex_);
+    return !requests_.Empty();
+}
+
+bool ParticleEffectLoader2D::HasResults() const
+{
+    MutexLock lock(mutex_);
+    for (unsigned i = 0; i < requests_.Size(); ++i)
+    {
+        const ParticleLoadRequest2D* request = requests_[i];
+        if (!request->cancelled_ && ((request->effectLoaded_ && !request->effectReturned_) ||
+            (request->effectReturned_ && request->textureLoaded_)))
+            return true;
+    }
+
+    return false;
+}
+
+float ParticleEffectLoader2D::GetProgress() const
+{
+    MutexLock lock(mutex_);
+    return totalBytes_ ? (float)loadedBytes_ / (float)totalBytes_ : 0.0f;
+}
+
+String ParticleEffectLoader2D::GetLoadingName() const
+{
+    MutexLock lock(mutex_);
+    return loadingName_;
+}
+
+Sprite2D* ParticleEffectLoader2D::GetPlaceholderSprite()
+{
+    if (!placeholderSprite_)
+    {
+        // A soft white dot keeps the shape and colors of the effect readable until its texture arrives
+        SharedPtr<Image> image(new Image(context_));
+        image->SetSize(PLACEHOLDER_SIZE, PLACEHOLDER_SIZE, 4);
+
+        float halfSize = PLACEHOLDER_SIZE * 0.5f;
+        for (int y = 0; y < PLACEHOLDER_SIZE; ++y)
+        {
+            for (int x = 0; x < PLACEHOLDER_SIZE; ++x)
+            {
+                Vector2 offset((x + 0.5f - halfSize) / halfSize, (y + 0.5f - halfSize) / halfSize);
+                float alpha = Clamp(1.0f - offset.Length(), 0.0f, 1.0f);
+                image->SetPixel(x, y, Color(1.0f, 1.0f, 1.0f, alpha));
+            }
+        }
+
+        SharedPtr<Texture2D> texture(new Texture2D(context_));
+        texture->Load(image, true);
+
+        placeholderSprite_ = new Sprite2D(context_);
+        placeholderSprite_->SetTexture(texture);
+        placeholderSprite_->SetRectangle(IntRect(0, 0, PLACEHOLDER_SIZE, PLACEHOLDER_SIZE));
+    }
+
+    return placeholderSprite_;
+}
+
+unsigned ParticleEffectLoader2D::AddRequest(ParticleLoadRequest2D* request)
+{
+    {
+        MutexLock lock(mutex_);
+        request->id_ = nextId_++;
+        requests_.Push(request);
+    }
+
+    if (!IsStarted())
+        Run();
+
+    return request->id_;
+}
+
+String ParticleEffectLoader2D::GetNativeFileName(const String& name) const
+{
+    String fileName = GetSubsystem<ResourceCache>()->GetResourceFileName(name);
+    if (fileName.Empty() && GetSubsystem<FileSystem>()->FileExists(name))
+        fileName = name;
+
+    return fileName;
+}
+
+bool ParticleEffectLoader2D::ReadFile(const String& fileName, PODVector<unsigned char>& dest)
+{
+    File file(context_);
+    if (!file.Open(fileName))
+        return false;
+
+    unsigned size = file.GetSize();
+    dest.Resize(size);
+    {
+        MutexLock lock(mutex_);
+        loadingName_ = fileName;
+        loadedBytes_ = 0;
+        totalBytes_ = size;
+    }
+
+    for (unsigned offset = 0; offset < size;)
+    {
+        if (!shouldRun_)
+            return false;
+
+        unsigned chunkSize = Min(size - offset, LOADER_CHUNK_SIZE);
+        if (file.Read(&dest[offset], chunkSize) != chunkSize)
+            return false;
+        offset += chunkSize;
+
+        MutexLock lock(mutex_);
+        loadedBytes_ = offset;
+    }
+
+    return true;
+}
+
+void ParticleEffectLoader2D::LoadEffectData(ParticleLoadRequest2D* request)
+{
+    PODVector<unsigned char> data;
+    ParticleEffectParameters2D parameters = request->parameters_;
+    ParticleEffectSettings2D settings;
+    String textureName;
+
+    bool success = ReadFile(request->effectFileName_, data) && !data.Empty() &&
+        ReadParticleEffectData(context_, IsParticleEffectBinary(request->effectFileName_), &data[0], data.Size(), parameters,
+        settings, textureName);
+
+    MutexLock lock(mutex_);
+    if (success)
+    {
+        request->parameters_ = parameters;
+        request->settings_ = settings;
+
+        // The texture name is relative to the effect
+        if (!textureName.Empty())
+        {
+            request->textureName_ = GetPath(request->effectName_) + textureName;
+            request->textureFileName_ = GetPath(request->effectFileName_) + textureName.Substring(0, textureName.Find('@'));
+        }
+    }
+
+    request->failed_ = !success;
+    request->effectLoaded_ = true;
+    current_ = 0;
+}
+
+void ParticleEffectLoader2D::LoadTextureData(ParticleLoadRequest2D* request)
+{
+    String imageName = request->textureName_;
+    String imageFileName = request->textureFileName_;
+    IntRect rectangle(IntRect::ZERO);
+
+    bool success = true;
+    unsigned separator = request->textureName_.Find('@');
+    if (separator != String::NPOS)
+    {
+        success = LoadSpriteSheetData(request->textureFileName_, request->textureName_.Substring(separator + 1), imageFileName,
+            rectangle);
+        imageName = GetPath(request->textureName_) + GetFileNameAndExtension(imageFileName);
+    }
+
+    PODVector<unsigned char> data;
+    SharedPtr<Image> image(new Image(context_));
+    if (success)
+        success = ReadFile(imageFileName, data) && !data.Empty();
+    if (success)
+    {
+        MemoryBuffer buffer(data);
+        success = image->Load(buffer);
+    }
+
+    MutexLock lock(mutex_);
+    if (success)
+    {
+        request->image_ = image;
+        request->imageName_ = imageName;
+        request->rectangle_ = rectangle;
+    }
+    request->textureLoaded_ = true;
+    current_ = 0;
+}
+
+bool ParticleEffectLoader2D::LoadSpriteSheetData(const String& sheetFileName, const String& spriteName, String& imageFileName,
+    IntRect& rectangle)
+{
+    PODVector<unsigned char> data;
+    if (!ReadFile(sheetFileName, data) || data.Empty())
+        return false;
+
+    SharedPtr<XMLFile> xmlFile(new XMLFile(context_));
+    MemoryBuffer buffer(data);
+    if (!xmlFile->Load(buffer))
+        return false;
+
+    XMLElement rootElem = xmlFile->GetRoot("TextureAtlas");
+    if (!rootElem)
+        return false;
+
+    for (XMLElement subTextureElem = rootElem.GetChild("SubTexture"); subTextureElem;
+        subTextureElem = subTextureElem.GetNext("SubTexture"))
+    {
+        if (subTextureElem.GetAttribute("name") != spriteName)
+            continue;
+
+        int x = subTextureElem.GetInt("x");
+        int y = subTextureElem.GetInt("y");
+        rectangle = IntRect(x, y, x + subTextureElem.GetInt("width"), y + subTextureElem.GetInt("height"));
+        imageFileName = GetPath(sheetFileName) + rootElem.GetAttribute("imagePath");
+        return true;
+    }
+
+    return false;
+}
+
+Sprite2D* ParticleEffectLoader2D::CreateSprite(ParticleLoadRequest2D* request)
+{
+    if (!request->image_)
+    {
+        LOGERROR("Load texture failed " + request->textureName_);
+        return 0;
+    }
+
+    // Sprites of one atlas share its texture
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    SharedPtr<Texture2D> texture(cache->GetExistingResource<Texture2D>(request->imageName_));
+    if (!texture)
+    {
+        texture = new Texture2D(context_);
+        texture->SetName(request->imageName_);
+        if (!texture->Load(request->image_))
+        {
+            LOGERROR("Create texture failed " + request->imageName_);
+            return 0;
+        }
+        cache->AddManualResource(texture);
+    }
+
+    IntRect rectangle = request->rectangle_;
+    if (rectangle.right_ <= rectangle.left_ || rectangle.bottom_ <= rectangle.top_)
+        rectangle = IntRect(0, 0, texture->GetWidth(), texture->GetHeight());
+
+    SharedPtr<Sprite2D> sprite(new Sprite2D(context_));
+    sprite->SetName(request->textureName_);
+    sprite->SetTexture(texture);
+    sprite->SetRectangle(rectangle);
+
+    // Later loads of the same sprite, also through the resource cache, share it
+    cache->AddManualResource(sprite);
+    return sprite;
+}
+
+}
@@ -0,0 +1,186 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Mutex.h"
+#include "Object.h"
+#include "Rect.h"
+#include "ParticleEffectBinary2D.h"
+#include "ParticleEffectSettings2D.h"
+#include "Thread.h"
+
+namespace Urho3D
+{
+
+class Image;
+class ParticleEffect2D;
+class Sprite2D;
+
+/// Load request. Fields written by the loader thread are guarded by the loader mutex.
+struct ParticleLoadRequest2D
+{
+    /// Construct.
+    ParticleLoadRequest2D() :
+        id_(0),
+        effectLoaded_(false),
+        textureLoaded_(false),
+        effectReturned_(false),
+        failed_(false),
+        cancelled_(false)
+    {
+    }
+
+    /// Request id.
+    unsigned id_;
+    /// Effect resource name, empty for sprite requests.
+    String effectName_;
+    /// Effect file path.
+    String effectFileName_;
+    /// Texture resource name, or sprite sheet name and sprite name separated by @.
+    String textureName_;
+    /// Texture or sprite sheet file path.
+    String textureFileName_;
+    /// Texture image resource name.
+    String imageName_;
+    /// Sprite rectangle within a sprite sheet texture. Zero for whole textures.
+    IntRect rectangle_;
+    /// Effect, created on the main thread.
+    SharedPtr<ParticleEffect2D> effect_;
+    /// Effect parameters.
+    ParticleEffectParameters2D parameters_;
+    /// Settings stored alongside the effect.
+    ParticleEffectSettings2D settings_;
+    /// Sprite, created on the main thread.
+    SharedPtr<Sprite2D> sprite_;
+    /// Decoded texture image.
+    SharedPtr<Image> image_;
+    /// Effect stage finished flag.
+    bool effectLoaded_;
+    /// Texture stage finished flag.
+    bool textureLoaded_;
+    /// Effect result returned flag.
+    bool effectReturned_;
+    /// Load failed flag.
+    bool failed_;
+    /// Cancelled flag.
+    bool cancelled_;
+};
+
+/// Finished load stage, returned on the main thread.
+struct ParticleLoadResult2D
+{
+    /// Construct.
+    ParticleLoadResult2D() :
+        id_(0),
+        texture_(false),
+        success_(false)
+    {
+    }
+
+    /// Request id.
+    unsigned id_;
+    /// Texture stage flag. The effect stage of a request is returned first.
+    bool texture_;
+    /// Effect or texture resource name.
+    String name_;
+    /// Loaded effect, null for sprite results. Its sprite is the placeholder until the sprite result arrives.
+    SharedPtr<ParticleEffect2D> effect_;
+    /// Settings stored alongside the effect.
+    ParticleEffectSettings2D settings_;
+    /// Loaded sprite, null for effect results and for effects without a texture.
+    SharedPtr<Sprite2D> sprite_;
+    /// Success flag.
+    bool success_;
+};
+
+/// Loads particle effects and their textures on a dedicated I/O thread, so that slow disks and network shares do not stall the
+/// editor. Files are read in chunks to report progress. Effects arrive first with a placeholder sprite, textures follow. Results
+/// are turned into resources on the main thread when GetNextResult() is called.
+class ParticleEffectLoader2D : public Object, public Thread
+{
+    OBJECT(ParticleEffectLoader2D)
+
+public:
+    /// Construct.
+    ParticleEffectLoader2D(Context* context);
+    /// Destruct. Stop the loader thread.
+    virtual ~ParticleEffectLoader2D();
+
+    /// Load thread function.
+    virtual void ThreadFunction();
+
+    /// Queue loading an effect and its texture by resource name or file path. Return request id, or 0 if the file does not exist.
+    unsigned LoadEffect(const String& name);
+    /// Queue loading a sprite by resource name. Return request id, or 0 if the file does not exist.
+    unsigned LoadSprite(const String& name);
+    /// Cancel a request. Results already returned stay valid.
+    void Cancel(unsigned id);
+    /// Return the next finished load stage. Call on the main thread. Return false if none.
+    bool GetNextResult(ParticleLoadResult2D& result);
+
+    /// Return whether requests are pending.
+    bool IsLoading() const;
+    /// Return whether finished load stages wait for GetNextResult().
+    bool HasResults() const;
+    /// Return progress of the file being read from 0 to 1.
+    float GetProgress() const;
+    /// Return name of the file being read.
+    String GetLoadingName() const;
+    /// Return placeholder sprite shown until textures arrive.
+    Sprite2D* GetPlaceholderSprite();
+
+private:
+    /// Queue a request and start the thread.
+    unsigned AddRequest(ParticleLoadRequest2D* request);
+    /// Return native file path of a resource name or file path, or empty if not found.
+    String GetNativeFileName(const String& name) const;
+    /// Read a file in chunks, updating progress. Return true if successful.
+    bool ReadFile(const String& fileName, PODVector<unsigned char>& dest);
+    /// Read the effect stage of a request on the loader thread.
+    void LoadEffectData(ParticleLoadRequest2D* request);
+    /// Read and decode the texture stage of a request on the loader thread.
+    void LoadTextureData(ParticleLoadRequest2D* request);
+    /// Read the image name and sprite rectangle of a sprite sheet sprite on the loader thread. Return true if successful.
+    bool LoadSpriteSheetData(const String& sheetFileName, const String& spriteName, String& imageFileName, IntRect& rectangle);
+    /// Create the sprite of a request with a decoded texture. Return null on failure.
+    Sprite2D* CreateSprite(ParticleLoadRequest2D* request);
+
+    /// Mutex for requests and progress.
+    mutable Mutex mutex_;
+    /// Requests in order.
+    PODVector<ParticleLoadRequest2D*> requests_;
+    /// Request being worked on by the loader thread.
+    ParticleLoadRequest2D* current_;
+    /// Next request id.
+    unsigned nextId_;
+    /// Name of the file being read.
+    String loadingName_;
+    /// Bytes read of the file being read.
+    unsigned loadedBytes_;
+    /// Size of the file being read.
+    unsigned totalBytes_;
+    /// Placeholder sprite.
+    SharedPtr<Sprite2D> placeholderSprite_;
+};
+
+}
@@ -0,0 +1,169 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "ParticleEffectLod2D.h"
+#include "Sort.h"
+#include "XMLElement.h"
+
+namespace Urho3D
+{
+
+/// Metric names in .pex files.
+static const char* lodMetricNames[] =
+{
+    "distance",
+    "screenSize",
+    0
+};
+
+/// Relative distance past a threshold before a more detailed level is picked again.
+static const float LOD_HYSTERESIS = 0.1f;
+
+static bool CompareDistanceLevels(const ParticleLodLevel2D& lhs, const ParticleLodLevel2D& rhs)
+{
+    return lhs.threshold_ < rhs.threshold_;
+}
+
+static bool CompareScreenSizeLevels(const ParticleLodLevel2D& lhs, const ParticleLodLevel2D& rhs)
+{
+    return lhs.threshold_ > rhs.threshold_;
+}
+
+ParticleEffectLod2D::ParticleEffectLod2D() :
+    metric_(PLM_DISTANCE)
+{
+}
+
+void ParticleEffectLod2D::Load(const XMLElement& source)
+{
+    *this = ParticleEffectLod2D();
+
+    XMLElement lodElem = source.GetChild("lod");
+    if (!lodElem)
+        return;
+
+    String metricName = lodElem.GetAttribute("metric");
+    for (unsigned i = 0; lodMetricNames[i]; ++i)
+    {
+        if (metricName == lodMetricNames[i])
+            metric_ = (ParticleLodMetric2D)i;
+    }
+
+    PODVector<ParticleLodLevel2D> levels;
+    for (XMLElement levelElem = lodElem.GetChild("level"); levelElem; levelElem = levelElem.GetNext("level"))
+    {
+        ParticleLodLevel2D level;
+        level.threshold_ = levelElem.GetFloat("threshold");
+        if (levelElem.HasAttribute("particles"))
+            level.particleScale_ = levelElem.GetFloat("particles");
+        if (levelElem.HasAttribute("spawnRate"))
+            level.spawnScale_ = levelElem.GetFloat("spawnRate");
+        level.simplified_ = levelElem.GetBool("simplified");
+        levels.Push(level);
+    }
+    SetLevels(levels);
+}
+
+void ParticleEffectLod2D::Save(XMLElement& dest) const
+{
+    dest.RemoveChild("lod");
+    if (levels_.Empty())
+        return;
+
+    XMLElement lodElem = dest.CreateChild("lod");
+    lodElem.SetAttribute("metric", lodMetricNames[metric_]);
+    for (unsigned i = 0; i < levels_.Size(); ++i)
+    {
+        XMLElement levelElem = lodElem.CreateChild("level");
+        levelElem.SetFloat("threshold", levels_[i].threshold_);
+        levelElem.SetFloat("particles", levels_[i].particleScale_);
+        levelElem.SetFloat("spawnRate", levels_[i].spawnScale_);
+        levelElem.SetBool("simplified", levels_[i].simplified_);
+    }
+}
+
+void ParticleEffectLod2D::SetMetric(ParticleLodMetric2D metric)
+{
+    if (metric == metric_ || metric >= MAX_PARTICLE_LOD_METRICS)
+        return;
+
+    metric_ = metric;
+    SetLevels(PODVector<ParticleLodLevel2D>(levels_));
+}
+
+void ParticleEffectLod2D::SetLevels(const PODVector<ParticleLodLevel2D>& levels)
+{
+    levels_.Clear();
+    for (unsigned i = 0; i < levels.Size() && i < MAX_PARTICLE_LOD_LEVELS; ++i)
+    {
+        ParticleLodLevel2D level = levels[i];
+        level.threshold_ = Max(level.threshold_, 0.0f);
+        level.particleScale_ = Clamp(level.particleScale_, 0.0f, 1.0f);
+        level.spawnScale_ = Clamp(level.spawnScale_, 0.0f, 1.0f);
+        levels_.Push(level);
+    }
+
+    // Detail falls with distance and rises with screen size
+    if (metric_ == PLM_DISTANCE)
+        Sort(levels_.Begin(), levels_.End(), CompareDistanceLevels);
+    else
+        Sort(levels_.Begin(), levels_.End(), CompareScreenSizeLevels);
+}
+
+unsigned ParticleEffectLod2D::SelectLevel(float value, unsigned currentLevel) const
+{
+    unsigned level = 0;
+    while (level < levels_.Size() && Reaches(value, levels_[level].threshold_, 1.0f))
+        ++level;
+
+    if (level < currentLevel && currentLevel <= levels_.Size() &&
+        Reaches(value, levels_[currentLevel - 1].threshold_, 1.0f - LOD_HYSTERESIS))
+        return currentLevel;
+
+    return level;
+}
+
+float ParticleEffectLod2D::GetParticleScale(unsigned level) const
+{
+    return level && level <= levels_.Size() ? levels_[level - 1].particleScale_ : 1.0f;
+}
+
+float ParticleEffectLod2D::GetSpawnScale(unsigned level) const
+{
+    return level && level <= levels_.Size() ? levels_[level - 1].spawnScale_ : 1.0f;
+}
+
+bool ParticleEffectLod2D::IsSimplified(unsigned level) const
+{
+    return level && level <= levels_.Size() ? levels_[level - 1].simplified_ : false;
+}
+
+bool ParticleEffectLod2D::Reaches(float value, float threshold, float factor) const
+{
+    // The factor widens the threshold towards more detail, which is below a distance and above a screen size
+    if (metric_ == PLM_DISTANCE)
+        return value >= threshold * factor;
+    else
+        return value <= threshold * (2.0f - factor);
+}
+
+}
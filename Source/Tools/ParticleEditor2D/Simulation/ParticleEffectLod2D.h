@@ -0,0 +1,110 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Vector.h"
+
+namespace Urho3D
+{
+
+class XMLElement;
+
+/// Quantity that selects the LOD level of a particle effect.
+enum ParticleLodMetric2D
+{
+    /// Distance between emitter and camera in pixels. A level applies at and beyond its threshold.
+    PLM_DISTANCE = 0,
+    /// Extent of the particles as a fraction of the view height. A level applies at and below its threshold.
+    PLM_SCREENSIZE,
+    MAX_PARTICLE_LOD_METRICS
+};
+
+/// Max number of reduced detail levels of an effect.
+static const unsigned MAX_PARTICLE_LOD_LEVELS = 4;
+
+/// Reduced detail level of a particle effect.
+struct ParticleLodLevel2D
+{
+    /// Construct.
+    ParticleLodLevel2D() :
+        threshold_(0.0f),
+        particleScale_(1.0f),
+        spawnScale_(1.0f),
+        simplified_(false)
+    {
+    }
+
+    /// Distance or screen size at which the level starts to apply.
+    float threshold_;
+    /// Max particles multiplier.
+    float particleScale_;
+    /// Spawn rate multiplier.
+    float spawnScale_;
+    /// Draw particles unrotated and without interpolation between fixed steps.
+    bool simplified_;
+};
+
+/// LOD levels of a particle effect, from most to least detailed. Level 0 is the effect as authored, level i + 1 is GetLevels()[i].
+class ParticleEffectLod2D
+{
+public:
+    /// Construct with no reduced levels.
+    ParticleEffectLod2D();
+
+    /// Load from the root element of a .pex file.
+    void Load(const XMLElement& source);
+    /// Save to the root element of a .pex file.
+    void Save(XMLElement& dest) const;
+
+    /// Set metric.
+    void SetMetric(ParticleLodMetric2D metric);
+    /// Set levels. They are clamped, sorted from most to least detailed and limited to MAX_PARTICLE_LOD_LEVELS.
+    void SetLevels(const PODVector<ParticleLodLevel2D>& levels);
+
+    /// Return metric.
+    ParticleLodMetric2D GetMetric() const { return metric_; }
+    /// Return levels.
+    const PODVector<ParticleLodLevel2D>& GetLevels() const { return levels_; }
+    /// Return number of reduced levels.
+    unsigned GetNumLevels() const { return levels_.Size(); }
+    /// Return the level for a distance or screen size. A level is only left for a more detailed one once the value is
+    /// clearly past its threshold, so values near a threshold do not flip levels every frame.
+    unsigned SelectLevel(float value, unsigned currentLevel) const;
+    /// Return max particles multiplier of a level.
+    float GetParticleScale(unsigned level) const;
+    /// Return spawn rate multiplier of a level.
+    float GetSpawnScale(unsigned level) const;
+    /// Return whether a level draws simplified particles.
+    bool IsSimplified(unsigned level) const;
+
+private:
+    /// Return whether a value reaches a threshold, widened by a factor.
+    bool Reaches(float value, float threshold, float factor) const;
+
+    /// Metric.
+    ParticleLodMetric2D metric_;
+    /// Reduced levels.
+    PODVector<ParticleLodLevel2D> levels_;
+};
+
+}
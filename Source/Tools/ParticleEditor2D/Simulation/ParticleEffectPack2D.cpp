@@ -0,0 +1,441 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Context.h"
+#include "File.h"
+#include "FileSystem.h"
+#include "HashSet.h"
+#include "Log.h"
+#include "ParticleEffect2D.h"
+#include "ParticleEffectBinary2D.h"
+#include "ParticleEffectPack2D.h"
+#include "ParticleEffectSettings2D.h"
+#include "Serializer.h"
+#include "Sort.h"
+#include "VectorBuffer.h"
+
+#include <cctype>
+#include <cstring>
+
+namespace Urho3D
+{
+
+/// Particle effect pack file extension.
+static const char* PARTICLE_EFFECT_PACK_EXTENSION = ".pexpack";
+/// Average entries per name index bucket. Larger buckets make the index smaller and the build slower.
+static const unsigned ENTRIES_PER_BUCKET = 2;
+/// Seeds tried per bucket before the build gives up.
+static const unsigned MAX_BUCKET_SEEDS = 1 << 24;
+
+/// Name index bucket while building.
+struct PackBucket
+{
+    /// Bucket index.
+    unsigned index_;
+    /// Entries hashed to the bucket.
+    PODVector<unsigned> entries_;
+};
+
+/// Hash a name with a seed, ignoring case like resource names. FNV-1a with a final mix, so that seeds give unrelated hashes.
+static unsigned HashName(const char* name, unsigned seed)
+{
+    unsigned hash = 2166136261U ^ (seed * 0x9e3779b9U);
+    for (; *name; ++name)
+    {
+        hash ^= (unsigned)tolower((unsigned char)*name);
+        hash *= 16777619U;
+    }
+
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bU;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35U;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+/// Return whether two names are equal, ignoring case.
+static bool NamesEqual(const char* lhs, const char* rhs)
+{
+    for (; *lhs && *rhs; ++lhs, ++rhs)
+    {
+        if (tolower((unsigned char)*lhs) != tolower((unsigned char)*rhs))
+            return false;
+    }
+
+    return *lhs == *rhs;
+}
+
+/// Order buckets from most to fewest entries, so the crowded ones are placed while most entries are free.
+static bool CompareBuckets(const PackBucket& lhs, const PackBucket& rhs)
+{
+    return lhs.entries_.Size() > rhs.entries_.Size();
+}
+
+/// Add a string to a string table unless it is there already. Return its offset.
+static unsigned AddString(const String& value, PODVector<char>& strings, HashMap<String, unsigned>& offsets)
+{
+    HashMap<String, unsigned>::Iterator i = offsets.Find(value);
+    if (i != offsets.End())
+        return i->second_;
+
+    unsigned offset = strings.Size();
+    strings.Resize(offset + value.Length() + 1);
+    memcpy(&strings[offset], value.CString(), value.Length() + 1);
+    offsets[value] = offset;
+    return offset;
+}
+
+bool IsParticleEffectPack(const String& fileName)
+{
+    return GetExtension(fileName) == PARTICLE_EFFECT_PACK_EXTENSION;
+}
+
+bool BuildParticleEffectPack(Context* context, const Vector<String>& fileNames, const String& basePath, Serializer& dest,
+    Vector<String>* errors)
+{
+    SharedPtr<ParticleEffect2D> defaultEffect(new ParticleEffect2D(context));
+    ParticleEffectParameters2D defaults;
+    GetParticleEffectParameters(defaultEffect, defaults);
+
+    String base = AddTrailingSlash(GetInternalPath(basePath));
+    Vector<String> names;
+    Vector<String> textureNames;
+    HashSet<String> lowerNames;
+    PODVector<unsigned> effectOffsets;
+    PODVector<unsigned> effectSizes;
+    VectorBuffer effectData;
+    for (unsigned i = 0; i < fileNames.Size(); ++i)
+    {
+        String fileName = GetInternalPath(fileNames[i]);
+        String name = fileName.StartsWith(base) ? fileName.Substring(base.Length()) : GetFileNameAndExtension(fileName);
+
+        // Names differing only in case would be the same resource, and the index could never tell them apart
+        if (lowerNames.Contains(name.ToLower()))
+        {
+            if (errors)
+                errors->Push(fileName + ": name " + name + " is already in the pack");
+            continue;
+        }
+
+        File file(context);
+        PODVector<unsigned char> data;
+        if (file.Open(fileName) && file.GetSize())
+        {
+            data.Resize(file.GetSize());
+            if (file.Read(&data[0], data.Size()) != data.Size())
+                data.Clear();
+        }
+
+        ParticleEffectParameters2D parameters = defaults;
+        ParticleEffectSettings2D settings;
+        String textureName;
+
+        // Each effect starts 4-byte aligned for the fixed layout structures it holds
+        while (effectData.GetSize() % 4)
+            effectData.WriteUByte(0);
+        unsigned effectOffset = effectData.GetSize();
+        if (data.Empty() || !ReadParticleEffectData(context, IsParticleEffectBinary(fileName), &data[0], data.Size(), parameters,
+            settings, textureName) || !WriteParticleEffectData(context, true, parameters, settings, textureName, effectData))
+        {
+            effectData.Resize(effectOffset);
+            if (errors)
+                errors->Push(fileName + ": not a valid particle effect");
+            continue;
+        }
+
+        // Textures are relative to the effect, which becomes relative to the pack
+        names.Push(name);
+        textureNames.Push(textureName.Empty() ? String::EMPTY : GetPath(name) + textureName);
+        lowerNames.Insert(name.ToLower());
+        effectOffsets.Push(effectOffset);
+        effectSizes.Push(effectData.GetSize() - effectOffset);
+    }
+
+    unsigned numEntries = names.Size();
+    unsigned numBuckets = Max((numEntries + ENTRIES_PER_BUCKET - 1) / ENTRIES_PER_BUCKET, 1U);
+
+    Vector<PackBucket> buckets(numBuckets);
+    for (unsigned i = 0; i < numBuckets; ++i)
+        buckets[i].index_ = i;
+    for (unsigned i = 0; i < numEntries; ++i)
+        buckets[HashName(names[i].CString(), 0) % numBuckets].entries_.Push(i);
+    Sort(buckets.Begin(), buckets.End(), CompareBuckets);
+
+    // Hash and displace: find a seed per bucket that sends all of its names to free slots
+    PODVector<unsigned> seeds(numBuckets);
+    PODVector<unsigned> slots(numEntries);
+    PODVector<bool> used(numEntries);
+    for (unsigned i = 0; i < numEntries; ++i)
+        used[i] = false;
+    for (unsigned i = 0; i < numBuckets; ++i)
+        seeds[i] = 0;
+
+    PODVector<unsigned> bucketSlots;
+    for (unsigned i = 0; i < numBuckets && !buckets[i].entries_.Empty(); ++i)
+    {
+        const PackBucket& bucket = buckets[i];
+        unsigned seed = 1;
+        for (; seed < MAX_BUCKET_SEEDS; ++seed)
+        {
+            bucketSlots.Clear();
+            for (unsigned j = 0; j < bucket.entries_.Size(); ++j)
+            {
+                unsigned slot = HashName(names[bucket.entries_[j]].CString(), seed) % numEntries;
+                if (used[slot] || bucketSlots.Contains(slot))
+                    break;
+                bucketSlots.Push(slot);
+            }
+            if (bucketSlots.Size() == bucket.entries_.Size())
+                break;
+        }
+        if (seed == MAX_BUCKET_SEEDS)
+        {
+            LOGERROR("Could not build the particle effect pack name index");
+            return false;
+        }
+
+        seeds[bucket.index_] = seed;
+        for (unsigned j = 0; j < bucketSlots.Size(); ++j)
+        {
+            used[bucketSlots[j]] = true;
+            slots[bucket.entries_[j]] = bucketSlots[j];
+        }
+    }
+
+    PODVector<char> strings;
+    HashMap<String, unsigned> stringOffsets;
+    PODVector<ParticleEffectPackEntry2D> entries(numEntries);
+    for (unsigned i = 0; i < numEntries; ++i)
+    {
+        ParticleEffectPackEntry2D& entry = entries[slots[i]];
+        entry.name_ = AddString(names[i], strings, stringOffsets);
+        entry.nameHash_ = HashName(names[i].CString(), 0);
+        entry.textureName_ = textureNames[i].Empty() ? M_MAX_UNSIGNED : AddString(textureNames[i], strings, stringOffsets);
+    }
+
+    ParticleEffectPackHeader2D header;
+    header.id_ = PARTICLE_EFFECT_PACK_ID;
+    header.version_ = PARTICLE_EFFECT_PACK_VERSION;
+    header.numEntries_ = numEntries;
+    header.numBuckets_ = numBuckets;
+    header.seedsOffset_ = sizeof header;
+    header.entriesOffset_ = header.seedsOffset_ + numBuckets * sizeof(unsigned);
+    header.stringsOffset_ = header.entriesOffset_ + numEntries * sizeof(ParticleEffectPackEntry2D);
+    header.stringsSize_ = strings.Size();
+
+    // Effect data follows the strings, padded so that it keeps its alignment
+    unsigned dataOffset = (header.stringsOffset_ + header.stringsSize_ + 3) & ~3U;
+    for (unsigned i = 0; i < numEntries; ++i)
+    {
+        entries[slots[i]].dataOffset_ = dataOffset + effectOffsets[i];
+        entries[slots[i]].dataSize_ = effectSizes[i];
+    }
+
+    static const unsigned char padding[4] = { 0, 0, 0, 0 };
+    unsigned seedsSize = numBuckets * sizeof(unsigned);
+    unsigned entriesSize = numEntries * sizeof(ParticleEffectPackEntry2D);
+    unsigned paddingSize = dataOffset - header.stringsOffset_ - header.stringsSize_;
+
+    bool success = true;
+    success &= dest.Write(&header, sizeof header) == sizeof header;
+    success &= dest.Write(&seeds[0], seedsSize) == seedsSize;
+    if (entriesSize)
+        success &= dest.Write(&entries[0], entriesSize) == entriesSize;
+    if (header.stringsSize_)
+        success &= dest.Write(&strings[0], header.stringsSize_) == header.stringsSize_;
+    success &= dest.Write(padding, paddingSize) == paddingSize;
+    if (effectData.GetSize())
+        success &= dest.Write(effectData.GetData(), effectData.GetSize()) == effectData.GetSize();
+
+    return success;
+}
+
+ParticleEffectPack2D::ParticleEffectPack2D() :
+    data_(0),
+    seeds_(0),
+    entries_(0),
+    strings_(0),
+    size_(0)
+{
+    memset(&header_, 0, sizeof header_);
+}
+
+ParticleEffectPack2D::~ParticleEffectPack2D()
+{
+}
+
+bool ParticleEffectPack2D::Load(Context* context, const String& fileName)
+{
+    Clear();
+
+    if (!mappedFile_.Open(context, fileName))
+    {
+        LOGERROR("Open particle effect pack failed " + fileName);
+        return false;
+    }
+
+    if (!SetData(mappedFile_.GetData(), mappedFile_.GetSize()))
+    {
+        LOGERROR("Load particle effect pack failed " + fileName);
+        Clear();
+        return false;
+    }
+
+    fileName_ = fileName;
+    return true;
+}
+
+unsigned ParticleEffectPack2D::Find(const String& name) const
+{
+    if (!header_.numEntries_)
+        return M_MAX_UNSIGNED;
+
+    unsigned hash = HashName(name.CString(), 0);
+    unsigned seed = seeds_[hash % header_.numBuckets_];
+    unsigned index = HashName(name.CString(), seed) % header_.numEntries_;
+
+    // Names that are not in the pack land on some entry too, so the name is checked
+    const ParticleEffectPackEntry2D& entry = entries_[index];
+    if (entry.nameHash_ != hash || !NamesEqual(strings_ + entry.name_, name.CString()))
+        return M_MAX_UNSIGNED;
+
+    return index;
+}
+
+SharedPtr<ParticleEffect2D> ParticleEffectPack2D::LoadEffect(Context* context, unsigned index,
+    ParticleEffectSettings2D* settings) const
+{
+    if (index >= header_.numEntries_)
+        return SharedPtr<ParticleEffect2D>();
+
+    // The name places the effect next to the pack, so its texture resolves the way it did before packing
+    SharedPtr<ParticleEffect2D> effect(new ParticleEffect2D(context));
+    effect->SetName(GetPath(fileName_) + GetEntryName(index));
+
+    ParticleEffectSettings2D effectSettings;
+    if (!LoadParticleEffectBinary(effect, effectSettings, GetEntryData(index), GetEntryDataSize(index)))
+    {
+        LOGERROR("Load particle effect failed " + effect->GetName());
+        return SharedPtr<ParticleEffect2D>();
+    }
+
+    if (settings)
+        *settings = effectSettings;
+    return effect;
+}
+
+String ParticleEffectPack2D::GetEntryName(unsigned index) const
+{
+    return index < header_.numEntries_ ? String(strings_ + entries_[index].name_) : String::EMPTY;
+}
+
+String ParticleEffectPack2D::GetEntryTextureName(unsigned index) const
+{
+    if (index >= header_.numEntries_ || entries_[index].textureName_ == M_MAX_UNSIGNED)
+        return String::EMPTY;
+
+    return String(strings_ + entries_[index].textureName_);
+}
+
+const unsigned char* ParticleEffectPack2D::GetEntryData(unsigned index) const
+{
+    return index < header_.numEntries_ ? data_ + entries_[index].dataOffset_ : 0;
+}
+
+unsigned ParticleEffectPack2D::GetEntryDataSize(unsigned index) const
+{
+    return index < header_.numEntries_ ? entries_[index].dataSize_ : 0;
+}
+
+bool ParticleEffectPack2D::SetData(const unsigned char* data, unsigned size)
+{
+    if (!data || size < sizeof(ParticleEffectPackHeader2D))
+    {
+        LOGERROR("Particle effect pack data is too small");
+        return false;
+    }
+
+    memcpy(&header_, data, sizeof header_);
+    if (header_.id_ != PARTICLE_EFFECT_PACK_ID)
+    {
+        LOGERROR("Not particle effect pack data");
+        return false;
+    }
+    if (header_.version_ != PARTICLE_EFFECT_PACK_VERSION)
+    {
+        LOGERROR("Unsupported particle effect pack version " + String(header_.version_));
+        return false;
+    }
+
+    // Counts are checked against the size before they are multiplied, so a damaged header cannot overflow the checks
+    if (!header_.numBuckets_ || header_.numBuckets_ > size / sizeof(unsigned) ||
+        header_.numEntries_ > size / sizeof(ParticleEffectPackEntry2D) ||
+        !IsBlockValid(header_.seedsOffset_, header_.numBuckets_ * sizeof(unsigned), size) ||
+        !IsBlockValid(header_.entriesOffset_, header_.numEntries_ * sizeof(ParticleEffectPackEntry2D), size) ||
+        !IsBlockValid(header_.stringsOffset_, header_.stringsSize_, size) ||
+        header_.seedsOffset_ % 4 || header_.entriesOffset_ % 4)
+    {
+        LOGERROR("Particle effect pack data is truncated");
+        return false;
+    }
+
+    // A terminated table keeps every string offset within it a valid C string
+    strings_ = (const char*)data + header_.stringsOffset_;
+    if (header_.numEntries_ && (!header_.stringsSize_ || strings_[header_.stringsSize_ - 1]))
+    {
+        LOGERROR("Particle effect pack strings are not terminated");
+        return false;
+    }
+
+    seeds_ = (const unsigned*)(data + header_.seedsOffset_);
+    entries_ = (const ParticleEffectPackEntry2D*)(data + header_.entriesOffset_);
+    for (unsigned i = 0; i < header_.numEntries_; ++i)
+    {
+        const ParticleEffectPackEntry2D& entry = entries_[i];
+        if (entry.name_ >= header_.stringsSize_ ||
+            (entry.textureName_ != M_MAX_UNSIGNED && entry.textureName_ >= header_.stringsSize_) ||
+            !IsBlockValid(entry.dataOffset_, entry.dataSize_, size))
+        {
+            LOGERROR("Particle effect pack entry " + String(i) + " is out of range");
+            return false;
+        }
+    }
+
+    data_ = data;
+    size_ = size;
+    return true;
+}
+
+void ParticleEffectPack2D::Clear()
+{
+    mappedFile_.Close();
+    memset(&header_, 0, sizeof header_);
+    data_ = 0;
+    seeds_ = 0;
+    entries_ = 0;
+    strings_ = 0;
+    size_ = 0;
+    fileName_.Clear();
+}
+
+}
@@ -0,0 +1,145 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "MemoryMappedFile.h"
+#include "Ptr.h"
+#include "RefCounted.h"
+#include "Str.h"
+
+namespace Urho3D
+{
+
+class Context;
+class ParticleEffect2D;
+class ParticleEffectSettings2D;
+class Serializer;
+
+/// Particle effect pack file identifier, "PPAK" in file order.
+static const unsigned PARTICLE_EFFECT_PACK_ID = 0x4B415050;
+/// Particle effect pack format version.
+static const unsigned PARTICLE_EFFECT_PACK_VERSION = 1;
+
+/// Particle effect pack file header. All fields are 32-bit little endian so the file can be used straight from a memory map.
+struct ParticleEffectPackHeader2D
+{
+    /// File identifier.
+    unsigned id_;
+    /// Format version.
+    unsigned version_;
+    /// Number of entries.
+    unsigned numEntries_;
+    /// Number of name index buckets.
+    unsigned numBuckets_;
+    /// Bucket seed table offset.
+    unsigned seedsOffset_;
+    /// Entry table offset.
+    unsigned entriesOffset_;
+    /// String table offset. Strings are zero terminated and stored once.
+    unsigned stringsOffset_;
+    /// String table size.
+    unsigned stringsSize_;
+};
+
+/// Particle effect pack entry, a compiled effect in the binary particle effect format.
+struct ParticleEffectPackEntry2D
+{
+    /// Effect name as an offset into the string table, relative to the pack.
+    unsigned name_;
+    /// Hash of the name, checked before the name itself.
+    unsigned nameHash_;
+    /// Texture name as an offset into the string table, relative to the pack. M_MAX_UNSIGNED if none.
+    unsigned textureName_;
+    /// Effect data offset.
+    unsigned dataOffset_;
+    /// Effect data size.
+    unsigned dataSize_;
+};
+
+/// Return whether file name has the particle effect pack extension.
+bool IsParticleEffectPack(const String& fileName);
+/// Compile .pex and .pexb files into one pack. Entries are named by their path relative to basePath, and so are the textures they
+/// reference. Files that can not be read are reported to errors when given and left out. Return true if successful.
+bool BuildParticleEffectPack(Context* context, const Vector<String>& fileNames, const String& basePath, Serializer& dest,
+    Vector<String>* errors = 0);
+
+/// Particle effect pack, read straight from the file data. Names are found through a minimal perfect hash: the name picks a
+/// bucket, the bucket's seed rehashes it to its entry, so a lookup costs two hashes and one name comparison whatever the size
+/// of the pack.
+class ParticleEffectPack2D : public RefCounted
+{
+public:
+    /// Construct.
+    ParticleEffectPack2D();
+    /// Destruct.
+    virtual ~ParticleEffectPack2D();
+
+    /// Load from a file through the resource cache. Plain files are memory mapped, packaged ones read into memory. Return true
+    /// if successful.
+    bool Load(Context* context, const String& fileName);
+    /// Return index of an entry by name, ignoring case like resource names. Return M_MAX_UNSIGNED if not found.
+    unsigned Find(const String& name) const;
+    /// Create an effect from an entry, named by the pack path and the entry name, with its sprite from the resource cache.
+    /// Settings are filled when given. Return null on failure.
+    SharedPtr<ParticleEffect2D> LoadEffect(Context* context, unsigned index, ParticleEffectSettings2D* settings = 0) const;
+
+    /// Return file name the pack was loaded from.
+    const String& GetFileName() const { return fileName_; }
+    /// Return number of entries.
+    unsigned GetNumEntries() const { return header_.numEntries_; }
+    /// Return entry name.
+    String GetEntryName(unsigned index) const;
+    /// Return entry texture name relative to the pack, empty if none.
+    String GetEntryTextureName(unsigned index) const;
+    /// Return entry effect data in the binary particle effect format.
+    const unsigned char* GetEntryData(unsigned index) const;
+    /// Return entry effect data size.
+    unsigned GetEntryDataSize(unsigned index) const;
+    /// Return size of the data in bytes.
+    unsigned GetDataSize() const { return size_; }
+
+private:
+    /// Validate data and point the tables into it. Return true if successful.
+    bool SetData(const unsigned char* data, unsigned size);
+    /// Clear data.
+    void Clear();
+
+    /// Memory mapped file.
+    MemoryMappedFile mappedFile_;
+    /// Header.
+    ParticleEffectPackHeader2D header_;
+    /// Start of the data.
+    const unsigned char* data_;
+    /// Bucket seeds.
+    const unsigned* seeds_;
+    /// Entries.
+    const ParticleEffectPackEntry2D* entries_;
+    /// String table.
+    const char* strings_;
+    /// Size of the data in bytes.
+    unsigned size_;
+    /// File name.
+    String fileName_;
+};
+
+}
@@ -0,0 +1,318 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "GraphicsDefs.h"
+#include "ParticleEffect2D.h"
+#include "ParticleEffectBinary2D.h"
+#include "ParticleEffectRanges2D.h"
+
+#include <cfloat>
+#include <cstddef>
+#include <cstring>
+
+namespace Urho3D
+{
+
+#define PARAMETER_OFFSET(member) ((unsigned)offsetof(ParticleEffectParameters2D, member))
+
+/// Editing ranges in ParticleEffectAttribute2D order. Keep in sync with what the editor widgets can express.
+static const ParticleEffectRange2D particleEffectRanges[] =
+{
+    { "maxParticles", 1.0f, 1000000.0f, PARAMETER_OFFSET(maxParticles_), 0, 1, true, PVR_NONE },
+    { "duration", -1.0f, 100.0f, PARAMETER_OFFSET(duration_), 0, 1, false, PVR_NONE },
+    { "angle", 0.0f, 360.0f, PARAMETER_OFFSET(angle_), PARAMETER_OFFSET(angleVariance_), 1, false, PVR_SPAN },
+    { "sourcePositionVariance", 0.0f, 1000.0f, PARAMETER_OFFSET(sourcePositionVariance_), 0, 2, false, PVR_NONE },
+    { "speed", 0.0f, 2000.0f, PARAMETER_OFFSET(speed_), PARAMETER_OFFSET(speedVariance_), 1, false, PVR_SPAN },
+    { "gravity", -3000.0f, 3000.0f, PARAMETER_OFFSET(gravity_), 0, 2, false, PVR_NONE },
+    { "radialAcceleration", -10000.0f, 10000.0f, PARAMETER_OFFSET(radialAcceleration_), PARAMETER_OFFSET(radialAccelVariance_), 1, false, PVR_SPAN },
+    { "tangentialAcceleration", -50000.0f, 50000.0f, PARAMETER_OFFSET(tangentialAcceleration_), PARAMETER_OFFSET(tangentialAccelVariance_), 1, false, PVR_SPAN },
+    { "maxRadius", 0.0f, 1000.0f, PARAMETER_OFFSET(maxRadius_), PARAMETER_OFFSET(maxRadiusVariance_), 1, false, PVR_SPAN },
+    { "minRadius", 0.0f, 1000.0f, PARAMETER_OFFSET(minRadius_), PARAMETER_OFFSET(minRadiusVariance_), 1, false, PVR_SPAN },
+    { "rotatePerSecond", -720.0f, 720.0f, PARAMETER_OFFSET(rotatePerSecond_), PARAMETER_OFFSET(rotatePerSecondVariance_), 1, false, PVR_SPAN },
+    { "particleLifeSpan", 0.01f, 10.0f, PARAMETER_OFFSET(particleLifeSpan_), PARAMETER_OFFSET(particleLifespanVariance_), 1, false, PVR_SPAN },
+    { "startParticleSize", 0.0f, 512.0f, PARAMETER_OFFSET(startParticleSize_), PARAMETER_OFFSET(startParticleSizeVariance_), 1, false, PVR_SPAN },
+    { "finishParticleSize", 0.0f, 512.0f, PARAMETER_OFFSET(finishParticleSize_), PARAMETER_OFFSET(finishParticleSizeVariance_), 1, false, PVR_SPAN },
+    { "rotationStart", 0.0f, 360.0f, PARAMETER_OFFSET(rotationStart_), PARAMETER_OFFSET(rotationStartVariance_), 1, false, PVR_SPAN },
+    { "rotationEnd", 0.0f, 360.0f, PARAMETER_OFFSET(rotationEnd_), PARAMETER_OFFSET(rotationEndVariance_), 1, false, PVR_SPAN },
+    { "startColor", 0.0f, 1.0f, PARAMETER_OFFSET(startColor_), PARAMETER_OFFSET(startColorVariance_), 4, false, PVR_EXTENT },
+    { "finishColor", 0.0f, 1.0f, PARAMETER_OFFSET(finishColor_), PARAMETER_OFFSET(finishColorVariance_), 4, false, PVR_EXTENT },
+};
+
+#undef PARAMETER_OFFSET
+
+/// Component names used in messages.
+static const char* componentNames[] = { "x", "y", "z", "w" };
+/// Color component names used in messages.
+static const char* colorComponentNames[] = { "red", "green", "blue", "alpha" };
+
+/// Return whether value is neither infinite nor NaN.
+static bool IsFinite(float value)
+{
+    return value >= -FLT_MAX && value <= FLT_MAX;
+}
+
+/// Return floats at an offset in parameters.
+static float* GetParameterFloats(ParticleEffectParameters2D& parameters, unsigned offset)
+{
+    return reinterpret_cast<float*>(reinterpret_cast<unsigned char*>(&parameters) + offset);
+}
+
+/// Return floats at an offset in parameters.
+static const float* GetParameterFloats(const ParticleEffectParameters2D& parameters, unsigned offset)
+{
+    return reinterpret_cast<const float*>(reinterpret_cast<const unsigned char*>(&parameters) + offset);
+}
+
+/// Return name of a component for messages.
+static String GetComponentName(const ParticleEffectRange2D& range, unsigned component, bool variance)
+{
+    String name(range.name_);
+    if (variance)
+        name += "Variance";
+    if (range.numComponents_ > 1)
+    {
+        name += ".";
+        name += range.numComponents_ == 4 ? colorComponentNames[component] : componentNames[component];
+    }
+    return name;
+}
+
+const ParticleEffectRange2D& GetParticleEffectRange(ParticleEffectAttribute2D attribute)
+{
+    return particleEffectRanges[attribute];
+}
+
+unsigned ValidateParticleEffectParameters(const ParticleEffectParameters2D& parameters, Vector<String>* issues)
+{
+    unsigned numIssues = 0;
+
+    for (unsigned i = 0; i < MAX_PARTICLE_EFFECT_ATTRIBUTES; ++i)
+    {
+        const ParticleEffectRange2D& range = particleEffectRanges[i];
+
+        if (range.integer_)
+        {
+            int value = *reinterpret_cast<const int*>(reinterpret_cast<const unsigned char*>(&parameters) + range.valueOffset_);
+            if (value < (int)range.min_ || value > (int)range.max_)
+            {
+                ++numIssues;
+                if (issues)
+                    issues->Push(String(range.name_) + " " + String(value) + " is outside " + String((int)range.min_) + " to " +
+                        String((int)range.max_));
+            }
+            continue;
+        }
+
+        for (unsigned j = 0; j < range.numComponents_; ++j)
+        {
+            float value = GetParameterFloats(parameters, range.valueOffset_)[j];
+            float variance = range.varianceRange_ != PVR_NONE ? GetParameterFloats(parameters, range.varianceOffset_)[j] : 0.0f;
+
+            if (!IsFinite(value) || !IsFinite(variance))
+            {
+                ++numIssues;
+                if (issues)
+                    issues->Push(GetComponentName(range, j, !IsFinite(variance)) + " is not a finite number");
+                continue;
+            }
+
+            if (range.varianceRange_ == PVR_EXTENT)
+            {
+                float low = value - Abs(variance);
+                float high = value + Abs(variance);
+                if (low < range.min_ || high > range.max_)
+                {
+                    ++numIssues;
+                    if (issues)
+                        issues->Push(GetComponentName(range, j, false) + " " + String(value) + " with variance " + String(variance) +
+                            " spans " + String(low) + " to " + String(high) + ", outside " + String(range.min_) + " to " + String(range.max_));
+                }
+                continue;
+            }
+
+            if (value < range.min_ || value > range.max_)
+            {
+                ++numIssues;
+                if (issues)
+                    issues->Push(GetComponentName(range, j, false) + " " + String(value) + " is outside " + String(range.min_) + " to " +
+                        String(range.max_));
+            }
+
+            if (range.varianceRange_ == PVR_SPAN && (variance < 0.0f || variance > range.max_ - range.min_))
+            {
+                ++numIssues;
+                if (issues)
+                    issues->Push(GetComponentName(range, j, true) + " " + String(variance) + " is outside 0 to " +
+                        String(range.max_ - range.min_));
+            }
+        }
+    }
+
+    if (parameters.emitterType_ != EMITTER_TYPE_GRAVITY && parameters.emitterType_ != EMITTER_TYPE_RADIAL)
+    {
+        ++numIssues;
+        if (issues)
+            issues->Push("emitterType " + String(parameters.emitterType_) + " is not a known emitter type");
+    }
+
+    if (parameters.blendMode_ < 0 || parameters.blendMode_ >= MAX_BLENDMODES)
+    {
+        ++numIssues;
+        if (issues)
+            issues->Push("blend mode " + String(parameters.blendMode_) + " is not a known blend mode");
+    }
+
+    return numIssues;
+}
+
+unsigned ClampParticleEffectParameters(ParticleEffectParameters2D& parameters)
+{
+    unsigned numChanged = 0;
+
+    for (unsigned i = 0; i < MAX_PARTICLE_EFFECT_ATTRIBUTES; ++i)
+    {
+        const ParticleEffectRange2D& range = particleEffectRanges[i];
+
+        if (range.integer_)
+        {
+            int* value = reinterpret_cast<int*>(reinterpret_cast<unsigned char*>(&parameters) + range.valueOffset_);
+            int clamped = Clamp(*value, (int)range.min_, (int)range.max_);
+            if (clamped != *value)
+            {
+                *value = clamped;
+                ++numChanged;
+            }
+            continue;
+        }
+
+        float* values = GetParameterFloats(parameters, range.valueOffset_);
+        float* variances = range.varianceRange_ != PVR_NONE ? GetParameterFloats(parameters, range.varianceOffset_) : 0;
+
+        for (unsigned j = 0; j < range.numComponents_; ++j)
+        {
+            float value = IsFinite(values[j]) ? Clamp(values[j], range.min_, range.max_) : range.min_;
+            float variance = variances && IsFinite(variances[j]) ? variances[j] : 0.0f;
+
+            if (range.varianceRange_ == PVR_EXTENT)
+            {
+                // Clamp both ends of the editor's min and max colors, then rebuild value and variance from them
+                float low = Clamp(values[j] - variance, range.min_, range.max_);
+                float high = Clamp(values[j] + variance, range.min_, range.max_);
+                if (IsFinite(values[j]))
+                {
+                    value = (low + high) * 0.5f;
+                    variance = (high - low) * 0.5f;
+                }
+            }
+            else if (range.varianceRange_ == PVR_SPAN)
+                variance = Clamp(variance, 0.0f, range.max_ - range.min_);
+
+            if (value != values[j])
+            {
+                values[j] = value;
+                ++numChanged;
+            }
+            if (variances && variance != variances[j])
+            {
+                variances[j] = variance;
+                ++numChanged;
+            }
+        }
+    }
+
+    if (parameters.emitterType_ != EMITTER_TYPE_GRAVITY && parameters.emitterType_ != EMITTER_TYPE_RADIAL)
+    {
+        parameters.emitterType_ = EMITTER_TYPE_GRAVITY;
+        ++numChanged;
+    }
+
+    if (parameters.blendMode_ < 0 || parameters.blendMode_ >= MAX_BLENDMODES)
+    {
+        parameters.blendMode_ = BLEND_ALPHA;
+        ++numChanged;
+    }
+
+    return numChanged;
+}
+
+unsigned CompareParticleEffectParameters(const ParticleEffectParameters2D& lhs, const ParticleEffectParameters2D& rhs,
+    Vector<String>* differences)
+{
+    if (!memcmp(&lhs, &rhs, sizeof lhs))
+        return 0;
+
+    unsigned numDifferences = 0;
+
+    for (unsigned i = 0; i < MAX_PARTICLE_EFFECT_ATTRIBUTES; ++i)
+    {
+        const ParticleEffectRange2D& range = particleEffectRanges[i];
+
+        if (range.integer_)
+        {
+            int lhsValue = *reinterpret_cast<const int*>(reinterpret_cast<const unsigned char*>(&lhs) + range.valueOffset_);
+            int rhsValue = *reinterpret_cast<const int*>(reinterpret_cast<const unsigned char*>(&rhs) + range.valueOffset_);
+            if (lhsValue != rhsValue)
+            {
+                ++numDifferences;
+                if (differences)
+                    differences->Push(String(range.name_) + " " + String(lhsValue) + " became " + String(rhsValue));
+            }
+            continue;
+        }
+
+        for (unsigned variance = 0; variance < (range.varianceRange_ != PVR_NONE ? 2U : 1U); ++variance)
+        {
+            unsigned offset = variance ? range.varianceOffset_ : range.valueOffset_;
+            const float* lhsValues = GetParameterFloats(lhs, offset);
+            const float* rhsValues = GetParameterFloats(rhs, offset);
+
+            for (unsigned j = 0; j < range.numComponents_; ++j)
+            {
+                if (!memcmp(&lhsValues[j], &rhsValues[j], sizeof(float)))
+                    continue;
+
+                ++numDifferences;
+                if (differences)
+                    differences->Push(GetComponentName(range, j, variance != 0) + " " + ToString("%.9g", lhsValues[j]) + " became " +
+                        ToString("%.9g", rhsValues[j]));
+            }
+        }
+    }
+
+    if (lhs.emitterType_ != rhs.emitterType_)
+    {
+        ++numDifferences;
+        if (differences)
+            differences->Push("emitterType " + String(lhs.emitterType_) + " became " + String(rhs.emitterType_));
+    }
+
+    if (lhs.blendMode_ != rhs.blendMode_)
+    {
+        ++numDifferences;
+        if (differences)
+            differences->Push("blend mode " + String(lhs.blendMode_) + " became " + String(rhs.blendMode_));
+    }
+
+    return numDifferences;
+}
+
+}
@@ -0,0 +1,100 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Str.h"
+#include "Vector.h"
+
+namespace Urho3D
+{
+
+struct ParticleEffectParameters2D;
+
+/// Particle effect attributes with an editing range.
+enum ParticleEffectAttribute2D
+{
+    PEA_MAXPARTICLES = 0,
+    PEA_DURATION,
+    PEA_ANGLE,
+    PEA_SOURCEPOSITIONVARIANCE,
+    PEA_SPEED,
+    PEA_GRAVITY,
+    PEA_RADIALACCELERATION,
+    PEA_TANGENTIALACCELERATION,
+    PEA_MAXRADIUS,
+    PEA_MINRADIUS,
+    PEA_ROTATEPERSECOND,
+    PEA_PARTICLELIFESPAN,
+    PEA_STARTPARTICLESIZE,
+    PEA_FINISHPARTICLESIZE,
+    PEA_ROTATIONSTART,
+    PEA_ROTATIONEND,
+    PEA_STARTCOLOR,
+    PEA_FINISHCOLOR,
+    MAX_PARTICLE_EFFECT_ATTRIBUTES
+};
+
+/// How the variance of an attribute is limited.
+enum ParticleVarianceRange2D
+{
+    /// No variance.
+    PVR_NONE = 0,
+    /// Variance lies in 0 to max - min, as the value variance editor allows.
+    PVR_SPAN,
+    /// Value minus and plus variance both lie in min to max, as the color variance editor allows. Variance may be negative.
+    PVR_EXTENT
+};
+
+/// Editing range of a particle effect attribute. The editors and the batch validator both use these.
+struct ParticleEffectRange2D
+{
+    /// Element name in the particle effect file.
+    const char* name_;
+    /// Minimum value.
+    float min_;
+    /// Maximum value.
+    float max_;
+    /// Value offset in ParticleEffectParameters2D.
+    unsigned valueOffset_;
+    /// Variance offset in ParticleEffectParameters2D, when the variance is not PVR_NONE.
+    unsigned varianceOffset_;
+    /// Number of float components, or 1 for an integer value.
+    unsigned numComponents_;
+    /// Integer value flag.
+    bool integer_;
+    /// Variance range.
+    ParticleVarianceRange2D varianceRange_;
+};
+
+/// Return editing range of an attribute.
+const ParticleEffectRange2D& GetParticleEffectRange(ParticleEffectAttribute2D attribute);
+/// Check parameters against the editing ranges and the valid emitter types and blend modes. Describe each violation in
+/// issues when given. Return number of violations.
+unsigned ValidateParticleEffectParameters(const ParticleEffectParameters2D& parameters, Vector<String>* issues = 0);
+/// Clamp parameters into the editing ranges. Return number of values changed.
+unsigned ClampParticleEffectParameters(ParticleEffectParameters2D& parameters);
+/// Compare parameters bit for bit. Describe each difference in differences when given. Return number of differences.
+unsigned CompareParticleEffectParameters(const ParticleEffectParameters2D& lhs, const ParticleEffectParameters2D& rhs,
+    Vector<String>* differences = 0);
+
+}
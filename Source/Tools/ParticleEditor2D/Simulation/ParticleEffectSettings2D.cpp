@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "ParticleEffectSettings2D.h"
+#include "MathDefs.h"
+#include "XMLElement.h"
+
+namespace Urho3D
+{
+
+ParticleEffectSettings2D::ParticleEffectSettings2D() :
+    randomSeed_(0),
+    prewarmTime_(0.0f)
+{
+}
+
+void ParticleEffectSettings2D::Load(const XMLElement& source)
+{
+    *this = ParticleEffectSettings2D();
+
+    XMLElement randomSeedElem = source.GetChild("randomSeed");
+    if (randomSeedElem)
+        randomSeed_ = randomSeedElem.GetUInt("value");
+
+    XMLElement prewarmElem = source.GetChild("prewarm");
+    if (prewarmElem)
+        prewarmTime_ = Max(prewarmElem.GetFloat("value"), 0.0f);
+
+    lod_.Load(source);
+}
+
+void ParticleEffectSettings2D::Save(XMLElement& dest) const
+{
+    XMLElement randomSeedElem = dest.GetChild("randomSeed");
+    if (!randomSeedElem)
+        randomSeedElem = dest.CreateChild("randomSeed");
+    randomSeedElem.SetUInt("value", randomSeed_);
+
+    // Written only when used, so effects without pre-warm save as before
+    dest.RemoveChild("prewarm");
+    if (prewarmTime_ > 0.0f)
+        dest.CreateChild("prewarm").SetFloat("value", prewarmTime_);
+
+    lod_.Save(dest);
+}
+
+bool ParticleEffectSettings2D::IsSettingsElement(const String& name)
+{
+    return name == "randomSeed" || name == "prewarm" || name == "lod";
+}
+
+}
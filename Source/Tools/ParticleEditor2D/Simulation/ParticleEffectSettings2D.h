@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "ParticleEffectLod2D.h"
+#include "Str.h"
+
+namespace Urho3D
+{
+
+class XMLElement;
+
+/// Effect settings that the engine's ParticleEffect2D does not know about. They are stored as extra elements in the
+/// .pex file, which the engine ignores when loading.
+class ParticleEffectSettings2D
+{
+public:
+    /// Construct with defaults.
+    ParticleEffectSettings2D();
+
+    /// Load from the root element of a .pex file. Missing elements fall back to defaults.
+    void Load(const XMLElement& source);
+    /// Save to the root element of a .pex file.
+    void Save(XMLElement& dest) const;
+
+    /// Set random seed.
+    void SetRandomSeed(unsigned seed) { randomSeed_ = seed; }
+    /// Return random seed.
+    unsigned GetRandomSeed() const { return randomSeed_; }
+    /// Set time in seconds the effect is pre-warmed to when it starts.
+    void SetPrewarmTime(float time) { prewarmTime_ = time; }
+    /// Return prewarm time.
+    float GetPrewarmTime() const { return prewarmTime_; }
+    /// Set LOD levels.
+    void SetLod(const ParticleEffectLod2D& lod) { lod_ = lod; }
+    /// Return LOD levels.
+    const ParticleEffectLod2D& GetLod() const { return lod_; }
+
+    /// Return whether an element name of a .pex file belongs to the settings.
+    static bool IsSettingsElement(const String& name);
+
+private:
+    /// Random seed.
+    unsigned randomSeed_;
+    /// Prewarm time.
+    float prewarmTime_;
+    /// LOD levels.
+    ParticleEffectLod2D lod_;
+};
+
+}
@@ -0,0 +1,249 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Context.h"
+#include "File.h"
+#include "FileSystem.h"
+#include "FileWatcher.h"
+#include "Image.h"
+#include "Log.h"
+#include "MemoryMappedFile.h"
+#include "ParticleEffect2D.h"
+#include "ParticleEffectBinary2D.h"
+#include "ParticleEffectSettings2D.h"
+#include "ParticleEffectWatcher2D.h"
+#include "ResourceCache.h"
+#include "SimulatedParticleEmitter2D.h"
+#include "Sprite2D.h"
+#include "Texture2D.h"
+#include "WorkQueue.h"
+
+namespace Urho3D
+{
+
+/// Time a file must stay unchanged before it is reported, so that half-written files are skipped.
+static const float WATCH_DELAY = 0.05f;
+
+static void DecodeTextureWork(const WorkItem* item, unsigned threadIndex)
+{
+    ParticleTextureDecode2D* decode = reinterpret_cast<ParticleTextureDecode2D*>(item->aux_);
+
+    File file(decode->image_->GetContext());
+    decode->success_ = file.Open(decode->fileName_) && decode->image_->Load(file);
+    decode->completed_ = true;
+}
+
+ParticleEffectWatcher2D::ParticleEffectWatcher2D(Context* context) :
+    Object(context),
+    decoding_(false),
+    textureDirty_(false)
+{
+    decode_.success_ = false;
+    decode_.completed_ = false;
+}
+
+ParticleEffectWatcher2D::~ParticleEffectWatcher2D()
+{
+    StopWatching();
+}
+
+bool ParticleEffectWatcher2D::Watch(const String& fileName, SimulatedParticleEmitter2D* emitter)
+{
+    StopWatching();
+
+    effectFileName_ = GetNativeFileName(fileName);
+    if (effectFileName_.Empty())
+        return false;
+
+    effectWatcher_ = new FileWatcher(context_);
+    effectWatcher_->SetDelay(WATCH_DELAY);
+    if (!effectWatcher_->StartWatching(GetPath(effectFileName_), false))
+    {
+        effectWatcher_.Reset();
+        return false;
+    }
+
+    emitter_ = emitter;
+    Sprite2D* sprite = emitter ? emitter->GetSprite() : 0;
+    Texture2D* texture = sprite ? sprite->GetTexture() : 0;
+    // Placeholder textures have no file
+    if (texture && !texture->GetName().Empty())
+        textureFileName_ = GetNativeFileName(texture->GetName());
+
+    // Textures next to the effect share its watcher
+    if (!textureFileName_.Empty() && GetPath(textureFileName_) != GetPath(effectFileName_))
+    {
+        textureWatcher_ = new FileWatcher(context_);
+        textureWatcher_->SetDelay(WATCH_DELAY);
+        if (!textureWatcher_->StartWatching(GetPath(textureFileName_), false))
+            textureWatcher_.Reset();
+    }
+
+    return true;
+}
+
+void ParticleEffectWatcher2D::StopWatching()
+{
+    CompleteTextureDecode();
+
+    effectWatcher_.Reset();
+    textureWatcher_.Reset();
+    emitter_.Reset();
+    effectFileName_.Clear();
+    textureFileName_.Clear();
+    textureDirty_ = false;
+}
+
+unsigned ParticleEffectWatcher2D::Update()
+{
+    unsigned flags = 0;
+    if (effectWatcher_)
+        flags |= CheckChanges(effectWatcher_);
+    if (textureWatcher_)
+        flags |= CheckChanges(textureWatcher_);
+
+    if (decoding_ && decode_.completed_)
+    {
+        decoding_ = false;
+        if (EndTextureDecode())
+            flags |= WATCH_TEXTURE_RELOADED;
+    }
+
+    if (textureDirty_ && !decoding_)
+    {
+        textureDirty_ = false;
+        BeginTextureDecode();
+    }
+
+    return flags;
+}
+
+bool ParticleEffectWatcher2D::ReadEffect(ParticleEffectParameters2D& parameters, ParticleEffectSettings2D& settings,
+    String& textureName) const
+{
+    MemoryMappedFile file;
+    if (effectFileName_.Empty() || !file.Open(effectFileName_))
+        return false;
+
+    settings = ParticleEffectSettings2D();
+    return ReadParticleEffectData(context_, IsParticleEffectBinary(effectFileName_), file.GetData(), file.GetSize(), parameters,
+        settings, textureName);
+}
+
+String ParticleEffectWatcher2D::GetNativeFileName(const String& name) const
+{
+    String fileName = GetSubsystem<ResourceCache>()->GetResourceFileName(name);
+    if (fileName.Empty() && GetSubsystem<FileSystem>()->FileExists(name))
+        fileName = name;
+
+    // Compare in the same form as the paths reported by the file watchers
+    return GetInternalPath(fileName);
+}
+
+unsigned ParticleEffectWatcher2D::CheckChanges(FileWatcher* watcher)
+{
+    unsigned flags = 0;
+    String fileName;
+    while (watcher->GetNextChange(fileName))
+    {
+        fileName = watcher->GetPath() + fileName;
+        if (fileName == effectFileName_)
+            flags |= WATCH_EFFECT_CHANGED;
+        if (fileName == textureFileName_)
+            textureDirty_ = true;
+    }
+
+    return flags;
+}
+
+void ParticleEffectWatcher2D::BeginTextureDecode()
+{
+    if (textureFileName_.Empty())
+        return;
+
+    decode_.fileName_ = textureFileName_;
+    decode_.image_ = new Image(context_);
+    decode_.success_ = false;
+    decode_.completed_ = false;
+
+    // Decode below the priority of the particle update, so a large texture never stalls a frame
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    WorkItem item;
+    item.workFunction_ = DecodeTextureWork;
+    item.aux_ = &decode_;
+    item.priority_ = 0;
+
+    if (queue && queue->GetNumThreads())
+    {
+        queue->AddWorkItem(item);
+        decoding_ = true;
+    }
+    else
+    {
+        DecodeTextureWork(&item, 0);
+        EndTextureDecode();
+    }
+}
+
+bool ParticleEffectWatcher2D::EndTextureDecode()
+{
+    SharedPtr<Image> image = decode_.image_;
+    decode_.image_.Reset();
+
+    if (!decode_.success_)
+    {
+        LOGERROR("Reload texture failed " + decode_.fileName_);
+        return false;
+    }
+
+    Sprite2D* sprite = emitter_ ? emitter_->GetSprite() : 0;
+    Texture2D* texture = sprite ? sprite->GetTexture() : 0;
+    if (!texture)
+        return false;
+
+    // A sprite covering the whole texture follows its new size
+    const IntRect& rectangle = sprite->GetRectangle();
+    bool wholeTexture = rectangle.left_ == 0 && rectangle.top_ == 0 && rectangle.right_ == texture->GetWidth() &&
+        rectangle.bottom_ == texture->GetHeight();
+
+    if (!texture->Load(image))
+        return false;
+
+    if (wholeTexture)
+        sprite->SetRectangle(IntRect(0, 0, texture->GetWidth(), texture->GetHeight()));
+
+    LOGINFO("Reloaded texture " + decode_.fileName_);
+    return true;
+}
+
+void ParticleEffectWatcher2D::CompleteTextureDecode()
+{
+    if (!decoding_)
+        return;
+
+    // The work item points into this object, so it must finish before the watch target changes
+    GetSubsystem<WorkQueue>()->Complete(0);
+    decoding_ = false;
+    decode_.image_.Reset();
+}
+
+}
@@ -0,0 +1,113 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Object.h"
+#include "Ptr.h"
+
+namespace Urho3D
+{
+
+class FileWatcher;
+class Image;
+class ParticleEffectSettings2D;
+class SimulatedParticleEmitter2D;
+struct ParticleEffectParameters2D;
+
+/// Effect file changed since the last update.
+static const unsigned WATCH_EFFECT_CHANGED = 0x1;
+/// Texture reloaded in the last update.
+static const unsigned WATCH_TEXTURE_RELOADED = 0x2;
+
+/// Texture decoded on a worker thread.
+struct ParticleTextureDecode2D
+{
+    /// Texture file name.
+    String fileName_;
+    /// Decoded image.
+    SharedPtr<Image> image_;
+    /// Decode success flag.
+    bool success_;
+    /// Completed flag, set by the worker thread last.
+    volatile bool completed_;
+};
+
+/// Watches the file of a particle effect and the texture of its sprite. Changed textures are decoded on a low priority
+/// work item and uploaded on the main thread. Changes to the effect file are reported, and ReadEffect() reads the new
+/// parameters so that the caller can patch the live effect.
+class ParticleEffectWatcher2D : public Object
+{
+    OBJECT(ParticleEffectWatcher2D)
+
+public:
+    /// Construct.
+    ParticleEffectWatcher2D(Context* context);
+    /// Destruct.
+    virtual ~ParticleEffectWatcher2D();
+
+    /// Watch an effect file, given as a resource name or file path, and the texture of the emitter's sprite. Return true if successful.
+    bool Watch(const String& fileName, SimulatedParticleEmitter2D* emitter);
+    /// Stop watching.
+    void StopWatching();
+    /// Check for changes, start decoding changed textures and upload decoded ones. Call on the main thread. Return WATCH_* flags.
+    unsigned Update();
+    /// Read parameters, settings and texture name from the watched effect file. Parameters missing from the file keep their
+    /// values. Return true if successful.
+    bool ReadEffect(ParticleEffectParameters2D& parameters, ParticleEffectSettings2D& settings, String& textureName) const;
+
+    /// Return watched effect file path.
+    const String& GetEffectFileName() const { return effectFileName_; }
+    /// Return watched texture file path.
+    const String& GetTextureFileName() const { return textureFileName_; }
+
+private:
+    /// Return file path of a resource name or file path, or empty if not found.
+    String GetNativeFileName(const String& name) const;
+    /// Drain file changes of a watcher. Return WATCH_EFFECT_CHANGED if the effect changed, and mark the texture dirty if it changed.
+    unsigned CheckChanges(FileWatcher* watcher);
+    /// Start decoding the texture.
+    void BeginTextureDecode();
+    /// Upload the decoded texture. Return true if successful.
+    bool EndTextureDecode();
+    /// Wait for a running decode.
+    void CompleteTextureDecode();
+
+    /// Watcher of the effect directory.
+    SharedPtr<FileWatcher> effectWatcher_;
+    /// Watcher of the texture directory, when it differs from the effect directory.
+    SharedPtr<FileWatcher> textureWatcher_;
+    /// Emitter.
+    WeakPtr<SimulatedParticleEmitter2D> emitter_;
+    /// Effect file path.
+    String effectFileName_;
+    /// Texture file path.
+    String textureFileName_;
+    /// Texture decode in progress or last finished.
+    ParticleTextureDecode2D decode_;
+    /// Decode running flag.
+    bool decoding_;
+    /// Texture changed while decoding flag.
+    bool textureDirty_;
+};
+
+}
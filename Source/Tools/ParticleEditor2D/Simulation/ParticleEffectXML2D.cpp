@@ -0,0 +1,279 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "GraphicsDefs.h"
+#include "ParticleEffectBinary2D.h"
+#include "ParticleEffectXML2D.h"
+#include "XMLElement.h"
+
+#include <cstddef>
+
+namespace Urho3D
+{
+
+/// Value type of a .pex element.
+enum ParticleElementType2D
+{
+    PET_INT = 0,
+    PET_FLOAT,
+    PET_VECTOR2,
+    PET_COLOR,
+    PET_TEXTURE,
+    PET_BLENDSOURCE,
+    PET_BLENDDESTINATION,
+    PET_UNUSED
+};
+
+/// Element of a .pex file.
+struct ParticleElement2D
+{
+    /// Element name.
+    const char* name_;
+    /// Value type.
+    ParticleElementType2D type_;
+    /// Value offset in ParticleEffectParameters2D.
+    unsigned offset_;
+};
+
+#define PARAMETER_OFFSET(member) ((unsigned)offsetof(ParticleEffectParameters2D, member))
+
+/// Elements in Particle Designer order. Source position is read by Particle Designer only, the emitter position comes from the node.
+static const ParticleElement2D particleElements[] =
+{
+    { "texture", PET_TEXTURE, 0 },
+    { "sourcePosition", PET_UNUSED, 0 },
+    { "sourcePositionVariance", PET_VECTOR2, PARAMETER_OFFSET(sourcePositionVariance_) },
+    { "speed", PET_FLOAT, PARAMETER_OFFSET(speed_) },
+    { "speedVariance", PET_FLOAT, PARAMETER_OFFSET(speedVariance_) },
+    { "particleLifeSpan", PET_FLOAT, PARAMETER_OFFSET(particleLifeSpan_) },
+    { "particleLifespanVariance", PET_FLOAT, PARAMETER_OFFSET(particleLifespanVariance_) },
+    { "angle", PET_FLOAT, PARAMETER_OFFSET(angle_) },
+    { "angleVariance", PET_FLOAT, PARAMETER_OFFSET(angleVariance_) },
+    { "gravity", PET_VECTOR2, PARAMETER_OFFSET(gravity_) },
+    { "radialAcceleration", PET_FLOAT, PARAMETER_OFFSET(radialAcceleration_) },
+    { "tangentialAcceleration", PET_FLOAT, PARAMETER_OFFSET(tangentialAcceleration_) },
+    { "radialAccelVariance", PET_FLOAT, PARAMETER_OFFSET(radialAccelVariance_) },
+    { "tangentialAccelVariance", PET_FLOAT, PARAMETER_OFFSET(tangentialAccelVariance_) },
+    { "startColor", PET_COLOR, PARAMETER_OFFSET(startColor_) },
+    { "startColorVariance", PET_COLOR, PARAMETER_OFFSET(startColorVariance_) },
+    { "finishColor", PET_COLOR, PARAMETER_OFFSET(finishColor_) },
+    { "finishColorVariance", PET_COLOR, PARAMETER_OFFSET(finishColorVariance_) },
+    { "maxParticles", PET_INT, PARAMETER_OFFSET(maxParticles_) },
+    { "startParticleSize", PET_FLOAT, PARAMETER_OFFSET(startParticleSize_) },
+    { "startParticleSizeVariance", PET_FLOAT, PARAMETER_OFFSET(startParticleSizeVariance_) },
+    { "finishParticleSize", PET_FLOAT, PARAMETER_OFFSET(finishParticleSize_) },
+    { "FinishParticleSizeVariance", PET_FLOAT, PARAMETER_OFFSET(finishParticleSizeVariance_) },
+    { "duration", PET_FLOAT, PARAMETER_OFFSET(duration_) },
+    { "emitterType", PET_INT, PARAMETER_OFFSET(emitterType_) },
+    { "maxRadius", PET_FLOAT, PARAMETER_OFFSET(maxRadius_) },
+    { "maxRadiusVariance", PET_FLOAT, PARAMETER_OFFSET(maxRadiusVariance_) },
+    { "minRadius", PET_FLOAT, PARAMETER_OFFSET(minRadius_) },
+    { "minRadiusVariance", PET_FLOAT, PARAMETER_OFFSET(minRadiusVariance_) },
+    { "rotatePerSecond", PET_FLOAT, PARAMETER_OFFSET(rotatePerSecond_) },
+    { "rotatePerSecondVariance", PET_FLOAT, PARAMETER_OFFSET(rotatePerSecondVariance_) },
+    { "blendFuncSource", PET_BLENDSOURCE, 0 },
+    { "blendFuncDestination", PET_BLENDDESTINATION, 0 },
+    { "rotationStart", PET_FLOAT, PARAMETER_OFFSET(rotationStart_) },
+    { "rotationStartVariance", PET_FLOAT, PARAMETER_OFFSET(rotationStartVariance_) },
+    { "rotationEnd", PET_FLOAT, PARAMETER_OFFSET(rotationEnd_) },
+    { "rotationEndVariance", PET_FLOAT, PARAMETER_OFFSET(rotationEndVariance_) },
+    { 0, PET_UNUSED, 0 }
+};
+
+#undef PARAMETER_OFFSET
+
+/// OpenGL source blend functions in BlendMode order. The subtract modes need a blend equation .pex files cannot store.
+static const int srcBlendFuncs[] =
+{
+    1,      // GL_ONE
+    1,      // GL_ONE
+    0x0306, // GL_DST_COLOR
+    0x0302, // GL_SRC_ALPHA
+    0x0302, // GL_SRC_ALPHA
+    1,      // GL_ONE
+    0x0305, // GL_ONE_MINUS_DST_ALPHA
+    1,      // GL_ONE
+    0x0302  // GL_SRC_ALPHA
+};
+
+/// OpenGL destination blend functions in BlendMode order.
+static const int destBlendFuncs[] =
+{
+    0,      // GL_ZERO
+    1,      // GL_ONE
+    0,      // GL_ZERO
+    0x0303, // GL_ONE_MINUS_SRC_ALPHA
+    1,      // GL_ONE
+    0x0303, // GL_ONE_MINUS_SRC_ALPHA
+    0x0304, // GL_DST_ALPHA
+    1,      // GL_ONE
+    1       // GL_ONE
+};
+
+/// Color component attribute names.
+static const char* colorAttributeNames[] = { "red", "green", "blue", "alpha" };
+
+/// Return float with the fewest digits that read back exactly.
+static String FormatFloat(float value)
+{
+    String text(value);
+    if (ToFloat(text) != value)
+        text = ToString("%.9g", value);
+    return text;
+}
+
+bool ReadParticleEffectXML(const XMLElement& source, ParticleEffectParameters2D& parameters, String& textureName)
+{
+    if (!source || source.GetName() != "particleEmitterConfig")
+        return false;
+
+    unsigned char* base = reinterpret_cast<unsigned char*>(&parameters);
+    bool hasBlendFuncs = false;
+    int blendFuncSource = 0;
+    int blendFuncDestination = 0;
+
+    for (const ParticleElement2D* element = particleElements; element->name_; ++element)
+    {
+        XMLElement child = source.GetChild(element->name_);
+        if (!child)
+            continue;
+
+        float* values = reinterpret_cast<float*>(base + element->offset_);
+        switch (element->type_)
+        {
+        case PET_INT:
+            *reinterpret_cast<int*>(base + element->offset_) = child.GetInt("value");
+            break;
+
+        case PET_FLOAT:
+            values[0] = child.GetFloat("value");
+            break;
+
+        case PET_VECTOR2:
+            values[0] = child.GetFloat("x");
+            values[1] = child.GetFloat("y");
+            break;
+
+        case PET_COLOR:
+            for (unsigned i = 0; i < 4; ++i)
+                values[i] = child.GetFloat(colorAttributeNames[i]);
+            break;
+
+        case PET_TEXTURE:
+            textureName = child.GetAttribute("name");
+            break;
+
+        case PET_BLENDSOURCE:
+            blendFuncSource = child.GetInt("value");
+            hasBlendFuncs = true;
+            break;
+
+        case PET_BLENDDESTINATION:
+            blendFuncDestination = child.GetInt("value");
+            hasBlendFuncs = true;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    // An unknown pair is kept as an invalid blend mode so validation can report it
+    if (hasBlendFuncs)
+        parameters.blendMode_ = GetParticleEffectBlendMode(blendFuncSource, blendFuncDestination);
+
+    return true;
+}
+
+void WriteParticleEffectXML(XMLElement& dest, const ParticleEffectParameters2D& parameters, const String& textureName)
+{
+    const unsigned char* base = reinterpret_cast<const unsigned char*>(&parameters);
+    int blendMode = Clamp(parameters.blendMode_, 0, MAX_BLENDMODES - 1);
+
+    for (const ParticleElement2D* element = particleElements; element->name_; ++element)
+    {
+        if (element->type_ == PET_UNUSED || (element->type_ == PET_TEXTURE && textureName.Empty()))
+            continue;
+
+        XMLElement child = dest.CreateChild(element->name_);
+        const float* values = reinterpret_cast<const float*>(base + element->offset_);
+        switch (element->type_)
+        {
+        case PET_INT:
+            child.SetInt("value", *reinterpret_cast<const int*>(base + element->offset_));
+            break;
+
+        case PET_FLOAT:
+            child.SetAttribute("value", FormatFloat(values[0]));
+            break;
+
+        case PET_VECTOR2:
+            child.SetAttribute("x", FormatFloat(values[0]));
+            child.SetAttribute("y", FormatFloat(values[1]));
+            break;
+
+        case PET_COLOR:
+            for (unsigned i = 0; i < 4; ++i)
+                child.SetAttribute(colorAttributeNames[i], FormatFloat(values[i]));
+            break;
+
+        case PET_TEXTURE:
+            child.SetAttribute("name", textureName);
+            break;
+
+        case PET_BLENDSOURCE:
+            child.SetInt("value", srcBlendFuncs[blendMode]);
+            break;
+
+        case PET_BLENDDESTINATION:
+            child.SetInt("value", destBlendFuncs[blendMode]);
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+bool IsParticleEffectXMLElement(const String& name)
+{
+    for (const ParticleElement2D* element = particleElements; element->name_; ++element)
+    {
+        if (name == element->name_)
+            return true;
+    }
+
+    return false;
+}
+
+int GetParticleEffectBlendMode(int blendFuncSource, int blendFuncDestination)
+{
+    for (int i = 0; i < MAX_BLENDMODES; ++i)
+    {
+        if (srcBlendFuncs[i] == blendFuncSource && destBlendFuncs[i] == blendFuncDestination)
+            return i;
+    }
+
+    return MAX_BLENDMODES;
+}
+
+}
@@ -0,0 +1,44 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Str.h"
+
+namespace Urho3D
+{
+
+class XMLElement;
+struct ParticleEffectParameters2D;
+
+/// Read parameters and texture name from the root element of a .pex file without touching the resource cache, so it can run
+/// on worker threads. Missing elements keep their values. Return true if the root element is a particle emitter config.
+bool ReadParticleEffectXML(const XMLElement& source, ParticleEffectParameters2D& parameters, String& textureName);
+/// Write parameters and texture name to the root element of a .pex file. Every element is written, in Particle Designer
+/// order, and floats use the fewest digits that read back exactly.
+void WriteParticleEffectXML(XMLElement& dest, const ParticleEffectParameters2D& parameters, const String& textureName);
+/// Return whether an element name of a .pex file is read by ReadParticleEffectXML.
+bool IsParticleEffectXMLElement(const String& name);
+/// Return blend mode for a pair of OpenGL blend functions, or MAX_BLENDMODES if none matches.
+int GetParticleEffectBlendMode(int blendFuncSource, int blendFuncDestination);
+
+}
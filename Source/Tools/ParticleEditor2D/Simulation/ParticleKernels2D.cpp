@@ -0,0 +1,408 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Log.h"
+#include "MathDefs.h"
+#include "Mutex.h"
+#include "ParticleKernels2D.h"
+
+#ifdef PARTICLE_KERNELS_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace Urho3D
+{
+
+/// Max relative error accepted when validating kernels against the scalar reference.
+static const float KERNEL_TOLERANCE = 1e-3f;
+/// Number of particles used for validation, deliberately not a multiple of the vector width. Fits in one chunk.
+static const unsigned NUM_VALIDATION_PARTICLES = 67;
+
+/// Number of pixels used for validating the span rasterizer.
+static const unsigned NUM_VALIDATION_PIXELS = 37;
+/// Width and height of the texture used for validating the span rasterizer.
+static const int VALIDATION_TEXTURE_SIZE = 5;
+
+/// Kernels picked by SelectParticleKernels(), null until the first call.
+static const ParticleKernels2D* selectedKernels = 0;
+/// Mutex for picking the kernels. Simulators may be created on worker threads, so the first call can come from any of them.
+static Mutex selectedKernelsMutex;
+
+static const ParticleKernels2D scalarKernels = { PKL_SCALAR, "Scalar", UpdateGravityParticlesScalar, UpdateRadialParticlesScalar,
+    GenerateParticleRandomsScalar, RasterizeParticleSpanScalar };
+#ifdef PARTICLE_KERNELS_X86
+// A pixel is four floats, so the AVX2 level rasterizes spans one pixel per SSE2 vector as well
+static const ParticleKernels2D sse2Kernels = { PKL_SSE2, "SSE2", UpdateGravityParticlesSSE2, UpdateRadialParticlesSSE2,
+    GenerateParticleRandomsSSE2, RasterizeParticleSpanSSE2 };
+static const ParticleKernels2D avx2Kernels = { PKL_AVX2, "AVX2", UpdateGravityParticlesAVX2, UpdateRadialParticlesAVX2,
+    GenerateParticleRandomsAVX2, RasterizeParticleSpanSSE2 };
+#endif
+
+#ifdef PARTICLE_KERNELS_X86
+static void CpuId(unsigned leaf, unsigned regs[4])
+{
+#ifdef _MSC_VER
+    __cpuidex((int*)regs, (int)leaf, 0);
+#else
+    __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static unsigned long long XGetBV()
+{
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned eax, edx;
+    __asm__ __volatile__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+    return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+#endif
+
+ParticleKernelLevel2D GetSupportedParticleKernelLevel()
+{
+#ifdef PARTICLE_KERNELS_X86
+    unsigned regs[4];
+    CpuId(0, regs);
+    unsigned maxLeaf = regs[0];
+
+    CpuId(1, regs);
+    bool sse2 = (regs[3] & (1U << 26)) != 0;
+    bool osxsave = (regs[2] & (1U << 27)) != 0;
+    bool avx = (regs[2] & (1U << 28)) != 0;
+    if (!sse2)
+        return PKL_SCALAR;
+
+    // AVX2 needs the OS to save YMM registers on context switch
+    if (maxLeaf >= 7 && osxsave && avx && (XGetBV() & 0x6) == 0x6)
+    {
+        CpuId(7, regs);
+        if (regs[1] & (1U << 5))
+            return PKL_AVX2;
+    }
+
+    return PKL_SSE2;
+#else
+    return PKL_SCALAR;
+#endif
+}
+
+const ParticleKernels2D& GetParticleKernels(ParticleKernelLevel2D level)
+{
+#ifdef PARTICLE_KERNELS_X86
+    ParticleKernelLevel2D supported = GetSupportedParticleKernelLevel();
+    if (level == PKL_AVX2 && supported >= PKL_AVX2)
+        return avx2Kernels;
+    if (level == PKL_SSE2 && supported >= PKL_SSE2)
+        return sse2Kernels;
+#endif
+    return scalarKernels;
+}
+
+const ParticleKernels2D& SelectParticleKernels()
+{
+    // Only taken when simulators and rasterizers are created, never while stepping
+    MutexLock lock(selectedKernelsMutex);
+    if (selectedKernels)
+        return *selectedKernels;
+
+    const ParticleKernels2D* selected = &scalarKernels;
+    for (int level = (int)GetSupportedParticleKernelLevel(); level > PKL_SCALAR; --level)
+    {
+        const ParticleKernels2D& kernels = GetParticleKernels((ParticleKernelLevel2D)level);
+        float error = ValidateParticleKernels(kernels);
+        if (error <= KERNEL_TOLERANCE)
+        {
+            selected = &kernels;
+            break;
+        }
+
+        LOGWARNING(String("Particle kernels ") + kernels.name_ + " do not match scalar reference, max relative error " + String(error));
+    }
+
+    LOGINFO(String("Using ") + selected->name_ + " particle kernels");
+    selectedKernels = selected;
+    return *selectedKernels;
+}
+
+/// Fill particle pool with deterministic pseudo random values.
+static void FillValidationParticles(ParticlePool2D& pool)
+{
+    unsigned state = 0x9e3779b9;
+    pool.SetCapacity(NUM_VALIDATION_PARTICLES);
+    pool.Clear();
+    for (unsigned i = 0; i < NUM_VALIDATION_PARTICLES; ++i)
+    {
+        unsigned index = pool.Allocate();
+        for (unsigned j = 0; j < MAX_PARTICLE_STREAMS; ++j)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            float value = (float)(state & 0xffffff) / (float)0xffffff;
+            pool.Get((ParticleStream2D)j, index) = value * 20.0f - 10.0f;
+        }
+
+        // Rotations may grow large over a long life, cover several turns
+        pool.Get(PS_EMIT_ROTATION, index) *= 180.0f;
+        pool.Get(PS_EMIT_ROTATION_DELTA, index) *= 72.0f;
+        // Some particles die within the step
+        pool.Get(PS_TIME_TO_LIVE, index) = Abs(pool.Get(PS_TIME_TO_LIVE, index)) * 0.01f;
+    }
+}
+
+/// Return max relative error between two particle pools.
+static float CompareParticles(const ParticlePool2D& lhs, const ParticlePool2D& rhs)
+{
+    float maxError = 0.0f;
+    for (unsigned i = 0; i < MAX_PARTICLE_STREAMS; ++i)
+    {
+        for (unsigned j = 0; j < lhs.GetSize(); ++j)
+        {
+            float a = lhs.Get((ParticleStream2D)i, j);
+            float b = rhs.Get((ParticleStream2D)i, j);
+            float error = Abs(a - b) / Max(1.0f, Abs(b));
+            // NaN never matches
+            if (error != error)
+                return M_INFINITY;
+            maxError = Max(maxError, error);
+        }
+    }
+    return maxError;
+}
+
+/// Return max error between a span rasterized by kernels and by the scalar reference. The span enters and leaves the quad
+/// and blends alpha against a varying destination.
+static float ValidateSpanKernel(const ParticleKernels2D& kernels)
+{
+    float texels[VALIDATION_TEXTURE_SIZE * VALIDATION_TEXTURE_SIZE * 4];
+    for (unsigned i = 0; i < VALIDATION_TEXTURE_SIZE * VALIDATION_TEXTURE_SIZE * 4; ++i)
+        texels[i] = (float)((i * 37) % 101) / 100.0f;
+
+    float reference[NUM_VALIDATION_PIXELS * 4];
+    float result[NUM_VALIDATION_PIXELS * 4];
+    for (unsigned i = 0; i < NUM_VALIDATION_PIXELS * 4; ++i)
+        reference[i] = result[i] = (float)((i * 53) % 97) / 96.0f;
+
+    ParticleSpanArgs2D args;
+    args.count_ = NUM_VALIDATION_PIXELS;
+    args.u_ = -0.2f;
+    args.v_ = 0.1f;
+    args.dudx_ = 1.4f / NUM_VALIDATION_PIXELS;
+    args.dvdx_ = 0.8f / NUM_VALIDATION_PIXELS;
+    args.texels_ = texels;
+    args.texWidth_ = VALIDATION_TEXTURE_SIZE;
+    args.texHeight_ = VALIDATION_TEXTURE_SIZE;
+    args.color_[0] = 0.9f;
+    args.color_[1] = 0.5f;
+    args.color_[2] = 0.25f;
+    args.color_[3] = 0.75f;
+    const float alphaBlend[8] = { 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f };
+    for (unsigned i = 0; i < 8; ++i)
+        args.blend_[i] = alphaBlend[i];
+
+    args.dest_ = reference;
+    unsigned referenceCovered = scalarKernels.span_(args);
+    args.dest_ = result;
+    if (kernels.span_(args) != referenceCovered)
+        return M_INFINITY;
+
+    float maxError = 0.0f;
+    for (unsigned i = 0; i < NUM_VALIDATION_PIXELS * 4; ++i)
+        maxError = Max(maxError, Abs(result[i] - reference[i]));
+    return maxError;
+}
+
+float ValidateParticleKernels(const ParticleKernels2D& kernels)
+{
+    float maxError = 0.0f;
+
+    for (unsigned type = 0; type < 2; ++type)
+    {
+        ParticlePool2D reference;
+        ParticlePool2D result;
+        FillValidationParticles(reference);
+        FillValidationParticles(result);
+
+        ParticleKernelArgs2D args;
+        args.begin_ = 0;
+        args.end_ = NUM_VALIDATION_PARTICLES;
+        args.timeStep_ = 1.0f / 60.0f;
+        args.gravityX_ = 0.5f;
+        args.gravityY_ = -9.8f;
+
+        for (unsigned i = 0; i < MAX_PARTICLE_STREAMS; ++i)
+            args.streams_[i] = reference.GetStream(0, (ParticleStream2D)i);
+        if (type == 0)
+            scalarKernels.gravity_(args);
+        else
+            scalarKernels.radial_(args);
+
+        for (unsigned i = 0; i < MAX_PARTICLE_STREAMS; ++i)
+            args.streams_[i] = result.GetStream(0, (ParticleStream2D)i);
+        if (type == 0)
+            kernels.gravity_(args);
+        else
+            kernels.radial_(args);
+
+        maxError = Max(maxError, CompareParticles(result, reference));
+    }
+
+    // Spawn randoms are integer math and must match exactly. Start near the top to cover counter wrap around
+    float referenceRandoms[NUM_VALIDATION_PARTICLES * MAX_PARTICLE_RANDOM_CHANNELS];
+    float resultRandoms[NUM_VALIDATION_PARTICLES * MAX_PARTICLE_RANDOM_CHANNELS];
+    unsigned first = M_MAX_UNSIGNED - NUM_VALIDATION_PARTICLES / 2;
+    scalarKernels.random_(12345, first, NUM_VALIDATION_PARTICLES, referenceRandoms);
+    kernels.random_(12345, first, NUM_VALIDATION_PARTICLES, resultRandoms);
+    for (unsigned i = 0; i < NUM_VALIDATION_PARTICLES * MAX_PARTICLE_RANDOM_CHANNELS; ++i)
+    {
+        if (resultRandoms[i] != referenceRandoms[i])
+            return M_INFINITY;
+    }
+
+    maxError = Max(maxError, ValidateSpanKernel(kernels));
+    return maxError;
+}
+
+/// Update the attributes shared by all emitter types.
+static inline void UpdateCommon(float* const* s, unsigned i, float step)
+{
+    s[PS_SIZE][i] += s[PS_SIZE_DELTA][i] * step;
+    s[PS_ROTATION][i] += s[PS_ROTATION_DELTA][i] * step;
+    s[PS_COLOR_R][i] += s[PS_COLOR_DELTA_R][i] * step;
+    s[PS_COLOR_G][i] += s[PS_COLOR_DELTA_G][i] * step;
+    s[PS_COLOR_B][i] += s[PS_COLOR_DELTA_B][i] * step;
+    s[PS_COLOR_A][i] += s[PS_COLOR_DELTA_A][i] * step;
+}
+
+void UpdateGravityParticlesScalar(const ParticleKernelArgs2D& args)
+{
+    float* const* s = args.streams_;
+    for (unsigned i = args.begin_; i < args.end_; ++i)
+    {
+        float step = Min(args.timeStep_, s[PS_TIME_TO_LIVE][i]);
+        s[PS_TIME_TO_LIVE][i] -= step;
+
+        float distanceX = s[PS_POSITION_X][i] - s[PS_START_X][i];
+        float distanceY = s[PS_POSITION_Y][i] - s[PS_START_Y][i];
+
+        float distanceScalar = Sqrt(distanceX * distanceX + distanceY * distanceY);
+        if (distanceScalar < 0.0001f)
+            distanceScalar = 0.0001f;
+
+        float radialX = distanceX / distanceScalar;
+        float radialY = distanceY / distanceScalar;
+
+        float tangentialX = -radialY * s[PS_TANGENTIAL_ACCELERATION][i];
+        float tangentialY = radialX * s[PS_TANGENTIAL_ACCELERATION][i];
+
+        radialX *= s[PS_RADIAL_ACCELERATION][i];
+        radialY *= s[PS_RADIAL_ACCELERATION][i];
+
+        s[PS_VELOCITY_X][i] += (args.gravityX_ + radialX - tangentialX) * step;
+        s[PS_VELOCITY_Y][i] -= (args.gravityY_ - radialY + tangentialY) * step;
+        s[PS_POSITION_X][i] += s[PS_VELOCITY_X][i] * step;
+        s[PS_POSITION_Y][i] += s[PS_VELOCITY_Y][i] * step;
+
+        UpdateCommon(s, i, step);
+    }
+}
+
+void UpdateRadialParticlesScalar(const ParticleKernelArgs2D& args)
+{
+    float* const* s = args.streams_;
+    for (unsigned i = args.begin_; i < args.end_; ++i)
+    {
+        float step = Min(args.timeStep_, s[PS_TIME_TO_LIVE][i]);
+        s[PS_TIME_TO_LIVE][i] -= step;
+
+        s[PS_EMIT_ROTATION][i] += s[PS_EMIT_ROTATION_DELTA][i] * step;
+        s[PS_EMIT_RADIUS][i] += s[PS_EMIT_RADIUS_DELTA][i] * step;
+
+        s[PS_POSITION_X][i] = s[PS_START_X][i] - Cos(s[PS_EMIT_ROTATION][i]) * s[PS_EMIT_RADIUS][i];
+        s[PS_POSITION_Y][i] = s[PS_START_Y][i] + Sin(s[PS_EMIT_ROTATION][i]) * s[PS_EMIT_RADIUS][i];
+
+        UpdateCommon(s, i, step);
+    }
+}
+
+/// Sample texels bilinearly with clamp to edge at quad coordinates in [0, 1).
+static void SampleTexels(const ParticleSpanArgs2D& args, float u, float v, float* dest)
+{
+    // Coordinates are at least -0.5 texels, so truncating after adding one rounds down
+    float x = u * args.texWidth_ - 0.5f;
+    float y = v * args.texHeight_ - 0.5f;
+    int x0 = (int)(x + 1.0f) - 1;
+    int y0 = (int)(y + 1.0f) - 1;
+    float fx = x - x0;
+    float fy = y - y0;
+    int xa = Max(x0, 0);
+    int xb = Min(x0 + 1, args.texWidth_ - 1);
+    int ya = Max(y0, 0);
+    int yb = Min(y0 + 1, args.texHeight_ - 1);
+
+    const float* t00 = args.texels_ + (ya * args.texWidth_ + xa) * 4;
+    const float* t01 = args.texels_ + (ya * args.texWidth_ + xb) * 4;
+    const float* t10 = args.texels_ + (yb * args.texWidth_ + xa) * 4;
+    const float* t11 = args.texels_ + (yb * args.texWidth_ + xb) * 4;
+    for (unsigned c = 0; c < 4; ++c)
+    {
+        float top = t00[c] + (t01[c] - t00[c]) * fx;
+        float bottom = t10[c] + (t11[c] - t10[c]) * fx;
+        dest[c] = top + (bottom - top) * fy;
+    }
+}
+
+unsigned RasterizeParticleSpanScalar(const ParticleSpanArgs2D& args)
+{
+    const float* f = args.blend_;
+    unsigned covered = 0;
+    for (unsigned i = 0; i < args.count_; ++i)
+    {
+        float u = args.u_ + args.dudx_ * i;
+        float v = args.v_ + args.dvdx_ * i;
+        if (!(u >= 0.0f && u < 1.0f && v >= 0.0f && v < 1.0f))
+            continue;
+        ++covered;
+
+        float src[4];
+        SampleTexels(args, u, v, src);
+        for (unsigned c = 0; c < 4; ++c)
+            src[c] *= args.color_[c];
+
+        float* dest = args.dest_ + i * 4;
+        float srcAlpha = src[3];
+        float destAlpha = dest[3];
+        float srcScale = f[0] + f[1] * srcAlpha + f[2] * destAlpha;
+        float destScale = f[4] + f[5] * srcAlpha + f[6] * destAlpha;
+        for (unsigned c = 0; c < 4; ++c)
+            dest[c] = Clamp(src[c] * (srcScale + f[3] * dest[c]) + dest[c] * destScale, 0.0f, 1.0f);
+    }
+    return covered;
+}
+
+}
@@ -0,0 +1,149 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "ParticlePool2D.h"
+#include "ParticleRandom2D.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define PARTICLE_KERNELS_X86
+#endif
+
+namespace Urho3D
+{
+
+/// Particle update kernel instruction set level.
+enum ParticleKernelLevel2D
+{
+    PKL_SCALAR = 0,
+    PKL_SSE2,
+    PKL_AVX2,
+    MAX_PARTICLE_KERNEL_LEVELS
+};
+
+/// Particle update kernel arguments.
+struct ParticleKernelArgs2D
+{
+    /// Attribute streams.
+    float* streams_[MAX_PARTICLE_STREAMS];
+    /// First particle to update.
+    unsigned begin_;
+    /// One past the last particle to update.
+    unsigned end_;
+    /// Time step.
+    float timeStep_;
+    /// Gravity X in world units.
+    float gravityX_;
+    /// Gravity Y in world units.
+    float gravityY_;
+};
+
+/// Particle update kernel function.
+typedef void (*ParticleKernel2D)(const ParticleKernelArgs2D& args);
+
+/// Spawn random batch function. Channel c of spawn first + i is written to dest[c * count + i].
+typedef void (*ParticleRandomKernel2D)(unsigned seed, unsigned first, unsigned count, float* dest);
+
+/// Particle span rasterizer arguments. A span is a run of pixels on one row that may be covered by a particle quad.
+struct ParticleSpanArgs2D
+{
+    /// Destination pixels, four floats each.
+    float* dest_;
+    /// Number of pixels.
+    unsigned count_;
+    /// Quad U coordinate at the first pixel. The pixel is covered where U and V are in [0, 1).
+    float u_;
+    /// Quad V coordinate at the first pixel.
+    float v_;
+    /// U change per pixel.
+    float dudx_;
+    /// V change per pixel.
+    float dvdx_;
+    /// Texels, four floats each, sampled bilinearly with clamp to edge.
+    const float* texels_;
+    /// Texture width.
+    int texWidth_;
+    /// Texture height.
+    int texHeight_;
+    /// Particle color.
+    float color_[4];
+    /// Blend factors. Destination becomes source * (f0 + f1 * srcAlpha + f2 * destAlpha + f3 * dest) + dest * (f4 + f5 *
+    /// srcAlpha + f6 * destAlpha), clamped to [0, 1].
+    float blend_[8];
+};
+
+/// Particle span rasterizer function. Return number of pixels covered.
+typedef unsigned (*ParticleSpanKernel2D)(const ParticleSpanArgs2D& args);
+
+/// Particle update kernels of one instruction set level.
+struct ParticleKernels2D
+{
+    /// Instruction set level.
+    ParticleKernelLevel2D level_;
+    /// Name.
+    const char* name_;
+    /// Gravity emitter type kernel.
+    ParticleKernel2D gravity_;
+    /// Radial emitter type kernel.
+    ParticleKernel2D radial_;
+    /// Spawn random batch kernel.
+    ParticleRandomKernel2D random_;
+    /// Span rasterizer kernel.
+    ParticleSpanKernel2D span_;
+};
+
+/// Return best kernel level supported by the CPU and operating system.
+ParticleKernelLevel2D GetSupportedParticleKernelLevel();
+/// Return kernels of level. Return scalar kernels if level is not supported.
+const ParticleKernels2D& GetParticleKernels(ParticleKernelLevel2D level);
+/// Return the best supported kernels that match the scalar reference. The choice is made once and cached. Safe to call from
+/// any thread.
+const ParticleKernels2D& SelectParticleKernels();
+/// Run kernels and the scalar reference on the same particles and return the max relative error.
+float ValidateParticleKernels(const ParticleKernels2D& kernels);
+
+/// Update gravity type particles, scalar reference.
+void UpdateGravityParticlesScalar(const ParticleKernelArgs2D& args);
+/// Update radial type particles, scalar reference.
+void UpdateRadialParticlesScalar(const ParticleKernelArgs2D& args);
+/// Rasterize a particle span, scalar reference.
+unsigned RasterizeParticleSpanScalar(const ParticleSpanArgs2D& args);
+
+#ifdef PARTICLE_KERNELS_X86
+/// Update gravity type particles with SSE2.
+void UpdateGravityParticlesSSE2(const ParticleKernelArgs2D& args);
+/// Update radial type particles with SSE2.
+void UpdateRadialParticlesSSE2(const ParticleKernelArgs2D& args);
+/// Generate spawn randoms four particles at a time with SSE2.
+void GenerateParticleRandomsSSE2(unsigned seed, unsigned first, unsigned count, float* dest);
+/// Rasterize a particle span with SSE2, one pixel per vector.
+unsigned RasterizeParticleSpanSSE2(const ParticleSpanArgs2D& args);
+/// Update gravity type particles with AVX2.
+void UpdateGravityParticlesAVX2(const ParticleKernelArgs2D& args);
+/// Update radial type particles with AVX2.
+void UpdateRadialParticlesAVX2(const ParticleKernelArgs2D& args);
+/// Generate spawn randoms eight particles at a time with AVX2.
+void GenerateParticleRandomsAVX2(unsigned seed, unsigned first, unsigned count, float* dest);
+#endif
+
+}
@@ -0,0 +1,234 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "ParticleKernels2D.h"
+
+#ifdef PARTICLE_KERNELS_X86
+
+#include <immintrin.h>
+
+namespace Urho3D
+{
+
+// Note: this file is compiled with AVX2 flags that the baseline build does not have. Do not call
+// inline functions from shared headers here, the linker may pick this copy for the whole program.
+
+/// Degrees to radians.
+static const float DEGTORAD = 3.14159265358979323846264338327950288f / 180.0f;
+
+/// Compute sine and cosine of angles in degrees.
+static inline void SinCosDegrees(__m256 degrees, __m256& sine, __m256& cosine)
+{
+    // Reduce to [-45, 45] degrees around the nearest multiple of 90
+    __m256i quadrant = _mm256_cvtps_epi32(_mm256_mul_ps(degrees, _mm256_set1_ps(1.0f / 90.0f)));
+    __m256 x = _mm256_sub_ps(degrees, _mm256_mul_ps(_mm256_cvtepi32_ps(quadrant), _mm256_set1_ps(90.0f)));
+    x = _mm256_mul_ps(x, _mm256_set1_ps(DEGTORAD));
+    __m256 x2 = _mm256_mul_ps(x, x);
+
+    // Polynomial approximations on [-pi/4, pi/4]
+    __m256 s = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(-1.9515295891e-4f), x2), _mm256_set1_ps(8.3321608736e-3f));
+    s = _mm256_add_ps(_mm256_mul_ps(s, x2), _mm256_set1_ps(-1.6666654611e-1f));
+    s = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(s, x2), x), x);
+
+    __m256 c = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(2.443315711809948e-5f), x2), _mm256_set1_ps(-1.388731625493765e-3f));
+    c = _mm256_add_ps(_mm256_mul_ps(c, x2), _mm256_set1_ps(4.166664568298827e-2f));
+    c = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(c, x2), x2), _mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(x2, _mm256_set1_ps(0.5f))));
+
+    // Odd quadrants swap sine and cosine, quadrant bit 1 flips the sign
+    __m256 swap =_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+    __m256 sinBase = _mm256_blendv_ps(s, c, swap);
+    __m256 cosBase = _mm256_blendv_ps(c, s, swap);
+
+    __m256 sinSign =_mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(2)), 30));
+    __m256 cosSign =_mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30));
+    sine = _mm256_xor_ps(sinBase, sinSign);
+    cosine = _mm256_xor_ps(cosBase, cosSign);
+}
+
+/// Advance stream by delta stream times step.
+static inline void Integrate(float* value, const float* delta, __m256 step)
+{
+    _mm256_storeu_ps(value, _mm256_add_ps(_mm256_loadu_ps(value), _mm256_mul_ps(_mm256_loadu_ps(delta), step)));
+}
+
+/// Update the attributes shared by all emitter types.
+static inline void UpdateCommon(float* const* s, unsigned i, __m256 step)
+{
+    Integrate(s[PS_SIZE] + i, s[PS_SIZE_DELTA] + i, step);
+    Integrate(s[PS_ROTATION] + i, s[PS_ROTATION_DELTA] + i, step);
+    Integrate(s[PS_COLOR_R] + i, s[PS_COLOR_DELTA_R] + i, step);
+    Integrate(s[PS_COLOR_G] + i, s[PS_COLOR_DELTA_G] + i, step);
+    Integrate(s[PS_COLOR_B] + i, s[PS_COLOR_DELTA_B] + i, step);
+    Integrate(s[PS_COLOR_A] + i, s[PS_COLOR_DELTA_A] + i, step);
+}
+
+/// Consume time to live and return the clamped step.
+static inline __m256 ConsumeTimeToLive(float* timeToLive, __m256 timeStep)
+{
+    __m256 ttl = _mm256_loadu_ps(timeToLive);
+    __m256 step = _mm256_min_ps(timeStep, ttl);
+    _mm256_storeu_ps(timeToLive, _mm256_sub_ps(ttl, step));
+    return step;
+}
+
+void UpdateGravityParticlesAVX2(const ParticleKernelArgs2D& args)
+{
+    float* const* s = args.streams_;
+    const __m256 timeStep = _mm256_set1_ps(args.timeStep_);
+    const __m256 gravityX = _mm256_set1_ps(args.gravityX_);
+    const __m256 gravityY = _mm256_set1_ps(args.gravityY_);
+    const __m256 minDistance = _mm256_set1_ps(0.0001f);
+
+    unsigned i = args.begin_;
+    for (; i + 8 <= args.end_; i += 8)
+    {
+        __m256 step = ConsumeTimeToLive(s[PS_TIME_TO_LIVE] + i, timeStep);
+
+        __m256 positionX = _mm256_loadu_ps(s[PS_POSITION_X] + i);
+        __m256 positionY = _mm256_loadu_ps(s[PS_POSITION_Y] + i);
+        __m256 distanceX = _mm256_sub_ps(positionX, _mm256_loadu_ps(s[PS_START_X] + i));
+        __m256 distanceY = _mm256_sub_ps(positionY, _mm256_loadu_ps(s[PS_START_Y] + i));
+
+        __m256 distanceScalar = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(distanceX, distanceX), _mm256_mul_ps(distanceY, distanceY)));
+        distanceScalar = _mm256_max_ps(distanceScalar, minDistance);
+
+        __m256 radialX = _mm256_div_ps(distanceX, distanceScalar);
+        __m256 radialY = _mm256_div_ps(distanceY, distanceScalar);
+
+        __m256 tangentialAcceleration = _mm256_loadu_ps(s[PS_TANGENTIAL_ACCELERATION] + i);
+        __m256 tangentialX = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_mul_ps(radialY, tangentialAcceleration));
+        __m256 tangentialY = _mm256_mul_ps(radialX, tangentialAcceleration);
+
+        __m256 radialAcceleration = _mm256_loadu_ps(s[PS_RADIAL_ACCELERATION] + i);
+        radialX = _mm256_mul_ps(radialX, radialAcceleration);
+        radialY = _mm256_mul_ps(radialY, radialAcceleration);
+
+        __m256 velocityX = _mm256_loadu_ps(s[PS_VELOCITY_X] + i);
+        __m256 velocityY = _mm256_loadu_ps(s[PS_VELOCITY_Y] + i);
+        velocityX = _mm256_add_ps(velocityX, _mm256_mul_ps(_mm256_sub_ps(_mm256_add_ps(gravityX, radialX), tangentialX), step));
+        velocityY = _mm256_sub_ps(velocityY, _mm256_mul_ps(_mm256_add_ps(_mm256_sub_ps(gravityY, radialY), tangentialY), step));
+        _mm256_storeu_ps(s[PS_VELOCITY_X] + i, velocityX);
+        _mm256_storeu_ps(s[PS_VELOCITY_Y] + i, velocityY);
+
+        _mm256_storeu_ps(s[PS_POSITION_X] + i, _mm256_add_ps(positionX, _mm256_mul_ps(velocityX, step)));
+        _mm256_storeu_ps(s[PS_POSITION_Y] + i, _mm256_add_ps(positionY, _mm256_mul_ps(velocityY, step)));
+
+        UpdateCommon(s, i, step);
+    }
+
+    ParticleKernelArgs2D tail = args;
+    tail.begin_ = i;
+    UpdateGravityParticlesScalar(tail);
+}
+
+void UpdateRadialParticlesAVX2(const ParticleKernelArgs2D& args)
+{
+    float* const* s = args.streams_;
+    const __m256 timeStep = _mm256_set1_ps(args.timeStep_);
+
+    unsigned i = args.begin_;
+    for (; i + 8 <= args.end_; i += 8)
+    {
+        __m256 step = ConsumeTimeToLive(s[PS_TIME_TO_LIVE] + i, timeStep);
+
+        __m256 emitRotation = _mm256_add_ps(_mm256_loadu_ps(s[PS_EMIT_ROTATION] + i), _mm256_mul_ps(_mm256_loadu_ps(s[PS_EMIT_ROTATION_DELTA] + i), step));
+        __m256 emitRadius = _mm256_add_ps(_mm256_loadu_ps(s[PS_EMIT_RADIUS] + i), _mm256_mul_ps(_mm256_loadu_ps(s[PS_EMIT_RADIUS_DELTA] + i), step));
+        _mm256_storeu_ps(s[PS_EMIT_ROTATION] + i, emitRotation);
+        _mm256_storeu_ps(s[PS_EMIT_RADIUS] + i, emitRadius);
+
+        __m256 sine, cosine;
+        SinCosDegrees(emitRotation, sine, cosine);
+        _mm256_storeu_ps(s[PS_POSITION_X] + i, _mm256_sub_ps(_mm256_loadu_ps(s[PS_START_X] + i), _mm256_mul_ps(cosine, emitRadius)));
+        _mm256_storeu_ps(s[PS_POSITION_Y] + i, _mm256_add_ps(_mm256_loadu_ps(s[PS_START_Y] + i), _mm256_mul_ps(sine, emitRadius)));
+
+        UpdateCommon(s, i, step);
+    }
+
+    ParticleKernelArgs2D tail = args;
+    tail.begin_ = i;
+    UpdateRadialParticlesScalar(tail);
+}
+
+
+/// Multiply eight lanes by a broadcast constant, returning the high and low halves of the 64-bit products.
+static inline void MulHiLo(__m256i a, __m256i b, __m256i& hi, __m256i& lo)
+{
+    const __m256i lowMask = _mm256_set_epi32(0, -1, 0, -1, 0, -1, 0, -1);
+    __m256i even = _mm256_mul_epu32(a, b);
+    __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b);
+    lo = _mm256_or_si256(_mm256_and_si256(even, lowMask), _mm256_slli_epi64(odd, 32));
+    hi = _mm256_or_si256(_mm256_srli_epi64(even, 32), _mm256_andnot_si256(lowMask, odd));
+}
+
+void GenerateParticleRandomsAVX2(unsigned seed, unsigned first, unsigned count, float* dest)
+{
+    const __m256i m0 = _mm256_set1_epi32((int)PHILOX_M0);
+    const __m256i m1 = _mm256_set1_epi32((int)PHILOX_M1);
+    const __m256 scale = _mm256_set1_ps(1.0f / 8388608.0f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    unsigned i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        // Each lane runs Philox4x32-10 on the counter of one spawn index
+        __m256i spawnIndex = _mm256_add_epi32(_mm256_set1_epi32((int)(first + i)), _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+        for (unsigned block = 0; block < NUM_PARTICLE_RANDOM_BLOCKS; ++block)
+        {
+            __m256i x[4] = { spawnIndex, _mm256_set1_epi32((int)block), _mm256_setzero_si256(), _mm256_setzero_si256() };
+            unsigned k0 = seed;
+            unsigned k1 = 0;
+
+            for (unsigned round = 0; round < PHILOX_ROUNDS; ++round)
+            {
+                __m256i hi0, lo0, hi1, lo1;
+                MulHiLo(x[0], m0, hi0, lo0);
+                MulHiLo(x[2], m1, hi1, lo1);
+
+                x[0] = _mm256_xor_si256(_mm256_xor_si256(hi1, x[1]), _mm256_set1_epi32((int)k0));
+                x[1] = lo1;
+                x[2] = _mm256_xor_si256(_mm256_xor_si256(hi0, x[3]), _mm256_set1_epi32((int)k1));
+                x[3] = lo0;
+
+                k0 += PHILOX_W0;
+                k1 += PHILOX_W1;
+            }
+
+            for (unsigned j = 0; j < PARTICLE_RANDOM_BLOCK_SIZE; ++j)
+            {
+                unsigned channel = block * PARTICLE_RANDOM_BLOCK_SIZE + j;
+                if (channel >= MAX_PARTICLE_RANDOM_CHANNELS)
+                    break;
+
+                // Top 24 bits convert exactly, same as the scalar reference
+                __m256 value = _mm256_cvtepi32_ps(_mm256_srli_epi32(x[j], 8));
+                _mm256_storeu_ps(dest + channel * count + i, _mm256_sub_ps(_mm256_mul_ps(value, scale), one));
+            }
+        }
+    }
+
+    for (; i < count; ++i)
+        GenerateParticleRandomScalar(seed, first + i, dest + i, count);
+}
+
+}
+
+#endif
@@ -0,0 +1,298 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "ParticleKernels2D.h"
+
+#ifdef PARTICLE_KERNELS_X86
+
+#include <emmintrin.h>
+
+namespace Urho3D
+{
+
+// Note: this file may be compiled with instruction set flags that the baseline build does not have. Do not call
+// inline functions from shared headers here, the linker may pick this copy for the whole program.
+
+/// Degrees to radians.
+static const float DEGTORAD = 3.14159265358979323846264338327950288f / 180.0f;
+
+/// Compute sine and cosine of angles in degrees.
+static inline void SinCosDegrees(__m128 degrees, __m128& sine, __m128& cosine)
+{
+    // Reduce to [-45, 45] degrees around the nearest multiple of 90
+    __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(degrees, _mm_set1_ps(1.0f / 90.0f)));
+    __m128 x = _mm_sub_ps(degrees, _mm_mul_ps(_mm_cvtepi32_ps(quadrant), _mm_set1_ps(90.0f)));
+    x = _mm_mul_ps(x, _mm_set1_ps(DEGTORAD));
+    __m128 x2 = _mm_mul_ps(x, x);
+
+    // Polynomial approximations on [-pi/4, pi/4]
+    __m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), x2), _mm_set1_ps(8.3321608736e-3f));
+    s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(-1.6666654611e-1f));
+    s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, x2), x), x);
+
+    __m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), x2), _mm_set1_ps(-1.388731625493765e-3f));
+    c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(4.166664568298827e-2f));
+    c = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(c, x2), x2), _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(x2, _mm_set1_ps(0.5f))));
+
+    // Odd quadrants swap sine and cosine, quadrant bit 1 flips the sign
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    __m128 sinBase = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+    __m128 cosBase = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+
+    __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+    sine = _mm_xor_ps(sinBase, sinSign);
+    cosine = _mm_xor_ps(cosBase, cosSign);
+}
+
+/// Advance stream by delta stream times step.
+static inline void Integrate(float* value, const float* delta, __m128 step)
+{
+    _mm_storeu_ps(value, _mm_add_ps(_mm_loadu_ps(value), _mm_mul_ps(_mm_loadu_ps(delta), step)));
+}
+
+/// Update the attributes shared by all emitter types.
+static inline void UpdateCommon(float* const* s, unsigned i, __m128 step)
+{
+    Integrate(s[PS_SIZE] + i, s[PS_SIZE_DELTA] + i, step);
+    Integrate(s[PS_ROTATION] + i, s[PS_ROTATION_DELTA] + i, step);
+    Integrate(s[PS_COLOR_R] + i, s[PS_COLOR_DELTA_R] + i, step);
+    Integrate(s[PS_COLOR_G] + i, s[PS_COLOR_DELTA_G] + i, step);
+    Integrate(s[PS_COLOR_B] + i, s[PS_COLOR_DELTA_B] + i, step);
+    Integrate(s[PS_COLOR_A] + i, s[PS_COLOR_DELTA_A] + i, step);
+}
+
+/// Consume time to live and return the clamped step.
+static inline __m128 ConsumeTimeToLive(float* timeToLive, __m128 timeStep)
+{
+    __m128 ttl = _mm_loadu_ps(timeToLive);
+    __m128 step = _mm_min_ps(timeStep, ttl);
+    _mm_storeu_ps(timeToLive, _mm_sub_ps(ttl, step));
+    return step;
+}
+
+void UpdateGravityParticlesSSE2(const ParticleKernelArgs2D& args)
+{
+    float* const* s = args.streams_;
+    const __m128 timeStep = _mm_set1_ps(args.timeStep_);
+    const __m128 gravityX = _mm_set1_ps(args.gravityX_);
+    const __m128 gravityY = _mm_set1_ps(args.gravityY_);
+    const __m128 minDistance = _mm_set1_ps(0.0001f);
+
+    unsigned i = args.begin_;
+    for (; i + 4 <= args.end_; i += 4)
+    {
+        __m128 step = ConsumeTimeToLive(s[PS_TIME_TO_LIVE] + i, timeStep);
+
+        __m128 positionX = _mm_loadu_ps(s[PS_POSITION_X] + i);
+        __m128 positionY = _mm_loadu_ps(s[PS_POSITION_Y] + i);
+        __m128 distanceX = _mm_sub_ps(positionX, _mm_loadu_ps(s[PS_START_X] + i));
+        __m128 distanceY = _mm_sub_ps(positionY, _mm_loadu_ps(s[PS_START_Y] + i));
+
+        __m128 distanceScalar = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(distanceX, distanceX), _mm_mul_ps(distanceY, distanceY)));
+        distanceScalar = _mm_max_ps(distanceScalar, minDistance);
+
+        __m128 radialX = _mm_div_ps(distanceX, distanceScalar);
+        __m128 radialY = _mm_div_ps(distanceY, distanceScalar);
+
+        __m128 tangentialAcceleration = _mm_loadu_ps(s[PS_TANGENTIAL_ACCELERATION] + i);
+        __m128 tangentialX = _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(radialY, tangentialAcceleration));
+        __m128 tangentialY = _mm_mul_ps(radialX, tangentialAcceleration);
+
+        __m128 radialAcceleration = _mm_loadu_ps(s[PS_RADIAL_ACCELERATION] + i);
+        radialX = _mm_mul_ps(radialX, radialAcceleration);
+        radialY = _mm_mul_ps(radialY, radialAcceleration);
+
+        __m128 velocityX = _mm_loadu_ps(s[PS_VELOCITY_X] + i);
+        __m128 velocityY = _mm_loadu_ps(s[PS_VELOCITY_Y] + i);
+        velocityX = _mm_add_ps(velocityX, _mm_mul_ps(_mm_sub_ps(_mm_add_ps(gravityX, radialX), tangentialX), step));
+        velocityY = _mm_sub_ps(velocityY, _mm_mul_ps(_mm_add_ps(_mm_sub_ps(gravityY, radialY), tangentialY), step));
+        _mm_storeu_ps(s[PS_VELOCITY_X] + i, velocityX);
+        _mm_storeu_ps(s[PS_VELOCITY_Y] + i, velocityY);
+
+        _mm_storeu_ps(s[PS_POSITION_X] + i, _mm_add_ps(positionX, _mm_mul_ps(velocityX, step)));
+        _mm_storeu_ps(s[PS_POSITION_Y] + i, _mm_add_ps(positionY, _mm_mul_ps(velocityY, step)));
+
+        UpdateCommon(s, i, step);
+    }
+
+    ParticleKernelArgs2D tail = args;
+    tail.begin_ = i;
+    UpdateGravityParticlesScalar(tail);
+}
+
+void UpdateRadialParticlesSSE2(const ParticleKernelArgs2D& args)
+{
+    float* const* s = args.streams_;
+    const __m128 timeStep = _mm_set1_ps(args.timeStep_);
+
+    unsigned i = args.begin_;
+    for (; i + 4 <= args.end_; i += 4)
+    {
+        __m128 step = ConsumeTimeToLive(s[PS_TIME_TO_LIVE] + i, timeStep);
+
+        __m128 emitRotation = _mm_add_ps(_mm_loadu_ps(s[PS_EMIT_ROTATION] + i), _mm_mul_ps(_mm_loadu_ps(s[PS_EMIT_ROTATION_DELTA] + i), step));
+        __m128 emitRadius = _mm_add_ps(_mm_loadu_ps(s[PS_EMIT_RADIUS] + i), _mm_mul_ps(_mm_loadu_ps(s[PS_EMIT_RADIUS_DELTA] + i), step));
+        _mm_storeu_ps(s[PS_EMIT_ROTATION] + i, emitRotation);
+        _mm_storeu_ps(s[PS_EMIT_RADIUS] + i, emitRadius);
+
+        __m128 sine, cosine;
+        SinCosDegrees(emitRotation, sine, cosine);
+        _mm_storeu_ps(s[PS_POSITION_X] + i, _mm_sub_ps(_mm_loadu_ps(s[PS_START_X] + i), _mm_mul_ps(cosine, emitRadius)));
+        _mm_storeu_ps(s[PS_POSITION_Y] + i, _mm_add_ps(_mm_loadu_ps(s[PS_START_Y] + i), _mm_mul_ps(sine, emitRadius)));
+
+        UpdateCommon(s, i, step);
+    }
+
+    ParticleKernelArgs2D tail = args;
+    tail.begin_ = i;
+    UpdateRadialParticlesScalar(tail);
+}
+
+
+/// Multiply four lanes by a broadcast constant, returning the high and low halves of the 64-bit products.
+static inline void MulHiLo(__m128i a, __m128i b, __m128i& hi, __m128i& lo)
+{
+    const __m128i lowMask = _mm_set_epi32(0, -1, 0, -1);
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), b);
+    lo = _mm_or_si128(_mm_and_si128(even, lowMask), _mm_slli_epi64(odd, 32));
+    hi = _mm_or_si128(_mm_srli_epi64(even, 32), _mm_andnot_si128(lowMask, odd));
+}
+
+void GenerateParticleRandomsSSE2(unsigned seed, unsigned first, unsigned count, float* dest)
+{
+    const __m128i m0 = _mm_set1_epi32((int)PHILOX_M0);
+    const __m128i m1 = _mm_set1_epi32((int)PHILOX_M1);
+    const __m128 scale = _mm_set1_ps(1.0f / 8388608.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    unsigned i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        // Each lane runs Philox4x32-10 on the counter of one spawn index
+        __m128i spawnIndex = _mm_add_epi32(_mm_set1_epi32((int)(first + i)), _mm_set_epi32(3, 2, 1, 0));
+        for (unsigned block = 0; block < NUM_PARTICLE_RANDOM_BLOCKS; ++block)
+        {
+            __m128i x[4] = { spawnIndex, _mm_set1_epi32((int)block), _mm_setzero_si128(), _mm_setzero_si128() };
+            unsigned k0 = seed;
+            unsigned k1 = 0;
+
+            for (unsigned round = 0; round < PHILOX_ROUNDS; ++round)
+            {
+                __m128i hi0, lo0, hi1, lo1;
+                MulHiLo(x[0], m0, hi0, lo0);
+                MulHiLo(x[2], m1, hi1, lo1);
+
+                x[0] = _mm_xor_si128(_mm_xor_si128(hi1, x[1]), _mm_set1_epi32((int)k0));
+                x[1] = lo1;
+                x[2] = _mm_xor_si128(_mm_xor_si128(hi0, x[3]), _mm_set1_epi32((int)k1));
+                x[3] = lo0;
+
+                k0 += PHILOX_W0;
+                k1 += PHILOX_W1;
+            }
+
+            for (unsigned j = 0; j < PARTICLE_RANDOM_BLOCK_SIZE; ++j)
+            {
+                unsigned channel = block * PARTICLE_RANDOM_BLOCK_SIZE + j;
+                if (channel >= MAX_PARTICLE_RANDOM_CHANNELS)
+                    break;
+
+                // Top 24 bits convert exactly, same as the scalar reference
+                __m128 value = _mm_cvtepi32_ps(_mm_srli_epi32(x[j], 8));
+                _mm_storeu_ps(dest + channel * count + i, _mm_sub_ps(_mm_mul_ps(value, scale), one));
+            }
+        }
+    }
+
+    for (; i < count; ++i)
+        GenerateParticleRandomScalar(seed, first + i, dest + i, count);
+}
+
+/// Sample texels bilinearly with clamp to edge at quad coordinates in [0, 1).
+static inline __m128 SampleTexels(const ParticleSpanArgs2D& args, float u, float v)
+{
+    // Coordinates are at least -0.5 texels, so truncating after adding one rounds down
+    float x = u * args.texWidth_ - 0.5f;
+    float y = v * args.texHeight_ - 0.5f;
+    int x0 = (int)(x + 1.0f) - 1;
+    int y0 = (int)(y + 1.0f) - 1;
+    __m128 fx = _mm_set1_ps(x - x0);
+    __m128 fy = _mm_set1_ps(y - y0);
+    int xa = x0 < 0 ? 0 : x0;
+    int xb = x0 + 1 < args.texWidth_ ? x0 + 1 : args.texWidth_ - 1;
+    int ya = y0 < 0 ? 0 : y0;
+    int yb = y0 + 1 < args.texHeight_ ? y0 + 1 : args.texHeight_ - 1;
+
+    __m128 t00 = _mm_loadu_ps(args.texels_ + (ya * args.texWidth_ + xa) * 4);
+    __m128 t01 = _mm_loadu_ps(args.texels_ + (ya * args.texWidth_ + xb) * 4);
+    __m128 t10 = _mm_loadu_ps(args.texels_ + (yb * args.texWidth_ + xa) * 4);
+    __m128 t11 = _mm_loadu_ps(args.texels_ + (yb * args.texWidth_ + xb) * 4);
+    __m128 top = _mm_add_ps(t00, _mm_mul_ps(_mm_sub_ps(t01, t00), fx));
+    __m128 bottom = _mm_add_ps(t10, _mm_mul_ps(_mm_sub_ps(t11, t10), fx));
+    return _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), fy));
+}
+
+unsigned RasterizeParticleSpanSSE2(const ParticleSpanArgs2D& args)
+{
+    const float* f = args.blend_;
+    __m128 color = _mm_loadu_ps(args.color_);
+    __m128 srcConstant = _mm_set1_ps(f[0]);
+    __m128 srcBySrcAlpha = _mm_set1_ps(f[1]);
+    __m128 srcByDestAlpha = _mm_set1_ps(f[2]);
+    __m128 srcByDest = _mm_set1_ps(f[3]);
+    __m128 destConstant = _mm_set1_ps(f[4]);
+    __m128 destBySrcAlpha = _mm_set1_ps(f[5]);
+    __m128 destByDestAlpha = _mm_set1_ps(f[6]);
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+
+    unsigned covered = 0;
+    for (unsigned i = 0; i < args.count_; ++i)
+    {
+        float u = args.u_ + args.dudx_ * i;
+        float v = args.v_ + args.dvdx_ * i;
+        if (!(u >= 0.0f && u < 1.0f && v >= 0.0f && v < 1.0f))
+            continue;
+        ++covered;
+
+        __m128 src = _mm_mul_ps(SampleTexels(args, u, v), color);
+        float* dest = args.dest_ + i * 4;
+        __m128 destColor = _mm_loadu_ps(dest);
+        __m128 srcAlpha = _mm_shuffle_ps(src, src, _MM_SHUFFLE(3, 3, 3, 3));
+        __m128 destAlpha = _mm_shuffle_ps(destColor, destColor, _MM_SHUFFLE(3, 3, 3, 3));
+
+        __m128 srcScale = _mm_add_ps(_mm_add_ps(srcConstant, _mm_mul_ps(srcBySrcAlpha, srcAlpha)),
+            _mm_mul_ps(srcByDestAlpha, destAlpha));
+        __m128 destScale = _mm_add_ps(_mm_add_ps(destConstant, _mm_mul_ps(destBySrcAlpha, srcAlpha)),
+            _mm_mul_ps(destByDestAlpha, destAlpha));
+        __m128 blended = _mm_add_ps(_mm_mul_ps(src, _mm_add_ps(srcScale, _mm_mul_ps(srcByDest, destColor))),
+            _mm_mul_ps(destColor, destScale));
+        _mm_storeu_ps(dest, _mm_min_ps(_mm_max_ps(blended, zero), one));
+    }
+    return covered;
+}
+
+}
+
+#endif
@@ -0,0 +1,162 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Color.h"
+#include "Context.h"
+#include "ParticleOverdraw2D.h"
+#include "ParticleRasterizer2D.h"
+
+namespace Urho3D
+{
+
+/// Heatmap opacity.
+static const float HEATMAP_ALPHA = 0.75f;
+
+/// Heatmap colors of pixels filled 1, 2, 4, 8, 16 and 32 or more times. Counts in between are interpolated.
+static const Color heatmapColors[] =
+{
+    Color(0.0f, 0.0f, 0.5f),
+    Color(0.0f, 0.5f, 1.0f),
+    Color(0.0f, 1.0f, 0.0f),
+    Color(1.0f, 1.0f, 0.0f),
+    Color(1.0f, 0.0f, 0.0f),
+    Color(1.0f, 1.0f, 1.0f)
+};
+
+/// Number of heatmap colors.
+static const unsigned NUM_HEATMAP_COLORS = sizeof(heatmapColors) / sizeof(heatmapColors[0]);
+
+/// Return heatmap color of a pixel filled count times, interpolated on a log2 scale.
+static Color GetHeatmapColor(unsigned count)
+{
+    float level = log2f((float)count);
+    unsigned index = (unsigned)level;
+    if (index + 1 >= NUM_HEATMAP_COLORS)
+        return heatmapColors[NUM_HEATMAP_COLORS - 1];
+
+    return heatmapColors[index].Lerp(heatmapColors[index + 1], level - index);
+}
+
+ParticleOverdraw2D::ParticleOverdraw2D(Context* context) :
+    Object(context),
+    rasterizer_(new ParticleRasterizer2D(context)),
+    numFragments_(0),
+    numCoveredPixels_(0),
+    maxOverdraw_(0)
+{
+    histogram_.Resize(MAX_OVERDRAW_BINS);
+    Clear();
+}
+
+ParticleOverdraw2D::~ParticleOverdraw2D()
+{
+}
+
+void ParticleOverdraw2D::SetSize(int width, int height)
+{
+    rasterizer_->SetSize(width, height);
+    coverage_.Resize(GetWidth() * GetHeight());
+    heatmap_.Resize(GetWidth() * GetHeight() * 4);
+    Clear();
+}
+
+void ParticleOverdraw2D::SetView(const Rect& rect)
+{
+    rasterizer_->SetView(rect);
+}
+
+void ParticleOverdraw2D::Clear()
+{
+    if (!coverage_.Empty())
+        memset(&coverage_[0], 0, coverage_.Size() * sizeof(unsigned));
+    if (!heatmap_.Empty())
+        memset(&heatmap_[0], 0, heatmap_.Size());
+    for (unsigned i = 0; i < MAX_OVERDRAW_BINS; ++i)
+        histogram_[i] = 0;
+
+    numFragments_ = 0;
+    numCoveredPixels_ = 0;
+    maxOverdraw_ = 0;
+}
+
+unsigned ParticleOverdraw2D::Accumulate(const ParticlePool2D& particles)
+{
+    unsigned numFragments = rasterizer_->DrawCoverage(particles, coverage_);
+    numFragments_ += numFragments;
+    return numFragments;
+}
+
+void ParticleOverdraw2D::Resolve()
+{
+    for (unsigned i = 0; i < MAX_OVERDRAW_BINS; ++i)
+        histogram_[i] = 0;
+    numCoveredPixels_ = 0;
+    maxOverdraw_ = 0;
+
+    // Colors are looked up per count, the last one covers everything above
+    unsigned char palette[(MAX_OVERDRAW_BINS * 2 + 1) * 4];
+    for (unsigned count = 1; count <= MAX_OVERDRAW_BINS * 2; ++count)
+    {
+        Color color = GetHeatmapColor(count);
+        unsigned char* dest = &palette[count * 4];
+        dest[0] = (unsigned char)(color.r_ * 255.0f + 0.5f);
+        dest[1] = (unsigned char)(color.g_ * 255.0f + 0.5f);
+        dest[2] = (unsigned char)(color.b_ * 255.0f + 0.5f);
+        dest[3] = (unsigned char)(HEATMAP_ALPHA * 255.0f + 0.5f);
+    }
+    palette[0] = palette[1] = palette[2] = palette[3] = 0;
+
+    for (unsigned i = 0; i < coverage_.Size(); ++i)
+    {
+        unsigned count = coverage_[i];
+        const unsigned char* source = &palette[Min(count, MAX_OVERDRAW_BINS * 2) * 4];
+        unsigned char* dest = &heatmap_[i * 4];
+        dest[0] = source[0];
+        dest[1] = source[1];
+        dest[2] = source[2];
+        dest[3] = source[3];
+
+        if (!count)
+            continue;
+
+        ++histogram_[Min(count, MAX_OVERDRAW_BINS) - 1];
+        ++numCoveredPixels_;
+        maxOverdraw_ = Max(maxOverdraw_, count);
+    }
+}
+
+int ParticleOverdraw2D::GetWidth() const
+{
+    return rasterizer_->GetWidth();
+}
+
+int ParticleOverdraw2D::GetHeight() const
+{
+    return rasterizer_->GetHeight();
+}
+
+float ParticleOverdraw2D::GetPixelsPerUnit() const
+{
+    return rasterizer_->GetPixelsPerUnit();
+}
+
+}
@@ -0,0 +1,97 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Object.h"
+#include "Rect.h"
+
+namespace Urho3D
+{
+
+class ParticlePool2D;
+class ParticleRasterizer2D;
+
+/// Number of overdraw histogram bins. The last bin counts pixels drawn at least this many times.
+static const unsigned MAX_OVERDRAW_BINS = 16;
+
+/// Overdraw map of particle quads. Counts how many times each pixel of a view is filled and resolves the counts into a heatmap
+/// and a histogram, so effects with few large particles show the fill cost their normal render hides.
+class ParticleOverdraw2D : public Object
+{
+    OBJECT(ParticleOverdraw2D)
+
+public:
+    /// Construct.
+    ParticleOverdraw2D(Context* context);
+    /// Destruct.
+    virtual ~ParticleOverdraw2D();
+
+    /// Set map size in pixels and clear it.
+    void SetSize(int width, int height);
+    /// Set world rectangle to cover. It is scaled uniformly to fit the map and centered.
+    void SetView(const Rect& rect);
+
+    /// Clear coverage and statistics.
+    void Clear();
+    /// Add the quads of particles to the coverage. Return number of fragments they fill.
+    unsigned Accumulate(const ParticlePool2D& particles);
+    /// Compute heatmap and histogram of the coverage accumulated since clear.
+    void Resolve();
+
+    /// Return width.
+    int GetWidth() const;
+    /// Return height.
+    int GetHeight() const;
+    /// Return pixels per world unit.
+    float GetPixelsPerUnit() const;
+    /// Return heatmap as RGBA bytes, top row first. Pixels that are not covered are transparent.
+    const PODVector<unsigned char>& GetHeatmap() const { return heatmap_; }
+    /// Return number of pixels by how many times they are filled. Bin 0 holds pixels filled once.
+    const PODVector<unsigned>& GetHistogram() const { return histogram_; }
+    /// Return fragments filled since clear.
+    unsigned GetNumFragments() const { return numFragments_; }
+    /// Return number of pixels filled at least once.
+    unsigned GetNumCoveredPixels() const { return numCoveredPixels_; }
+    /// Return most times a pixel is filled.
+    unsigned GetMaxOverdraw() const { return maxOverdraw_; }
+    /// Return mean times a covered pixel is filled.
+    float GetMeanOverdraw() const { return numCoveredPixels_ ? (float)numFragments_ / numCoveredPixels_ : 0.0f; }
+
+private:
+    /// Rasterizer that maps particles to pixels.
+    SharedPtr<ParticleRasterizer2D> rasterizer_;
+    /// Times each pixel is filled.
+    PODVector<unsigned> coverage_;
+    /// Heatmap.
+    PODVector<unsigned char> heatmap_;
+    /// Histogram.
+    PODVector<unsigned> histogram_;
+    /// Fragments filled.
+    unsigned numFragments_;
+    /// Pixels filled at least once.
+    unsigned numCoveredPixels_;
+    /// Most times a pixel is filled.
+    unsigned maxOverdraw_;
+};
+
+}
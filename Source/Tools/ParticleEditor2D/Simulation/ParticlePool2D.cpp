@@ -0,0 +1,99 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "ParticlePool2D.h"
+
+namespace Urho3D
+{
+
+/// Stream alignment in floats.
+static const unsigned STREAM_ALIGNMENT = 8;
+
+ParticlePool2D::Chunk::Chunk() :
+    allocation_(new float[PARTICLE_CHUNK_SIZE * MAX_PARTICLE_STREAMS + STREAM_ALIGNMENT])
+{
+    // Over-allocated so that the first stream can be moved to a 32-byte boundary. The chunk size is a multiple of the
+    // alignment, so every other stream is aligned as well
+    size_t address = (size_t)allocation_.Get();
+    data_ = (float*)((address + STREAM_ALIGNMENT * sizeof(float) - 1) & ~(size_t)(STREAM_ALIGNMENT * sizeof(float) - 1));
+}
+
+ParticlePool2D::ParticlePool2D() :
+    capacity_(0),
+    size_(0)
+{
+}
+
+ParticlePool2D::~ParticlePool2D()
+{
+}
+
+void ParticlePool2D::SetCapacity(unsigned capacity)
+{
+    capacity_ = capacity;
+
+    // The chunk table is sized up front, so that only the chunks themselves are allocated while the pool grows
+    unsigned maxChunks = (capacity_ + PARTICLE_CHUNK_SIZE - 1) / PARTICLE_CHUNK_SIZE;
+    if (chunks_.Capacity() < maxChunks)
+        chunks_.Reserve(maxChunks);
+}
+
+unsigned ParticlePool2D::Allocate()
+{
+    if (size_ >= capacity_)
+        return M_MAX_UNSIGNED;
+
+    if (size_ >= chunks_.Size() * PARTICLE_CHUNK_SIZE)
+        chunks_.Push(Chunk());
+
+    return size_++;
+}
+
+void ParticlePool2D::Remove(unsigned index)
+{
+    if (index >= size_)
+        return;
+
+    --size_;
+    if (index == size_)
+        return;
+
+    const float* source = chunks_[size_ / PARTICLE_CHUNK_SIZE].Get() + size_ % PARTICLE_CHUNK_SIZE;
+    float* dest = chunks_[index / PARTICLE_CHUNK_SIZE].Get() + index % PARTICLE_CHUNK_SIZE;
+    for (unsigned i = 0; i < MAX_PARTICLE_STREAMS; ++i)
+        dest[i * PARTICLE_CHUNK_SIZE] = source[i * PARTICLE_CHUNK_SIZE];
+}
+
+void ParticlePool2D::Clear()
+{
+    size_ = 0;
+}
+
+void ParticlePool2D::Trim()
+{
+    unsigned maxChunks = Min(GetNumChunks() + 1, (capacity_ + PARTICLE_CHUNK_SIZE - 1) / PARTICLE_CHUNK_SIZE);
+    maxChunks = Max(maxChunks, GetNumChunks());
+    while (chunks_.Size() > maxChunks)
+        chunks_.Pop();
+}
+
+}
@@ -0,0 +1,143 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "ArrayPtr.h"
+#include "MathDefs.h"
+#include "Vector.h"
+
+namespace Urho3D
+{
+
+/// Particle attribute stream.
+enum ParticleStream2D
+{
+    PS_TIME_TO_LIVE = 0,
+    PS_POSITION_X,
+    PS_POSITION_Y,
+    PS_SIZE,
+    PS_SIZE_DELTA,
+    PS_ROTATION,
+    PS_ROTATION_DELTA,
+    PS_COLOR_R,
+    PS_COLOR_G,
+    PS_COLOR_B,
+    PS_COLOR_A,
+    PS_COLOR_DELTA_R,
+    PS_COLOR_DELTA_G,
+    PS_COLOR_DELTA_B,
+    PS_COLOR_DELTA_A,
+    // EMITTER_TYPE_GRAVITY parameters
+    PS_START_X,
+    PS_START_Y,
+    PS_VELOCITY_X,
+    PS_VELOCITY_Y,
+    PS_RADIAL_ACCELERATION,
+    PS_TANGENTIAL_ACCELERATION,
+    // EMITTER_TYPE_RADIAL parameters
+    PS_EMIT_RADIUS,
+    PS_EMIT_RADIUS_DELTA,
+    PS_EMIT_ROTATION,
+    PS_EMIT_ROTATION_DELTA,
+    // Position before the last step, for interpolating between fixed steps
+    PS_PREVIOUS_X,
+    PS_PREVIOUS_Y,
+    MAX_PARTICLE_STREAMS
+};
+
+/// Number of particles per chunk.
+static const unsigned PARTICLE_CHUNK_SIZE = 1024;
+
+/// Structure-of-arrays particle storage, allocated in fixed size chunks. Each chunk holds one 32-byte aligned stream per
+/// attribute. Growing adds chunks, so live particles are never reallocated. Chunks stay allocated until Trim(), so once the pool
+/// has reached its peak size, allocating and removing particles does not touch the heap.
+class ParticlePool2D
+{
+public:
+    /// Construct.
+    ParticlePool2D();
+    /// Destruct.
+    ~ParticlePool2D();
+
+    /// Set capacity. Live particles beyond the new capacity are kept until removed, but no new ones can be allocated. Allocated
+    /// chunks are kept, so lowering and raising the capacity again does not reallocate.
+    void SetCapacity(unsigned capacity);
+    /// Add a particle and return its index, or M_MAX_UNSIGNED if full. Attributes are left uninitialized.
+    unsigned Allocate();
+    /// Remove particle by moving the last particle into its slot.
+    void Remove(unsigned index);
+    /// Remove all particles. Allocated chunks are kept for the next ones.
+    void Clear();
+    /// Release chunks that are no longer needed, keeping one spare to avoid churn at a chunk boundary. Not called while stepping.
+    void Trim();
+
+    /// Return capacity.
+    unsigned GetCapacity() const { return capacity_; }
+    /// Return number of live particles.
+    unsigned GetSize() const { return size_; }
+    /// Return number of chunks holding live particles.
+    unsigned GetNumChunks() const { return (size_ + PARTICLE_CHUNK_SIZE - 1) / PARTICLE_CHUNK_SIZE; }
+    /// Return number of allocated chunks.
+    unsigned GetNumAllocatedChunks() const { return chunks_.Size(); }
+    /// Return number of live particles in chunk.
+    unsigned GetChunkSize(unsigned chunk) const { return Min(size_ - chunk * PARTICLE_CHUNK_SIZE, PARTICLE_CHUNK_SIZE); }
+    /// Return attribute stream of chunk.
+    float* GetStream(unsigned chunk, ParticleStream2D stream) { return chunks_[chunk].Get() + stream * PARTICLE_CHUNK_SIZE; }
+    /// Return attribute stream of chunk.
+    const float* GetStream(unsigned chunk, ParticleStream2D stream) const { return chunks_[chunk].Get() + stream * PARTICLE_CHUNK_SIZE; }
+    /// Return attribute of particle.
+    float& Get(ParticleStream2D stream, unsigned index) { return GetStream(index / PARTICLE_CHUNK_SIZE, stream)[index % PARTICLE_CHUNK_SIZE]; }
+    /// Return attribute of particle.
+    float Get(ParticleStream2D stream, unsigned index) const { return GetStream(index / PARTICLE_CHUNK_SIZE, stream)[index % PARTICLE_CHUNK_SIZE]; }
+
+private:
+    /// Prevent copy construction.
+    ParticlePool2D(const ParticlePool2D& rhs);
+    /// Prevent assignment.
+    ParticlePool2D& operator = (const ParticlePool2D& rhs);
+
+    /// Aligned chunk storage.
+    class Chunk
+    {
+    public:
+        /// Construct and allocate.
+        Chunk();
+        /// Return aligned stream storage.
+        float* Get() const { return data_; }
+
+    private:
+        /// Allocation.
+        SharedArrayPtr<float> allocation_;
+        /// Aligned start of allocation.
+        float* data_;
+    };
+
+    /// Chunks.
+    Vector<Chunk> chunks_;
+    /// Capacity.
+    unsigned capacity_;
+    /// Number of live particles.
+    unsigned size_;
+};
+
+}
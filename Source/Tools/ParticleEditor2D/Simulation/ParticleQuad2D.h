@@ -0,0 +1,73 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Drawable2D.h"
+
+namespace Urho3D
+{
+
+/// Half the diagonal of a unit quad. Scaled by the particle size it covers the quad at any rotation.
+static const float PARTICLE_QUAD_HALF_DIAGONAL = 0.7071068f;
+
+/// Return corner offsets of a particle quad rotated by angle degrees. The corners are at (-sub, -add), (-add, sub), (sub, add)
+/// and (add, -sub) from the center.
+inline void GetParticleQuadOffsets(float size, float angle, float& add, float& sub)
+{
+    float c = Cos(-angle);
+    float s = Sin(-angle);
+    add = (c + s) * size * 0.5f;
+    sub = (c - s) * size * 0.5f;
+}
+
+/// Write the four vertices of a particle quad from its center and corner offsets.
+inline void WriteParticleQuad(Vertex2D* vertex, float x, float y, float add, float sub, unsigned color, const Rect& textureRect)
+{
+    vertex[0].position_ = Vector3(x - sub, y - add, 0.0f);
+    vertex[0].color_ = color;
+    vertex[0].uv_ = Vector2(textureRect.min_.x_, textureRect.max_.y_);
+
+    vertex[1].position_ = Vector3(x - add, y + sub, 0.0f);
+    vertex[1].color_ = color;
+    vertex[1].uv_ = textureRect.min_;
+
+    vertex[2].position_ = Vector3(x + sub, y + add, 0.0f);
+    vertex[2].color_ = color;
+    vertex[2].uv_ = Vector2(textureRect.max_.x_, textureRect.min_.y_);
+
+    vertex[3].position_ = Vector3(x + add, y - sub, 0.0f);
+    vertex[3].color_ = color;
+    vertex[3].uv_ = textureRect.max_;
+}
+
+/// Grow bounds to cover a particle quad at any rotation.
+inline void MergeParticleQuadBounds(Vector2& minPoint, Vector2& maxPoint, float x, float y, float size)
+{
+    float halfSize = size * PARTICLE_QUAD_HALF_DIAGONAL;
+    minPoint.x_ = Min(minPoint.x_, x - halfSize);
+    minPoint.y_ = Min(minPoint.y_, y - halfSize);
+    maxPoint.x_ = Max(maxPoint.x_, x + halfSize);
+    maxPoint.y_ = Max(maxPoint.y_, y + halfSize);
+}
+
+}
@@ -0,0 +1,105 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "ParticleRandom2D.h"
+
+namespace Urho3D
+{
+
+/// Convert random bits to a float in [-1, 1). Uses the top 24 bits so the conversion is exact.
+static inline float ToFloat(unsigned bits)
+{
+    return (float)(bits >> 8) * (1.0f / 8388608.0f) - 1.0f;
+}
+
+static inline void MulHiLo(unsigned a, unsigned b, unsigned& hi, unsigned& lo)
+{
+    unsigned long long product = (unsigned long long)a * b;
+    hi = (unsigned)(product >> 32);
+    lo = (unsigned)product;
+}
+
+void Philox4x32(const unsigned counter[4], const unsigned key[2], unsigned result[4])
+{
+    unsigned x0 = counter[0];
+    unsigned x1 = counter[1];
+    unsigned x2 = counter[2];
+    unsigned x3 = counter[3];
+    unsigned k0 = key[0];
+    unsigned k1 = key[1];
+
+    for (unsigned round = 0; round < PHILOX_ROUNDS; ++round)
+    {
+        unsigned hi0, lo0, hi1, lo1;
+        MulHiLo(PHILOX_M0, x0, hi0, lo0);
+        MulHiLo(PHILOX_M1, x2, hi1, lo1);
+
+        x0 = hi1 ^ x1 ^ k0;
+        x1 = lo1;
+        x2 = hi0 ^ x3 ^ k1;
+        x3 = lo0;
+
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    result[0] = x0;
+    result[1] = x1;
+    result[2] = x2;
+    result[3] = x3;
+}
+
+float GetParticleRandom(unsigned seed, unsigned spawnIndex, ParticleRandomChannel2D channel)
+{
+    // Counter is (spawn index, block), so every particle owns its own stream and no state is shared
+    unsigned counter[4] = { spawnIndex, (unsigned)channel / PARTICLE_RANDOM_BLOCK_SIZE, 0, 0 };
+    unsigned key[2] = { seed, 0 };
+    unsigned result[4];
+    Philox4x32(counter, key, result);
+    return ToFloat(result[channel % PARTICLE_RANDOM_BLOCK_SIZE]);
+}
+
+void GenerateParticleRandomScalar(unsigned seed, unsigned spawnIndex, float* dest, unsigned stride)
+{
+    unsigned key[2] = { seed, 0 };
+    for (unsigned block = 0; block < NUM_PARTICLE_RANDOM_BLOCKS; ++block)
+    {
+        unsigned counter[4] = { spawnIndex, block, 0, 0 };
+        unsigned result[4];
+        Philox4x32(counter, key, result);
+
+        for (unsigned i = 0; i < PARTICLE_RANDOM_BLOCK_SIZE; ++i)
+        {
+            unsigned channel = block * PARTICLE_RANDOM_BLOCK_SIZE + i;
+            if (channel < MAX_PARTICLE_RANDOM_CHANNELS)
+                dest[channel * stride] = ToFloat(result[i]);
+        }
+    }
+}
+
+void GenerateParticleRandomsScalar(unsigned seed, unsigned first, unsigned count, float* dest)
+{
+    for (unsigned i = 0; i < count; ++i)
+        GenerateParticleRandomScalar(seed, first + i, dest + i, count);
+}
+
+}
@@ -0,0 +1,74 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+namespace Urho3D
+{
+
+/// Random value channel of a spawned particle. Each channel is an independent value in [-1, 1).
+enum ParticleRandomChannel2D
+{
+    PRC_LIFESPAN = 0,
+    PRC_POSITION_X,
+    PRC_POSITION_Y,
+    PRC_ANGLE,
+    PRC_SPEED,
+    PRC_MAX_RADIUS,
+    PRC_MIN_RADIUS,
+    PRC_EMIT_ROTATION,
+    PRC_ROTATE_PER_SECOND,
+    PRC_RADIAL_ACCELERATION,
+    PRC_TANGENTIAL_ACCELERATION,
+    PRC_START_SIZE,
+    PRC_FINISH_SIZE,
+    PRC_START_COLOR,
+    PRC_FINISH_COLOR,
+    PRC_START_ROTATION,
+    PRC_END_ROTATION,
+    MAX_PARTICLE_RANDOM_CHANNELS
+};
+
+/// Number of values produced by one Philox block.
+static const unsigned PARTICLE_RANDOM_BLOCK_SIZE = 4;
+/// Number of Philox blocks needed for all channels.
+static const unsigned NUM_PARTICLE_RANDOM_BLOCKS = (MAX_PARTICLE_RANDOM_CHANNELS + PARTICLE_RANDOM_BLOCK_SIZE - 1) / PARTICLE_RANDOM_BLOCK_SIZE;
+
+/// Philox4x32-10 multipliers.
+static const unsigned PHILOX_M0 = 0xD2511F53;
+static const unsigned PHILOX_M1 = 0xCD9E8D57;
+/// Philox4x32-10 key increments.
+static const unsigned PHILOX_W0 = 0x9E3779B9;
+static const unsigned PHILOX_W1 = 0xBB67AE85;
+/// Philox4x32-10 round count.
+static const unsigned PHILOX_ROUNDS = 10;
+
+/// Run Philox4x32-10 on a counter with a key. Output is a pure function of the inputs.
+void Philox4x32(const unsigned counter[4], const unsigned key[2], unsigned result[4]);
+/// Return a random value in [-1, 1) for a channel of a spawned particle. Same seed, spawn index and channel always give the same value.
+float GetParticleRandom(unsigned seed, unsigned spawnIndex, ParticleRandomChannel2D channel);
+/// Generate all channels of one spawned particle. Channel c is written to dest[c * stride].
+void GenerateParticleRandomScalar(unsigned seed, unsigned spawnIndex, float* dest, unsigned stride);
+/// Generate all channels for count consecutive spawn indices, scalar reference. Channel c of spawn first + i is written to dest[c * count + i].
+void GenerateParticleRandomsScalar(unsigned seed, unsigned first, unsigned count, float* dest);
+
+}
@@ -0,0 +1,468 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Context.h"
+#include "File.h"
+#include "FileSystem.h"
+#include "Image.h"
+#include "Log.h"
+#include "ParticleEffect2D.h"
+#include "ParticleEffectSettings2D.h"
+#include "ParticleQuad2D.h"
+#include "ParticleRasterizer2D.h"
+#include "ParticleSimulator2D.h"
+#include "XMLFile.h"
+
+namespace Urho3D
+{
+
+/// Simulation step of thumbnails for emitters that can not be evaluated in closed form.
+static const float THUMBNAIL_TIME_STEP = 1.0f / 60.0f;
+/// Space around the particles of a thumbnail as a fraction of their extent.
+static const float THUMBNAIL_MARGIN = 0.1f;
+/// Smallest half extent of a thumbnail view in world units.
+static const float MIN_THUMBNAIL_EXTENT = 0.25f;
+
+/// Blend factors of each blend mode in the form the span kernels take, matching the engine's blend states.
+static const float blendFactors[MAX_BLENDMODES][8] =
+{
+    // Replace: source
+    { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f },
+    // Add: source + dest
+    { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f },
+    // Multiply: source * dest
+    { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f },
+    // Alpha: source * srcAlpha + dest * (1 - srcAlpha)
+    { 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f },
+    // Add alpha: source * srcAlpha + dest
+    { 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f },
+    // Premultiplied alpha: source + dest * (1 - srcAlpha)
+    { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f },
+    // Inverse destination alpha: source * (1 - destAlpha) + dest * destAlpha
+    { 1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f },
+    // Subtract: dest - source
+    { -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f },
+    // Subtract alpha: dest - source * srcAlpha
+    { 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f }
+};
+
+/// Narrow a span of pixels begin to end to those where value + step * pixel may be in [0, 1). One pixel of slack is left on
+/// each side, the kernels test every pixel exactly.
+static void ClipSpan(float value, float step, int& begin, int& end)
+{
+    if (Abs(step) < M_EPSILON)
+    {
+        if (value < 0.0f || value >= 1.0f)
+            end = begin;
+        return;
+    }
+
+    float first = -value / step;
+    float last = (1.0f - value) / step;
+    float low = Clamp(Min(first, last), (float)begin, (float)end);
+    float high = Clamp(Max(first, last), (float)begin, (float)end);
+    begin = Max(begin, (int)floorf(low));
+    end = Min(end, (int)ceilf(high) + 1);
+}
+
+ParticleRasterizer2D::ParticleRasterizer2D(Context* context) :
+    Object(context),
+    width_(0),
+    height_(0),
+    view_(-1.0f, -1.0f, 1.0f, 1.0f),
+    pixelsPerUnit_(1.0f),
+    texWidth_(0),
+    texHeight_(0),
+    kernels_(&SelectParticleKernels())
+{
+    SetTexture(0);
+}
+
+ParticleRasterizer2D::~ParticleRasterizer2D()
+{
+}
+
+void ParticleRasterizer2D::SetSize(int width, int height)
+{
+    width_ = Max(width, 0);
+    height_ = Max(height, 0);
+    pixels_.Clear();
+    SetView(view_);
+}
+
+void ParticleRasterizer2D::SetView(const Rect& rect)
+{
+    view_ = rect;
+
+    Vector2 size = rect.max_ - rect.min_;
+    pixelsPerUnit_ = Min(width_ / Max(size.x_, M_EPSILON), height_ / Max(size.y_, M_EPSILON));
+    pixelsPerUnit_ = Max(pixelsPerUnit_, M_EPSILON);
+
+    // The buffer's top row is the largest world Y
+    Vector2 center = (rect.min_ + rect.max_) * 0.5f;
+    origin_ = Vector2(center.x_ - 0.5f * width_ / pixelsPerUnit_, center.y_ + 0.5f * height_ / pixelsPerUnit_);
+}
+
+bool ParticleRasterizer2D::SetTexture(Image* image, const IntRect& rectangle)
+{
+    // One white texel draws solid squares
+    texWidth_ = 1;
+    texHeight_ = 1;
+    texels_.Resize(4);
+    for (unsigned i = 0; i < 4; ++i)
+        texels_[i] = 1.0f;
+
+    if (!image)
+        return true;
+
+    if (image->IsCompressed())
+    {
+        LOGERROR("Compressed textures can not be rasterized");
+        return false;
+    }
+
+    IntRect rect = rectangle;
+    if (rect.right_ <= rect.left_ || rect.bottom_ <= rect.top_)
+        rect = IntRect(0, 0, image->GetWidth(), image->GetHeight());
+    rect.left_ = Clamp(rect.left_, 0, image->GetWidth());
+    rect.right_ = Clamp(rect.right_, rect.left_, image->GetWidth());
+    rect.top_ = Clamp(rect.top_, 0, image->GetHeight());
+    rect.bottom_ = Clamp(rect.bottom_, rect.top_, image->GetHeight());
+    if (rect.Width() == 0 || rect.Height() == 0)
+        return false;
+
+    texWidth_ = rect.Width();
+    texHeight_ = rect.Height();
+    texels_.Resize(texWidth_ * texHeight_ * 4);
+
+    // Expand to RGBA the way the engine creates textures: one component is alpha, two are luminance and alpha
+    unsigned components = image->GetComponents();
+    const unsigned char* data = image->GetData();
+    for (int y = 0; y < texHeight_; ++y)
+    {
+        for (int x = 0; x < texWidth_; ++x)
+        {
+            const unsigned char* source = data + ((rect.top_ + y) * image->GetWidth() + rect.left_ + x) * components;
+            float* dest = &texels_[(y * texWidth_ + x) * 4];
+            switch (components)
+            {
+            case 1:
+                dest[0] = dest[1] = dest[2] = 0.0f;
+                dest[3] = source[0] / 255.0f;
+                break;
+
+            case 2:
+                dest[0] = dest[1] = dest[2] = source[0] / 255.0f;
+                dest[3] = source[1] / 255.0f;
+                break;
+
+            default:
+                dest[0] = source[0] / 255.0f;
+                dest[1] = source[1] / 255.0f;
+                dest[2] = source[2] / 255.0f;
+                dest[3] = components >= 4 ? source[3] / 255.0f : 1.0f;
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+void ParticleRasterizer2D::SetKernelLevel(ParticleKernelLevel2D level)
+{
+    kernels_ = &GetParticleKernels(level);
+}
+
+void ParticleRasterizer2D::Clear(const Color& color)
+{
+    float values[4] = { Clamp(color.r_, 0.0f, 1.0f), Clamp(color.g_, 0.0f, 1.0f), Clamp(color.b_, 0.0f, 1.0f),
+        Clamp(color.a_, 0.0f, 1.0f) };
+    pixels_.Resize(width_ * height_ * 4);
+    for (unsigned i = 0; i < pixels_.Size(); ++i)
+        pixels_[i] = values[i & 3];
+}
+
+unsigned ParticleRasterizer2D::Draw(const ParticlePool2D& particles, BlendMode blendMode)
+{
+    if (!width_ || !height_ || blendMode >= MAX_BLENDMODES)
+        return 0;
+    if (pixels_.Empty())
+        Clear(Color::TRANSPARENT);
+
+    ParticleSpanArgs2D args;
+    args.texels_ = &texels_[0];
+    args.texWidth_ = texWidth_;
+    args.texHeight_ = texHeight_;
+    for (unsigned i = 0; i < 8; ++i)
+        args.blend_[i] = blendFactors[blendMode][i];
+
+    return Rasterize(particles, args, 0);
+}
+
+unsigned ParticleRasterizer2D::DrawCoverage(const ParticlePool2D& particles, PODVector<unsigned>& coverage)
+{
+    if (!width_ || !height_)
+        return 0;
+
+    unsigned numPixels = (unsigned)(width_ * height_);
+    if (coverage.Size() != numPixels)
+    {
+        coverage.Resize(numPixels);
+        memset(&coverage[0], 0, numPixels * sizeof(unsigned));
+    }
+
+    ParticleSpanArgs2D args;
+    return Rasterize(particles, args, &coverage[0]);
+}
+
+unsigned ParticleRasterizer2D::Rasterize(const ParticlePool2D& particles, ParticleSpanArgs2D& args, unsigned* coverage)
+{
+    unsigned numPixels = 0;
+    for (unsigned chunk = 0; chunk < particles.GetNumChunks(); ++chunk)
+    {
+        const float* positionX = particles.GetStream(chunk, PS_POSITION_X);
+        const float* positionY = particles.GetStream(chunk, PS_POSITION_Y);
+        const float* size = particles.GetStream(chunk, PS_SIZE);
+        const float* rotation = particles.GetStream(chunk, PS_ROTATION);
+        const float* colorR = particles.GetStream(chunk, PS_COLOR_R);
+        const float* colorG = particles.GetStream(chunk, PS_COLOR_G);
+        const float* colorB = particles.GetStream(chunk, PS_COLOR_B);
+        const float* colorA = particles.GetStream(chunk, PS_COLOR_A);
+        unsigned chunkSize = particles.GetChunkSize(chunk);
+
+        for (unsigned i = 0; i < chunkSize; ++i)
+        {
+            // Negated so that NaN sizes are skipped too
+            float pixelSize = size[i] * pixelsPerUnit_;
+            if (!(pixelSize > 0.0f))
+                continue;
+
+            float x = (positionX[i] - origin_.x_) * pixelsPerUnit_;
+            float y = (origin_.y_ - positionY[i]) * pixelsPerUnit_;
+            float extent = pixelSize * PARTICLE_QUAD_HALF_DIAGONAL;
+            int left = Max((int)floorf(x - extent), 0);
+            int right = Min((int)ceilf(x + extent), width_);
+            int top = Max((int)floorf(y - extent), 0);
+            int bottom = Min((int)ceilf(y + extent), height_);
+            if (left >= right || top >= bottom)
+                continue;
+
+            // Same quad as the emitter's vertices: U runs along the rotated X axis, V down the rotated Y axis
+            float c = Cos(-rotation[i]);
+            float s = Sin(-rotation[i]);
+            float invSize = 1.0f / pixelSize;
+            args.dudx_ = c * invSize;
+            args.dvdx_ = s * invSize;
+            args.color_[0] = Clamp(colorR[i], 0.0f, 1.0f);
+            args.color_[1] = Clamp(colorG[i], 0.0f, 1.0f);
+            args.color_[2] = Clamp(colorB[i], 0.0f, 1.0f);
+            args.color_[3] = Clamp(colorA[i], 0.0f, 1.0f);
+
+            float dx = left + 0.5f - x;
+            for (int row = top; row < bottom; ++row)
+            {
+                float dy = row + 0.5f - y;
+                float u = 0.5f + (dx * c - dy * s) * invSize;
+                float v = 0.5f + (dx * s + dy * c) * invSize;
+
+                int begin = 0;
+                int end = right - left;
+                ClipSpan(u, args.dudx_, begin, end);
+                ClipSpan(v, args.dvdx_, begin, end);
+                if (begin >= end)
+                    continue;
+
+                args.count_ = (unsigned)(end - begin);
+                args.u_ = u + args.dudx_ * begin;
+                args.v_ = v + args.dvdx_ * begin;
+
+                if (coverage)
+                {
+                    // Same inside test as the span kernels
+                    unsigned* dest = coverage + row * width_ + left + begin;
+                    for (unsigned pixel = 0; pixel < args.count_; ++pixel)
+                    {
+                        float pu = args.u_ + args.dudx_ * pixel;
+                        float pv = args.v_ + args.dvdx_ * pixel;
+                        if (pu >= 0.0f && pu < 1.0f && pv >= 0.0f && pv < 1.0f)
+                        {
+                            ++dest[pixel];
+                            ++numPixels;
+                        }
+                    }
+                    continue;
+                }
+
+                args.dest_ = &pixels_[(row * width_ + left + begin) * 4];
+                numPixels += kernels_->span_(args);
+            }
+        }
+    }
+
+    return numPixels;
+}
+
+SharedPtr<Image> ParticleRasterizer2D::GetImage() const
+{
+    SharedPtr<Image> image(new Image(context_));
+    image->SetSize(width_, height_, 4);
+
+    unsigned char* data = image->GetData();
+    if (pixels_.Empty())
+        memset(data, 0, width_ * height_ * 4);
+    for (unsigned i = 0; i < pixels_.Size(); ++i)
+        data[i] = (unsigned char)(pixels_[i] * 255.0f + 0.5f);
+
+    return image;
+}
+
+Rect GetParticleBounds(const ParticlePool2D& particles)
+{
+    if (!particles.GetSize())
+        return Rect::ZERO;
+
+    Vector2 minPoint(M_INFINITY, M_INFINITY);
+    Vector2 maxPoint(-M_INFINITY, -M_INFINITY);
+    for (unsigned chunk = 0; chunk < particles.GetNumChunks(); ++chunk)
+    {
+        const float* positionX = particles.GetStream(chunk, PS_POSITION_X);
+        const float* positionY = particles.GetStream(chunk, PS_POSITION_Y);
+        const float* size = particles.GetStream(chunk, PS_SIZE);
+        unsigned chunkSize = particles.GetChunkSize(chunk);
+        for (unsigned i = 0; i < chunkSize; ++i)
+            MergeParticleQuadBounds(minPoint, maxPoint, positionX[i], positionY[i], Max(size[i], 0.0f));
+    }
+
+    return Rect(minPoint, maxPoint);
+}
+
+SharedPtr<Image> LoadParticleTextureImage(Context* context, const String& effectFileName, const String& textureName,
+    IntRect& rectangle)
+{
+    rectangle = IntRect::ZERO;
+    if (textureName.Empty())
+        return SharedPtr<Image>();
+
+    // Sprites of a sheet are named sheet.xml@sprite, relative to the effect like plain textures
+    String imageFileName = GetPath(effectFileName) + textureName;
+    unsigned separator = textureName.Find('@');
+    if (separator != String::NPOS)
+    {
+        String sheetFileName = GetPath(effectFileName) + textureName.Substring(0, separator);
+        String spriteName = textureName.Substring(separator + 1);
+
+        File sheetFile(context);
+        SharedPtr<XMLFile> xmlFile(new XMLFile(context));
+        if (!sheetFile.Open(sheetFileName) || !xmlFile->Load(sheetFile))
+            return SharedPtr<Image>();
+
+        XMLElement rootElem = xmlFile->GetRoot("TextureAtlas");
+        XMLElement subTextureElem = rootElem ? rootElem.GetChild("SubTexture") : XMLElement();
+        while (subTextureElem && subTextureElem.GetAttribute("name") != spriteName)
+            subTextureElem = subTextureElem.GetNext("SubTexture");
+        if (!subTextureElem)
+            return SharedPtr<Image>();
+
+        int x = subTextureElem.GetInt("x");
+        int y = subTextureElem.GetInt("y");
+        rectangle = IntRect(x, y, x + subTextureElem.GetInt("width"), y + subTextureElem.GetInt("height"));
+        imageFileName = GetPath(sheetFileName) + rootElem.GetAttribute("imagePath");
+    }
+
+    File file(context);
+    SharedPtr<Image> image(new Image(context));
+    if (!file.Open(imageFileName) || !image->Load(file))
+        return SharedPtr<Image>();
+
+    return image;
+}
+
+SharedPtr<Image> RenderParticleThumbnail(Context* context, ParticleEffect2D* effect, const ParticleEffectSettings2D& settings,
+    Image* texture, const IntRect& rectangle, int size, ParticleKernelLevel2D level)
+{
+    if (!effect)
+        return SharedPtr<Image>();
+
+    SharedPtr<ParticleSimulator2D> simulator(new ParticleSimulator2D(context));
+    simulator->SetKernelLevel(level);
+    simulator->SetRandomSeed(settings.GetRandomSeed());
+    simulator->SetEffect(effect);
+
+    float time = settings.GetPrewarmTime();
+    if (time <= 0.0f)
+    {
+        float lifespan = effect->GetParticleLifeSpan() + Max(effect->GetParticleLifespanVariance(), 0.0f);
+        time = effect->GetDuration() < 0.0f ? lifespan : Min(effect->GetDuration(), lifespan);
+    }
+    simulator->Seek(time, THUMBNAIL_TIME_STEP);
+
+    // Square view around the particles, so thumbnails of different effects are framed alike
+    const ParticlePool2D& particles = simulator->GetParticles();
+    Vector2 center = Vector2::ZERO;
+    float extent = MIN_THUMBNAIL_EXTENT;
+    if (particles.GetSize())
+    {
+        Rect bounds = GetParticleBounds(particles);
+        center = (bounds.min_ + bounds.max_) * 0.5f;
+        extent = Max(Max(bounds.max_.x_ - bounds.min_.x_, bounds.max_.y_ - bounds.min_.y_) * 0.5f * (1.0f + THUMBNAIL_MARGIN),
+            extent);
+    }
+
+    SharedPtr<ParticleRasterizer2D> rasterizer(new ParticleRasterizer2D(context));
+    rasterizer->SetKernelLevel(level);
+    rasterizer->SetSize(size, size);
+    rasterizer->SetView(Rect(center - Vector2(extent, extent), center + Vector2(extent, extent)));
+    rasterizer->SetTexture(texture, rectangle);
+    rasterizer->Clear(Color::BLACK);
+    rasterizer->Draw(particles, effect->GetBlendMode());
+    return rasterizer->GetImage();
+}
+
+unsigned CompareParticleImages(const Image* lhs, const Image* rhs, int tolerance, int& maxDifference)
+{
+    maxDifference = 0;
+    if (!lhs || !rhs || lhs->GetWidth() != rhs->GetWidth() || lhs->GetHeight() != rhs->GetHeight() ||
+        lhs->GetComponents() != rhs->GetComponents() || lhs->IsCompressed() || rhs->IsCompressed())
+        return M_MAX_UNSIGNED;
+
+    unsigned components = lhs->GetComponents();
+    unsigned numPixels = (unsigned)(lhs->GetWidth() * lhs->GetHeight());
+    const unsigned char* lhsData = lhs->GetData();
+    const unsigned char* rhsData = rhs->GetData();
+
+    unsigned numDifferent = 0;
+    for (unsigned i = 0; i < numPixels; ++i)
+    {
+        int pixelDifference = 0;
+        for (unsigned c = 0; c < components; ++c)
+            pixelDifference = Max(pixelDifference, Abs((int)lhsData[i * components + c] - (int)rhsData[i * components + c]));
+
+        maxDifference = Max(maxDifference, pixelDifference);
+        if (pixelDifference > tolerance)
+            ++numDifferent;
+    }
+
+    return numDifferent;
+}
+
+}
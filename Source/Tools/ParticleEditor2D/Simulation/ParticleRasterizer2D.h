@@ -0,0 +1,122 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "GraphicsDefs.h"
+#include "Object.h"
+#include "ParticleKernels2D.h"
+#include "Rect.h"
+
+namespace Urho3D
+{
+
+class Color;
+class Image;
+class ParticleEffect2D;
+class ParticleEffectSettings2D;
+
+/// CPU rasterizer for simulated particles. Draws the quads the emitter would submit, textured with the effect's sprite and
+/// blended with its blend mode, into an RGBA float buffer. Needs no window or GPU, so thumbnails and golden images can be
+/// rendered headless.
+class ParticleRasterizer2D : public Object
+{
+    OBJECT(ParticleRasterizer2D)
+
+public:
+    /// Construct.
+    ParticleRasterizer2D(Context* context);
+    /// Destruct.
+    virtual ~ParticleRasterizer2D();
+
+    /// Set buffer size in pixels. The buffer is allocated transparent black when first cleared or drawn to, so coverage
+    /// passes do not pay for it.
+    void SetSize(int width, int height);
+    /// Set world rectangle to draw. It is scaled uniformly to fit the buffer and centered.
+    void SetView(const Rect& rect);
+    /// Set texture from an image and a rectangle of it in pixels, the whole image if the rectangle is zero. Without a texture
+    /// particles are drawn as solid squares. Return true if successful.
+    bool SetTexture(Image* image, const IntRect& rectangle = IntRect::ZERO);
+    /// Set span kernel instruction set level. Unsupported levels fall back to scalar.
+    void SetKernelLevel(ParticleKernelLevel2D level);
+
+    /// Allocate buffer if necessary and fill it with color.
+    void Clear(const Color& color);
+    /// Draw particles in pool order with blend mode. Return number of pixels written.
+    unsigned Draw(const ParticlePool2D& particles, BlendMode blendMode);
+    /// Add the number of particle quads covering each pixel to coverage, one count per pixel of the buffer, without drawing.
+    /// Counts whole quads regardless of texture alpha, like the GPU fills them. Return number of pixels covered.
+    unsigned DrawCoverage(const ParticlePool2D& particles, PODVector<unsigned>& coverage);
+    /// Return buffer converted to an 8-bit RGBA image.
+    SharedPtr<Image> GetImage() const;
+
+    /// Return width.
+    int GetWidth() const { return width_; }
+    /// Return height.
+    int GetHeight() const { return height_; }
+    /// Return pixels, four floats each, top row first. Empty until cleared or drawn to.
+    const PODVector<float>& GetPixels() const { return pixels_; }
+    /// Return pixels per world unit.
+    float GetPixelsPerUnit() const { return pixelsPerUnit_; }
+
+private:
+    /// Rasterize particle quads row by row. Spans are drawn with the span kernel and args, or counted into coverage when given.
+    unsigned Rasterize(const ParticlePool2D& particles, ParticleSpanArgs2D& args, unsigned* coverage);
+
+    /// Buffer width.
+    int width_;
+    /// Buffer height.
+    int height_;
+    /// Pixels.
+    PODVector<float> pixels_;
+    /// World rectangle to draw.
+    Rect view_;
+    /// World position of the top left corner of the buffer.
+    Vector2 origin_;
+    /// Pixels per world unit.
+    float pixelsPerUnit_;
+    /// Texels, four floats each.
+    PODVector<float> texels_;
+    /// Texture width.
+    int texWidth_;
+    /// Texture height.
+    int texHeight_;
+    /// Span kernels.
+    const ParticleKernels2D* kernels_;
+};
+
+/// Return world bounds of the particle quads at any rotation. Return a zero rectangle if there are no particles.
+Rect GetParticleBounds(const ParticlePool2D& particles);
+/// Load the texture of an effect from the file system, resolving sprite sheet names. The rectangle is zero unless the texture
+/// is a sprite of a sheet. Return null if it could not be loaded.
+SharedPtr<Image> LoadParticleTextureImage(Context* context, const String& effectFileName, const String& textureName,
+    IntRect& rectangle);
+/// Simulate an effect at the origin to a representative time and render it into a square image framing its particles. The
+/// time is the prewarm time if set, one life span for effects that emit forever, otherwise the end of emission or one life
+/// span, whichever comes first. Return null if the effect is null.
+SharedPtr<Image> RenderParticleThumbnail(Context* context, ParticleEffect2D* effect, const ParticleEffectSettings2D& settings,
+    Image* texture, const IntRect& rectangle, int size, ParticleKernelLevel2D level);
+/// Compare two images of the same size channel by channel. Return number of pixels that differ by more than tolerance, or
+/// M_MAX_UNSIGNED if sizes or channel counts differ. Largest difference goes to maxDifference.
+unsigned CompareParticleImages(const Image* lhs, const Image* rhs, int tolerance, int& maxDifference);
+
+}
@@ -0,0 +1,610 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Context.h"
+#include "Drawable2D.h"
+#include "MathDefs.h"
+#include "ParticleEffect2D.h"
+#include "ParticleSimulator2D.h"
+
+#include <cstring>
+
+namespace Urho3D
+{
+
+/// Number of spawn slots whose random channels Seek() generates at once.
+static const unsigned SEEK_BATCH_SIZE = 1024;
+/// Largest spawn slot count Seek() steps through. Keeps the slot loop and the float conversions in range.
+static const unsigned MAX_SEEK_SLOTS = 0x7fffffff;
+/// Sub-step of the pre-warm seek for emitters that cannot be evaluated in closed form.
+static const float PREWARM_TIME_STEP = 1.0f / 60.0f;
+
+/// Round a spawn slot position up to a slot count, clamped to what Seek() can step through. NaN gives zero.
+static unsigned CeilSeekSlots(float slots)
+{
+    if (!(slots > 0.0f))
+        return 0;
+    return slots < (float)MAX_SEEK_SLOTS ? (unsigned)ceilf(slots) : MAX_SEEK_SLOTS;
+}
+
+/// Push a value onto a binary min-heap.
+static void PushHeap(PODVector<float>& heap, float value)
+{
+    heap.Push(value);
+    unsigned index = heap.Size() - 1;
+    while (index)
+    {
+        unsigned parent = (index - 1) / 2;
+        if (heap[parent] <= value)
+            break;
+        heap[index] = heap[parent];
+        index = parent;
+    }
+    heap[index] = value;
+}
+
+/// Remove the smallest value of a binary min-heap.
+static void PopHeap(PODVector<float>& heap)
+{
+    float value = heap.Back();
+    heap.Pop();
+    if (heap.Empty())
+        return;
+
+    unsigned index = 0;
+    for (;;)
+    {
+        unsigned child = index * 2 + 1;
+        if (child >= heap.Size())
+            break;
+        if (child + 1 < heap.Size() && heap[child + 1] < heap[child])
+            ++child;
+        if (value <= heap[child])
+            break;
+        heap[index] = heap[child];
+        index = child;
+    }
+    heap[index] = value;
+}
+
+ParticleSimulator2D::ParticleSimulator2D(Context* context) :
+    Object(context),
+    position_(Vector2::ZERO),
+    angle_(0.0f),
+    scale_(1.0f),
+    kernels_(&SelectParticleKernels()),
+    emissionTime_(0.0f),
+    emitParticleTime_(0.0f),
+    elapsedTime_(0.0f),
+    startDelay_(0.0f),
+    prewarmTime_(0.0f),
+    particleScale_(1.0f),
+    spawnScale_(1.0f),
+    numEmitted_(0),
+    numSpawns_(0),
+    randomSeed_(0),
+    trackIds_(false),
+    numPending_(0),
+    pendingTimeStep_(0.0f),
+    pendingWorldScale_(0.0f)
+{
+}
+
+ParticleSimulator2D::~ParticleSimulator2D()
+{
+}
+
+void ParticleSimulator2D::SetEffect(ParticleEffect2D* effect)
+{
+    effect_ = effect;
+    if (!effect_)
+    {
+        pool_.SetCapacity(0);
+        pool_.Trim();
+        return;
+    }
+
+    // Chunks sized for the previous effect are released here rather than while stepping
+    SetMaxParticles((unsigned)Max(effect_->GetMaxParticles(), 1));
+    Reset();
+    pool_.Trim();
+}
+
+void ParticleSimulator2D::SetMaxParticles(unsigned maxParticles)
+{
+    pool_.SetCapacity(Max(maxParticles, 1U));
+}
+
+void ParticleSimulator2D::SetPosition(const Vector2& position)
+{
+    position_ = position;
+}
+
+void ParticleSimulator2D::SetAngle(float angle)
+{
+    angle_ = angle;
+}
+
+void ParticleSimulator2D::SetScale(float scale)
+{
+    scale_ = scale;
+}
+
+void ParticleSimulator2D::SetRandomSeed(unsigned seed)
+{
+    randomSeed_ = seed;
+}
+
+void ParticleSimulator2D::SetKernelLevel(ParticleKernelLevel2D level)
+{
+    kernels_ = &GetParticleKernels(level);
+}
+
+void ParticleSimulator2D::SetStartDelay(float delay)
+{
+    startDelay_ = Max(delay, 0.0f);
+}
+
+void ParticleSimulator2D::SetParticleScale(float scale)
+{
+    particleScale_ = Clamp(scale, 0.0f, 1.0f);
+}
+
+void ParticleSimulator2D::SetSpawnScale(float scale)
+{
+    spawnScale_ = Clamp(scale, 0.0f, 1.0f);
+}
+
+void ParticleSimulator2D::SetTrackIds(bool enable)
+{
+    if (enable == trackIds_)
+        return;
+
+    // Ids of particles already alive are unknown, so tracking starts over with the next reset
+    trackIds_ = enable;
+    Reset();
+}
+
+void ParticleSimulator2D::SetPrewarmTime(float time)
+{
+    prewarmTime_ = Max(time, 0.0f);
+}
+
+void ParticleSimulator2D::Reset()
+{
+    // Pre-warming is a seek, so it costs the particles alive at the prewarm time rather than the frames leading up to it
+    if (prewarmTime_ > 0.0f)
+        Seek(prewarmTime_, PREWARM_TIME_STEP);
+    else
+        Clear();
+}
+
+void ParticleSimulator2D::Clear()
+{
+    pool_.Clear();
+    particleIds_.Clear();
+    emissionTime_ = effect_ ? effect_->GetDuration() : 0.0f;
+    emitParticleTime_ = 0.0f;
+    elapsedTime_ = 0.0f;
+    numEmitted_ = 0;
+    numSpawns_ = 0;
+    numPending_ = 0;
+}
+
+void ParticleSimulator2D::Update(float timeStep)
+{
+    BeginUpdate(timeStep);
+    UpdateParticles(0, numPending_);
+}
+
+void ParticleSimulator2D::BeginUpdate(float timeStep)
+{
+    numPending_ = 0;
+    if (!effect_ || timeStep <= 0.0f)
+        return;
+
+    float worldScale = scale_ * PIXEL_SIZE;
+
+    // Remove dead particles. The survivors are stepped later by UpdateParticles(), possibly from worker threads
+    unsigned particleIndex = 0;
+    while (particleIndex < pool_.GetSize())
+    {
+        if (pool_.Get(PS_TIME_TO_LIVE, particleIndex) > 0.0f)
+            ++particleIndex;
+        else
+        {
+            // Mirror the pool, which moves the last particle into the removed one's place
+            if (trackIds_)
+            {
+                particleIds_[particleIndex] = particleIds_.Back();
+                particleIds_.Pop();
+            }
+            pool_.Remove(particleIndex);
+        }
+    }
+
+    numPending_ = pool_.GetSize();
+    pendingTimeStep_ = timeStep;
+    pendingWorldScale_ = worldScale;
+
+    // New particles are appended after the survivors and stepped here, so emission order and random values stay
+    // the same however the survivors are split
+    // Only the part of the step past the start delay emits, so delayed layers start on the same spawn slots every time
+    float emitStep = Min(timeStep, elapsedTime_ + timeStep - startDelay_);
+    if (emitStep > 0.0f && IsEmitting())
+    {
+        // A scaled spawn rate advances the accumulator slower. Spawn times are converted back to seconds
+        float timeBetweenParticles = effect_->GetParticleLifeSpan() / pool_.GetCapacity();
+        emitParticleTime_ += emitStep * spawnScale_;
+
+        spawnTimes_.Clear();
+        while (emitParticleTime_ > 0.0f)
+        {
+            spawnTimes_.Push(emitParticleTime_ / spawnScale_);
+
+            // Guard against a zero life span, which would never drain the accumulator
+            if (timeBetweenParticles <= 0.0f)
+            {
+                emitParticleTime_ = 0.0f;
+                break;
+            }
+
+            emitParticleTime_ -= timeBetweenParticles;
+        }
+
+        // Spawn slots are counted even when the pool is full, so a particle's values depend only on when it spawned
+        unsigned numSpawns = spawnTimes_.Size();
+        if (numSpawns)
+        {
+            spawnRandoms_.Resize(numSpawns * MAX_PARTICLE_RANDOM_CHANNELS);
+            kernels_->random_(randomSeed_, numSpawns_, numSpawns, &spawnRandoms_[0]);
+            numSpawns_ += numSpawns;
+
+            for (unsigned i = 0; i < numSpawns; ++i)
+            {
+                unsigned index = EmitParticle(worldScale, &spawnRandoms_[i], numSpawns);
+                if (index != M_MAX_UNSIGNED)
+                {
+                    if (trackIds_)
+                        particleIds_.Push(numSpawns_ - numSpawns + i);
+                    RunKernel(index, index + 1, spawnTimes_[i], worldScale);
+                }
+            }
+        }
+
+        if (emissionTime_ > 0.0f)
+            emissionTime_ = Max(0.0f, emissionTime_ - emitStep);
+    }
+
+    elapsedTime_ += timeStep;
+}
+
+void ParticleSimulator2D::UpdateParticles(unsigned begin, unsigned end)
+{
+    RunKernel(begin, Min(end, numPending_), pendingTimeStep_, pendingWorldScale_);
+}
+
+void ParticleSimulator2D::Simulate(float duration, float timeStep)
+{
+    if (timeStep <= 0.0f)
+        return;
+
+    while (duration > 0.0f)
+    {
+        float step = Min(duration, timeStep);
+        Update(step);
+        duration -= step;
+    }
+}
+
+void ParticleSimulator2D::Seek(float time, float timeStep)
+{
+    Clear();
+    if (!effect_ || time <= 0.0f || timeStep <= 0.0f)
+        return;
+
+    // A zero life span gives no spawn spacing to solve for, so such effects are stepped
+    float lifespan = effect_->GetParticleLifeSpan();
+    float lifespanVariance = effect_->GetParticleLifespanVariance();
+    float timeBetweenParticles = lifespan / pool_.GetCapacity();
+    if (timeBetweenParticles <= 0.0f)
+    {
+        Simulate(time, timeStep);
+        return;
+    }
+
+    float worldScale = scale_ * PIXEL_SIZE;
+
+    // Emission runs from the end of the start delay until the duration runs out. The accumulator takes one spawn interval
+    // per slot, so slot k is due k intervals after emission starts however the time was stepped
+    float duration = effect_->GetDuration();
+    float emitTime = Max(time - startDelay_, 0.0f);
+    if (duration >= 0.0f)
+        emitTime = Min(emitTime, duration);
+
+    unsigned numSlots = 0;
+    float spawnInterval = 0.0f;
+    if (spawnScale_ > 0.0f)
+    {
+        spawnInterval = timeBetweenParticles / spawnScale_;
+        numSlots = CeilSeekSlots(emitTime / spawnInterval);
+    }
+
+    // Particles alive at the time spawned within one life span of it. Whether the pool had room for them depends on the
+    // particles alive when they spawned, so one more life span before that is replayed to fill the pool
+    float history = 2.0f * (lifespan + Abs(lifespanVariance));
+    unsigned firstSlot = 0;
+    if (numSlots && time - startDelay_ > history)
+        firstSlot = Min(CeilSeekSlots((time - startDelay_ - history) / spawnInterval), numSlots);
+
+    unsigned limit = GetParticleLimit();
+    PODVector<float> deaths;
+    PODVector<float> ages;
+    for (unsigned batchStart = firstSlot; batchStart < numSlots; batchStart += SEEK_BATCH_SIZE)
+    {
+        unsigned count = Min(SEEK_BATCH_SIZE, numSlots - batchStart);
+        spawnRandoms_.Resize(count * MAX_PARTICLE_RANDOM_CHANNELS);
+        kernels_->random_(randomSeed_, batchStart, count, &spawnRandoms_[0]);
+
+        for (unsigned i = 0; i < count; ++i)
+        {
+            unsigned slot = batchStart + i;
+            float spawnTime = startDelay_ + slot * spawnInterval;
+
+            // Live particles are only counted against the limit, so the pool holds just the ones that survive to the time
+            while (!deaths.Empty() && deaths[0] <= spawnTime)
+                PopHeap(deaths);
+            if (deaths.Size() >= limit)
+                continue;
+
+            float particleLifespan = lifespan + lifespanVariance * spawnRandoms_[PRC_LIFESPAN * count + i];
+            if (particleLifespan <= 0.0f)
+                continue;
+
+            float deathTime = spawnTime + particleLifespan;
+            PushHeap(deaths, deathTime);
+            if (deathTime <= time)
+            {
+                ++numEmitted_;
+                continue;
+            }
+
+            if (EmitParticle(worldScale, &spawnRandoms_[i], count) == M_MAX_UNSIGNED)
+                continue;
+            if (trackIds_)
+                particleIds_.Push(slot);
+            ages.Push(time - spawnTime);
+        }
+    }
+
+    if (IsSeekClosedForm())
+        EvaluateParticles(ages, timeStep, worldScale);
+    else
+        SubstepParticles(ages, timeStep, worldScale);
+
+    emitParticleTime_ = numSlots ? emitTime * spawnScale_ - numSlots * timeBetweenParticles : 0.0f;
+    if (duration > 0.0f)
+        emissionTime_ = Max(duration - emitTime, 0.0f);
+    elapsedTime_ = time;
+    numSpawns_ = numSlots;
+}
+
+ParticleEffect2D* ParticleSimulator2D::GetEffect() const
+{
+    return effect_;
+}
+
+unsigned ParticleSimulator2D::GetParticleLimit() const
+{
+    if (!effect_)
+        return 0;
+
+    return (unsigned)(Max(effect_->GetMaxParticles(), 0) * particleScale_ + 0.5f);
+}
+
+bool ParticleSimulator2D::IsEmitting() const
+{
+    // Negative duration emits forever, positive duration emits until it runs out
+    return emissionTime_ < 0.0f || emissionTime_ > 0.0f;
+}
+
+bool ParticleSimulator2D::IsSeekClosedForm() const
+{
+    if (!effect_ || effect_->GetEmitterType() == EMITTER_TYPE_RADIAL)
+        return true;
+
+    return effect_->GetRadialAcceleration() == 0.0f && effect_->GetRadialAccelVariance() == 0.0f &&
+        effect_->GetTangentialAcceleration() == 0.0f && effect_->GetTangentialAccelVariance() == 0.0f;
+}
+
+unsigned ParticleSimulator2D::EmitParticle(float worldScale, const float* random, unsigned stride)
+{
+    if (pool_.GetSize() >= GetParticleLimit())
+        return M_MAX_UNSIGNED;
+
+    float lifespan = effect_->GetParticleLifeSpan() + effect_->GetParticleLifespanVariance() * random[PRC_LIFESPAN * stride];
+    if (lifespan <= 0.0f)
+        return M_MAX_UNSIGNED;
+
+    unsigned index = pool_.Allocate();
+    if (index == M_MAX_UNSIGNED)
+        return M_MAX_UNSIGNED;
+
+    float invLifespan = 1.0f / lifespan;
+    ++numEmitted_;
+
+    pool_.Get(PS_TIME_TO_LIVE, index) = lifespan;
+
+    pool_.Get(PS_POSITION_X, index) = position_.x_ + worldScale * effect_->GetSourcePositionVariance().x_ * random[PRC_POSITION_X * stride];
+    pool_.Get(PS_POSITION_Y, index) = position_.y_ + worldScale * effect_->GetSourcePositionVariance().y_ * random[PRC_POSITION_Y * stride];
+    pool_.Get(PS_START_X, index) = position_.x_;
+    pool_.Get(PS_START_Y, index) = position_.y_;
+
+    float angle = angle_ + effect_->GetAngle() + effect_->GetAngleVariance() * random[PRC_ANGLE * stride];
+    float speed = worldScale * (effect_->GetSpeed() + effect_->GetSpeedVariance() * random[PRC_SPEED * stride]);
+    pool_.Get(PS_VELOCITY_X, index) = speed * Cos(angle);
+    pool_.Get(PS_VELOCITY_Y, index) = speed * Sin(angle);
+
+    float maxRadius = Max(0.0f, worldScale * (effect_->GetMaxRadius() + effect_->GetMaxRadiusVariance() * random[PRC_MAX_RADIUS * stride]));
+    float minRadius = Max(0.0f, worldScale * (effect_->GetMinRadius() + effect_->GetMinRadiusVariance() * random[PRC_MIN_RADIUS * stride]));
+    pool_.Get(PS_EMIT_RADIUS, index) = maxRadius;
+    pool_.Get(PS_EMIT_RADIUS_DELTA, index) = (minRadius - maxRadius) * invLifespan;
+    pool_.Get(PS_EMIT_ROTATION, index) = angle_ + effect_->GetAngle() + effect_->GetAngleVariance() * random[PRC_EMIT_ROTATION * stride];
+    pool_.Get(PS_EMIT_ROTATION_DELTA, index) = effect_->GetRotatePerSecond() + effect_->GetRotatePerSecondVariance() * random[PRC_ROTATE_PER_SECOND * stride];
+    pool_.Get(PS_RADIAL_ACCELERATION, index) = worldScale * (effect_->GetRadialAcceleration() + effect_->GetRadialAccelVariance() * random[PRC_RADIAL_ACCELERATION * stride]);
+    pool_.Get(PS_TANGENTIAL_ACCELERATION, index) = worldScale * (effect_->GetTangentialAcceleration() + effect_->GetTangentialAccelVariance() * random[PRC_TANGENTIAL_ACCELERATION * stride]);
+
+    float startSize = worldScale * Max(0.1f, effect_->GetStartParticleSize() + effect_->GetStartParticleSizeVariance() * random[PRC_START_SIZE * stride]);
+    float finishSize = worldScale * Max(0.1f, effect_->GetFinishParticleSize() + effect_->GetFinishParticleSizeVariance() * random[PRC_FINISH_SIZE * stride]);
+    pool_.Get(PS_SIZE, index) = startSize;
+    pool_.Get(PS_SIZE_DELTA, index) = (finishSize - startSize) * invLifespan;
+
+    Color startColor = effect_->GetStartColor() + effect_->GetStartColorVariance() * random[PRC_START_COLOR * stride];
+    Color endColor = effect_->GetFinishColor() + effect_->GetFinishColorVariance() * random[PRC_FINISH_COLOR * stride];
+    Color colorDelta = (endColor - startColor) * invLifespan;
+    pool_.Get(PS_COLOR_R, index) = startColor.r_;
+    pool_.Get(PS_COLOR_G, index) = startColor.g_;
+    pool_.Get(PS_COLOR_B, index) = startColor.b_;
+    pool_.Get(PS_COLOR_A, index) = startColor.a_;
+    pool_.Get(PS_COLOR_DELTA_R, index) = colorDelta.r_;
+    pool_.Get(PS_COLOR_DELTA_G, index) = colorDelta.g_;
+    pool_.Get(PS_COLOR_DELTA_B, index) = colorDelta.b_;
+    pool_.Get(PS_COLOR_DELTA_A, index) = colorDelta.a_;
+
+    float startRotation = angle_ + effect_->GetRotationStart() + effect_->GetRotationStartVariance() * random[PRC_START_ROTATION * stride];
+    float endRotation = angle_ + effect_->GetRotationEnd() + effect_->GetRotationEndVariance() * random[PRC_END_ROTATION * stride];
+    pool_.Get(PS_ROTATION, index) = startRotation;
+    pool_.Get(PS_ROTATION_DELTA, index) = (endRotation - startRotation) * invLifespan;
+
+    return index;
+}
+
+void ParticleSimulator2D::RunKernel(unsigned begin, unsigned end, float timeStep, float worldScale)
+{
+    if (begin >= end)
+        return;
+
+    ParticleKernelArgs2D args;
+    args.timeStep_ = timeStep;
+
+    const Vector2& gravity = effect_->GetGravity();
+    args.gravityX_ = gravity.x_ * worldScale;
+    args.gravityY_ = gravity.y_ * worldScale;
+
+    ParticleKernel2D kernel = effect_->GetEmitterType() == EMITTER_TYPE_RADIAL ? kernels_->radial_ : kernels_->gravity_;
+
+    // Kernels work on one chunk at a time
+    for (unsigned chunk = begin / PARTICLE_CHUNK_SIZE; chunk * PARTICLE_CHUNK_SIZE < end; ++chunk)
+    {
+        unsigned chunkStart = chunk * PARTICLE_CHUNK_SIZE;
+        for (unsigned i = 0; i < MAX_PARTICLE_STREAMS; ++i)
+            args.streams_[i] = pool_.GetStream(chunk, (ParticleStream2D)i);
+        args.begin_ = Max(begin, chunkStart) - chunkStart;
+        args.end_ = Min(end, chunkStart + PARTICLE_CHUNK_SIZE) - chunkStart;
+
+        unsigned count = (args.end_ - args.begin_) * sizeof(float);
+        memcpy(args.streams_[PS_PREVIOUS_X] + args.begin_, args.streams_[PS_POSITION_X] + args.begin_, count);
+        memcpy(args.streams_[PS_PREVIOUS_Y] + args.begin_, args.streams_[PS_POSITION_Y] + args.begin_, count);
+        kernel(args);
+    }
+}
+
+void ParticleSimulator2D::EvaluateParticles(const PODVector<float>& ages, float timeStep, float worldScale)
+{
+    const Vector2& gravity = effect_->GetGravity();
+    float gravityX = gravity.x_ * worldScale;
+    float gravityY = -gravity.y_ * worldScale;
+    bool radial = effect_->GetEmitterType() == EMITTER_TYPE_RADIAL;
+
+    for (unsigned chunk = 0; chunk < pool_.GetNumChunks(); ++chunk)
+    {
+        float* s[MAX_PARTICLE_STREAMS];
+        for (unsigned i = 0; i < MAX_PARTICLE_STREAMS; ++i)
+            s[i] = pool_.GetStream(chunk, (ParticleStream2D)i);
+        const float* chunkAges = &ages[chunk * PARTICLE_CHUNK_SIZE];
+        unsigned chunkSize = pool_.GetChunkSize(chunk);
+
+        for (unsigned i = 0; i < chunkSize; ++i)
+        {
+            float age = chunkAges[i];
+            s[PS_TIME_TO_LIVE][i] -= age;
+
+            if (radial)
+            {
+                s[PS_EMIT_ROTATION][i] += s[PS_EMIT_ROTATION_DELTA][i] * age;
+                s[PS_EMIT_RADIUS][i] += s[PS_EMIT_RADIUS_DELTA][i] * age;
+                s[PS_POSITION_X][i] = s[PS_START_X][i] - Cos(s[PS_EMIT_ROTATION][i]) * s[PS_EMIT_RADIUS][i];
+                s[PS_POSITION_Y][i] = s[PS_START_Y][i] + Sin(s[PS_EMIT_ROTATION][i]) * s[PS_EMIT_RADIUS][i];
+            }
+            else
+            {
+                // The kernel adds gravity to the velocity before moving, so over a partial first step and then whole steps
+                // the position takes gravity times the sum of the elapsed times at the end of each step
+                float numSteps = floorf(age / timeStep);
+                float firstStep = age - numSteps * timeStep;
+                float gravityTime = firstStep * firstStep + numSteps * firstStep * timeStep +
+                    timeStep * timeStep * numSteps * (numSteps + 1.0f) * 0.5f;
+                s[PS_POSITION_X][i] += s[PS_VELOCITY_X][i] * age + gravityX * gravityTime;
+                s[PS_POSITION_Y][i] += s[PS_VELOCITY_Y][i] * age + gravityY * gravityTime;
+                s[PS_VELOCITY_X][i] += gravityX * age;
+                s[PS_VELOCITY_Y][i] += gravityY * age;
+            }
+
+            s[PS_SIZE][i] += s[PS_SIZE_DELTA][i] * age;
+            s[PS_ROTATION][i] += s[PS_ROTATION_DELTA][i] * age;
+            s[PS_COLOR_R][i] += s[PS_COLOR_DELTA_R][i] * age;
+            s[PS_COLOR_G][i] += s[PS_COLOR_DELTA_G][i] * age;
+            s[PS_COLOR_B][i] += s[PS_COLOR_DELTA_B][i] * age;
+            s[PS_COLOR_A][i] += s[PS_COLOR_DELTA_A][i] * age;
+            s[PS_PREVIOUS_X][i] = s[PS_POSITION_X][i];
+            s[PS_PREVIOUS_Y][i] = s[PS_POSITION_Y][i];
+        }
+    }
+}
+
+void ParticleSimulator2D::SubstepParticles(const PODVector<float>& ages, float timeStep, float worldScale)
+{
+    if (ages.Empty())
+        return;
+
+    // Each particle first steps by the part of its age that does not fill a whole step, which lines its remaining steps
+    // up with those of every other particle
+    for (unsigned i = 0; i < ages.Size(); ++i)
+    {
+        float firstStep = ages[i] - floorf(ages[i] / timeStep) * timeStep;
+        if (firstStep > 0.0f)
+            RunKernel(i, i + 1, firstStep, worldScale);
+    }
+
+    // Older particles come first, so the particles due for each shared step are a prefix of the pool that shrinks as the
+    // step count grows
+    unsigned numSteps = (unsigned)(ages[0] / timeStep);
+    unsigned end = ages.Size();
+    for (unsigned step = 1; step <= numSteps; ++step)
+    {
+        while (end && (unsigned)(ages[end - 1] / timeStep) < step)
+            --end;
+        RunKernel(0, end, timeStep, worldScale);
+    }
+}
+
+}
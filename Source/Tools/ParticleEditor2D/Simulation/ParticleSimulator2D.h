@@ -0,0 +1,197 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Object.h"
+#include "ParticleKernels2D.h"
+#include "ParticlePool2D.h"
+#include "Ptr.h"
+#include "Vector2.h"
+
+namespace Urho3D
+{
+
+class ParticleEffect2D;
+
+/// Headless 2D particle simulator, stepping a particle effect without scene, renderer or window. Particles are stored
+/// as structure of arrays and updated with the best SIMD kernels the CPU supports.
+class ParticleSimulator2D : public Object
+{
+    OBJECT(ParticleSimulator2D)
+
+public:
+    /// Construct.
+    ParticleSimulator2D(Context* context);
+    /// Destruct.
+    virtual ~ParticleSimulator2D();
+
+    /// Set particle effect and restart simulation.
+    void SetEffect(ParticleEffect2D* effect);
+    /// Set max particles.
+    void SetMaxParticles(unsigned maxParticles);
+    /// Set emitter world position.
+    void SetPosition(const Vector2& position);
+    /// Set emitter world angle in degrees.
+    void SetAngle(float angle);
+    /// Set emitter world scale (1 pixel in effect units maps to scale * PIXEL_SIZE world units).
+    void SetScale(float scale);
+    /// Set random seed. Particles are a pure function of seed and spawn index, so the same seed always replays the same simulation.
+    void SetRandomSeed(unsigned seed);
+    /// Set update kernel instruction set level. Unsupported levels fall back to scalar.
+    void SetKernelLevel(ParticleKernelLevel2D level);
+    /// Set time in seconds after each reset before emission starts. The effect duration counts from the end of the delay.
+    void SetStartDelay(float delay);
+    /// Set multiplier of the effect's max particles. Live particles above the new limit are left to die.
+    void SetParticleScale(float scale);
+    /// Set multiplier of the spawn rate.
+    void SetSpawnScale(float scale);
+    /// Set whether to keep the spawn slot of each live particle as its id. Removing a particle moves the last one into its
+    /// place, so ids are the only way to follow a particle across steps. Off by default.
+    void SetTrackIds(bool enable);
+    /// Set time in seconds the simulation is already at after each reset. Reset() seeks to it, so looping effects start in
+    /// their steady state instead of ramping up from empty.
+    void SetPrewarmTime(float time);
+
+    /// Clear all particles and restart emission, pre-warmed to the prewarm time.
+    void Reset();
+    /// Step simulation.
+    void Update(float timeStep);
+    /// Remove dead particles, emit new ones and advance time, leaving the surviving particles to be stepped by UpdateParticles(). Main thread only.
+    void BeginUpdate(float timeStep);
+    /// Step surviving particles in range by the time step given to BeginUpdate(). Disjoint ranges may be updated from worker threads in parallel.
+    void UpdateParticles(unsigned begin, unsigned end);
+    /// Step simulation for duration seconds in fixed steps.
+    void Simulate(float duration, float timeStep);
+    /// Restart and jump to a time in seconds without stepping through it. Particles alive at the time are emitted from their
+    /// spawn slots and evaluated in closed form where the emitter type allows, otherwise sub-stepped by timeStep from their
+    /// own spawn time. Effects older than two life spans are rebuilt from the last two life spans only.
+    void Seek(float time, float timeStep);
+
+    /// Return particle effect.
+    ParticleEffect2D* GetEffect() const;
+    /// Return max particles.
+    unsigned GetMaxParticles() const { return pool_.GetCapacity(); }
+    /// Return number of live particles.
+    unsigned GetNumParticles() const { return pool_.GetSize(); }
+    /// Return particle storage.
+    const ParticlePool2D& GetParticles() const { return pool_; }
+    /// Return update kernels.
+    const ParticleKernels2D& GetKernels() const { return *kernels_; }
+    /// Return emitter world position.
+    const Vector2& GetPosition() const { return position_; }
+    /// Return emitter world angle.
+    float GetAngle() const { return angle_; }
+    /// Return emitter world scale.
+    float GetScale() const { return scale_; }
+    /// Return random seed.
+    unsigned GetRandomSeed() const { return randomSeed_; }
+    /// Return start delay.
+    float GetStartDelay() const { return startDelay_; }
+    /// Return prewarm time.
+    float GetPrewarmTime() const { return prewarmTime_; }
+    /// Return max particles multiplier.
+    float GetParticleScale() const { return particleScale_; }
+    /// Return spawn rate multiplier.
+    float GetSpawnScale() const { return spawnScale_; }
+    /// Return number of particles that may be alive at once, the effect's max particles scaled by the particle scale.
+    unsigned GetParticleLimit() const;
+    /// Return whether is still emitting.
+    bool IsEmitting() const;
+    /// Return whether Seek() evaluates particles in closed form. Gravity emitters with radial or tangential acceleration
+    /// depend on their own path and are sub-stepped.
+    bool IsSeekClosedForm() const;
+    /// Return simulated time since last reset.
+    float GetElapsedTime() const { return elapsedTime_; }
+    /// Return total number of emitted particles since last reset.
+    unsigned GetNumEmitted() const { return numEmitted_; }
+    /// Return number of spawn slots since last reset, including those skipped because the pool was full.
+    unsigned GetNumSpawns() const { return numSpawns_; }
+    /// Return whether particle ids are kept.
+    bool GetTrackIds() const { return trackIds_; }
+    /// Return spawn slot of each live particle in pool order, empty unless ids are kept.
+    const PODVector<unsigned>& GetParticleIds() const { return particleIds_; }
+    /// Return number of surviving particles left to step by UpdateParticles() after BeginUpdate().
+    unsigned GetNumPendingParticles() const { return numPending_; }
+
+private:
+    /// Clear all particles and restart emission from time zero.
+    void Clear();
+    /// Emit a new particle from its spawn random channels, which are stride floats apart. Return its index or M_MAX_UNSIGNED if there is no free slot or life span is not positive.
+    unsigned EmitParticle(float worldScale, const float* random, unsigned stride);
+    /// Run the selected kernel on particles in range.
+    void RunKernel(unsigned begin, unsigned end, float timeStep, float worldScale);
+    /// Advance each particle by its age in closed form, matching fixed steps of timeStep that end at the current time.
+    void EvaluateParticles(const PODVector<float>& ages, float timeStep, float worldScale);
+    /// Advance each particle by its age with the kernels, a partial step first and then fixed steps shared by all particles.
+    /// Ages must not increase with particle index.
+    void SubstepParticles(const PODVector<float>& ages, float timeStep, float worldScale);
+
+    /// Particle effect.
+    SharedPtr<ParticleEffect2D> effect_;
+    /// Emitter world position.
+    Vector2 position_;
+    /// Emitter world angle.
+    float angle_;
+    /// Emitter world scale.
+    float scale_;
+    /// Particles.
+    ParticlePool2D pool_;
+    /// Update kernels.
+    const ParticleKernels2D* kernels_;
+    /// Remaining emission time, negative for infinite emission.
+    float emissionTime_;
+    /// Emit particle time accumulator.
+    float emitParticleTime_;
+    /// Simulated time since last reset.
+    float elapsedTime_;
+    /// Time after reset before emission starts.
+    float startDelay_;
+    /// Time the simulation is pre-warmed to on reset.
+    float prewarmTime_;
+    /// Max particles multiplier.
+    float particleScale_;
+    /// Spawn rate multiplier.
+    float spawnScale_;
+    /// Total number of emitted particles since last reset.
+    unsigned numEmitted_;
+    /// Number of spawn slots since last reset.
+    unsigned numSpawns_;
+    /// Random seed.
+    unsigned randomSeed_;
+    /// Emission time of each spawn slot this frame.
+    PODVector<float> spawnTimes_;
+    /// Random channels of each spawn slot this frame.
+    PODVector<float> spawnRandoms_;
+    /// Spawn slot of each live particle when ids are kept.
+    PODVector<unsigned> particleIds_;
+    /// Whether particle ids are kept.
+    bool trackIds_;
+    /// Number of surviving particles left to step after BeginUpdate().
+    unsigned numPending_;
+    /// Time step given to BeginUpdate().
+    float pendingTimeStep_;
+    /// World scale at BeginUpdate().
+    float pendingWorldScale_;
+};
+
+}
@@ -0,0 +1,288 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Camera.h"
+#include "Context.h"
+#include "ParticleSimulator2D.h"
+#include "ParticleUpdater2D.h"
+#include "Profiler.h"
+#include "Scene.h"
+#include "SceneEvents.h"
+#include "SimulatedParticleEmitter2D.h"
+#include "WorkQueue.h"
+
+namespace Urho3D
+{
+
+/// Time step of Step() and Seek() without a fixed time step.
+static const float DEFAULT_SEEK_TIME_STEP = 1.0f / 60.0f;
+
+static void UpdateEmitterChunkWork(const WorkItem* item, unsigned threadIndex)
+{
+    SimulatedParticleEmitter2D* emitter = reinterpret_cast<SimulatedParticleEmitter2D*>(item->start_);
+    emitter->UpdateChunk((unsigned)(size_t)item->aux_, threadIndex);
+}
+
+ParticleUpdater2D::ParticleUpdater2D(Context* context) :
+    Component(context),
+    fixedTimeStep_(0.0f),
+    maxSteps_(4),
+    accumulator_(0.0f),
+    interpolation_(1.0f),
+    particleBudget_(0),
+    particleDemand_(0),
+    budgetScale_(1.0f),
+    paused_(false)
+{
+}
+
+ParticleUpdater2D::~ParticleUpdater2D()
+{
+}
+
+void ParticleUpdater2D::RegisterObject(Context* context)
+{
+    context->RegisterFactory<ParticleUpdater2D>();
+}
+
+void ParticleUpdater2D::AddEmitter(SimulatedParticleEmitter2D* emitter)
+{
+    if (!emitter || emitters_.Contains(emitter))
+        return;
+
+    emitters_.Push(emitter);
+}
+
+void ParticleUpdater2D::RemoveEmitter(SimulatedParticleEmitter2D* emitter)
+{
+    emitters_.Remove(emitter);
+}
+
+void ParticleUpdater2D::SetFixedTimeStep(float timeStep)
+{
+    fixedTimeStep_ = Max(timeStep, 0.0f);
+    accumulator_ = 0.0f;
+}
+
+void ParticleUpdater2D::SetMaxSteps(unsigned maxSteps)
+{
+    maxSteps_ = Max(maxSteps, 1U);
+}
+
+void ParticleUpdater2D::SetLodCamera(Camera* camera)
+{
+    lodCamera_ = camera;
+}
+
+void ParticleUpdater2D::SetParticleBudget(unsigned budget)
+{
+    particleBudget_ = budget;
+}
+
+void ParticleUpdater2D::SetPaused(bool enable)
+{
+    paused_ = enable;
+    accumulator_ = 0.0f;
+}
+
+void ParticleUpdater2D::Advance(float timeStep)
+{
+    if (paused_)
+        return;
+
+    UpdateLod();
+
+    if (fixedTimeStep_ <= 0.0f)
+    {
+        interpolation_ = 1.0f;
+        for (unsigned i = 0; i < emitters_.Size(); ++i)
+            emitters_[i]->SetInterpolation(interpolation_);
+        Update(timeStep);
+        return;
+    }
+
+    accumulator_ += timeStep;
+    unsigned numSteps = (unsigned)(accumulator_ / fixedTimeStep_);
+    if (numSteps > maxSteps_)
+    {
+        numSteps = maxSteps_;
+        accumulator_ = numSteps * fixedTimeStep_;
+    }
+    accumulator_ -= numSteps * fixedTimeStep_;
+
+    // The remainder is drawn as a blend of the last two steps, so motion stays smooth when frames and steps do not line up
+    interpolation_ = Clamp(accumulator_ / fixedTimeStep_, 0.0f, 1.0f);
+    for (unsigned i = 0; i < emitters_.Size(); ++i)
+        emitters_[i]->SetInterpolation(interpolation_);
+
+    for (unsigned i = 0; i < numSteps; ++i)
+        Update(fixedTimeStep_, i == numSteps - 1);
+}
+
+void ParticleUpdater2D::Update(float timeStep, bool updateVertices)
+{
+    PROFILE(UpdateParticles2D);
+
+    // Emission consumes the random sequence, so it runs serially in emitter order
+    updateEmitters_.Clear();
+    updateChunks_.Clear();
+    unsigned numChunks = 0;
+    for (unsigned i = 0; i < emitters_.Size(); ++i)
+    {
+        SimulatedParticleEmitter2D* emitter = emitters_[i];
+        if (!emitter->IsEnabledEffective())
+            continue;
+
+        unsigned emitterChunks = emitter->BeginUpdate(timeStep, updateVertices);
+        updateEmitters_.Push(emitter);
+        updateChunks_.Push(emitterChunks);
+        numChunks += emitterChunks;
+    }
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    if (queue && queue->GetNumThreads() && numChunks > 1)
+    {
+        WorkItem item;
+        item.workFunction_ = UpdateEmitterChunkWork;
+        item.priority_ = M_MAX_UNSIGNED;
+
+        for (unsigned i = 0; i < updateEmitters_.Size(); ++i)
+        {
+            item.start_ = updateEmitters_[i];
+            for (unsigned chunk = 0; chunk < updateChunks_[i]; ++chunk)
+            {
+                item.aux_ = (void*)(size_t)chunk;
+                queue->AddWorkItem(item);
+            }
+        }
+
+        queue->Complete(M_MAX_UNSIGNED);
+    }
+    else
+    {
+        for (unsigned i = 0; i < updateEmitters_.Size(); ++i)
+        {
+            for (unsigned chunk = 0; chunk < updateChunks_[i]; ++chunk)
+                updateEmitters_[i]->UpdateChunk(chunk);
+        }
+    }
+
+    for (unsigned i = 0; i < updateEmitters_.Size(); ++i)
+        updateEmitters_[i]->EndUpdate();
+}
+
+void ParticleUpdater2D::Step()
+{
+    UpdateLod();
+
+    // Time left over from the frames before is dropped, so the step shows exactly where the simulation is
+    accumulator_ = 0.0f;
+    interpolation_ = 1.0f;
+    for (unsigned i = 0; i < emitters_.Size(); ++i)
+        emitters_[i]->SetInterpolation(interpolation_);
+
+    Update(fixedTimeStep_ > 0.0f ? fixedTimeStep_ : DEFAULT_SEEK_TIME_STEP);
+}
+
+void ParticleUpdater2D::Seek(float time)
+{
+    UpdateLod();
+
+    accumulator_ = 0.0f;
+    interpolation_ = 1.0f;
+    float timeStep = fixedTimeStep_ > 0.0f ? fixedTimeStep_ : DEFAULT_SEEK_TIME_STEP;
+    for (unsigned i = 0; i < emitters_.Size(); ++i)
+    {
+        SimulatedParticleEmitter2D* emitter = emitters_[i];
+        if (emitter->IsEnabledEffective())
+            emitter->Seek(time, timeStep);
+    }
+}
+
+Camera* ParticleUpdater2D::GetLodCamera() const
+{
+    return lodCamera_;
+}
+
+bool ParticleUpdater2D::IsActive() const
+{
+    if (paused_)
+        return false;
+
+    for (unsigned i = 0; i < emitters_.Size(); ++i)
+    {
+        SimulatedParticleEmitter2D* emitter = emitters_[i];
+        if (!emitter->IsEnabledEffective())
+            continue;
+
+        ParticleSimulator2D* simulator = emitter->GetSimulator();
+        if (simulator->GetNumParticles() || (simulator->GetEffect() && simulator->IsEmitting()))
+            return true;
+    }
+
+    return false;
+}
+
+void ParticleUpdater2D::OnNodeSet(Node* node)
+{
+    if (node)
+    {
+        Scene* scene = GetScene();
+        if (scene)
+            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(ParticleUpdater2D, HandleScenePostUpdate));
+    }
+}
+
+void ParticleUpdater2D::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ScenePostUpdate;
+
+    Advance(eventData[P_TIMESTEP].GetFloat());
+}
+
+void ParticleUpdater2D::UpdateLod()
+{
+    particleDemand_ = 0;
+    for (unsigned i = 0; i < emitters_.Size(); ++i)
+    {
+        SimulatedParticleEmitter2D* emitter = emitters_[i];
+        if (!emitter->IsEnabledEffective())
+            continue;
+
+        emitter->UpdateLodLevel(lodCamera_);
+
+        // Finished emitters are left out, so a burst that has died down does not hold the others back
+        ParticleSimulator2D* simulator = emitter->GetSimulator();
+        if (simulator->GetNumParticles() || (simulator->GetEffect() && simulator->IsEmitting()))
+            particleDemand_ += emitter->GetLodParticleLimit();
+    }
+
+    // Every emitter gives up the same share, so their relative densities stay as authored
+    budgetScale_ = 1.0f;
+    if (particleBudget_ && particleDemand_ > particleBudget_)
+        budgetScale_ = (float)particleBudget_ / (float)particleDemand_;
+
+    for (unsigned i = 0; i < emitters_.Size(); ++i)
+        emitters_[i]->SetBudgetScale(budgetScale_);
+}
+
+}
@@ -0,0 +1,128 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Component.h"
+
+namespace Urho3D
+{
+
+class Camera;
+class SimulatedParticleEmitter2D;
+
+/// Scene component that steps all 2D particle emitters of the scene every frame. Emission runs on the main thread;
+/// particle updates and vertex generation are split into chunk work items on the WorkQueue, across all emitters.
+/// With a fixed time step, frame time is accumulated and consumed in whole steps, and emitters draw their particles
+/// between the last two steps by the remaining fraction. Once per frame, emitters pick their LOD level from the LOD
+/// camera, and all active emitters are scaled down evenly when their particles exceed the particle budget.
+class ParticleUpdater2D : public Component
+{
+    OBJECT(ParticleUpdater2D)
+
+public:
+    /// Construct.
+    ParticleUpdater2D(Context* context);
+    /// Destruct.
+    virtual ~ParticleUpdater2D();
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+
+    /// Add emitter.
+    void AddEmitter(SimulatedParticleEmitter2D* emitter);
+    /// Remove emitter.
+    void RemoveEmitter(SimulatedParticleEmitter2D* emitter);
+    /// Set fixed time step, or zero to step once per frame by the frame time step.
+    void SetFixedTimeStep(float timeStep);
+    /// Set max number of fixed steps per frame. Time beyond them is dropped so a slow frame does not snowball.
+    void SetMaxSteps(unsigned maxSteps);
+    /// Set camera that LOD levels are selected by. Emitters stay at their level without one.
+    void SetLodCamera(Camera* camera);
+    /// Set max number of particles of all active emitters, or zero for no limit.
+    void SetParticleBudget(unsigned budget);
+    /// Set whether frame time is ignored. Paused emitters still step and seek on request.
+    void SetPaused(bool enable);
+    /// Advance by frame time, stepping all enabled emitters by the fixed time step or by the frame time step.
+    void Advance(float timeStep);
+    /// Step all enabled emitters once.
+    void Update(float timeStep, bool updateVertices = true);
+    /// Step all enabled emitters once by the fixed time step and draw the result without interpolation.
+    void Step();
+    /// Restart all enabled emitters and jump to a time in seconds.
+    void Seek(float time);
+
+    /// Return emitters.
+    const PODVector<SimulatedParticleEmitter2D*>& GetEmitters() const { return emitters_; }
+    /// Return fixed time step.
+    float GetFixedTimeStep() const { return fixedTimeStep_; }
+    /// Return max number of fixed steps per frame.
+    unsigned GetMaxSteps() const { return maxSteps_; }
+    /// Return fraction of a fixed step accumulated but not yet stepped.
+    float GetInterpolation() const { return interpolation_; }
+    /// Return LOD camera.
+    Camera* GetLodCamera() const;
+    /// Return particle budget.
+    unsigned GetParticleBudget() const { return particleBudget_; }
+    /// Return number of particles active emitters would allow at their LOD levels, before the budget.
+    unsigned GetParticleDemand() const { return particleDemand_; }
+    /// Return multiplier the budget applies to active emitters.
+    float GetBudgetScale() const { return budgetScale_; }
+    /// Return whether frame time is ignored.
+    bool IsPaused() const { return paused_; }
+    /// Return whether not paused and any enabled emitter has live particles or is still emitting.
+    bool IsActive() const;
+
+private:
+    /// Handle node being assigned.
+    virtual void OnNodeSet(Node* node);
+    /// Handle scene post update.
+    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    /// Select LOD levels and apply the particle budget.
+    void UpdateLod();
+
+    /// Emitters.
+    PODVector<SimulatedParticleEmitter2D*> emitters_;
+    /// Emitters being updated this frame.
+    PODVector<SimulatedParticleEmitter2D*> updateEmitters_;
+    /// Number of chunks to update per emitter this frame.
+    PODVector<unsigned> updateChunks_;
+    /// Fixed time step.
+    float fixedTimeStep_;
+    /// Max number of fixed steps per frame.
+    unsigned maxSteps_;
+    /// Frame time not yet stepped.
+    float accumulator_;
+    /// Fraction of a fixed step not yet stepped.
+    float interpolation_;
+    /// LOD camera.
+    WeakPtr<Camera> lodCamera_;
+    /// Particle budget.
+    unsigned particleBudget_;
+    /// Number of particles active emitters allow at their LOD levels.
+    unsigned particleDemand_;
+    /// Budget multiplier.
+    float budgetScale_;
+    /// Whether frame time is ignored.
+    bool paused_;
+};
+
+}
@@ -0,0 +1,237 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Context.h"
+#include "GraphicsEvents.h"
+#include "PhaseProfiler2D.h"
+#include "Serializer.h"
+#include "Sort.h"
+#include "WorkQueue.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include <cstdio>
+
+namespace Urho3D
+{
+
+static const char* phaseNames[] =
+{
+    "Qt events",
+    "Frame",
+    "Spawn",
+    "Integrate",
+    "Vertices",
+    "Submit",
+    0
+};
+
+static void WriteText(Serializer& dest, const String& text)
+{
+    dest.Write(text.CString(), text.Length());
+}
+
+PhaseProfiler2D::PhaseProfiler2D(Context* context) :
+    Object(context),
+    historyIndex_(0),
+    numFrames_(0),
+    capture_(false),
+    traceIndex_(0),
+    traceStart_(0),
+    renderStart_(0)
+{
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    threads_.Resize(queue ? queue->GetNumThreads() + 1 : 1);
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+    {
+        for (unsigned j = 0; j < MAX_PROFILE_PHASES; ++j)
+            threads_[i].frameTimes_[j] = 0;
+    }
+
+    SubscribeToEvent(E_BEGINRENDERING, HANDLER(PhaseProfiler2D, HandleBeginRendering));
+    SubscribeToEvent(E_ENDRENDERING, HANDLER(PhaseProfiler2D, HandleEndRendering));
+}
+
+PhaseProfiler2D::~PhaseProfiler2D()
+{
+}
+
+void PhaseProfiler2D::AddEvent(ProfilePhase2D phase, long long start, long long end, unsigned thread)
+{
+    if (thread >= threads_.Size())
+        return;
+
+    ProfileThread2D& data = threads_[thread];
+    data.frameTimes_[phase] += end - start;
+
+    // Event storage is reserved when capture starts, so workers do not allocate while they are timed
+    if (!capture_ || data.events_.Size() >= MAX_PROFILE_FRAME_EVENTS)
+        return;
+
+    ProfileEvent2D event;
+    event.phase_ = phase;
+    event.thread_ = thread;
+    event.start_ = start;
+    event.end_ = end;
+    data.events_.Push(event);
+}
+
+void PhaseProfiler2D::EndFrame()
+{
+    for (unsigned i = 0; i < MAX_PROFILE_PHASES; ++i)
+    {
+        long long frameTime = 0;
+        for (unsigned j = 0; j < threads_.Size(); ++j)
+        {
+            frameTime += threads_[j].frameTimes_[i];
+            threads_[j].frameTimes_[i] = 0;
+        }
+        history_[i][historyIndex_] = (float)(frameTime / 1000000.0);
+    }
+
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+    {
+        PODVector<ProfileEvent2D>& events = threads_[i].events_;
+        for (unsigned j = 0; j < events.Size(); ++j)
+            AddTraceEvent(events[j]);
+        events.Clear();
+    }
+
+    historyIndex_ = (historyIndex_ + 1) % PROFILE_HISTORY_SIZE;
+    if (numFrames_ < PROFILE_HISTORY_SIZE)
+        ++numFrames_;
+}
+
+void PhaseProfiler2D::SetCapture(bool enable)
+{
+    if (enable && !capture_)
+    {
+        traceEvents_.Clear();
+        traceEvents_.Reserve(MAX_PROFILE_TRACE_EVENTS);
+        traceIndex_ = 0;
+        traceStart_ = GetTime();
+    }
+
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+    {
+        threads_[i].events_.Clear();
+        if (enable)
+            threads_[i].events_.Reserve(MAX_PROFILE_FRAME_EVENTS);
+    }
+
+    capture_ = enable;
+}
+
+bool PhaseProfiler2D::SaveChromeTrace(Serializer& dest)
+{
+    WriteText(dest, "{\"traceEvents\":[\n");
+
+    // Name the thread lanes so the trace viewer shows main and worker threads apart
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+    {
+        String name = i == 0 ? String("Main") : ToString("Worker %u", i);
+        WriteText(dest, ToString("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}},\n", i,
+            name.CString()));
+    }
+
+    // Once the ring has wrapped the oldest interval is at the next slot
+    unsigned numEvents = traceEvents_.Size();
+    for (unsigned i = 0; i < numEvents; ++i)
+    {
+        const ProfileEvent2D& event = traceEvents_[(traceIndex_ + i) % numEvents];
+        WriteText(dest, ToString("{\"name\":\"%s\",\"cat\":\"particles\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f},\n",
+            phaseNames[event.phase_], event.thread_, (event.start_ - traceStart_) / 1000.0, (event.end_ - event.start_) / 1000.0));
+    }
+
+    WriteText(dest, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"ParticleEditor2D\"}}\n");
+    WriteText(dest, "],\n\"displayTimeUnit\":\"ms\"}\n");
+
+    return true;
+}
+
+ProfileStats2D PhaseProfiler2D::GetStats(ProfilePhase2D phase) const
+{
+    ProfileStats2D stats;
+    stats.last_ = stats.p50_ = stats.p95_ = stats.p99_ = stats.max_ = 0.0f;
+    if (!numFrames_)
+        return stats;
+
+    PODVector<float> times(numFrames_);
+    for (unsigned i = 0; i < numFrames_; ++i)
+        times[i] = history_[phase][i];
+    Sort(times.Begin(), times.End());
+
+    stats.last_ = history_[phase][(historyIndex_ + PROFILE_HISTORY_SIZE - 1) % PROFILE_HISTORY_SIZE];
+    stats.p50_ = times[(numFrames_ - 1) * 50 / 100];
+    stats.p95_ = times[(numFrames_ - 1) * 95 / 100];
+    stats.p99_ = times[(numFrames_ - 1) * 99 / 100];
+    stats.max_ = times[numFrames_ - 1];
+
+    return stats;
+}
+
+long long PhaseProfiler2D::GetTime()
+{
+#ifdef WIN32
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (long long)((double)counter.QuadPart * 1000000000.0 / (double)frequency.QuadPart);
+#else
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (long long)time.tv_sec * 1000000000LL + time.tv_nsec;
+#endif
+}
+
+const char* PhaseProfiler2D::GetPhaseName(ProfilePhase2D phase)
+{
+    return phase < MAX_PROFILE_PHASES ? phaseNames[phase] : "";
+}
+
+void PhaseProfiler2D::HandleBeginRendering(StringHash eventType, VariantMap& eventData)
+{
+    renderStart_ = GetTime();
+}
+
+void PhaseProfiler2D::HandleEndRendering(StringHash eventType, VariantMap& eventData)
+{
+    AddEvent(PP_SUBMIT, renderStart_, GetTime());
+}
+
+void PhaseProfiler2D::AddTraceEvent(const ProfileEvent2D& event)
+{
+    if (traceEvents_.Size() < MAX_PROFILE_TRACE_EVENTS)
+        traceEvents_.Push(event);
+    else
+    {
+        traceEvents_[traceIndex_] = event;
+        traceIndex_ = (traceIndex_ + 1) % MAX_PROFILE_TRACE_EVENTS;
+    }
+}
+
+}
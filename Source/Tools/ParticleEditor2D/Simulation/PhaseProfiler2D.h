@@ -0,0 +1,191 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Object.h"
+
+namespace Urho3D
+{
+
+class Serializer;
+
+/// Profiled phase of an editor frame.
+enum ProfilePhase2D
+{
+    /// Qt event processing between frames.
+    PP_EVENTPUMP = 0,
+    /// Whole engine frame.
+    PP_FRAME,
+    /// Dead particle removal and emission.
+    PP_SPAWN,
+    /// Particle integration.
+    PP_INTEGRATE,
+    /// Vertex generation.
+    PP_VERTICES,
+    /// Batch submission and rendering.
+    PP_SUBMIT,
+    MAX_PROFILE_PHASES
+};
+
+/// Number of frames kept for percentiles.
+static const unsigned PROFILE_HISTORY_SIZE = 300;
+/// Max number of events kept for a trace.
+static const unsigned MAX_PROFILE_TRACE_EVENTS = 65536;
+/// Max number of events a thread keeps per frame for a trace. Later ones are dropped.
+static const unsigned MAX_PROFILE_FRAME_EVENTS = 4096;
+
+/// Profiled interval.
+struct ProfileEvent2D
+{
+    /// Phase.
+    ProfilePhase2D phase_;
+    /// Thread index, 0 for the main thread.
+    unsigned thread_;
+    /// Start time in nanoseconds.
+    long long start_;
+    /// End time in nanoseconds.
+    long long end_;
+};
+
+/// Phase times and trace intervals one thread has added to the current frame. Only that thread writes to it until frame end.
+struct ProfileThread2D
+{
+    /// Time of the current frame so far per phase, in nanoseconds.
+    long long frameTimes_[MAX_PROFILE_PHASES];
+    /// Intervals of the current frame while capturing.
+    PODVector<ProfileEvent2D> events_;
+};
+
+/// Per-frame time statistics of a phase in milliseconds.
+struct ProfileStats2D
+{
+    /// Last frame.
+    float last_;
+    /// Median.
+    float p50_;
+    /// 95th percentile.
+    float p95_;
+    /// 99th percentile.
+    float p99_;
+    /// Maximum.
+    float max_;
+};
+
+/// Editor frame phase profiler subsystem. Scoped markers add the time of each phase, from any thread, to the current frame.
+/// The per-frame totals are kept for rolling percentiles and, while capturing, every interval is kept for a Chrome trace. Each
+/// thread adds to its own slot without locking and the slots are merged at frame end, so timing worker chunks does not make
+/// them contend. Worker threads only run while the main thread waits for them, so the main thread needs no lock either.
+class PhaseProfiler2D : public Object
+{
+    OBJECT(PhaseProfiler2D)
+
+public:
+    /// Construct with a slot for the main thread and each work queue thread. Must be called on the main thread after the
+    /// engine has started its worker threads.
+    PhaseProfiler2D(Context* context);
+    /// Destruct.
+    virtual ~PhaseProfiler2D();
+
+    /// Add a phase interval to the current frame from a thread, numbered as the work queue does with 0 for the main thread.
+    void AddEvent(ProfilePhase2D phase, long long start, long long end, unsigned thread = 0);
+    /// Close the current frame, merge the threads and add their totals to the history. Called on the main thread.
+    void EndFrame();
+    /// Start or stop keeping intervals for a trace. Starting clears the previous trace.
+    void SetCapture(bool enable);
+    /// Save kept intervals in Chrome trace event format. Return true if successful.
+    bool SaveChromeTrace(Serializer& dest);
+
+    /// Return whether intervals are being kept.
+    bool IsCapturing() const { return capture_; }
+    /// Return number of kept intervals.
+    unsigned GetNumTraceEvents() const { return traceEvents_.Size(); }
+    /// Return number of frames in the history.
+    unsigned GetNumFrames() const { return numFrames_; }
+    /// Return statistics of a phase over the history.
+    ProfileStats2D GetStats(ProfilePhase2D phase) const;
+
+    /// Return current time in nanoseconds.
+    static long long GetTime();
+    /// Return phase name.
+    static const char* GetPhaseName(ProfilePhase2D phase);
+
+private:
+    /// Handle begin rendering event.
+    void HandleBeginRendering(StringHash eventType, VariantMap& eventData);
+    /// Handle end rendering event.
+    void HandleEndRendering(StringHash eventType, VariantMap& eventData);
+    /// Add an interval to the trace ring.
+    void AddTraceEvent(const ProfileEvent2D& event);
+
+    /// Current frame of each thread, the main thread first.
+    Vector<ProfileThread2D> threads_;
+    /// Per-frame times of each phase in milliseconds, as a ring.
+    float history_[MAX_PROFILE_PHASES][PROFILE_HISTORY_SIZE];
+    /// Next history slot.
+    unsigned historyIndex_;
+    /// Number of frames in the history.
+    unsigned numFrames_;
+    /// Capture flag.
+    bool capture_;
+    /// Kept intervals, as a ring once full.
+    PODVector<ProfileEvent2D> traceEvents_;
+    /// Next trace slot once the ring is full.
+    unsigned traceIndex_;
+    /// Start time of the trace.
+    long long traceStart_;
+    /// Start time of rendering.
+    long long renderStart_;
+};
+
+/// Scoped phase marker. Does nothing without a profiler.
+class PhaseProfileScope2D
+{
+public:
+    /// Construct and start timing on a thread, numbered as the work queue does.
+    PhaseProfileScope2D(PhaseProfiler2D* profiler, ProfilePhase2D phase, unsigned thread = 0) :
+        profiler_(profiler),
+        phase_(phase),
+        thread_(thread),
+        start_(profiler ? PhaseProfiler2D::GetTime() : 0)
+    {
+    }
+
+    /// Destruct and add the interval.
+    ~PhaseProfileScope2D()
+    {
+        if (profiler_)
+            profiler_->AddEvent(phase_, start_, PhaseProfiler2D::GetTime(), thread_);
+    }
+
+private:
+    /// Profiler.
+    PhaseProfiler2D* profiler_;
+    /// Phase.
+    ProfilePhase2D phase_;
+    /// Thread index.
+    unsigned thread_;
+    /// Start time.
+    long long start_;
+};
+
+}
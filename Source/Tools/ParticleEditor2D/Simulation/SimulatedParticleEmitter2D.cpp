@@ -0,0 +1,415 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Camera.h"
+#include "Context.h"
+#include "ParticleEffect2D.h"
+#include "ParticleEffectBinary2D.h"
+#include "ParticleQuad2D.h"
+#include "ParticleSimulator2D.h"
+#include "ParticleUpdater2D.h"
+#include "PhaseProfiler2D.h"
+#include "Scene.h"
+#include "SimulatedParticleEmitter2D.h"
+#include "Sprite2D.h"
+#include "Texture2D.h"
+
+namespace Urho3D
+{
+
+SimulatedParticleEmitter2D::SimulatedParticleEmitter2D(Context* context) :
+    Drawable2D(context),
+    simulator_(new ParticleSimulator2D(context)),
+    textureRect_(Rect::ZERO),
+    particleBounds_(Rect::ZERO),
+    interpolation_(1.0f),
+    lodLevel_(0),
+    budgetScale_(1.0f),
+    simplified_(false),
+    updateVertices_(true),
+    profiler_(0)
+{
+}
+
+SimulatedParticleEmitter2D::~SimulatedParticleEmitter2D()
+{
+    if (updater_)
+        updater_->RemoveEmitter(this);
+}
+
+void SimulatedParticleEmitter2D::RegisterObject(Context* context)
+{
+    context->RegisterFactory<SimulatedParticleEmitter2D>();
+}
+
+void SimulatedParticleEmitter2D::SetEffect(ParticleEffect2D* effect)
+{
+    if (effect == simulator_->GetEffect())
+        return;
+
+    simulator_->SetEffect(effect);
+    if (effect)
+    {
+        SetSprite(effect->GetSprite());
+        SetBlendMode(effect->GetBlendMode());
+    }
+
+    verticesDirty_ = true;
+}
+
+void SimulatedParticleEmitter2D::SetMaxParticles(unsigned maxParticles)
+{
+    simulator_->SetMaxParticles(maxParticles);
+}
+
+void SimulatedParticleEmitter2D::SetEffectParameters(const ParticleEffectParameters2D& parameters)
+{
+    ParticleEffect2D* effect = simulator_->GetEffect();
+    if (!effect)
+        return;
+
+    SetParticleEffectParameters(effect, parameters);
+
+    // The particle pool grows in chunks and keeps live particles, so the new size applies right away
+    if (parameters.maxParticles_ != (int)simulator_->GetMaxParticles())
+        SetMaxParticles(parameters.maxParticles_);
+    if ((BlendMode)parameters.blendMode_ != GetBlendMode())
+        SetBlendMode((BlendMode)parameters.blendMode_);
+}
+
+ParticleEffect2D* SimulatedParticleEmitter2D::GetEffect() const
+{
+    return simulator_->GetEffect();
+}
+
+unsigned SimulatedParticleEmitter2D::GetMaxParticles() const
+{
+    return simulator_->GetMaxParticles();
+}
+
+void SimulatedParticleEmitter2D::SetInterpolation(float interpolation)
+{
+    interpolation = Clamp(interpolation, 0.0f, 1.0f);
+    if (interpolation == interpolation_)
+        return;
+
+    interpolation_ = interpolation;
+    verticesDirty_ = true;
+    OnMarkedDirty(node_);
+}
+
+void SimulatedParticleEmitter2D::SetLod(const ParticleEffectLod2D& lod)
+{
+    lod_ = lod;
+    lodLevel_ = 0;
+    ApplyLod();
+}
+
+void SimulatedParticleEmitter2D::UpdateLodLevel(Camera* camera)
+{
+    if (!camera || !node_ || !lod_.GetNumLevels())
+        return;
+
+    float value;
+    if (lod_.GetMetric() == PLM_DISTANCE)
+    {
+        Vector3 offset = node_->GetWorldPosition() - camera->GetNode()->GetWorldPosition();
+        value = offset.Length() / PIXEL_SIZE;
+    }
+    else
+    {
+        // Without particles there is no size to measure, so the level stays until the effect shows again
+        if (!simulator_->GetNumParticles())
+            return;
+
+        Vector2 min = camera->WorldToScreenPoint(Vector3(particleBounds_.min_.x_, particleBounds_.min_.y_, 0.0f));
+        Vector2 max = camera->WorldToScreenPoint(Vector3(particleBounds_.max_.x_, particleBounds_.max_.y_, 0.0f));
+        value = Max(Abs(max.x_ - min.x_) * camera->GetAspectRatio(), Abs(max.y_ - min.y_));
+    }
+
+    unsigned level = lod_.SelectLevel(value, lodLevel_);
+    if (level != lodLevel_)
+    {
+        lodLevel_ = level;
+        ApplyLod();
+    }
+}
+
+void SimulatedParticleEmitter2D::SetBudgetScale(float scale)
+{
+    scale = Clamp(scale, 0.0f, 1.0f);
+    if (scale == budgetScale_)
+        return;
+
+    budgetScale_ = scale;
+    ApplyLod();
+}
+
+void SimulatedParticleEmitter2D::Seek(float time, float timeStep)
+{
+    Vector3 worldPosition = node_->GetWorldPosition();
+    simulator_->SetPosition(Vector2(worldPosition.x_, worldPosition.y_));
+    simulator_->SetAngle(node_->GetWorldRotation().RollAngle());
+    simulator_->SetScale(node_->GetWorldScale().x_);
+    simulator_->Seek(time, timeStep);
+
+    interpolation_ = 1.0f;
+    verticesDirty_ = true;
+    UpdateVertices();
+    OnMarkedDirty(node_);
+}
+
+unsigned SimulatedParticleEmitter2D::GetLodParticleLimit() const
+{
+    ParticleEffect2D* effect = simulator_->GetEffect();
+    if (!effect)
+        return 0;
+
+    return (unsigned)(Max(effect->GetMaxParticles(), 0) * lod_.GetParticleScale(lodLevel_) + 0.5f);
+}
+
+unsigned SimulatedParticleEmitter2D::BeginUpdate(float timeStep, bool updateVertices)
+{
+    Vector3 worldPosition = node_->GetWorldPosition();
+    simulator_->SetPosition(Vector2(worldPosition.x_, worldPosition.y_));
+    simulator_->SetAngle(node_->GetWorldRotation().RollAngle());
+    simulator_->SetScale(node_->GetWorldScale().x_);
+
+    profiler_ = GetSubsystem<PhaseProfiler2D>();
+    {
+        PhaseProfileScope2D scope(profiler_, PP_SPAWN);
+        simulator_->BeginUpdate(timeStep);
+    }
+
+    updateVertices_ = updateVertices;
+    const ParticlePool2D& particles = simulator_->GetParticles();
+    if (!updateVertices_)
+        return particles.GetNumChunks();
+
+    // Size the outputs up front so that chunks write to disjoint ranges
+    ResizeOutputs();
+
+    return particles.GetNumChunks();
+}
+
+void SimulatedParticleEmitter2D::UpdateChunk(unsigned chunk, unsigned thread)
+{
+    unsigned chunkStart = chunk * PARTICLE_CHUNK_SIZE;
+    {
+        PhaseProfileScope2D scope(profiler_, PP_INTEGRATE, thread);
+        simulator_->UpdateParticles(chunkStart, chunkStart + PARTICLE_CHUNK_SIZE);
+    }
+    if (updateVertices_)
+    {
+        PhaseProfileScope2D scope(profiler_, PP_VERTICES, thread);
+        UpdateChunkVertices(chunk);
+    }
+}
+
+void SimulatedParticleEmitter2D::EndUpdate()
+{
+    // Vertices of an intermediate step are left to the final step of the frame
+    if (!updateVertices_)
+    {
+        verticesDirty_ = true;
+        return;
+    }
+
+    MergeChunkBounds();
+
+    OnMarkedDirty(node_);
+    verticesDirty_ = false;
+}
+
+void SimulatedParticleEmitter2D::OnNodeSet(Node* node)
+{
+    Drawable2D::OnNodeSet(node);
+
+    if (node)
+    {
+        Scene* scene = GetScene();
+        if (scene)
+        {
+            updater_ = scene->GetOrCreateComponent<ParticleUpdater2D>();
+            updater_->AddEmitter(this);
+        }
+    }
+    else if (updater_)
+    {
+        updater_->RemoveEmitter(this);
+        updater_.Reset();
+    }
+}
+
+void SimulatedParticleEmitter2D::OnWorldBoundingBoxUpdate()
+{
+    if (!simulator_->GetNumParticles())
+    {
+        Vector3 worldPosition = node_->GetWorldPosition();
+        worldBoundingBox_.Define(worldPosition, worldPosition);
+        return;
+    }
+
+    worldBoundingBox_.Define(Vector3(particleBounds_.min_.x_, particleBounds_.min_.y_, 0.0f),
+        Vector3(particleBounds_.max_.x_, particleBounds_.max_.y_, 0.0f));
+}
+
+void SimulatedParticleEmitter2D::UpdateVertices()
+{
+    if (!verticesDirty_)
+        return;
+
+    const ParticlePool2D& particles = simulator_->GetParticles();
+    ResizeOutputs();
+    for (unsigned chunk = 0; chunk < particles.GetNumChunks(); ++chunk)
+        UpdateChunkVertices(chunk);
+    MergeChunkBounds();
+
+    verticesDirty_ = false;
+}
+
+void SimulatedParticleEmitter2D::ResizeOutputs()
+{
+    // Storage follows the chunks the pool has allocated rather than the live count, so it only grows when the pool does and
+    // a running emitter writes its vertices without touching the heap. Resizing down keeps the storage
+    const ParticlePool2D& particles = simulator_->GetParticles();
+    unsigned numAllocated = particles.GetNumAllocatedChunks() * PARTICLE_CHUNK_SIZE;
+    if (vertices_.Capacity() < numAllocated * 4)
+        vertices_.Reserve(numAllocated * 4);
+    if (chunkBounds_.Capacity() < particles.GetNumAllocatedChunks())
+        chunkBounds_.Reserve(particles.GetNumAllocatedChunks());
+    if (interpolated_.Capacity() < numAllocated * 2)
+        interpolated_.Reserve(numAllocated * 2);
+
+    vertices_.Resize(UpdateTextureRect() ? particles.GetSize() * 4 : 0);
+    chunkBounds_.Resize(particles.GetNumChunks());
+    interpolated_.Resize(interpolation_ < 1.0f && !simplified_ ? particles.GetNumChunks() * PARTICLE_CHUNK_SIZE * 2 : 0);
+}
+
+bool SimulatedParticleEmitter2D::UpdateTextureRect()
+{
+    Texture2D* texture = sprite_ ? sprite_->GetTexture() : 0;
+    if (!texture)
+        return false;
+
+    const IntRect& rectangle = sprite_->GetRectangle();
+    if (rectangle.Width() == 0 || rectangle.Height() == 0)
+        return false;
+
+    float invTexW = 1.0f / (float)texture->GetWidth();
+    float invTexH = 1.0f / (float)texture->GetHeight();
+
+    textureRect_.min_ = Vector2(rectangle.left_ * invTexW, rectangle.top_ * invTexH);
+    textureRect_.max_ = Vector2(rectangle.right_ * invTexW, rectangle.bottom_ * invTexH);
+    return true;
+}
+
+void SimulatedParticleEmitter2D::UpdateChunkVertices(unsigned chunk)
+{
+    const ParticlePool2D& particles = simulator_->GetParticles();
+    const float* currentX = particles.GetStream(chunk, PS_POSITION_X);
+    const float* currentY = particles.GetStream(chunk, PS_POSITION_Y);
+    const float* size = particles.GetStream(chunk, PS_SIZE);
+    unsigned chunkSize = particles.GetChunkSize(chunk);
+
+    // Draw between the previous and the last fixed step. Sizes, rotations and colors change slowly enough to be drawn
+    // as of the last step. Simplified particles are drawn as of the last step too
+    const float* positionX = currentX;
+    const float* positionY = currentY;
+    if (interpolation_ < 1.0f && !simplified_)
+    {
+        const float* previousX = particles.GetStream(chunk, PS_PREVIOUS_X);
+        const float* previousY = particles.GetStream(chunk, PS_PREVIOUS_Y);
+        float* interpolatedX = &interpolated_[chunk * PARTICLE_CHUNK_SIZE * 2];
+        float* interpolatedY = interpolatedX + PARTICLE_CHUNK_SIZE;
+        for (unsigned i = 0; i < chunkSize; ++i)
+        {
+            interpolatedX[i] = previousX[i] + (currentX[i] - previousX[i]) * interpolation_;
+            interpolatedY[i] = previousY[i] + (currentY[i] - previousY[i]) * interpolation_;
+        }
+        positionX = interpolatedX;
+        positionY = interpolatedY;
+    }
+
+    Vector2 minPoint(M_INFINITY, M_INFINITY);
+    Vector2 maxPoint(-M_INFINITY, -M_INFINITY);
+    for (unsigned i = 0; i < chunkSize; ++i)
+        MergeParticleQuadBounds(minPoint, maxPoint, positionX[i], positionY[i], size[i]);
+    chunkBounds_[chunk] = Rect(minPoint, maxPoint);
+
+    if (vertices_.Empty())
+        return;
+
+    const float* rotation = particles.GetStream(chunk, PS_ROTATION);
+    const float* colorR = particles.GetStream(chunk, PS_COLOR_R);
+    const float* colorG = particles.GetStream(chunk, PS_COLOR_G);
+    const float* colorB = particles.GetStream(chunk, PS_COLOR_B);
+    const float* colorA = particles.GetStream(chunk, PS_COLOR_A);
+
+    // Each particle owns four vertices at a fixed offset, so the result does not depend on which thread wrote it
+    Vertex2D* vertex = &vertices_[chunk * PARTICLE_CHUNK_SIZE * 4];
+    for (unsigned i = 0; i < chunkSize; ++i)
+    {
+        // Simplified particles skip the rotation and are drawn axis aligned
+        float add = size[i] * 0.5f;
+        float sub = add;
+        if (!simplified_)
+            GetParticleQuadOffsets(size[i], rotation[i], add, sub);
+        unsigned color = Color(colorR[i], colorG[i], colorB[i], colorA[i]).ToUInt();
+
+        WriteParticleQuad(vertex, positionX[i], positionY[i], add, sub, color, textureRect_);
+        vertex += 4;
+    }
+}
+
+void SimulatedParticleEmitter2D::MergeChunkBounds()
+{
+    if (chunkBounds_.Empty())
+    {
+        particleBounds_ = Rect::ZERO;
+        return;
+    }
+
+    particleBounds_ = chunkBounds_[0];
+    for (unsigned i = 1; i < chunkBounds_.Size(); ++i)
+    {
+        particleBounds_.min_.x_ = Min(particleBounds_.min_.x_, chunkBounds_[i].min_.x_);
+        particleBounds_.min_.y_ = Min(particleBounds_.min_.y_, chunkBounds_[i].min_.y_);
+        particleBounds_.max_.x_ = Max(particleBounds_.max_.x_, chunkBounds_[i].max_.x_);
+        particleBounds_.max_.y_ = Max(particleBounds_.max_.y_, chunkBounds_[i].max_.y_);
+    }
+}
+
+void SimulatedParticleEmitter2D::ApplyLod()
+{
+    simulator_->SetParticleScale(lod_.GetParticleScale(lodLevel_) * budgetScale_);
+    simulator_->SetSpawnScale(lod_.GetSpawnScale(lodLevel_) * budgetScale_);
+
+    bool simplified = lod_.IsSimplified(lodLevel_);
+    if (simplified != simplified_)
+    {
+        simplified_ = simplified;
+        verticesDirty_ = true;
+    }
+}
+
+}
@@ -0,0 +1,140 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Drawable2D.h"
+#include "ParticleEffectLod2D.h"
+
+namespace Urho3D
+{
+
+class Camera;
+class ParticleEffect2D;
+struct ParticleEffectParameters2D;
+class ParticleSimulator2D;
+class ParticleUpdater2D;
+class PhaseProfiler2D;
+
+/// 2D particle emitter component driven by ParticleSimulator2D. The scene's ParticleUpdater2D steps it once per frame.
+class SimulatedParticleEmitter2D : public Drawable2D
+{
+    OBJECT(SimulatedParticleEmitter2D)
+
+public:
+    /// Construct.
+    SimulatedParticleEmitter2D(Context* context);
+    /// Destruct.
+    virtual ~SimulatedParticleEmitter2D();
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+
+    /// Set particle effect, also takes its sprite and blend mode.
+    void SetEffect(ParticleEffect2D* effect);
+    /// Set max particles.
+    void SetMaxParticles(unsigned maxParticles);
+    /// Set attributes of the effect in place, keeping live particles, and take its max particles and blend mode.
+    void SetEffectParameters(const ParticleEffectParameters2D& parameters);
+    /// Set how far between the previous and the last step particles are drawn, 1 draws the last step.
+    void SetInterpolation(float interpolation);
+    /// Set LOD levels and return to full detail.
+    void SetLod(const ParticleEffectLod2D& lod);
+    /// Select the LOD level by distance to the camera or by the screen size of the particles.
+    void UpdateLodLevel(Camera* camera);
+    /// Set multiplier of max particles and spawn rate from the particle budget, applied on top of the LOD level.
+    void SetBudgetScale(float scale);
+    /// Restart and jump to a time in seconds, following the node transform, and update vertices.
+    void Seek(float time, float timeStep);
+
+    /// Return particle effect.
+    ParticleEffect2D* GetEffect() const;
+    /// Return max particles.
+    unsigned GetMaxParticles() const;
+    /// Return simulator.
+    ParticleSimulator2D* GetSimulator() const { return simulator_; }
+    /// Return interpolation between the previous and the last step.
+    float GetInterpolation() const { return interpolation_; }
+    /// Return LOD levels.
+    const ParticleEffectLod2D& GetLod() const { return lod_; }
+    /// Return LOD level, 0 for full detail.
+    unsigned GetLodLevel() const { return lodLevel_; }
+    /// Return number of particles the LOD level allows, before the particle budget.
+    unsigned GetLodParticleLimit() const;
+    /// Return particle budget multiplier.
+    float GetBudgetScale() const { return budgetScale_; }
+
+    /// Begin a step on the main thread: follow the node transform, remove dead and emit new particles. Return number of chunks to update.
+    /// Vertices are only written when requested, so intermediate steps of a frame skip them.
+    unsigned BeginUpdate(float timeStep, bool updateVertices = true);
+    /// Step particles of one chunk and write their vertices if requested. Different chunks may be updated from worker threads in parallel.
+    /// The thread is numbered as the work queue does, 0 for the main thread, and picks the profiler slot.
+    void UpdateChunk(unsigned chunk, unsigned thread = 0);
+    /// Finish a frame on the main thread: merge chunk bounds and mark the drawable dirty.
+    void EndUpdate();
+
+private:
+    /// Handle node being assigned.
+    virtual void OnNodeSet(Node* node);
+    /// Recalculate the world-space bounding box.
+    virtual void OnWorldBoundingBoxUpdate();
+    /// Update vertices.
+    virtual void UpdateVertices();
+    /// Size vertices, chunk bounds and interpolated positions for the live particles.
+    void ResizeOutputs();
+    /// Update texture coordinates from the sprite, return false if there is nothing to draw.
+    bool UpdateTextureRect();
+    /// Write vertices and bounds of one chunk.
+    void UpdateChunkVertices(unsigned chunk);
+    /// Merge chunk bounds into the particle bounds.
+    void MergeChunkBounds();
+    /// Pass the scales of the LOD level and the budget to the simulator.
+    void ApplyLod();
+
+    /// Simulator.
+    SharedPtr<ParticleSimulator2D> simulator_;
+    /// Updater of the scene.
+    WeakPtr<ParticleUpdater2D> updater_;
+    /// Texture coordinates of the sprite.
+    Rect textureRect_;
+    /// Bounds of each chunk, written by UpdateChunkVertices().
+    PODVector<Rect> chunkBounds_;
+    /// Interpolated positions of each chunk, X then Y.
+    PODVector<float> interpolated_;
+    /// Bounds of all particles.
+    Rect particleBounds_;
+    /// Interpolation between the previous and the last step.
+    float interpolation_;
+    /// LOD levels.
+    ParticleEffectLod2D lod_;
+    /// LOD level.
+    unsigned lodLevel_;
+    /// Particle budget multiplier.
+    float budgetScale_;
+    /// Whether the LOD level draws simplified particles.
+    bool simplified_;
+    /// Whether the current step writes vertices.
+    bool updateVertices_;
+    /// Phase profiler if registered, looked up in BeginUpdate() for the chunk updates.
+    PhaseProfiler2D* profiler_;
+};
+
+}
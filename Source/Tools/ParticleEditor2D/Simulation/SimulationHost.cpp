@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Context.h"
+#include "Engine.h"
+#include "Log.h"
+#include "ParticleEffect2D.h"
+#include "ParticleEffectBinary2D.h"
+#include "ParticleEffectSettings2D.h"
+#include "SimulationHost.h"
+
+namespace Urho3D
+{
+
+SimulationHost::SimulationHost(Context* context) :
+    Object(context)
+{
+}
+
+SimulationHost::~SimulationHost()
+{
+}
+
+bool SimulationHost::Initialize(const String& logName, bool logQuiet)
+{
+    if (engine_)
+        return true;
+
+    engine_ = new Engine(context_);
+
+    VariantMap engineParameters;
+    engineParameters["Headless"] = true;
+    engineParameters["Sound"] = false;
+    engineParameters["LogName"] = logName;
+    engineParameters["LogQuiet"] = logQuiet;
+    if (!engine_->Initialize(engineParameters))
+    {
+        engine_.Reset();
+        return false;
+    }
+
+    return true;
+}
+
+ParticleEffect2D* SimulationHost::LoadEffect(const String& fileName)
+{
+    ParticleEffect2D* particleEffect = LoadParticleEffect(context_, fileName);
+    if (!particleEffect)
+        LOGERROR("Load particle effect failed " + fileName);
+
+    return particleEffect;
+}
+
+bool SimulationHost::LoadSettings(const String& fileName, ParticleEffectSettings2D& settings)
+{
+    if (!LoadParticleEffect(context_, fileName, &settings))
+    {
+        LOGERROR("Load particle effect settings failed " + fileName);
+        return false;
+    }
+
+    return true;
+}
+
+}
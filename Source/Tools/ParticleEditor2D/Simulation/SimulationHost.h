@@ -0,0 +1,61 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Object.h"
+#include "Ptr.h"
+
+namespace Urho3D
+{
+
+class Engine;
+class ParticleEffect2D;
+class ParticleEffectSettings2D;
+
+/// Headless engine host for loading and simulating particle effects without window or GPU.
+class SimulationHost : public Object
+{
+    OBJECT(SimulationHost)
+
+public:
+    /// Construct.
+    SimulationHost(Context* context);
+    /// Destruct.
+    virtual ~SimulationHost();
+
+    /// Initialize headless engine. A quiet log only goes to the log file. Return true if successful.
+    bool Initialize(const String& logName = "ParticleSimulation2D.log", bool logQuiet = false);
+    /// Load particle effect through the resource cache, as the editor does. The format is picked by extension.
+    ParticleEffect2D* LoadEffect(const String& fileName);
+    /// Load the extra settings stored in a particle effect file. Return true if successful.
+    bool LoadSettings(const String& fileName, ParticleEffectSettings2D& settings);
+
+    /// Return engine.
+    Engine* GetEngine() const { return engine_; }
+
+private:
+    /// Engine.
+    SharedPtr<Engine> engine_;
+};
+
+}
@@ -0,0 +1,158 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "ParticleEditor.h"
+#include "ParticleSimulator2D.h"
+#include "ParticleUpdater2D.h"
+#include "SimulatedParticleEmitter2D.h"
+#include "TimelineWidget.h"
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QSlider>
+#include <QTimer>
+#include <QVBoxLayout>
+
+namespace Urho3D
+{
+
+TimelineWidget::TimelineWidget(Context* context) :
+    QWidget(),
+    ParticleEffectEditor(context)
+{
+    QVBoxLayout* vBoxLayout = new QVBoxLayout();
+    setLayout(vBoxLayout);
+
+    QHBoxLayout* hBoxLayout = new QHBoxLayout();
+    vBoxLayout->addLayout(hBoxLayout);
+
+    playPushButton_ = new QPushButton(tr("Pause"));
+    hBoxLayout->addWidget(playPushButton_);
+    connect(playPushButton_, SIGNAL(clicked(bool)), this, SLOT(HandlePlayPushButtonClicked()));
+
+    QPushButton* stepPushButton = new QPushButton(tr("Step"));
+    hBoxLayout->addWidget(stepPushButton);
+    connect(stepPushButton, SIGNAL(clicked(bool)), this, SLOT(HandleStepPushButtonClicked()));
+
+    QPushButton* restartPushButton = new QPushButton(tr("Restart"));
+    hBoxLayout->addWidget(restartPushButton);
+    connect(restartPushButton, SIGNAL(clicked(bool)), this, SLOT(HandleRestartPushButtonClicked()));
+
+    timeSlider_ = new QSlider(Qt::Horizontal);
+    hBoxLayout->addWidget(timeSlider_, 1);
+    connect(timeSlider_, SIGNAL(valueChanged(int)), this, SLOT(HandleTimeSliderValueChanged(int)));
+
+    timeLabel_ = new QLabel();
+    timeLabel_->setMinimumWidth(48);
+    hBoxLayout->addWidget(timeLabel_);
+
+    statusLabel_ = new QLabel();
+    vBoxLayout->addWidget(statusLabel_);
+    vBoxLayout->addStretch(1);
+
+    // The slider follows the simulation, so it is polled more often than the statistics of other docks
+    QTimer* timer = new QTimer(this);
+    connect(timer, SIGNAL(timeout()), this, SLOT(HandleRefreshTimeout()));
+    timer->start(50);
+}
+
+TimelineWidget::~TimelineWidget()
+{
+}
+
+void TimelineWidget::HandlePlayPushButtonClicked()
+{
+    ParticleUpdater2D* updater = ParticleEditor::Get()->GetUpdater();
+    if (!updater)
+        return;
+
+    updater->SetPaused(!updater->IsPaused());
+    ParticleEditor::Get()->RequestFrame();
+    HandleRefreshTimeout();
+}
+
+void TimelineWidget::HandleStepPushButtonClicked()
+{
+    // Stepping holds the simulation after the step
+    ParticleUpdater2D* updater = ParticleEditor::Get()->GetUpdater();
+    if (!updater)
+        return;
+
+    updater->SetPaused(true);
+    updater->Step();
+    ParticleEditor::Get()->RequestFrame();
+    HandleRefreshTimeout();
+}
+
+void TimelineWidget::HandleRestartPushButtonClicked()
+{
+    ParticleEditor::Get()->Restart();
+    HandleRefreshTimeout();
+}
+
+void TimelineWidget::HandleTimeSliderValueChanged(int value)
+{
+    if (updatingWidget_)
+        return;
+
+    // Scrubbing holds the simulation where the slider is
+    ParticleEditor* editor = ParticleEditor::Get();
+    ParticleUpdater2D* updater = editor->GetUpdater();
+    SimulatedParticleEmitter2D* emitter = GetEmitter();
+    if (!updater || !emitter)
+        return;
+
+    updater->SetPaused(true);
+    float time = value * 0.001f;
+    long long elapsed = editor->Seek(time);
+
+    bool closedForm = emitter->GetSimulator()->IsSeekClosedForm();
+    statusLabel_->setText(tr("Seek to %1 s took %2 ms, %3").arg(time, 0, 'f', 2).arg(elapsed * 0.001, 0, 'f', 2)
+        .arg(closedForm ? tr("closed form") : tr("sub-stepped")));
+    HandleRefreshTimeout();
+}
+
+void TimelineWidget::HandleRefreshTimeout()
+{
+    ParticleUpdater2D* updater = ParticleEditor::Get()->GetUpdater();
+    SimulatedParticleEmitter2D* emitter = GetEmitter();
+    if (!updater || !emitter || !isVisible())
+        return;
+
+    // Following the simulation must not count as scrubbing
+    float time = emitter->GetSimulator()->GetElapsedTime();
+    float length = Max(ParticleEditor::Get()->GetTimelineLength(), time);
+    timeSlider_->blockSignals(true);
+    timeSlider_->setRange(0, (int)(length * 1000.0f));
+    timeSlider_->setValue((int)(time * 1000.0f));
+    timeSlider_->blockSignals(false);
+
+    playPushButton_->setText(updater->IsPaused() ? tr("Play") : tr("Pause"));
+    timeLabel_->setText(tr("%1 s").arg(time, 0, 'f', 2));
+}
+
+void TimelineWidget::HandleUpdateWidget()
+{
+    HandleRefreshTimeout();
+}
+
+}
@@ -0,0 +1,73 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "ParticleEffectEditor.h"
+#include <QWidget>
+
+class QLabel;
+class QPushButton;
+class QSlider;
+
+namespace Urho3D
+{
+
+/// Play, pause, step and seek the preview of all layers.
+class TimelineWidget : public QWidget, public ParticleEffectEditor
+{
+    Q_OBJECT
+    OBJECT(TimelineWidget)
+
+public:
+    /// Construct.
+    TimelineWidget(Context* context);
+    /// Destruct.
+    virtual ~TimelineWidget();
+
+private slots:
+    /// Handle play button.
+    void HandlePlayPushButtonClicked();
+    /// Handle step button.
+    void HandleStepPushButtonClicked();
+    /// Handle restart button.
+    void HandleRestartPushButtonClicked();
+    /// Handle time slider.
+    void HandleTimeSliderValueChanged(int value);
+    /// Handle refresh timer.
+    void HandleRefreshTimeout();
+
+private:
+    /// Handle update widget.
+    virtual void HandleUpdateWidget();
+
+    /// Play button.
+    QPushButton* playPushButton_;
+    /// Time slider in milliseconds.
+    QSlider* timeSlider_;
+    /// Time label.
+    QLabel* timeLabel_;
+    /// Last seek label.
+    QLabel* statusLabel_;
+};
+
+}